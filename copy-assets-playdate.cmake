@@ -4,7 +4,17 @@
   
 - Assets are:
   - pdxinfo
-  - assets/**
+  - assets/**: staged incrementally by scripts/stage_assets.py (needs PYTHON3_EXECUTABLE): only
+    changed assets are copied/converted (in parallel), removed ones are deleted from Source/assets;
+    content hashes are kept in the build directory (asset_stage_manifest.json). Conversions:
+    - assets/**/<name>.framepack: numbered frame images ("<name>_frame-<NN>*.png") packed into
+      one file per sequence by scripts/pack_frames.py; the frame images themselves are left out.
+    - assets/**/<name>.tileset: images larger than the screen tiled (with half-resolution levels) by
+      scripts/tile_image.py, to be streamed tile by tile; the images themselves are staged too.
+    - assets/**/*.wav, *.mp3: transcoded by scripts/transcode_audio.py to the format
+      src/audio_manifest.json sets per file/directory (e.g. MP3 for music, streamed by the
+      fileplayer).
+    Without Python, assets are copied as they are (frame images unpacked, no tile sets, audio not transcoded).
   
 - It is intended to run before Playdate's CMake scripts so that these 
   assets are available for its build process as needed.
@@ -26,5 +36,25 @@ file(COPY ${CMAKE_CURRENT_LIST_DIR}/src/pdxinfo DESTINATION ../Source)
 
 # assets/
 if(NOT PD_ASSETS_MISSING)
-	file(COPY ${CMAKE_CURRENT_LIST_DIR}/src/assets DESTINATION ../Source)
+	set(PD_ASSETS_STAGED false)
+	if(PYTHON3_EXECUTABLE)
+		execute_process(
+			COMMAND ${PYTHON3_EXECUTABLE} ${CMAKE_CURRENT_LIST_DIR}/scripts/stage_assets.py 
+				--src-dir ${CMAKE_CURRENT_LIST_DIR}/src/assets 
+				--out-dir ../Source/assets 
+				--manifest asset_stage_manifest.json 
+				--audio-manifest ${CMAKE_CURRENT_LIST_DIR}/src/audio_manifest.json
+			RESULT_VARIABLE PD_STAGE_RESULT
+		)
+		if(PD_STAGE_RESULT EQUAL 0)
+			set(PD_ASSETS_STAGED true)
+		else()
+			message(WARNING "Staging assets failed; copying them as they are instead")
+		endif()
+	else()
+		message(WARNING "Python 3 not found; assets are copied as they are (frame images unpacked, no tile sets, audio not transcoded)")
+	endif()
+	if(NOT PD_ASSETS_STAGED)
+		file(COPY ${CMAKE_CURRENT_LIST_DIR}/src/assets DESTINATION ../Source)
+	endif()
 endif()
@@ -0,0 +1,247 @@
+#[[
+- This CMake script generates the asset manifest's table (asset_manifest_data.h, see include/asset_manifest.h)
+  from the assets in ~PROJECT_ROOT/src/assets: an ID, kind, load path, dimensions and byte size per asset.
+
+- Usage: cmake -DASSETS_DIR=<src/assets> -DOUTPUT=<header> -P gen-asset-manifest.cmake
+  The header is only rewritten if its contents changed (so unchanged assets don't trigger a rebuild).
+
+- IDs are "kAsset" plus the asset's path (relative to assets/, without extension) in CamelCase, e.g.
+  music/arp+surf=earth.mp3 -> kAssetMusicArpSurfEarth, in path order. Also generated:
+  - per frame sequence ("<name>_frame-<NN>*.png", staged as <name>.framepack, see scripts/pack_frames.py):
+    an entry of kind kAssetKindFrameSequence followed by its frames in number order, and
+    <ID>Count, <ID>Width and <ID>Height constants;
+  - per image: <ID>Width and <ID>Height constants;
+  - per image larger than the screen (staged as a tile set too, see scripts/tile_image.py): an entry
+    <ID>Tiles of kind kAssetKindTileSet after the image's;
+  - per directory: kAssetDir<Path>First and kAssetDir<Path>Count, the range of IDs of the files directly in it.
+  Code referring to an asset that is missing, or checking sizes with _Static_assert(), fails to compile.
+
+- Assets that are broken fail the build here: images that aren't PNGs, WAVs without RIFF/WAVE header,
+  frame sequences with missing frame numbers or frames of different sizes, and assets that would be
+  staged to the same load path.
+
+- Left out: pd_launcher/ (the system's launcher images), font glyph tables ("*-table-<W>-<H>.png"),
+  hidden files.
+]]
+
+cmake_minimum_required(VERSION 3.14)
+
+if(NOT ASSETS_DIR OR NOT OUTPUT)
+	message(FATAL_ERROR "Usage: cmake -DASSETS_DIR=<dir> -DOUTPUT=<header> -P gen-asset-manifest.cmake")
+endif()
+
+# Sets out_var to the CamelCase identifier of path's alphanumeric runs
+function(pd_asset_identifier out_var path)
+	string(REGEX MATCHALL "[A-Za-z0-9]+" tokens "${path}")
+	set(identifier "")
+	foreach(token IN LISTS tokens)
+		string(SUBSTRING "${token}" 0 1 first)
+		string(SUBSTRING "${token}" 1 -1 rest)
+		string(TOUPPER "${first}" first)
+		string(APPEND identifier "${first}${rest}")
+	endforeach()
+	set(${out_var} "${identifier}" PARENT_SCOPE)
+endfunction()
+
+# Sets width_var and height_var to the PNG file's dimensions (fails the build if it isn't a PNG)
+function(pd_png_size width_var height_var file)
+	file(READ "${file}" signature HEX LIMIT 8)
+	file(READ "${file}" header HEX OFFSET 16 LIMIT 8)
+	string(LENGTH "${header}" header_length)
+	if(NOT signature STREQUAL "89504e470d0a1a0a" OR NOT header_length EQUAL 16)
+		message(FATAL_ERROR "Asset ${file} is not a PNG image")
+	endif()
+	string(SUBSTRING "${header}" 0 8 width)
+	string(SUBSTRING "${header}" 8 8 height)
+	math(EXPR width "0x${width}")
+	math(EXPR height "0x${height}")
+	if(width EQUAL 0 OR height EQUAL 0)
+		message(FATAL_ERROR "Asset ${file} is an empty image")
+	endif()
+	set(${width_var} ${width} PARENT_SCOPE)
+	set(${height_var} ${height} PARENT_SCOPE)
+endfunction()
+
+set(pd_ids "")
+set(pd_entries "")
+set(pd_constants "")
+set(pd_load_paths "")
+
+# Appends an asset entry (and its ID); fails the build on duplicate IDs or load paths
+macro(pd_add_asset id kind load_path width height size first count)
+	if("${id}" IN_LIST pd_ids)
+		message(FATAL_ERROR "Assets ${load_path} and another asset both have the ID ${id}; rename one")
+	endif()
+	if("${load_path}" IN_LIST pd_load_paths)
+		message(FATAL_ERROR "Assets both stage to ${load_path} (only their extensions differ); rename one")
+	endif()
+	list(APPEND pd_ids "${id}")
+	list(APPEND pd_load_paths "${load_path}")
+	string(REPLACE "\\" "\\\\" escaped_path "${load_path}")
+	string(REPLACE "\"" "\\\"" escaped_path "${escaped_path}")
+	string(APPEND pd_entries "\t{ ${kind}, \"${escaped_path}\", ${width}, ${height}, ${size}u, ${first}, ${count} }, \\\n")
+endmacro()
+
+file(GLOB_RECURSE pd_files RELATIVE "${ASSETS_DIR}" "${ASSETS_DIR}/*")
+list(SORT pd_files)
+list(FILTER pd_files EXCLUDE REGEX "^pd_launcher/")
+list(FILTER pd_files EXCLUDE REGEX "(^|/)\\.")
+list(FILTER pd_files EXCLUDE REGEX "-table-[0-9]+-[0-9]+\\.png$")
+
+# directories, in order of their first file (files of a directory are contiguous in path order, subdirectories aside)
+set(pd_dirs "")
+foreach(file IN LISTS pd_files)
+	get_filename_component(dir "${file}" DIRECTORY)
+	if(NOT "${dir}" IN_LIST pd_dirs)
+		list(APPEND pd_dirs "${dir}")
+	endif()
+endforeach()
+
+foreach(dir IN LISTS pd_dirs)
+	set(dir_prefix "")
+	if(NOT dir STREQUAL "")
+		set(dir_prefix "${dir}/")
+	endif()
+	list(LENGTH pd_ids dir_first)
+	set(done_sequences "")
+
+	foreach(file IN LISTS pd_files)
+		get_filename_component(file_dir "${file}" DIRECTORY)
+		if(NOT file_dir STREQUAL dir)
+			continue()
+		endif()
+		get_filename_component(name "${file}" NAME)
+		get_filename_component(ext "${file}" LAST_EXT)
+		string(TOLOWER "${ext}" ext)
+		string(LENGTH "${file}" file_length)
+		string(LENGTH "${ext}" ext_length)
+		math(EXPR stem_length "${file_length} - ${ext_length}")
+		string(SUBSTRING "${file}" 0 ${stem_length} stem)
+		pd_asset_identifier(id "${stem}")
+		set(id "kAsset${id}")
+		file(SIZE "${ASSETS_DIR}/${file}" size)
+
+		if(name MATCHES "^(.+)_frame-([0-9]+)[^/]*\\.png$")
+			# a frame sequence: added as a whole, at its first frame
+			set(sequence "${CMAKE_MATCH_1}")
+			if("${sequence}" IN_LIST done_sequences)
+				continue()
+			endif()
+			list(APPEND done_sequences "${sequence}")
+
+			# its frames, by (zero-padded) frame number
+			set(frames "")
+			foreach(frame IN LISTS pd_files)
+				get_filename_component(frame_dir "${frame}" DIRECTORY)
+				get_filename_component(frame_name "${frame}" NAME)
+				if(frame_dir STREQUAL dir AND frame_name MATCHES "^(.+)_frame-([0-9]+)[^/]*\\.png$" AND CMAKE_MATCH_1 STREQUAL sequence)
+					set(number "0000000000${CMAKE_MATCH_2}")
+					string(LENGTH "${number}" number_length)
+					math(EXPR number_start "${number_length} - 10")
+					string(SUBSTRING "${number}" ${number_start} 10 number)
+					list(APPEND frames "${number}|${frame}")
+				endif()
+			endforeach()
+			list(SORT frames)
+			list(LENGTH frames frame_count)
+
+			set(sequence_size 0)
+			set(sequence_width "")
+			set(expected_number "")
+			foreach(frame IN LISTS frames)
+				string(REGEX MATCH "^([0-9]+)\\|(.*)$" _ "${frame}")
+				math(EXPR number "${CMAKE_MATCH_1}")
+				set(frame "${CMAKE_MATCH_2}")
+				if(NOT expected_number STREQUAL "" AND NOT number EQUAL expected_number)
+					message(FATAL_ERROR "Frame sequence ${dir_prefix}${sequence} is missing frame ${expected_number}")
+				endif()
+				math(EXPR expected_number "${number} + 1")
+				pd_png_size(width height "${ASSETS_DIR}/${frame}")
+				if(sequence_width STREQUAL "")
+					set(sequence_width ${width})
+					set(sequence_height ${height})
+				elseif(NOT width EQUAL sequence_width OR NOT height EQUAL sequence_height)
+					message(FATAL_ERROR "Frame ${frame} is ${width}x${height}, unlike the ${sequence_width}x${sequence_height} of the frames before it")
+				endif()
+				file(SIZE "${ASSETS_DIR}/${frame}" frame_size)
+				math(EXPR sequence_size "${sequence_size} + ${frame_size}")
+			endforeach()
+
+			pd_asset_identifier(sequence_id "${dir_prefix}${sequence}")
+			set(sequence_id "kAsset${sequence_id}")
+			list(LENGTH pd_ids frame_first)
+			math(EXPR frame_first "${frame_first} + 1")
+			pd_add_asset(${sequence_id} kAssetKindFrameSequence "assets/${dir_prefix}${sequence}.framepack" ${sequence_width} ${sequence_height} ${sequence_size} ${frame_first} ${frame_count})
+			string(APPEND pd_constants "\t${sequence_id}Count = ${frame_count},\n\t${sequence_id}Width = ${sequence_width},\n\t${sequence_id}Height = ${sequence_height},\n")
+			foreach(frame IN LISTS frames)
+				string(REGEX REPLACE "^[0-9]+\\|" "" frame "${frame}")
+				get_filename_component(frame_stem "${frame}" NAME_WLE)
+				pd_asset_identifier(frame_id "${dir_prefix}${frame_stem}")
+				file(SIZE "${ASSETS_DIR}/${frame}" frame_size)
+				pd_add_asset(kAsset${frame_id} kAssetKindImage "assets/${dir_prefix}${frame_stem}" ${sequence_width} ${sequence_height} ${frame_size} 0 0)
+			endforeach()
+		elseif(ext STREQUAL ".png")
+			pd_png_size(width height "${ASSETS_DIR}/${file}")
+			pd_add_asset(${id} kAssetKindImage "assets/${stem}" ${width} ${height} ${size} 0 0)
+			string(APPEND pd_constants "\t${id}Width = ${width},\n\t${id}Height = ${height},\n")
+			# (keep in sync with scripts/tile_image.py's SCREEN_WIDTH/SCREEN_HEIGHT)
+			if(width GREATER 400 OR height GREATER 240)
+				pd_add_asset(${id}Tiles kAssetKindTileSet "assets/${stem}.tileset" ${width} ${height} ${size} 0 0)
+			endif()
+		elseif(ext STREQUAL ".fnt")
+			pd_add_asset(${id} kAssetKindFont "assets/${stem}" 0 0 ${size} 0 0)
+		elseif(ext STREQUAL ".wav" OR ext STREQUAL ".mp3" OR ext STREQUAL ".aif" OR ext STREQUAL ".aiff")
+			if(ext STREQUAL ".wav")
+				file(READ "${ASSETS_DIR}/${file}" riff HEX LIMIT 12)
+				if(NOT riff MATCHES "^52494646........57415645$")
+					message(FATAL_ERROR "Asset ${file} is not a WAV file")
+				endif()
+			endif()
+			# (music is streamed by a file player, anything else loaded as a sample; see src/audio_manifest.json)
+			if(file MATCHES "(^|/)music/")
+				set(kind kAssetKindMusic)
+			else()
+				set(kind kAssetKindSound)
+			endif()
+			pd_add_asset(${id} ${kind} "assets/${stem}" 0 0 ${size} 0 0)
+		else()
+			pd_asset_identifier(id "${file}")
+			pd_add_asset(kAsset${id} kAssetKindData "assets/${file}" 0 0 ${size} 0 0)
+		endif()
+	endforeach()
+
+	list(LENGTH pd_ids dir_end)
+	math(EXPR dir_count "${dir_end} - ${dir_first}")
+	pd_asset_identifier(dir_id "${dir}")
+	string(APPEND pd_constants "\tkAssetDir${dir_id}First = ${dir_first},\n\tkAssetDir${dir_id}Count = ${dir_count},\n")
+endforeach()
+
+string(REPLACE ";" ",\n\t" pd_id_list "${pd_ids}")
+set(pd_header "// Generated by gen-asset-manifest.cmake from src/assets; do not edit.
+
+#ifndef asset_manifest_data_h
+#define asset_manifest_data_h
+
+/** Asset IDs: indices into assetManifest */
+enum {
+	${pd_id_list},
+	kNumAssets
+};
+
+/** Frame sequence frame counts, image and frame dimensions, and directory ID ranges */
+enum {
+${pd_constants}};
+
+/** assetManifest's entries (see asset_manifest.c) */
+#define ASSET_MANIFEST_ENTRIES \\
+${pd_entries}
+#endif /* asset_manifest_data_h */
+")
+
+set(pd_previous "")
+if(EXISTS "${OUTPUT}")
+	file(READ "${OUTPUT}" pd_previous)
+endif()
+if(NOT pd_previous STREQUAL pd_header)
+	file(WRITE "${OUTPUT}" "${pd_header}")
+endif()
@@ -0,0 +1,129 @@
+//
+//  pd_host.h
+//  playdate-hello-world-c-kickstarter
+//
+//  Headless host stand-in for the Playdate runtime. Provides a PlaydateAPI whose
+//  graphics, sprite, sound, system, display and file tables are backed by an
+//  in-memory 400x240 1-bit frame buffer, real PNG/WAV/font loading and a
+//  scripted input source, so the game's eventHandler/update can be driven and
+//  measured on a plain Linux box (see host/src/bench.c).
+//
+
+#ifndef pd_host_h
+#define pd_host_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "pd_api.h"
+
+/** The maximum number of asset directories searched by the host file/asset loaders. */
+#define HOST_MAX_ASSET_ROOTS 4
+
+/** One frame's worth of hardware input, as fed to the host runtime before each update. */
+typedef struct {
+	/** Buttons held this frame */
+	PDButtons current;
+	/** Extra buttons reported as pushed this frame on top of those derived from `current` (e.g. press+release within one frame) */
+	PDButtons pushed;
+	/** Extra buttons reported as released this frame on top of those derived from `current` */
+	PDButtons released;
+	float crankAngle;
+	float crankChange;
+	int crankDocked;
+	float accelX;
+	float accelY;
+	float accelZ;
+} HostInput;
+
+/** Counters accumulated by the host runtime; reset with hostResetStats(). */
+typedef struct {
+	/** Number of heap allocations (new blocks) made through the host, including pd->system->realloc */
+	uint64_t allocCount;
+	/** Number of heap blocks released through the host */
+	uint64_t freeCount;
+	/** Total bytes requested by allocations */
+	uint64_t allocBytes;
+	/** Bytes currently held by live host allocations */
+	uint64_t liveBytes;
+	/** High-water mark of liveBytes */
+	uint64_t peakBytes;
+	/** Number of update() passes run */
+	uint64_t frames;
+	/** Number of update() passes that asked for a display update (non-zero return) */
+	uint64_t framesDisplayed;
+	/** Number of frame buffer rows flushed to the (virtual) display */
+	uint64_t rowsFlushed;
+	/** Number of file opens (assets, data and pd->file) */
+	uint64_t fileOpens;
+	/** Number of pd->system->error calls (kept by hostResetStats(), so errors before it still count) */
+	uint64_t errors;
+} HostStats;
+
+/**
+ * Initializes the host runtime.
+ *
+ * @param assetRoots directories searched in order for read-only game files (i.e. what would be in the .pdx)
+ * @param numAssetRoots number of entries in assetRoots, at most HOST_MAX_ASSET_ROOTS
+ * @param dataRoot directory used for the game's data directory (kFileReadData / kFileWrite)
+ */
+void hostInit(const char** assetRoots, int numAssetRoots, const char* dataRoot);
+void hostShutdown(void);
+
+/** The PlaydateAPI to hand to eventHandler. */
+PlaydateAPI* hostGetApi(void);
+
+/** Sets the input returned by pd->system calls during the next hostRunFrame(). */
+void hostSetInput(const HostInput* input);
+
+/**
+ * Runs one pass of the registered update callback, then flushes updated rows (if requested)
+ * and advances the virtual audio clock by one frame.
+ *
+ * @return the update callback's return value, or -1 if no update callback is registered
+ */
+int hostRunFrame(void);
+
+/** Simulates the user selecting the system menu item at index (in order of creation); toggles/cycles its value and invokes its callback. */
+void hostActivateMenuItem(int index);
+int hostGetMenuItemCount(void);
+
+const HostStats* hostGetStats(void);
+/** Zeroes the stats, except for liveBytes (peakBytes restarts from it) and errors. */
+void hostResetStats(void);
+
+/** Monotonic wall clock in nanoseconds. */
+uint64_t hostNowNanos(void);
+
+/** The current display refresh rate, as last set by pd->display->setRefreshRate (0 means "as fast as possible"). */
+float hostGetRefreshRate(void);
+
+/** The frame buffer as last flushed to the (virtual) display. */
+const uint8_t* hostGetDisplayFrame(void);
+
+/**
+ * Resolves a game-relative path against the asset roots, trying each of the given extensions in turn
+ * (an empty string tries the path as given), skipping any whose host path doesn't fit in outPath.
+ *
+ * @return 1 and writes the host path into outPath if a file was found; otherwise 0
+ */
+int hostResolveAssetPath(const char* path, const char** extensions, int numExtensions, char* outPath, size_t outPathSize);
+
+// - internal, shared between the host's translation units
+
+void* hostAlloc(size_t size);
+void* hostRealloc(void* ptr, size_t size);
+void hostFree(void* ptr);
+void hostCountFileOpen(void);
+void hostGraphicsInit(void);
+void hostGraphicsShutdown(void);
+int hostGraphicsFlush(void);
+void hostSoundInit(void);
+void hostSoundShutdown(void);
+void hostSoundTick(float seconds);
+
+extern const struct playdate_graphics hostGraphics;
+extern const struct playdate_sprite hostSprite;
+extern const struct playdate_sound hostSound;
+
+#endif /* pd_host_h */
@@ -0,0 +1,775 @@
+//
+//  bench.c
+//  playdate-hello-world-c-kickstarter
+//
+//  Benchmark harness: drives the game's eventHandler(kEventInit) and then N update() passes
+//  against the headless host runtime with a scripted input pattern, and reports init time, the frames
+//  and time until the first frame's assets and then all assets are loaded, ns/frame and allocations/frame.
+//
+//  With --replay TRACE, the game replays an input trace (see include/input_trace.h) in place of the
+//  scenario's input, from its first frame (warmup included) to the trace's end.
+//
+//  With --globe, the game renders the globe from its map (see proceduralGlobe in main.c) instead of
+//  showing its frames.
+//
+//  Before the game runs, checks a frame arena and a pool (see include/memory_arena.h) used frame after frame make no
+//  heap allocations and count the allocations they refuse; and after it runs, that the game's frame arena never ran out.
+//
+//  With --sprite-path, the game draws through the sprite system (see redrawOnChangeOnly in main.c)
+//  instead of patching frame buffer rows, and each frame it displays is compared with the row path's,
+//  run alongside in a child process.
+//
+//  With --text FONT, instead compares drawing text labels through drawText() with a FontBlitter
+//  (N passes over the labels per draw mode), and checks a pass of both draws the same pixels.
+//
+//  With --globe-sweep MAP, instead times rendering the globe from MAP (N passes, a degree of rotation
+//  apart) per disc size and scale, against copying a pre-rendered frame, and checks the pixels around
+//  the disc are kept and a full turn renders the same pixels.
+//
+//  usage: <PLAYDATE_GAME_NAME>_bench [--frames N] [--warmup N] [--scenario idle|crank|buttons|mixed|map]
+//                                    [--assets DIR]... [--data DIR] [--replay TRACE] [--globe]
+//                                    [--sprite-path] [--text FONT] [--globe-sweep MAP]
+//
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "pd_api.h"
+
+#include "pd_host.h"
+#include "asset_loader.h"
+#include "font_blitter.h"
+#include "globe_renderer.h"
+#include "memory_arena.h"
+
+
+#ifndef HOST_DEFAULT_ASSET_ROOT
+#define HOST_DEFAULT_ASSET_ROOT "src"
+#endif
+#ifndef HOST_DEFAULT_DATA_ROOT
+#define HOST_DEFAULT_DATA_ROOT "host_data"
+#endif
+/** Where the game looks for an input trace to replay, in its data directory (see inputTraceReplayPath in main.c) */
+#define REPLAY_TRACE_NAME "input_replay.pdtrace"
+
+/** The most frames the game's assets may take to load before the run fails */
+#define BENCH_MAX_LOAD_FRAMES 10000
+
+/** The game's sprite mode (main.c), set by --globe */
+extern int proceduralGlobe;
+/** The game's drawing path (main.c): 0 (the sprite system's) by --sprite-path */
+extern int redrawOnChangeOnly;
+/** The game's asset loader (main.c), and the priority of its jobs the first frame needs (kLoadPriorityFirstFrame) */
+extern AssetLoader assetLoader;
+/** In main.c */
+extern MemoryArena frameArena;
+#define LOAD_PRIORITY_FIRST_FRAME 0
+
+typedef enum {
+	kScenarioIdle,
+	kScenarioCrank,
+	kScenarioButtons,
+	kScenarioMixed,
+	kScenarioMap
+} Scenario;
+
+static const char* scenarioNames[] = { "idle", "crank", "buttons", "mixed", "map" };
+
+
+/**
+ * Fills in the scripted input for frame i. Deterministic, so runs are comparable.
+ *
+ * - idle: crank docked, nothing pressed
+ * - crank: crank undocked and turning forward 10 degrees per frame
+ * - buttons: A/B mashed every few frames (B also tapped within a frame) while the D-pad cycles through all directions
+ * - mixed: repeating 600-frame cycle of crank spins (both directions), button mashing, D-pad switching, menu toggles and idle
+ * - map: A and B pressed together once (entering the map viewer), then a repeating 400-frame cycle of zooming in,
+ *   panning in all directions (diagonally too), zooming out and idle
+ */
+static void scenarioInput(Scenario scenario, int i, HostInput* in, float* crankAngle) {
+	static const PDButtons dpad[4] = { kButtonUp, kButtonRight, kButtonDown, kButtonLeft };
+
+	memset(in, 0, sizeof(HostInput));
+	in->crankDocked = 1;
+
+	switch (scenario) {
+		case kScenarioIdle:
+			break;
+
+		case kScenarioCrank:
+			in->crankDocked = 0;
+			in->crankChange = 10.0f;
+			break;
+
+		case kScenarioButtons:
+			in->current = (PDButtons)(((i % 6) < 2 ? kButtonA : 0) | ((i % 6) == 3 ? kButtonB : 0) | dpad[(i / 10) % 4]);
+			if ((i % 6) == 5) {
+				in->pushed = kButtonB;
+				in->released = kButtonB;
+			}
+			break;
+
+		case kScenarioMixed: {
+			int t = i % 600;
+			in->crankDocked = 0;
+			if (t < 100) {
+				in->crankChange = 12.0f;
+			}
+			else if (t < 200) {
+				in->crankChange = -20.0f;
+			}
+			else if (t < 300) {
+				in->current = (PDButtons)(((t % 4) < 2) ? ((t % 8) < 4 ? kButtonA : kButtonB) : 0);
+			}
+			else if (t < 400) {
+				in->current = dpad[((t - 300) / 25) % 4];
+			}
+			break;
+		}
+
+		case kScenarioMap: {
+			static const PDButtons pan[4] = { kButtonRight, kButtonDown | kButtonLeft, kButtonUp, kButtonRight | kButtonDown };
+			int t = i % 400;
+			in->crankDocked = 0;
+			if (i < 2) {
+				in->current = (i == 0) ? kButtonA : (kButtonA | kButtonB);
+			}
+			else if (t < 20) {
+				in->crankChange = 5.0f;
+			}
+			else if (t < 300) {
+				in->current = pan[(t - 20) / 70];
+			}
+			else if (t < 320) {
+				in->crankChange = -5.0f;
+			}
+			break;
+		}
+	}
+
+	*crankAngle += in->crankChange;
+	while (*crankAngle >= 360.0f) {
+		*crankAngle -= 360.0f;
+	}
+	while (*crankAngle < 0.0f) {
+		*crankAngle += 360.0f;
+	}
+	in->crankAngle = *crankAngle;
+}
+
+/** Menu toggles for the mixed scenario: flips the first menu item (e.g. "say hello!") off and back on. */
+static void scenarioMenu(Scenario scenario, int i) {
+	if (scenario == kScenarioMixed && hostGetMenuItemCount() > 0) {
+		int t = i % 600;
+		if (t == 450 || t == 550) {
+			hostActivateMenuItem(0);
+		}
+	}
+}
+
+/** The text labels of --text: demo_inputs' labels, where it draws them */
+static const struct {
+	const char* text;
+	int x;
+	int y;
+} textLabels[] = {
+	{ "D-pad", 40, 5 }, { "A", 220, 5 }, { "B", 170, 5 }, { "Crank", 325, 5 },
+	{ "Accelerometer", 165, 150 }, { "X", 195, 170 }, { "Y", 195, 190 }, { "Z", 195, 210 }
+};
+#define NUM_TEXT_LABELS (int)(sizeof(textLabels) / sizeof(textLabels[0]))
+
+/**
+ * Draws the text labels once, through drawText() (if blitter is NULL) or blitter, over a screen cleared to background.
+ */
+static void drawTextLabels(PlaydateAPI* api, FontBlitter* blitter) {
+	for (int l = 0; l < NUM_TEXT_LABELS; l++) {
+		const char* text = textLabels[l].text;
+		if (blitter != NULL) {
+			fontBlitterDrawLabel(api, blitter, text, strlen(text), textLabels[l].x, textLabels[l].y);
+		}
+		else {
+			api->graphics->drawText(text, strlen(text), kASCIIEncoding, textLabels[l].x, textLabels[l].y);
+		}
+	}
+}
+
+/**
+ * Draws the text labels through drawText() (if blitter is NULL) or blitter, over a screen cleared to background: once,
+ * kept as drawn in frame (a single pass, so modes that flip pixels don't cancel out), then passes times.
+ *
+ * @return ns per label drawn
+ */
+static double benchTextLabels(PlaydateAPI* api, LCDFont* font, FontBlitter* blitter, LCDBitmapDrawMode mode, LCDColor background, int passes, uint8_t* frame) {
+	api->graphics->clear(background);
+	api->graphics->setFont(font);
+	api->graphics->setDrawMode(mode);
+	if (blitter != NULL) {
+		fontBlitterSetDrawMode(blitter, mode);
+	}
+	drawTextLabels(api, blitter);
+	memcpy(frame, api->graphics->getFrame(), LCD_ROWS * LCD_ROWSIZE);
+
+	uint64_t start = hostNowNanos();
+	for (int i = 0; i < passes; i++) {
+		drawTextLabels(api, blitter);
+	}
+	uint64_t nanos = hostNowNanos() - start;
+
+	api->graphics->setDrawMode(kDrawModeCopy);
+	return (double)nanos / ((double)passes * NUM_TEXT_LABELS);
+}
+
+/**
+ * --text: compares drawText() with a FontBlitter on the text labels, per draw mode.
+ *
+ * @return 0 if both draw the same pixels in all modes; otherwise 1
+ */
+static int benchText(PlaydateAPI* api, const char* fontPath, int passes) {
+	static const struct {
+		const char* name;
+		LCDBitmapDrawMode mode;
+		LCDColor background;
+	} modes[] = {
+		{ "copy", kDrawModeCopy, kColorWhite },
+		{ "fill black", kDrawModeFillBlack, kColorWhite },
+		{ "fill white", kDrawModeFillWhite, kColorBlack },
+		{ "XOR", kDrawModeXOR, kColorBlack },
+		{ "NXOR", kDrawModeNXOR, kColorWhite },
+		{ "inverted", kDrawModeInverted, kColorBlack },
+		{ "white transp.", kDrawModeWhiteTransparent, kColorWhite },
+		{ "black transp.", kDrawModeBlackTransparent, kColorBlack }
+	};
+	static uint8_t drawn[LCD_ROWS * LCD_ROWSIZE];
+	static uint8_t blitted[LCD_ROWS * LCD_ROWSIZE];
+
+	const char* err = NULL;
+	LCDFont* font = api->graphics->loadFont(fontPath, &err);
+	if (font == NULL) {
+		fprintf(stderr, "bench: error loading font %s: %s\n", fontPath, err != NULL ? err : "?");
+		return 1;
+	}
+	FontBlitter blitter;
+	if (fontBlitterInit(api, &blitter, font) == 0) {
+		fprintf(stderr, "bench: %s can't be blitted; comparing drawText() with itself\n", fontPath);
+	}
+
+	int mismatches = 0;
+	printf("text:             %i labels x %i passes per mode, %s\n", NUM_TEXT_LABELS, passes, fontPath);
+	for (int m = 0; m < (int)(sizeof(modes) / sizeof(modes[0])); m++) {
+		double drawTextNanos = benchTextLabels(api, font, NULL, modes[m].mode, modes[m].background, passes, drawn);
+		double blitterNanos = benchTextLabels(api, font, &blitter, modes[m].mode, modes[m].background, passes, blitted);
+		int same = memcmp(drawn, blitted, sizeof(drawn)) == 0;
+		mismatches += !same;
+		printf("  %-14s  drawText() %.0f ns/label, blitter %.0f ns/label (%.1fx), %s\n",
+			modes[m].name, drawTextNanos, blitterNanos, blitterNanos > 0.0 ? drawTextNanos / blitterNanos : 0.0,
+			same ? "same pixels" : "PIXELS DIFFER");
+	}
+	printf("  blitter:        %u runs blitted, %u through drawText(), %u label cache hits, %u misses\n",
+		(unsigned int)blitter.stats.blits, (unsigned int)blitter.stats.fallbacks,
+		(unsigned int)blitter.stats.labelHits, (unsigned int)blitter.stats.labelMisses);
+
+	fontBlitterFree(api, &blitter);
+	return mismatches > 0 ? 1 : 0;
+}
+
+/** The discs of --globe-sweep: the game's (see GLOBE_RADIUS in main.c), at both scales, then smaller and larger ones */
+static const struct {
+	int radius;
+	int scale;
+} globeSettings[] = { { 106, 1 }, { 106, 2 }, { 53, 1 }, { 120, 1 }, { 120, 2 } };
+#define NUM_GLOBE_SETTINGS (int)(sizeof(globeSettings) / sizeof(globeSettings[0]))
+/** The disc's center of --globe-sweep (see GLOBE_CENTER_X/Y in main.c) */
+#define GLOBE_SWEEP_CENTER_X 198
+#define GLOBE_SWEEP_CENTER_Y 120
+
+/**
+ * @return the number of pixels of image outside the disc of radius (past a pixel of rounding) at the center that
+ * aren't background
+ */
+static int countGlobeBackgroundChanges(const uint8_t* image, int radius, uint8_t background) {
+	int changes = 0;
+	for (int y = 0; y < LCD_ROWS; y++) {
+		for (int x = 0; x < LCD_COLUMNS; x++) {
+			int dx = 2 * (x - GLOBE_SWEEP_CENTER_X) + 1;
+			int dy = 2 * (y - GLOBE_SWEEP_CENTER_Y) + 1;
+			int outside = dx * dx + dy * dy > 4 * (radius + 1) * (radius + 1);
+			int bit = (image[y * LCD_ROWSIZE + x / 8] >> (7 - x % 8)) & 1;
+			changes += outside && bit != (background & 1);
+		}
+	}
+	return changes;
+}
+
+/**
+ * --globe-sweep: times rendering the globe from the map at mapPath per disc of globeSettings, passes times a degree of
+ * rotation apart, against copying a screen-sized frame into the frame buffer (what showing a pre-rendered frame takes).
+ *
+ * @return 0 if all discs render keeping the pixels around them, and the same pixels a full turn apart; otherwise 1
+ */
+static int benchGlobe(PlaydateAPI* api, const char* mapPath, int passes) {
+	static uint8_t image[LCD_ROWS * LCD_ROWSIZE];
+	static uint8_t turned[LCD_ROWS * LCD_ROWSIZE];
+
+	const char* err = NULL;
+	LCDBitmap* map = api->graphics->loadBitmap(mapPath, &err);
+	if (map == NULL) {
+		fprintf(stderr, "bench: error loading map %s: %s\n", mapPath, err != NULL ? err : "?");
+		return 1;
+	}
+	int mapWidth, mapHeight;
+	api->graphics->getBitmapData(map, &mapWidth, &mapHeight, NULL, NULL, NULL);
+
+	// the baseline: a frame's rows copied into the frame buffer
+	memset(turned, 0x55, sizeof(turned));
+	uint64_t start = hostNowNanos();
+	for (int i = 0; i < passes; i++) {
+		uint8_t* frame = api->graphics->getFrame();
+		for (int row = 0; row < LCD_ROWS; row++) {
+			memcpy(frame + row * LCD_ROWSIZE, turned + row * LCD_ROWSIZE, LCD_COLUMNS / 8);
+		}
+		turned[i % sizeof(turned)] ^= 1; // (so the copies aren't hoisted)
+	}
+	double copyNanos = (double)(hostNowNanos() - start) / passes;
+
+	int failures = 0;
+	printf("globe:            %ix%i map, %i passes per disc, frame copy %.0f ns/frame\n", mapWidth, mapHeight, passes, copyNanos);
+	for (int g = 0; g < NUM_GLOBE_SETTINGS; g++) {
+		MemoryArena arena;
+		GlobeRenderer globe;
+		size_t tableSize = globeRendererTableSize(globeSettings[g].radius, globeSettings[g].scale);
+		if (memoryArenaInit(api, &arena, tableSize) == 0 || globeRendererInit(api, &globe, map, globeSettings[g].radius, globeSettings[g].scale, &arena) == 0) {
+			fprintf(stderr, "bench: error setting up the globe renderer, radius %i, scale %i\n", globeSettings[g].radius, globeSettings[g].scale);
+			memoryArenaFree(api, &arena);
+			failures++;
+			continue;
+		}
+
+		memset(image, 0xff, sizeof(image));
+		start = hostNowNanos();
+		for (int i = 0; i < passes; i++) {
+			globeRendererDraw(&globe, (float)i, image, LCD_ROWSIZE, LCD_ROWS, GLOBE_SWEEP_CENTER_X, GLOBE_SWEEP_CENTER_Y);
+		}
+		double drawNanos = (double)(hostNowNanos() - start) / passes;
+
+		int changes = countGlobeBackgroundChanges(image, globe.radius, 0xff);
+		globeRendererDraw(&globe, 90.0f, image, LCD_ROWSIZE, LCD_ROWS, GLOBE_SWEEP_CENTER_X, GLOBE_SWEEP_CENTER_Y);
+		memcpy(turned, image, sizeof(turned));
+		globeRendererDraw(&globe, 90.0f + 360.0f, turned, LCD_ROWSIZE, LCD_ROWS, GLOBE_SWEEP_CENTER_X, GLOBE_SWEEP_CENTER_Y);
+		int same = memcmp(image, turned, sizeof(image)) == 0;
+		failures += changes > 0 || !same;
+		printf("  radius %3i x%i    %.0f ns/frame (%.1fx a frame copy), %u samples, %u bytes of table, %s, %s\n",
+			globe.radius, globe.scale, drawNanos, copyNanos > 0.0 ? drawNanos / copyNanos : 0.0,
+			(unsigned int)(globe.stats.samples / globe.stats.draws), (unsigned int)tableSize,
+			changes == 0 ? "background kept" : "BACKGROUND CHANGED", same ? "turns around" : "TURN DIFFERS");
+		memoryArenaFree(api, &arena);
+	}
+
+	api->graphics->freeBitmap(map);
+	return failures > 0 ? 1 : 0;
+}
+
+#define ALLOCATOR_CHECK_ARENA_SIZE 1024
+#define ALLOCATOR_CHECK_BLOCK_SIZE 24
+#define ALLOCATOR_CHECK_BLOCKS 16
+#define ALLOCATOR_CHECK_SCRATCH_SIZE 256
+
+/**
+ * Runs frames of a frame arena's use (released back to the pool carved from its start, then scratch allocations until
+ * one is refused) and the pool's (blocks allocated until one is refused, half freed, then the rest reset), and checks
+ * they made no heap allocations after init and counted every refusal.
+ *
+ * @return 0 on success; otherwise 1
+ */
+static int checkAllocators(PlaydateAPI* api, int frames) {
+	MemoryArena arena;
+	MemoryPool pool;
+	if (memoryArenaInit(api, &arena, ALLOCATOR_CHECK_ARENA_SIZE) == 0
+		|| memoryPoolInit(&pool, &arena, ALLOCATOR_CHECK_BLOCK_SIZE, ALLOCATOR_CHECK_BLOCKS) == 0) {
+		fprintf(stderr, "bench: error setting up the allocator check\n");
+		memoryArenaFree(api, &arena);
+		return 1;
+	}
+	size_t poolEnd = memoryArenaMark(&arena);
+	void* blocks[ALLOCATOR_CHECK_BLOCKS];
+	uint64_t allocsBefore = hostGetStats()->allocCount;
+	uint32_t arenaRefusals = 0;
+
+	for (int f = 0; f < frames; f++) {
+		memoryArenaRelease(&arena, poolEnd);
+		while (memoryArenaAlloc(&arena, ALLOCATOR_CHECK_SCRATCH_SIZE) != NULL) {
+		}
+		arenaRefusals++;
+
+		for (int b = 0; b < ALLOCATOR_CHECK_BLOCKS; b++) {
+			blocks[b] = memoryPoolAlloc(&pool);
+		}
+		memoryPoolAlloc(&pool);
+		for (int b = 0; b < ALLOCATOR_CHECK_BLOCKS; b += 2) {
+			memoryPoolFree(&pool, blocks[b]);
+		}
+		memoryPoolReset(&pool);
+	}
+
+	uint64_t allocs = hostGetStats()->allocCount - allocsBefore;
+	int ok = allocs == 0 && arena.stats.overflows == arenaRefusals && pool.overflows == (uint32_t)frames
+		&& pool.peakLive == ALLOCATOR_CHECK_BLOCKS;
+	printf("allocators:       frame arena and pool, %.3f heap allocs/frame over %i frames, %u + %u refusals counted%s\n",
+		(double)allocs / frames, frames, (unsigned int)arena.stats.overflows, (unsigned int)pool.overflows,
+		ok ? "" : " (CHECK FAILED)");
+	memoryArenaFree(api, &arena);
+	return ok ? 0 : 1;
+}
+
+/**
+ * --sprite-path: the pipe the row path's run (a child process) passes the hash of each frame it displays over to the
+ * sprite path's run, which compares its own (-1: not comparing)
+ */
+static int frameHashPipe = -1;
+/** 1 in the row path's run */
+static int rowPathRun = 0;
+static int framesCompared = 0;
+static int framesDiffering = 0;
+static int firstDifferingFrame = -1;
+
+/**
+ * @return the FNV-1a hash of the visible bytes of the frame last displayed
+ */
+static uint64_t hashDisplayFrame(void) {
+	const uint8_t* frame = hostGetDisplayFrame();
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (int y = 0; y < LCD_ROWS; y++) {
+		for (int x = 0; x < LCD_COLUMNS / 8; x++) {
+			hash = (hash ^ frame[y * LCD_ROWSIZE + x]) * 0x100000001b3ull;
+		}
+	}
+	return hash;
+}
+
+/**
+ * --sprite-path: passes on (in the row path's run) or compares (in the sprite path's) the frame displayed by frame i.
+ */
+static void compareDisplayFrame(int i) {
+	if (frameHashPipe < 0) {
+		return;
+	}
+	uint64_t hash = hashDisplayFrame();
+	if (rowPathRun) {
+		if (write(frameHashPipe, &hash, sizeof(hash)) != (ssize_t)sizeof(hash)) {
+			exit(1);
+		}
+		return;
+	}
+
+	uint64_t rowPathHash;
+	if (read(frameHashPipe, &rowPathHash, sizeof(rowPathHash)) != (ssize_t)sizeof(rowPathHash)) {
+		// (the row path's run ended early: the frames past it count as differing)
+		close(frameHashPipe);
+		frameHashPipe = -1;
+		rowPathHash = ~hash;
+	}
+	framesCompared++;
+	if (rowPathHash != hash) {
+		framesDiffering++;
+		if (firstDifferingFrame < 0) {
+			firstDifferingFrame = i;
+		}
+	}
+}
+
+/**
+ * Copies the file at from to to.
+ *
+ * @return 1 on success; otherwise 0
+ */
+static int copyFile(const char* from, const char* to) {
+	FILE* in = fopen(from, "rb");
+	if (in == NULL) {
+		return 0;
+	}
+	FILE* out = fopen(to, "wb");
+	if (out == NULL) {
+		fclose(in);
+		return 0;
+	}
+	char buffer[4096];
+	size_t n;
+	int ok = 1;
+	while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+		ok &= fwrite(buffer, 1, n, out) == n;
+	}
+	fclose(in);
+	ok &= fclose(out) == 0;
+	return ok;
+}
+
+static int compareU64(const void* a, const void* b) {
+	uint64_t x = *(const uint64_t*)a;
+	uint64_t y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+static void usage(const char* argv0) {
+	fprintf(stderr,
+		"usage: %s [--frames N] [--warmup N] [--scenario idle|crank|buttons|mixed|map] [--assets DIR]... [--data DIR] [--replay TRACE] [--globe]\n"
+		"       [--sprite-path] [--text FONT] [--globe-sweep MAP]\n",
+		argv0);
+}
+
+int main(int argc, char** argv) {
+	int frames = 10000;
+	int warmup = 100;
+	Scenario scenario = kScenarioMixed;
+	const char* assetRoots[HOST_MAX_ASSET_ROOTS];
+	int numAssetRoots = 0;
+	const char* dataRoot = HOST_DEFAULT_DATA_ROOT;
+	const char* textFontPath = NULL;
+	const char* globeMapPath = NULL;
+	const char* replayPath = NULL;
+	int spritePath = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			frames = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+			warmup = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+			const char* name = argv[++i];
+			int found = 0;
+			for (int s = 0; s < (int)(sizeof(scenarioNames) / sizeof(scenarioNames[0])); s++) {
+				if (strcmp(name, scenarioNames[s]) == 0) {
+					scenario = (Scenario)s;
+					found = 1;
+				}
+			}
+			if (!found) {
+				usage(argv[0]);
+				return 2;
+			}
+		}
+		else if (strcmp(argv[i], "--assets") == 0 && i + 1 < argc) {
+			if (numAssetRoots < HOST_MAX_ASSET_ROOTS) {
+				assetRoots[numAssetRoots++] = argv[++i];
+			}
+		}
+		else if (strcmp(argv[i], "--data") == 0 && i + 1 < argc) {
+			dataRoot = argv[++i];
+		}
+		else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			replayPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--globe") == 0) {
+			proceduralGlobe = 1;
+		}
+		else if (strcmp(argv[i], "--sprite-path") == 0) {
+			spritePath = 1;
+		}
+		else if (strcmp(argv[i], "--text") == 0 && i + 1 < argc) {
+			textFontPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--globe-sweep") == 0 && i + 1 < argc) {
+			globeMapPath = argv[++i];
+		}
+		else {
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	if (frames <= 0 || warmup < 0) {
+		usage(argv[0]);
+		return 2;
+	}
+	if (numAssetRoots == 0) {
+		assetRoots[numAssetRoots++] = HOST_DEFAULT_ASSET_ROOT;
+	}
+
+	hostInit(assetRoots, numAssetRoots, dataRoot);
+	PlaydateAPI* api = hostGetApi();
+
+	// (the trace goes where the game looks for one, for this run only)
+	char replayTracePath[1024];
+	snprintf(replayTracePath, sizeof(replayTracePath), "%s/%s", dataRoot, REPLAY_TRACE_NAME);
+	if (replayPath != NULL && !copyFile(replayPath, replayTracePath)) {
+		fprintf(stderr, "bench: error copying %s to %s\n", replayPath, replayTracePath);
+		return 1;
+	}
+
+	if (textFontPath != NULL) {
+		int result = benchText(api, textFontPath, frames);
+		hostShutdown();
+		return result;
+	}
+	if (globeMapPath != NULL) {
+		int result = benchGlobe(api, globeMapPath, frames);
+		hostShutdown();
+		return result;
+	}
+
+	if (checkAllocators(api, frames) != 0) {
+		hostShutdown();
+		return 1;
+	}
+
+	// --sprite-path: the row path runs alongside (in a child process, quietly), for each frame displayed to be compared
+	pid_t rowPathPid = -1;
+	if (spritePath) {
+		int fds[2];
+		if (pipe(fds) != 0 || (rowPathPid = fork()) < 0) {
+			fprintf(stderr, "bench: error starting the row path's run\n");
+			return 1;
+		}
+		rowPathRun = rowPathPid == 0;
+		frameHashPipe = rowPathRun ? fds[1] : fds[0];
+		close(rowPathRun ? fds[0] : fds[1]);
+		if (rowPathRun) {
+			freopen("/dev/null", "w", stdout);
+			freopen("/dev/null", "w", stderr); // (its errors fail its run, reported by the sprite path's)
+		}
+		else {
+			redrawOnChangeOnly = 0;
+		}
+	}
+
+	// init, then the frames until the asset loader is done: the first frame's assets, then the rest (see assetLoader in
+	// main.c), with the scenario's input from the first frame on
+	uint64_t t0 = hostNowNanos();
+	eventHandler(api, kEventInit, 0);
+	uint64_t initNanos = hostNowNanos() - t0;
+	uint64_t loadNanos = initNanos;
+	uint64_t firstFrameNanos = 0;
+	int firstFrame = -1;
+	int frame = 0;
+	HostInput in;
+	float crankAngle = 0.0f;
+	while (assetLoaderIsDone(&assetLoader, INT_MAX) == 0 && frame < BENCH_MAX_LOAD_FRAMES) {
+		if (firstFrame < 0 && assetLoaderIsDone(&assetLoader, LOAD_PRIORITY_FIRST_FRAME)) {
+			firstFrame = frame;
+			firstFrameNanos = loadNanos;
+		}
+		scenarioInput(scenario, frame, &in, &crankAngle);
+		hostSetInput(&in);
+		scenarioMenu(scenario, frame);
+		uint64_t start = hostNowNanos();
+		hostRunFrame();
+		loadNanos += hostNowNanos() - start;
+		compareDisplayFrame(frame);
+		frame++;
+	}
+	if (firstFrame < 0) {
+		firstFrame = frame;
+		firstFrameNanos = loadNanos;
+	}
+	int loadFrames = frame;
+	HostStats loadStats = *hostGetStats();
+	if (replayPath != NULL && rowPathRun == 0) {
+		// (with --sprite-path, the row path's run has read it too: it displayed a frame after its kEventInit)
+		remove(replayTracePath);
+	}
+
+	if (loadStats.errors > 0) {
+		fprintf(stderr, "bench: %llu error(s) during init and loading; check --assets\n", (unsigned long long)loadStats.errors);
+		return 1;
+	}
+	if (assetLoaderIsDone(&assetLoader, INT_MAX) == 0) {
+		fprintf(stderr, "bench: assets still loading after %i frames\n", loadFrames);
+		return 1;
+	}
+
+	// warmup (not measured; the loading frames count towards it)
+	for (; frame < warmup; frame++) {
+		scenarioInput(scenario, frame, &in, &crankAngle);
+		hostSetInput(&in);
+		scenarioMenu(scenario, frame);
+		hostRunFrame();
+		compareDisplayFrame(frame);
+	}
+	int warmupFrames = frame;
+
+	// measured frames
+	uint64_t* samples = malloc((size_t)frames * sizeof(uint64_t));
+	if (samples == NULL) {
+		return 1;
+	}
+	hostResetStats();
+	uint64_t total = 0;
+	for (int i = 0; i < frames; i++) {
+		scenarioInput(scenario, warmupFrames + i, &in, &crankAngle);
+		hostSetInput(&in);
+		scenarioMenu(scenario, warmupFrames + i);
+
+		uint64_t start = hostNowNanos();
+		hostRunFrame();
+		samples[i] = hostNowNanos() - start;
+		total += samples[i];
+		compareDisplayFrame(warmupFrames + i);
+	}
+	HostStats frameStats = *hostGetStats();
+	MemoryArenaStats frameArenaStats = frameArena.stats;
+	size_t frameArenaCapacity = frameArena.capacity;
+
+	eventHandler(api, kEventTerminate, 0);
+	hostShutdown();
+
+	qsort(samples, (size_t)frames, sizeof(uint64_t), compareU64);
+
+	if (replayPath != NULL) {
+		printf("scenario:         replay of %s (then %s)\n", replayPath, scenarioNames[scenario]);
+	}
+	else {
+		printf("scenario:         %s\n", scenarioNames[scenario]);
+	}
+	if (proceduralGlobe) {
+		printf("sprite:           procedural globe\n");
+	}
+	int pathsDiffer = 0;
+	if (spritePath && rowPathRun == 0) {
+		int status = 0;
+		waitpid(rowPathPid, &status, 0);
+		int totalFrames = warmupFrames + frames;
+		pathsDiffer = framesDiffering > 0 || framesCompared != totalFrames || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+		if (pathsDiffer == 0) {
+			printf("drawing:          sprite path, all %i frames displayed the same as the row path's\n", totalFrames);
+		}
+		else {
+			printf("drawing:          sprite path, FRAMES DIFFER from the row path's: %i of %i (first: frame %i)%s\n",
+				framesDiffering, framesCompared, firstDifferingFrame,
+				(WIFEXITED(status) && WEXITSTATUS(status) == 0) ? "" : ", the row path's run failed");
+		}
+	}
+	printf("frames:           %i (+%i warmup)\n", frames, warmupFrames);
+	printf("init:             %.3f ms (kEventInit), first frame ready after %i update(s), %.3f ms\n",
+		initNanos / 1e6, firstFrame, firstFrameNanos / 1e6);
+	printf("loading:          done after %i update(s), %.3f ms, %llu allocs, %llu bytes, %llu file opens\n",
+		loadFrames, loadNanos / 1e6,
+		(unsigned long long)loadStats.allocCount,
+		(unsigned long long)loadStats.allocBytes,
+		(unsigned long long)loadStats.fileOpens);
+	printf("update:           %.0f ns/frame mean, %llu p50, %llu p95, %llu p99, %llu max\n",
+		(double)total / frames,
+		(unsigned long long)samples[frames / 2],
+		(unsigned long long)samples[(int)(frames * 0.95)],
+		(unsigned long long)samples[(int)(frames * 0.99)],
+		(unsigned long long)samples[frames - 1]);
+	printf("allocs/frame:     %.3f (%.1f bytes/frame)\n",
+		(double)frameStats.allocCount / frames,
+		(double)frameStats.allocBytes / frames);
+	printf("display updates:  %.1f%% of frames, %.1f rows flushed/frame\n",
+		100.0 * frameStats.framesDisplayed / frames,
+		(double)frameStats.rowsFlushed / frames);
+	printf("memory:           %llu bytes live after loading, %llu bytes peak during frames\n",
+		(unsigned long long)loadStats.liveBytes,
+		(unsigned long long)frameStats.peakBytes);
+	printf("frame arena:      %u of %u bytes peak, %u overflow(s)\n",
+		(unsigned int)frameArenaStats.peak, (unsigned int)frameArenaCapacity, (unsigned int)frameArenaStats.overflows);
+	if (frameStats.errors > 0) {
+		printf("errors:           %llu\n", (unsigned long long)frameStats.errors);
+	}
+
+	free(samples);
+	return (frameStats.errors > 0 || pathsDiffer || frameArenaStats.overflows > 0) ? 1 : 0;
+}
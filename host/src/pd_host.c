@@ -0,0 +1,907 @@
+//
+//  pd_host.c
+//  playdate-hello-world-c-kickstarter
+//
+//  Host runtime core: allocator accounting, pd->system, pd->display and pd->file tables,
+//  scripted input and the per-frame driver.
+//
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pd_host.h"
+
+
+#define HOST_MAX_MENU_ITEMS 3
+#define HOST_MAX_MENU_OPTIONS 8
+#define HOST_PATH_MAX 1024
+
+/** Allocation header; keeps block size so live/peak bytes can be tracked. Sized to preserve max alignment. */
+typedef union {
+	size_t size;
+	max_align_t align;
+} HostAllocHeader;
+
+typedef enum {
+	kHostMenuItemAction,
+	kHostMenuItemCheckmark,
+	kHostMenuItemOptions
+} HostMenuItemKind;
+
+struct PDMenuItem {
+	HostMenuItemKind kind;
+	char title[64];
+	int value;
+	int optionsCount;
+	const char* optionTitles[HOST_MAX_MENU_OPTIONS];
+	PDMenuItemCallbackFunction* callback;
+	void* userdata;
+};
+
+typedef struct {
+	FILE* fp;
+} HostFile;
+
+static HostStats stats;
+
+static char assetRoots[HOST_MAX_ASSET_ROOTS][HOST_PATH_MAX];
+static int numAssetRoots = 0;
+static char dataRoot[HOST_PATH_MAX];
+
+static HostInput input;
+static PDButtons btnsPrevHost;
+
+static PDCallbackFunction* updateCallback = NULL;
+static void* updateUserdata = NULL;
+
+static PDButtonCallbackFunction* buttonCallback = NULL;
+static void* buttonUserdata = NULL;
+static int buttonQueueSize = 0;
+
+static PDMenuItem* menuItems[HOST_MAX_MENU_ITEMS];
+static int numMenuItems = 0;
+
+static PDPeripherals peripherals = kNone;
+static float refreshRate = 30.0f;
+
+static uint64_t startNanos = 0;
+static uint64_t elapsedNanos = 0;
+
+static const char* fileErr = NULL;
+
+
+uint64_t hostNowNanos(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+
+// - allocator accounting
+
+void* hostAlloc(size_t size) {
+	return hostRealloc(NULL, size);
+}
+
+void hostFree(void* ptr) {
+	hostRealloc(ptr, 0);
+}
+
+void* hostRealloc(void* ptr, size_t size) {
+	HostAllocHeader* header = ptr != NULL ? ((HostAllocHeader*)ptr) - 1 : NULL;
+
+	if (size == 0) {
+		if (header != NULL) {
+			stats.freeCount++;
+			stats.liveBytes -= header->size;
+			free(header);
+		}
+		return NULL;
+	}
+
+	size_t prevSize = header != NULL ? header->size : 0;
+	HostAllocHeader* next = realloc(header, sizeof(HostAllocHeader) + size);
+	if (next == NULL) {
+		return NULL;
+	}
+	next->size = size;
+
+	// a realloc that has to grow counts as a heap allocation too; it is what the frame loop should avoid either way
+	if (header == NULL || size > prevSize) {
+		stats.allocCount++;
+		stats.allocBytes += size - prevSize;
+	}
+	stats.liveBytes = stats.liveBytes - prevSize + size;
+	if (stats.liveBytes > stats.peakBytes) {
+		stats.peakBytes = stats.liveBytes;
+	}
+
+	return next + 1;
+}
+
+void hostCountFileOpen(void) {
+	stats.fileOpens++;
+}
+
+
+// - paths
+
+/**
+ * Writes root/path, then extension, into outPath.
+ *
+ * @return 1 on success; otherwise 0 (it didn't fit; outPath then holds a truncated path, not to be used)
+ */
+static int joinPath(const char* root, const char* path, const char* extension, char* outPath, size_t outPathSize) {
+	int len = snprintf(outPath, outPathSize, "%s/%s%s", root, path, extension);
+	return len >= 0 && (size_t)len < outPathSize;
+}
+
+int hostResolveAssetPath(const char* path, const char** extensions, int numExtensions, char* outPath, size_t outPathSize) {
+	static const char* noExtension[] = { "" };
+	if (extensions == NULL || numExtensions <= 0) {
+		extensions = noExtension;
+		numExtensions = 1;
+	}
+
+	for (int r = 0; r < numAssetRoots; r++) {
+		for (int e = 0; e < numExtensions; e++) {
+			struct stat st;
+			if (!joinPath(assetRoots[r], path, extensions[e], outPath, outPathSize)) {
+				continue;
+			}
+			if (stat(outPath, &st) == 0 && S_ISREG(st.st_mode)) {
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @return 1 and writes the host path of a path in the data directory into outPath; otherwise 0 (it didn't fit), and
+ * sets fileErr
+ */
+static int dataPath(const char* path, char* outPath, size_t outPathSize) {
+	if (!joinPath(dataRoot, path, "", outPath, outPathSize)) {
+		fileErr = "path too long";
+		return 0;
+	}
+	return 1;
+}
+
+static void makeDirs(const char* path) {
+	char buf[HOST_PATH_MAX];
+	snprintf(buf, sizeof(buf), "%s", path);
+	for (char* p = buf + 1; *p != '\0'; p++) {
+		if (*p == '/') {
+			*p = '\0';
+			mkdir(buf, 0755);
+			*p = '/';
+		}
+	}
+	mkdir(buf, 0755);
+}
+
+
+// - pd->system
+
+static void* sysRealloc(void* ptr, size_t size) {
+	return hostRealloc(ptr, size);
+}
+
+static int sysVaFormatString(char** outstr, const char* fmt, va_list args) {
+	va_list copy;
+	va_copy(copy, args);
+	int len = vsnprintf(NULL, 0, fmt, copy);
+	va_end(copy);
+
+	*outstr = hostAlloc((size_t)len + 1);
+	if (*outstr == NULL) {
+		return -1;
+	}
+	return vsnprintf(*outstr, (size_t)len + 1, fmt, args);
+}
+
+static int sysFormatString(char** ret, const char* fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	int len = sysVaFormatString(ret, fmt, args);
+	va_end(args);
+	return len;
+}
+
+static void sysLogToConsole(const char* fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	fputc('\n', stderr);
+}
+
+static void sysError(const char* fmt, ...) {
+	stats.errors++;
+
+	va_list args;
+	va_start(args, fmt);
+	fputs("error: ", stderr);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	fputc('\n', stderr);
+}
+
+static PDLanguage sysGetLanguage(void) {
+	return kPDLanguageEnglish;
+}
+
+static unsigned int sysGetCurrentTimeMilliseconds(void) {
+	return (unsigned int)((hostNowNanos() - startNanos) / 1000000ull);
+}
+
+static unsigned int sysGetSecondsSinceEpoch(unsigned int* milliseconds) {
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	if (milliseconds != NULL) {
+		*milliseconds = (unsigned int)(ts.tv_nsec / 1000000);
+	}
+	// Playdate epoch is 2000-01-01
+	return (unsigned int)(ts.tv_sec - 946684800);
+}
+
+static void sysDrawFPS(int x, int y) {
+	// approximates the cost of the system's FPS box without rendering digits
+	hostGraphics.fillRect(x, y, 14, 12, kColorWhite);
+}
+
+static void sysSetUpdateCallback(PDCallbackFunction* update, void* userdata) {
+	updateCallback = update;
+	updateUserdata = userdata;
+}
+
+static void sysSetButtonCallback(PDButtonCallbackFunction* cb, void* buttonud, int queuesize) {
+	buttonCallback = cb;
+	buttonUserdata = buttonud;
+	buttonQueueSize = queuesize;
+}
+
+static void sysGetButtonState(PDButtons* current, PDButtons* pushed, PDButtons* released) {
+	if (current != NULL) {
+		*current = input.current;
+	}
+	if (pushed != NULL) {
+		*pushed = (PDButtons)((input.current & ~btnsPrevHost) | input.pushed);
+	}
+	if (released != NULL) {
+		*released = (PDButtons)((btnsPrevHost & ~input.current) | input.released);
+	}
+}
+
+static void sysSetPeripheralsEnabled(PDPeripherals mask) {
+	peripherals = mask;
+}
+
+static void sysGetAccelerometer(float* outx, float* outy, float* outz) {
+	int enabled = (peripherals & kAccelerometer) != 0;
+	if (outx != NULL) {
+		*outx = enabled ? input.accelX : 0.0f;
+	}
+	if (outy != NULL) {
+		*outy = enabled ? input.accelY : 0.0f;
+	}
+	if (outz != NULL) {
+		*outz = enabled ? input.accelZ : 0.0f;
+	}
+}
+
+static float sysGetCrankChange(void) {
+	return input.crankDocked ? 0.0f : input.crankChange;
+}
+
+static float sysGetCrankAngle(void) {
+	return input.crankAngle;
+}
+
+static int sysIsCrankDocked(void) {
+	return input.crankDocked;
+}
+
+static int sysSetCrankSoundsDisabled(int flag) {
+	(void)flag;
+	return 0;
+}
+
+static int sysGetFlipped(void) {
+	return 0;
+}
+
+static void sysSetAutoLockDisabled(int disable) {
+	(void)disable;
+}
+
+static void sysSetMenuImage(LCDBitmap* bitmap, int xOffset) {
+	(void)bitmap;
+	(void)xOffset;
+}
+
+static PDMenuItem* newMenuItem(HostMenuItemKind kind, const char* title, PDMenuItemCallbackFunction* callback, void* userdata) {
+	if (numMenuItems >= HOST_MAX_MENU_ITEMS) {
+		sysError("%s:%i too many menu items (max %i)", __FILE__, __LINE__, HOST_MAX_MENU_ITEMS);
+		return NULL;
+	}
+
+	PDMenuItem* item = hostAlloc(sizeof(PDMenuItem));
+	if (item == NULL) {
+		return NULL;
+	}
+	memset(item, 0, sizeof(PDMenuItem));
+	item->kind = kind;
+	snprintf(item->title, sizeof(item->title), "%s", title != NULL ? title : "");
+	item->callback = callback;
+	item->userdata = userdata;
+	menuItems[numMenuItems++] = item;
+	return item;
+}
+
+static PDMenuItem* sysAddMenuItem(const char* title, PDMenuItemCallbackFunction* callback, void* userdata) {
+	return newMenuItem(kHostMenuItemAction, title, callback, userdata);
+}
+
+static PDMenuItem* sysAddCheckmarkMenuItem(const char* title, int value, PDMenuItemCallbackFunction* callback, void* userdata) {
+	PDMenuItem* item = newMenuItem(kHostMenuItemCheckmark, title, callback, userdata);
+	if (item != NULL) {
+		item->value = value ? 1 : 0;
+	}
+	return item;
+}
+
+static PDMenuItem* sysAddOptionsMenuItem(const char* title, const char** optionTitles, int optionsCount, PDMenuItemCallbackFunction* f, void* userdata) {
+	PDMenuItem* item = newMenuItem(kHostMenuItemOptions, title, f, userdata);
+	if (item != NULL) {
+		item->optionsCount = optionsCount < HOST_MAX_MENU_OPTIONS ? optionsCount : HOST_MAX_MENU_OPTIONS;
+		for (int i = 0; i < item->optionsCount; i++) {
+			item->optionTitles[i] = optionTitles[i];
+		}
+	}
+	return item;
+}
+
+static void sysRemoveMenuItem(PDMenuItem* menuItem) {
+	for (int i = 0; i < numMenuItems; i++) {
+		if (menuItems[i] == menuItem) {
+			memmove(&menuItems[i], &menuItems[i + 1], (size_t)(numMenuItems - i - 1) * sizeof(PDMenuItem*));
+			numMenuItems--;
+			hostFree(menuItem);
+			return;
+		}
+	}
+}
+
+static void sysRemoveAllMenuItems(void) {
+	while (numMenuItems > 0) {
+		sysRemoveMenuItem(menuItems[0]);
+	}
+}
+
+static int sysGetMenuItemValue(PDMenuItem* menuItem) {
+	return menuItem != NULL ? menuItem->value : 0;
+}
+
+static void sysSetMenuItemValue(PDMenuItem* menuItem, int value) {
+	if (menuItem != NULL) {
+		menuItem->value = value;
+	}
+}
+
+static const char* sysGetMenuItemTitle(PDMenuItem* menuItem) {
+	return menuItem != NULL ? menuItem->title : NULL;
+}
+
+static void sysSetMenuItemTitle(PDMenuItem* menuItem, const char* title) {
+	if (menuItem != NULL) {
+		snprintf(menuItem->title, sizeof(menuItem->title), "%s", title);
+	}
+}
+
+static void* sysGetMenuItemUserdata(PDMenuItem* menuItem) {
+	return menuItem != NULL ? menuItem->userdata : NULL;
+}
+
+static void sysSetMenuItemUserdata(PDMenuItem* menuItem, void* ud) {
+	if (menuItem != NULL) {
+		menuItem->userdata = ud;
+	}
+}
+
+static int sysGetReduceFlashing(void) {
+	return 0;
+}
+
+static float sysGetElapsedTime(void) {
+	return (float)((hostNowNanos() - elapsedNanos) / 1e9);
+}
+
+static void sysResetElapsedTime(void) {
+	elapsedNanos = hostNowNanos();
+}
+
+static float sysGetBatteryPercentage(void) {
+	return 100.0f;
+}
+
+static float sysGetBatteryVoltage(void) {
+	return 4.2f;
+}
+
+static int32_t sysGetTimezoneOffset(void) {
+	return 0;
+}
+
+static int sysShouldDisplay24HourTime(void) {
+	return 1;
+}
+
+static void sysClearICache(void) {
+}
+
+static int sysParseString(const char* str, const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	int n = vsscanf(str, format, args);
+	va_end(args);
+	return n;
+}
+
+static const struct playdate_sys hostSystem = {
+	.realloc = sysRealloc,
+	.formatString = sysFormatString,
+	.logToConsole = sysLogToConsole,
+	.error = sysError,
+	.getLanguage = sysGetLanguage,
+	.getCurrentTimeMilliseconds = sysGetCurrentTimeMilliseconds,
+	.getSecondsSinceEpoch = sysGetSecondsSinceEpoch,
+	.drawFPS = sysDrawFPS,
+	.setUpdateCallback = sysSetUpdateCallback,
+	.getButtonState = sysGetButtonState,
+	.setButtonCallback = sysSetButtonCallback,
+	.setPeripheralsEnabled = sysSetPeripheralsEnabled,
+	.getAccelerometer = sysGetAccelerometer,
+	.getCrankChange = sysGetCrankChange,
+	.getCrankAngle = sysGetCrankAngle,
+	.isCrankDocked = sysIsCrankDocked,
+	.setCrankSoundsDisabled = sysSetCrankSoundsDisabled,
+	.getFlipped = sysGetFlipped,
+	.setAutoLockDisabled = sysSetAutoLockDisabled,
+	.setMenuImage = sysSetMenuImage,
+	.addMenuItem = sysAddMenuItem,
+	.addCheckmarkMenuItem = sysAddCheckmarkMenuItem,
+	.addOptionsMenuItem = sysAddOptionsMenuItem,
+	.removeAllMenuItems = sysRemoveAllMenuItems,
+	.removeMenuItem = sysRemoveMenuItem,
+	.getMenuItemValue = sysGetMenuItemValue,
+	.setMenuItemValue = sysSetMenuItemValue,
+	.getMenuItemTitle = sysGetMenuItemTitle,
+	.setMenuItemTitle = sysSetMenuItemTitle,
+	.getMenuItemUserdata = sysGetMenuItemUserdata,
+	.setMenuItemUserdata = sysSetMenuItemUserdata,
+	.getReduceFlashing = sysGetReduceFlashing,
+	.getElapsedTime = sysGetElapsedTime,
+	.resetElapsedTime = sysResetElapsedTime,
+	.getBatteryPercentage = sysGetBatteryPercentage,
+	.getBatteryVoltage = sysGetBatteryVoltage,
+	.getTimezoneOffset = sysGetTimezoneOffset,
+	.shouldDisplay24HourTime = sysShouldDisplay24HourTime,
+	.clearICache = sysClearICache,
+	.vaFormatString = sysVaFormatString,
+	.parseString = sysParseString,
+};
+
+
+// - pd->display
+
+static int displayGetWidth(void) {
+	return LCD_COLUMNS;
+}
+
+static int displayGetHeight(void) {
+	return LCD_ROWS;
+}
+
+static void displaySetRefreshRate(float rate) {
+	refreshRate = rate;
+}
+
+static void displaySetInverted(int flag) {
+	(void)flag;
+}
+
+static void displaySetScale(unsigned int s) {
+	(void)s;
+}
+
+static void displaySetMosaic(unsigned int x, unsigned int y) {
+	(void)x;
+	(void)y;
+}
+
+static void displaySetFlipped(int x, int y) {
+	(void)x;
+	(void)y;
+}
+
+static void displaySetOffset(int x, int y) {
+	(void)x;
+	(void)y;
+}
+
+static const struct playdate_display hostDisplay = {
+	.getWidth = displayGetWidth,
+	.getHeight = displayGetHeight,
+	.setRefreshRate = displaySetRefreshRate,
+	.setInverted = displaySetInverted,
+	.setScale = displaySetScale,
+	.setMosaic = displaySetMosaic,
+	.setFlipped = displaySetFlipped,
+	.setOffset = displaySetOffset,
+};
+
+
+// - pd->file
+
+static const char* fileGeterr(void) {
+	return fileErr;
+}
+
+static int fileListfiles(const char* path, void (*callback)(const char* path, void* userdata), void* userdata, int showhidden) {
+	char hostPath[HOST_PATH_MAX];
+	DIR* dirs[HOST_MAX_ASSET_ROOTS + 1];
+	int numDirs = 0;
+
+	if (dataPath(path, hostPath, sizeof(hostPath)) && (dirs[numDirs] = opendir(hostPath)) != NULL) {
+		numDirs++;
+	}
+	for (int r = 0; r < numAssetRoots; r++) {
+		if (!joinPath(assetRoots[r], path, "", hostPath, sizeof(hostPath))) {
+			continue;
+		}
+		if ((dirs[numDirs] = opendir(hostPath)) != NULL) {
+			numDirs++;
+		}
+	}
+	if (numDirs == 0) {
+		fileErr = "directory not found";
+		return -1;
+	}
+
+	for (int d = 0; d < numDirs; d++) {
+		struct dirent* entry;
+		while ((entry = readdir(dirs[d])) != NULL) {
+			if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+				continue;
+			}
+			if (!showhidden && entry->d_name[0] == '.') {
+				continue;
+			}
+			if (entry->d_type == DT_DIR) {
+				char name[HOST_PATH_MAX];
+				snprintf(name, sizeof(name), "%s/", entry->d_name);
+				callback(name, userdata);
+			}
+			else {
+				callback(entry->d_name, userdata);
+			}
+		}
+		closedir(dirs[d]);
+	}
+
+	return 0;
+}
+
+static int fileStat(const char* path, FileStat* out) {
+	char hostPath[HOST_PATH_MAX];
+	struct stat st;
+
+	int inData = dataPath(path, hostPath, sizeof(hostPath)) && stat(hostPath, &st) == 0;
+	if (!inData && !hostResolveAssetPath(path, NULL, 0, hostPath, sizeof(hostPath))) {
+		fileErr = "file not found";
+		return -1;
+	}
+	if (stat(hostPath, &st) != 0) {
+		fileErr = strerror(errno);
+		return -1;
+	}
+
+	struct tm tm;
+	gmtime_r(&st.st_mtime, &tm);
+	out->isdir = S_ISDIR(st.st_mode) ? 1 : 0;
+	out->size = (unsigned int)st.st_size;
+	out->m_year = tm.tm_year + 1900;
+	out->m_month = tm.tm_mon + 1;
+	out->m_day = tm.tm_mday;
+	out->m_hour = tm.tm_hour;
+	out->m_minute = tm.tm_min;
+	out->m_second = tm.tm_sec;
+	return 0;
+}
+
+static int fileMkdir(const char* path) {
+	char hostPath[HOST_PATH_MAX];
+	if (!dataPath(path, hostPath, sizeof(hostPath))) {
+		return -1;
+	}
+	makeDirs(hostPath);
+	return 0;
+}
+
+static int fileUnlink(const char* name, int recursive) {
+	char hostPath[HOST_PATH_MAX];
+	if (!dataPath(name, hostPath, sizeof(hostPath))) {
+		return -1;
+	}
+	(void)recursive; // only files and empty directories are removed by the host
+	if (remove(hostPath) != 0) {
+		fileErr = strerror(errno);
+		return -1;
+	}
+	return 0;
+}
+
+static int fileRename(const char* from, const char* to) {
+	char hostFrom[HOST_PATH_MAX];
+	char hostTo[HOST_PATH_MAX];
+	if (!dataPath(from, hostFrom, sizeof(hostFrom)) || !dataPath(to, hostTo, sizeof(hostTo))) {
+		return -1;
+	}
+	if (rename(hostFrom, hostTo) != 0) {
+		fileErr = strerror(errno);
+		return -1;
+	}
+	return 0;
+}
+
+static SDFile* fileOpen(const char* name, FileOptions mode) {
+	char hostPath[HOST_PATH_MAX];
+	FILE* fp = NULL;
+
+	if (mode & (kFileWrite | kFileAppend)) {
+		if (!dataPath(name, hostPath, sizeof(hostPath))) {
+			return NULL;
+		}
+		char dir[HOST_PATH_MAX];
+		snprintf(dir, sizeof(dir), "%s", hostPath);
+		char* slash = strrchr(dir, '/');
+		if (slash != NULL) {
+			*slash = '\0';
+			makeDirs(dir);
+		}
+		fp = fopen(hostPath, (mode & kFileAppend) ? "ab" : "wb");
+	}
+	else {
+		if ((mode & kFileReadData) && dataPath(name, hostPath, sizeof(hostPath))) {
+			fp = fopen(hostPath, "rb");
+		}
+		if (fp == NULL && (mode & kFileRead) && hostResolveAssetPath(name, NULL, 0, hostPath, sizeof(hostPath))) {
+			fp = fopen(hostPath, "rb");
+		}
+	}
+
+	if (fp == NULL) {
+		fileErr = "file not found";
+		return NULL;
+	}
+	hostCountFileOpen();
+
+	HostFile* file = hostAlloc(sizeof(HostFile));
+	file->fp = fp;
+	return file;
+}
+
+static int fileClose(SDFile* file) {
+	HostFile* f = file;
+	int result = fclose(f->fp);
+	hostFree(f);
+	return result == 0 ? 0 : -1;
+}
+
+static int fileRead(SDFile* file, void* buf, unsigned int len) {
+	HostFile* f = file;
+	size_t n = fread(buf, 1, len, f->fp);
+	if (n == 0 && ferror(f->fp)) {
+		fileErr = "read error";
+		return -1;
+	}
+	return (int)n;
+}
+
+static int fileWrite(SDFile* file, const void* buf, unsigned int len) {
+	HostFile* f = file;
+	size_t n = fwrite(buf, 1, len, f->fp);
+	if (n != len) {
+		fileErr = "write error";
+		return -1;
+	}
+	return (int)n;
+}
+
+static int fileFlush(SDFile* file) {
+	HostFile* f = file;
+	return fflush(f->fp) == 0 ? 0 : -1;
+}
+
+static int fileTell(SDFile* file) {
+	HostFile* f = file;
+	return (int)ftell(f->fp);
+}
+
+static int fileSeek(SDFile* file, int pos, int whence) {
+	HostFile* f = file;
+	return fseek(f->fp, pos, whence) == 0 ? 0 : -1;
+}
+
+static const struct playdate_file hostFileApi = {
+	.geterr = fileGeterr,
+	.listfiles = fileListfiles,
+	.stat = fileStat,
+	.mkdir = fileMkdir,
+	.unlink = fileUnlink,
+	.rename = fileRename,
+	.open = fileOpen,
+	.close = fileClose,
+	.read = fileRead,
+	.write = fileWrite,
+	.flush = fileFlush,
+	.tell = fileTell,
+	.seek = fileSeek,
+};
+
+
+// - runtime
+
+static PlaydateAPI hostApi = {
+	.system = &hostSystem,
+	.file = &hostFileApi,
+	.graphics = &hostGraphics,
+	.sprite = &hostSprite,
+	.display = &hostDisplay,
+	.sound = &hostSound,
+};
+
+void hostInit(const char** roots, int numRoots, const char* data) {
+	memset(&stats, 0, sizeof(stats));
+	memset(&input, 0, sizeof(input));
+	input.crankDocked = 1;
+	btnsPrevHost = 0;
+	buttonCallback = NULL;
+
+	numAssetRoots = numRoots < HOST_MAX_ASSET_ROOTS ? numRoots : HOST_MAX_ASSET_ROOTS;
+	for (int i = 0; i < numAssetRoots; i++) {
+		snprintf(assetRoots[i], sizeof(assetRoots[i]), "%s", roots[i]);
+	}
+	snprintf(dataRoot, sizeof(dataRoot), "%s", data);
+	makeDirs(dataRoot);
+
+	startNanos = hostNowNanos();
+	elapsedNanos = startNanos;
+	refreshRate = 30.0f;
+
+	hostGraphicsInit();
+	hostSoundInit();
+}
+
+void hostShutdown(void) {
+	sysRemoveAllMenuItems();
+	hostSoundShutdown();
+	hostGraphicsShutdown();
+	updateCallback = NULL;
+	updateUserdata = NULL;
+}
+
+PlaydateAPI* hostGetApi(void) {
+	return &hostApi;
+}
+
+void hostSetInput(const HostInput* next) {
+	input = *next;
+}
+
+/**
+ * Calls the button callback (if set) with the frame's button events, ahead of the update like the system does: per
+ * button, a press+release within the frame is a press then a release if up now, otherwise a release then a press.
+ */
+static void deliverButtonEvents(void) {
+	if (buttonCallback == NULL) {
+		return;
+	}
+
+	PDButtons pushed, released;
+	sysGetButtonState(NULL, &pushed, &released);
+	unsigned int when = sysGetCurrentTimeMilliseconds();
+	int delivered = 0;
+	for (int i = 0; i < 6 && delivered < buttonQueueSize; i++) {
+		PDButtons button = (PDButtons)(1 << i);
+		if ((pushed & released & button) && (input.current & button)) {
+			buttonCallback(button, 0, when, buttonUserdata);
+			delivered++;
+		}
+		if ((pushed & button) && delivered < buttonQueueSize) {
+			buttonCallback(button, 1, when, buttonUserdata);
+			delivered++;
+		}
+		if ((released & button) && !(input.current & button) && delivered < buttonQueueSize) {
+			buttonCallback(button, 0, when, buttonUserdata);
+			delivered++;
+		}
+	}
+}
+
+int hostRunFrame(void) {
+	if (updateCallback == NULL) {
+		return -1;
+	}
+
+	deliverButtonEvents();
+
+	int result = updateCallback(updateUserdata);
+
+	stats.frames++;
+	if (result != 0) {
+		stats.framesDisplayed++;
+		stats.rowsFlushed += (uint64_t)hostGraphicsFlush();
+	}
+
+	// the system never flushes faster than the refresh rate; treat "as fast as possible" as 50 fps (the display's limit)
+	hostSoundTick(1.0f / (refreshRate > 0.0f ? refreshRate : 50.0f));
+
+	btnsPrevHost = input.current;
+	input.pushed = 0;
+	input.released = 0;
+	input.crankChange = 0.0f;
+
+	return result;
+}
+
+void hostActivateMenuItem(int index) {
+	if (index < 0 || index >= numMenuItems) {
+		return;
+	}
+
+	PDMenuItem* item = menuItems[index];
+	if (item->kind == kHostMenuItemCheckmark) {
+		item->value = !item->value;
+	}
+	else if (item->kind == kHostMenuItemOptions && item->optionsCount > 0) {
+		item->value = (item->value + 1) % item->optionsCount;
+	}
+
+	if (item->callback != NULL) {
+		item->callback(item->userdata);
+	}
+}
+
+int hostGetMenuItemCount(void) {
+	return numMenuItems;
+}
+
+const HostStats* hostGetStats(void) {
+	return &stats;
+}
+
+void hostResetStats(void) {
+	uint64_t liveBytes = stats.liveBytes;
+	uint64_t errors = stats.errors;
+	memset(&stats, 0, sizeof(stats));
+	stats.liveBytes = liveBytes;
+	stats.peakBytes = liveBytes;
+	stats.errors = errors;
+}
+
+float hostGetRefreshRate(void) {
+	return refreshRate;
+}
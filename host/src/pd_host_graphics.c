@@ -0,0 +1,2026 @@
+//
+//  pd_host_graphics.c
+//  playdate-hello-world-c-kickstarter
+//
+//  Host pd->graphics and pd->sprite: a 1-bit software rasterizer over an in-memory
+//  400x240 frame buffer (bit set = white, most significant bit first, LCD_ROWSIZE bytes per row),
+//  PNG bitmap loading through libpng and Playdate .fnt font loading.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <png.h>
+
+#include "pd_host.h"
+
+
+#define HOST_CONTEXT_STACK_SIZE 8
+#define HOST_FONT_NUM_GLYPHS 128
+#define HOST_PATH_MAX 1024
+
+struct LCDBitmap {
+	int width;
+	int height;
+	int rowbytes;
+	/** 1 = white */
+	uint8_t* data;
+	/** 1 = opaque; NULL if the bitmap has no mask */
+	uint8_t* mask;
+	/** If 1, data is not owned by this bitmap (e.g. it wraps the frame buffer) */
+	int borrowed;
+};
+
+struct LCDBitmapTable {
+	int count;
+	int width;
+	int height;
+	LCDBitmap** bitmaps;
+};
+
+struct LCDFontGlyph {
+	LCDBitmap* bitmap;
+	int advance;
+};
+
+struct LCDFontPage {
+	LCDFont* font;
+};
+
+struct LCDFont {
+	int cellWidth;
+	int cellHeight;
+	int tracking;
+	LCDFontPage page;
+	LCDFontGlyph glyphs[HOST_FONT_NUM_GLYPHS];
+};
+
+struct LCDSprite {
+	float x;
+	float y;
+	float width;
+	float height;
+	float centerX;
+	float centerY;
+	LCDBitmap* image;
+	LCDBitmapFlip flip;
+	LCDBitmapDrawMode drawMode;
+	int16_t zIndex;
+	int visible;
+	int opaque;
+	int inDisplayList;
+	int updatesEnabled;
+	int hasClipRect;
+	LCDRect clipRect;
+	uint8_t tag;
+	void* userdata;
+	PDRect collideRect;
+	LCDSpriteDrawFunction* drawFunction;
+	LCDSpriteUpdateFunction* updateFunction;
+};
+
+typedef struct {
+	LCDBitmap* target;
+	uint8_t* data;
+	int rowbytes;
+	int width;
+	int height;
+	LCDBitmapDrawMode drawMode;
+	int offsetX;
+	int offsetY;
+	/** clip rect, [left, right) x [top, bottom) in target coordinates */
+	int clipLeft;
+	int clipTop;
+	int clipRight;
+	int clipBottom;
+	LCDFont* font;
+	int tracking;
+	int leading;
+} DrawContext;
+
+static uint8_t frame[LCD_ROWSIZE * LCD_ROWS];
+static uint8_t displayFrame[LCD_ROWSIZE * LCD_ROWS];
+static uint8_t rowsDirty[LCD_ROWS];
+static LCDBitmap frameBitmap;
+static LCDBitmap displayFrameBitmap;
+
+static DrawContext contextStack[HOST_CONTEXT_STACK_SIZE];
+static int contextDepth = 0;
+static DrawContext* ctx = &contextStack[0];
+
+static LCDSolidColor backgroundColor = kColorWhite;
+static LCDPattern colorPatterns[4];
+static int colorPatternNext = 0;
+
+static LCDSprite** displayList = NULL;
+static int displayListCount = 0;
+static int displayListCapacity = 0;
+static int spritesAlwaysRedraw = 0;
+/** The most dirty rects kept apart (as the system does) until drawSprites(); past that, new ones merge into the last */
+#define HOST_MAX_DIRTY_RECTS 8
+/** The rects drawSprites() redraws (spritesDirty of them; overlapping rects are merged) */
+static LCDRect spritesDirtyRects[HOST_MAX_DIRTY_RECTS];
+static int spritesDirty = 0;
+
+
+// - pixels
+
+static inline int getBit(const uint8_t* row, int x) {
+	return (row[x >> 3] >> (7 - (x & 7))) & 1;
+}
+
+static inline void setBit(uint8_t* row, int x, int white) {
+	uint8_t bit = (uint8_t)(0x80 >> (x & 7));
+	if (white) {
+		row[x >> 3] |= bit;
+	}
+	else {
+		row[x >> 3] &= (uint8_t)~bit;
+	}
+}
+
+static inline void xorBit(uint8_t* row, int x) {
+	row[x >> 3] ^= (uint8_t)(0x80 >> (x & 7));
+}
+
+/** Reads 8 bits starting at bit position x, MSB first. */
+static inline uint8_t readBits8(const uint8_t* row, int x, int rowbytes) {
+	int byte = x >> 3;
+	int shift = x & 7;
+	if (shift == 0) {
+		return row[byte];
+	}
+	uint16_t w = (uint16_t)(row[byte] << 8);
+	if (byte + 1 < rowbytes) {
+		w |= row[byte + 1];
+	}
+	return (uint8_t)((w << shift) >> 8);
+}
+
+static void markRows(int top, int bottom) {
+	if (ctx->target != NULL) {
+		return;
+	}
+	if (top < 0) {
+		top = 0;
+	}
+	if (bottom > LCD_ROWS - 1) {
+		bottom = LCD_ROWS - 1;
+	}
+	for (int y = top; y <= bottom; y++) {
+		rowsDirty[y] = 1;
+	}
+}
+
+/** Resolves whether (x, y) should be white for the given color, or -1 for transparent, or 2 for "invert". */
+static inline int colorAt(LCDColor color, int x, int y) {
+	if (color == kColorBlack) {
+		return 0;
+	}
+	if (color == kColorWhite) {
+		return 1;
+	}
+	if (color == kColorClear) {
+		return -1;
+	}
+	if (color == kColorXOR) {
+		return 2;
+	}
+
+	const uint8_t* pattern = (const uint8_t*)color;
+	if (((pattern[8 + (y & 7)] >> (7 - (x & 7))) & 1) == 0) {
+		return -1;
+	}
+	return (pattern[y & 7] >> (7 - (x & 7))) & 1;
+}
+
+static inline void plotRaw(int x, int y, LCDColor color) {
+	if (x < ctx->clipLeft || x >= ctx->clipRight || y < ctx->clipTop || y >= ctx->clipBottom) {
+		return;
+	}
+	uint8_t* row = ctx->data + y * ctx->rowbytes;
+	int c = colorAt(color, x, y);
+	if (c == 2) {
+		xorBit(row, x);
+	}
+	else if (c >= 0) {
+		setBit(row, x, c);
+	}
+}
+
+/** Fills the span [x0, x1] on row y (target coordinates, clipped here). */
+static void fillSpan(int x0, int x1, int y, LCDColor color) {
+	if (y < ctx->clipTop || y >= ctx->clipBottom) {
+		return;
+	}
+	if (x0 < ctx->clipLeft) {
+		x0 = ctx->clipLeft;
+	}
+	if (x1 >= ctx->clipRight) {
+		x1 = ctx->clipRight - 1;
+	}
+	if (x1 < x0) {
+		return;
+	}
+
+	uint8_t* row = ctx->data + y * ctx->rowbytes;
+
+	if (color > kColorXOR) {
+		for (int x = x0; x <= x1; x++) {
+			plotRaw(x, y, color);
+		}
+		return;
+	}
+	if (color == kColorClear) {
+		return;
+	}
+
+	int b0 = x0 >> 3;
+	int b1 = x1 >> 3;
+	uint8_t m0 = (uint8_t)(0xff >> (x0 & 7));
+	uint8_t m1 = (uint8_t)(0xff << (7 - (x1 & 7)));
+
+	for (int b = b0; b <= b1; b++) {
+		uint8_t m = 0xff;
+		if (b == b0) {
+			m &= m0;
+		}
+		if (b == b1) {
+			m &= m1;
+		}
+		if (color == kColorWhite) {
+			row[b] |= m;
+		}
+		else if (color == kColorBlack) {
+			row[b] &= (uint8_t)~m;
+		}
+		else {
+			row[b] ^= m;
+		}
+	}
+}
+
+/**
+ * Draws count pixels of a bitmap row into the current context.
+ *
+ * @param dx destination x (target coordinates, already clipped so [dx, dx+count) is inside the clip rect)
+ * @param sx source x of the first pixel drawn (already flipped if flipX)
+ */
+static void blitRow(uint8_t* dst, int dx, const uint8_t* src, const uint8_t* srcMask, int sx, int count, int srcRowbytes, LCDBitmapDrawMode mode, int flipX) {
+	if (mode == kDrawModeCopy && srcMask == NULL && !flipX) {
+		int i = 0;
+		while (i < count && ((dx + i) & 7) != 0) {
+			setBit(dst, dx + i, getBit(src, sx + i));
+			i++;
+		}
+		while (count - i >= 8) {
+			dst[(dx + i) >> 3] = readBits8(src, sx + i, srcRowbytes);
+			i += 8;
+		}
+		while (i < count) {
+			setBit(dst, dx + i, getBit(src, sx + i));
+			i++;
+		}
+		return;
+	}
+
+	for (int i = 0; i < count; i++) {
+		int x = flipX ? sx - i : sx + i;
+		if (srcMask != NULL && !getBit(srcMask, x)) {
+			continue;
+		}
+		int white = getBit(src, x);
+		int d = dx + i;
+		switch (mode) {
+			case kDrawModeCopy:
+				setBit(dst, d, white);
+				break;
+			case kDrawModeWhiteTransparent:
+				if (!white) {
+					setBit(dst, d, 0);
+				}
+				break;
+			case kDrawModeBlackTransparent:
+				if (white) {
+					setBit(dst, d, 1);
+				}
+				break;
+			case kDrawModeFillWhite:
+				setBit(dst, d, 1);
+				break;
+			case kDrawModeFillBlack:
+				setBit(dst, d, 0);
+				break;
+			case kDrawModeXOR:
+				if (white) {
+					xorBit(dst, d);
+				}
+				break;
+			case kDrawModeNXOR:
+				if (!white) {
+					xorBit(dst, d);
+				}
+				break;
+			case kDrawModeInverted:
+				setBit(dst, d, !white);
+				break;
+		}
+	}
+}
+
+/** Draws a bitmap at (x, y) in target coordinates with the given mode/flip, clipped to the context. */
+static void drawBitmapRaw(LCDBitmap* bitmap, int x, int y, LCDBitmapDrawMode mode, LCDBitmapFlip flip) {
+	if (bitmap == NULL) {
+		return;
+	}
+
+	int flipX = (flip == kBitmapFlippedX || flip == kBitmapFlippedXY);
+	int flipY = (flip == kBitmapFlippedY || flip == kBitmapFlippedXY);
+
+	int x0 = x > ctx->clipLeft ? x : ctx->clipLeft;
+	int x1 = (x + bitmap->width) < ctx->clipRight ? (x + bitmap->width) : ctx->clipRight;
+	int y0 = y > ctx->clipTop ? y : ctx->clipTop;
+	int y1 = (y + bitmap->height) < ctx->clipBottom ? (y + bitmap->height) : ctx->clipBottom;
+	if (x1 <= x0 || y1 <= y0) {
+		return;
+	}
+
+	for (int dy = y0; dy < y1; dy++) {
+		int sy = flipY ? (bitmap->height - 1 - (dy - y)) : (dy - y);
+		const uint8_t* src = bitmap->data + sy * bitmap->rowbytes;
+		const uint8_t* srcMask = bitmap->mask != NULL ? bitmap->mask + sy * bitmap->rowbytes : NULL;
+		int sx = flipX ? (bitmap->width - 1 - (x0 - x)) : (x0 - x);
+		blitRow(ctx->data + dy * ctx->rowbytes, x0, src, srcMask, sx, x1 - x0, bitmap->rowbytes, mode, flipX);
+	}
+	markRows(y0, y1 - 1);
+}
+
+
+// - bitmaps
+
+static LCDBitmap* newBitmapRaw(int width, int height, int withMask) {
+	int rowbytes = ((width + 31) / 32) * 4;
+	size_t dataSize = (size_t)rowbytes * (size_t)height;
+	LCDBitmap* bitmap = hostAlloc(sizeof(LCDBitmap) + dataSize * (withMask ? 2 : 1));
+	if (bitmap == NULL) {
+		return NULL;
+	}
+	bitmap->width = width;
+	bitmap->height = height;
+	bitmap->rowbytes = rowbytes;
+	bitmap->data = (uint8_t*)(bitmap + 1);
+	bitmap->mask = withMask ? bitmap->data + dataSize : NULL;
+	bitmap->borrowed = 0;
+	return bitmap;
+}
+
+static void fillBitmap(LCDBitmap* bitmap, LCDColor color) {
+	size_t dataSize = (size_t)bitmap->rowbytes * (size_t)bitmap->height;
+	if (color == kColorBlack || color == kColorWhite) {
+		memset(bitmap->data, color == kColorWhite ? 0xff : 0x00, dataSize);
+		if (bitmap->mask != NULL) {
+			memset(bitmap->mask, 0xff, dataSize);
+		}
+	}
+	else if (color == kColorClear) {
+		memset(bitmap->data, 0x00, dataSize);
+		if (bitmap->mask != NULL) {
+			memset(bitmap->mask, 0x00, dataSize);
+		}
+	}
+	else if (color > kColorXOR) {
+		for (int y = 0; y < bitmap->height; y++) {
+			for (int x = 0; x < bitmap->width; x++) {
+				int c = colorAt(color, x, y);
+				setBit(bitmap->data + y * bitmap->rowbytes, x, c == 1);
+				if (bitmap->mask != NULL) {
+					setBit(bitmap->mask + y * bitmap->rowbytes, x, c >= 0);
+				}
+			}
+		}
+	}
+}
+
+/** Converts 8-bit gray+alpha pixels into a 1-bit bitmap; gray >= 128 is white, alpha < 128 is transparent. */
+static LCDBitmap* bitmapFromGrayAlpha(const uint8_t* ga, int width, int height, int stride) {
+	int hasTransparency = 0;
+	for (int y = 0; y < height && !hasTransparency; y++) {
+		for (int x = 0; x < width; x++) {
+			if (ga[y * stride + x * 2 + 1] < 128) {
+				hasTransparency = 1;
+				break;
+			}
+		}
+	}
+
+	LCDBitmap* bitmap = newBitmapRaw(width, height, hasTransparency);
+	if (bitmap == NULL) {
+		return NULL;
+	}
+	memset(bitmap->data, 0, (size_t)bitmap->rowbytes * (size_t)height);
+	if (bitmap->mask != NULL) {
+		memset(bitmap->mask, 0, (size_t)bitmap->rowbytes * (size_t)height);
+	}
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			const uint8_t* px = ga + y * stride + x * 2;
+			if (px[0] >= 128) {
+				setBit(bitmap->data + y * bitmap->rowbytes, x, 1);
+			}
+			if (bitmap->mask != NULL && px[1] >= 128) {
+				setBit(bitmap->mask + y * bitmap->rowbytes, x, 1);
+			}
+		}
+	}
+	return bitmap;
+}
+
+/** Decodes a PNG (from file if path is non-NULL, else from memory). */
+static LCDBitmap* decodePng(const char* path, const void* mem, size_t memSize, const char** outerr) {
+	png_image image;
+	memset(&image, 0, sizeof(image));
+	image.version = PNG_IMAGE_VERSION;
+
+	int ok = path != NULL ?
+		png_image_begin_read_from_file(&image, path) :
+		png_image_begin_read_from_memory(&image, mem, memSize);
+	if (!ok) {
+		if (outerr != NULL) {
+			*outerr = "PNG decode failed";
+		}
+		return NULL;
+	}
+
+	image.format = PNG_FORMAT_GA;
+	size_t stride = PNG_IMAGE_ROW_STRIDE(image) * PNG_IMAGE_PIXEL_COMPONENT_SIZE(image.format);
+	uint8_t* buffer = malloc(PNG_IMAGE_BUFFER_SIZE(image, stride)); // decode scratch; not part of what the device would allocate
+	if (buffer == NULL || !png_image_finish_read(&image, NULL, buffer, (png_int_32)stride, NULL)) {
+		free(buffer);
+		png_image_free(&image);
+		if (outerr != NULL) {
+			*outerr = "PNG decode failed";
+		}
+		return NULL;
+	}
+
+	LCDBitmap* bitmap = bitmapFromGrayAlpha(buffer, (int)image.width, (int)image.height, (int)stride);
+	free(buffer);
+	return bitmap;
+}
+
+static LCDBitmap* gfxNewBitmap(int width, int height, LCDColor bgcolor) {
+	LCDBitmap* bitmap = newBitmapRaw(width, height, bgcolor == kColorClear || bgcolor > kColorXOR);
+	if (bitmap != NULL) {
+		fillBitmap(bitmap, bgcolor);
+	}
+	return bitmap;
+}
+
+static void gfxFreeBitmap(LCDBitmap* bitmap) {
+	if (bitmap != NULL && !bitmap->borrowed) {
+		hostFree(bitmap);
+	}
+}
+
+static LCDBitmap* gfxLoadBitmap(const char* path, const char** outerr) {
+	static const char* extensions[] = { ".png", "" };
+	char hostPath[HOST_PATH_MAX];
+
+	if (!hostResolveAssetPath(path, extensions, 2, hostPath, sizeof(hostPath))) {
+		if (outerr != NULL) {
+			*outerr = "file not found";
+		}
+		return NULL;
+	}
+	hostCountFileOpen();
+	return decodePng(hostPath, NULL, 0, outerr);
+}
+
+static LCDBitmap* gfxCopyBitmap(LCDBitmap* bitmap) {
+	LCDBitmap* copy = newBitmapRaw(bitmap->width, bitmap->height, bitmap->mask != NULL);
+	if (copy != NULL) {
+		size_t dataSize = (size_t)bitmap->rowbytes * (size_t)bitmap->height;
+		memcpy(copy->data, bitmap->data, dataSize);
+		if (bitmap->mask != NULL) {
+			memcpy(copy->mask, bitmap->mask, dataSize);
+		}
+	}
+	return copy;
+}
+
+static void gfxLoadIntoBitmap(const char* path, LCDBitmap* bitmap, const char** outerr) {
+	LCDBitmap* loaded = gfxLoadBitmap(path, outerr);
+	if (loaded == NULL) {
+		return;
+	}
+	if (loaded->width != bitmap->width || loaded->height != bitmap->height) {
+		if (outerr != NULL) {
+			*outerr = "bitmap size mismatch";
+		}
+	}
+	else {
+		size_t dataSize = (size_t)bitmap->rowbytes * (size_t)bitmap->height;
+		memcpy(bitmap->data, loaded->data, dataSize);
+		if (bitmap->mask != NULL) {
+			if (loaded->mask != NULL) {
+				memcpy(bitmap->mask, loaded->mask, dataSize);
+			}
+			else {
+				memset(bitmap->mask, 0xff, dataSize);
+			}
+		}
+	}
+	gfxFreeBitmap(loaded);
+}
+
+static void gfxGetBitmapData(LCDBitmap* bitmap, int* width, int* height, int* rowbytes, uint8_t** mask, uint8_t** data) {
+	if (width != NULL) {
+		*width = bitmap->width;
+	}
+	if (height != NULL) {
+		*height = bitmap->height;
+	}
+	if (rowbytes != NULL) {
+		*rowbytes = bitmap->rowbytes;
+	}
+	if (mask != NULL) {
+		*mask = bitmap->mask;
+	}
+	if (data != NULL) {
+		*data = bitmap->data;
+	}
+}
+
+static void gfxClearBitmap(LCDBitmap* bitmap, LCDColor bgcolor) {
+	fillBitmap(bitmap, bgcolor);
+}
+
+static LCDSolidColor gfxGetBitmapPixel(LCDBitmap* bitmap, int x, int y) {
+	if (x < 0 || y < 0 || x >= bitmap->width || y >= bitmap->height) {
+		return kColorClear;
+	}
+	if (bitmap->mask != NULL && !getBit(bitmap->mask + y * bitmap->rowbytes, x)) {
+		return kColorClear;
+	}
+	return getBit(bitmap->data + y * bitmap->rowbytes, x) ? kColorWhite : kColorBlack;
+}
+
+static int gfxSetBitmapMask(LCDBitmap* bitmap, LCDBitmap* mask) {
+	if (bitmap->mask == NULL || mask->width != bitmap->width || mask->height != bitmap->height) {
+		return 0;
+	}
+	memcpy(bitmap->mask, mask->data, (size_t)bitmap->rowbytes * (size_t)bitmap->height);
+	return 1;
+}
+
+static LCDBitmap* gfxGetBitmapMask(LCDBitmap* bitmap) {
+	(void)bitmap;
+	return NULL;
+}
+
+static LCDBitmap* gfxRotatedBitmap(LCDBitmap* bitmap, float rotation, float xscale, float yscale, int* allocedSize) {
+	float rad = rotation * (float)M_PI / 180.0f;
+	float c = cosf(rad);
+	float s = sinf(rad);
+	float w = bitmap->width * xscale;
+	float h = bitmap->height * yscale;
+	int outW = (int)ceilf(fabsf(w * c) + fabsf(h * s));
+	int outH = (int)ceilf(fabsf(w * s) + fabsf(h * c));
+
+	LCDBitmap* out = newBitmapRaw(outW, outH, 1);
+	if (out == NULL) {
+		return NULL;
+	}
+	fillBitmap(out, kColorClear);
+
+	for (int y = 0; y < outH; y++) {
+		for (int x = 0; x < outW; x++) {
+			float dx = x + 0.5f - outW / 2.0f;
+			float dy = y + 0.5f - outH / 2.0f;
+			int sx = (int)floorf((dx * c + dy * s) / xscale + bitmap->width / 2.0f);
+			int sy = (int)floorf((-dx * s + dy * c) / yscale + bitmap->height / 2.0f);
+			LCDSolidColor p = gfxGetBitmapPixel(bitmap, sx, sy);
+			if (p != kColorClear) {
+				setBit(out->data + y * out->rowbytes, x, p == kColorWhite);
+				setBit(out->mask + y * out->rowbytes, x, 1);
+			}
+		}
+	}
+
+	if (allocedSize != NULL) {
+		*allocedSize = (int)(sizeof(LCDBitmap) + (size_t)out->rowbytes * (size_t)outH * 2);
+	}
+	return out;
+}
+
+
+// - bitmap tables
+
+static LCDBitmapTable* gfxNewBitmapTable(int count, int width, int height) {
+	LCDBitmapTable* table = hostAlloc(sizeof(LCDBitmapTable) + (size_t)count * sizeof(LCDBitmap*));
+	table->count = count;
+	table->width = width;
+	table->height = height;
+	table->bitmaps = (LCDBitmap**)(table + 1);
+	for (int i = 0; i < count; i++) {
+		table->bitmaps[i] = gfxNewBitmap(width, height, kColorClear);
+	}
+	return table;
+}
+
+static void gfxFreeBitmapTable(LCDBitmapTable* table) {
+	if (table == NULL) {
+		return;
+	}
+	for (int i = 0; i < table->count; i++) {
+		gfxFreeBitmap(table->bitmaps[i]);
+	}
+	hostFree(table);
+}
+
+static LCDBitmapTable* gfxLoadBitmapTable(const char* path, const char** outerr) {
+	(void)path;
+	if (outerr != NULL) {
+		*outerr = "bitmap tables are not supported by the host runtime";
+	}
+	return NULL;
+}
+
+static void gfxLoadIntoBitmapTable(const char* path, LCDBitmapTable* table, const char** outerr) {
+	(void)table;
+	gfxLoadBitmapTable(path, outerr);
+}
+
+static LCDBitmap* gfxGetTableBitmap(LCDBitmapTable* table, int idx) {
+	if (table == NULL || idx < 0 || idx >= table->count) {
+		return NULL;
+	}
+	return table->bitmaps[idx];
+}
+
+static void gfxGetBitmapTableInfo(LCDBitmapTable* table, int* count, int* width) {
+	if (count != NULL) {
+		*count = table->count;
+	}
+	if (width != NULL) {
+		*width = table->width;
+	}
+}
+
+
+// - fonts
+
+static int base64Value(char c) {
+	if (c >= 'A' && c <= 'Z') {
+		return c - 'A';
+	}
+	if (c >= 'a' && c <= 'z') {
+		return c - 'a' + 26;
+	}
+	if (c >= '0' && c <= '9') {
+		return c - '0' + 52;
+	}
+	if (c == '+') {
+		return 62;
+	}
+	if (c == '/') {
+		return 63;
+	}
+	return -1;
+}
+
+static size_t base64Decode(const char* in, uint8_t* out) {
+	size_t n = 0;
+	uint32_t acc = 0;
+	int bits = 0;
+	for (; *in != '\0' && *in != '\n' && *in != '\r'; in++) {
+		int v = base64Value(*in);
+		if (v < 0) {
+			continue;
+		}
+		acc = (acc << 6) | (uint32_t)v;
+		bits += 6;
+		if (bits >= 8) {
+			bits -= 8;
+			out[n++] = (uint8_t)(acc >> bits);
+		}
+	}
+	return n;
+}
+
+/** Decodes the first UTF-8 code point of s; returns the number of bytes used. */
+static int decodeUtf8(const char* s, uint32_t* out) {
+	const uint8_t* u = (const uint8_t*)s;
+	if (u[0] < 0x80) {
+		*out = u[0];
+		return 1;
+	}
+	if ((u[0] & 0xe0) == 0xc0 && u[1] != 0) {
+		*out = ((uint32_t)(u[0] & 0x1f) << 6) | (u[1] & 0x3f);
+		return 2;
+	}
+	if ((u[0] & 0xf0) == 0xe0 && u[1] != 0 && u[2] != 0) {
+		*out = ((uint32_t)(u[0] & 0x0f) << 12) | ((uint32_t)(u[1] & 0x3f) << 6) | (u[2] & 0x3f);
+		return 3;
+	}
+	if ((u[0] & 0xf8) == 0xf0 && u[1] != 0 && u[2] != 0 && u[3] != 0) {
+		*out = ((uint32_t)(u[0] & 0x07) << 18) | ((uint32_t)(u[1] & 0x3f) << 12) | ((uint32_t)(u[2] & 0x3f) << 6) | (u[3] & 0x3f);
+		return 4;
+	}
+	*out = u[0];
+	return 1;
+}
+
+static void freeFont(LCDFont* font) {
+	for (int i = 0; i < HOST_FONT_NUM_GLYPHS; i++) {
+		gfxFreeBitmap(font->glyphs[i].bitmap);
+	}
+	hostFree(font);
+}
+
+static LCDFont* gfxLoadFont(const char* path, const char** outErr) {
+	static const char* extensions[] = { ".fnt", "" };
+	char hostPath[HOST_PATH_MAX];
+
+	if (!hostResolveAssetPath(path, extensions, 2, hostPath, sizeof(hostPath))) {
+		if (outErr != NULL) {
+			*outErr = "file not found";
+		}
+		return NULL;
+	}
+
+	FILE* fp = fopen(hostPath, "rb");
+	if (fp == NULL) {
+		if (outErr != NULL) {
+			*outErr = "file not found";
+		}
+		return NULL;
+	}
+	hostCountFileOpen();
+
+	LCDFont* font = hostAlloc(sizeof(LCDFont));
+	memset(font, 0, sizeof(LCDFont));
+	font->page.font = font;
+
+	uint8_t* png = NULL;
+	size_t pngSize = 0;
+	LCDBitmap* sheet = NULL;
+	int glyphIndex = 0;
+	int cols = 0;
+
+	char line[65536];
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		size_t len = strlen(line);
+		while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+			line[--len] = '\0';
+		}
+		if (len == 0 || strncmp(line, "--", 2) == 0) {
+			continue;
+		}
+
+		if (strncmp(line, "data=", 5) == 0) {
+			free(png);
+			png = malloc(len);
+			pngSize = base64Decode(line + 5, png);
+			continue;
+		}
+		if (strncmp(line, "datalen=", 8) == 0) {
+			continue;
+		}
+		if (strncmp(line, "width=", 6) == 0) {
+			font->cellWidth = atoi(line + 6);
+			continue;
+		}
+		if (strncmp(line, "height=", 7) == 0) {
+			font->cellHeight = atoi(line + 7);
+			continue;
+		}
+		if (strncmp(line, "tracking=", 9) == 0) {
+			font->tracking = atoi(line + 9);
+			continue;
+		}
+
+		char* tab = strchr(line, '\t');
+		if (tab == NULL) {
+			continue;
+		}
+		*tab = '\0';
+
+		uint32_t codepoint;
+		if (strcmp(line, "space") == 0) {
+			codepoint = ' ';
+		}
+		else {
+			int used = decodeUtf8(line, &codepoint);
+			if (line[used] != '\0') {
+				continue; // kerning pair; the host ignores kerning
+			}
+		}
+
+		if (sheet == NULL && png != NULL) {
+			sheet = decodePng(NULL, png, pngSize, outErr);
+			if (sheet != NULL && font->cellWidth > 0) {
+				cols = sheet->width / font->cellWidth;
+			}
+		}
+
+		if (codepoint < HOST_FONT_NUM_GLYPHS) {
+			LCDFontGlyph* glyph = &font->glyphs[codepoint];
+			glyph->advance = atoi(tab + 1);
+			if (sheet != NULL && cols > 0 && codepoint != ' ') {
+				int gx = (glyphIndex % cols) * font->cellWidth;
+				int gy = (glyphIndex / cols) * font->cellHeight;
+				glyph->bitmap = newBitmapRaw(font->cellWidth, font->cellHeight, 1);
+				memset(glyph->bitmap->data, 0, (size_t)glyph->bitmap->rowbytes * (size_t)font->cellHeight);
+				memset(glyph->bitmap->mask, 0, (size_t)glyph->bitmap->rowbytes * (size_t)font->cellHeight);
+				for (int y = 0; y < font->cellHeight; y++) {
+					for (int x = 0; x < font->cellWidth; x++) {
+						LCDSolidColor p = gfxGetBitmapPixel(sheet, gx + x, gy + y);
+						if (p != kColorClear) {
+							setBit(glyph->bitmap->data + y * glyph->bitmap->rowbytes, x, p == kColorWhite);
+							setBit(glyph->bitmap->mask + y * glyph->bitmap->rowbytes, x, 1);
+						}
+					}
+				}
+			}
+		}
+		glyphIndex++;
+	}
+	fclose(fp);
+	free(png);
+
+	if (sheet == NULL || font->cellHeight <= 0) {
+		gfxFreeBitmap(sheet);
+		freeFont(font);
+		if (outErr != NULL) {
+			*outErr = "font has no embedded glyph image";
+		}
+		return NULL;
+	}
+	gfxFreeBitmap(sheet);
+
+	return font;
+}
+
+static LCDFontPage* gfxGetFontPage(LCDFont* font, uint32_t c) {
+	return (font != NULL && c < HOST_FONT_NUM_GLYPHS) ? &font->page : NULL;
+}
+
+static LCDFontGlyph* gfxGetPageGlyph(LCDFontPage* page, uint32_t c, LCDBitmap** bitmap, int* advance) {
+	if (page == NULL || c >= HOST_FONT_NUM_GLYPHS) {
+		return NULL;
+	}
+	LCDFontGlyph* glyph = &page->font->glyphs[c];
+	if (bitmap != NULL) {
+		*bitmap = glyph->bitmap;
+	}
+	if (advance != NULL) {
+		*advance = glyph->advance;
+	}
+	return glyph;
+}
+
+static int gfxGetGlyphKerning(LCDFontGlyph* glyph, uint32_t glyphcode, uint32_t nextcode) {
+	(void)glyph;
+	(void)glyphcode;
+	(void)nextcode;
+	return 0;
+}
+
+static uint8_t gfxGetFontHeight(LCDFont* font) {
+	return font != NULL ? (uint8_t)font->cellHeight : 0;
+}
+
+static LCDFont* gfxMakeFontFromData(LCDFontData* data, int wide) {
+	(void)data;
+	(void)wide;
+	return NULL;
+}
+
+/** Iterates text as code points; ASCII and UTF-8 are handled, 16-bit LE is read as such. */
+static int nextCodepoint(const void* text, size_t len, PDStringEncoding encoding, size_t* pos, uint32_t* out) {
+	if (*pos >= len) {
+		return 0;
+	}
+	if (encoding == k16BitLEEncoding) {
+		const uint16_t* t = text;
+		*out = t[*pos];
+		*pos += 1;
+		return 1;
+	}
+	const char* t = text;
+	if (encoding == kASCIIEncoding) {
+		*out = (uint8_t)t[*pos];
+		*pos += 1;
+		return 1;
+	}
+	*pos += (size_t)decodeUtf8(t + *pos, out);
+	return 1;
+}
+
+static int gfxGetTextWidth(LCDFont* font, const void* text, size_t len, PDStringEncoding encoding, int tracking) {
+	if (font == NULL) {
+		return 0;
+	}
+
+	int width = 0;
+	int count = 0;
+	size_t pos = 0;
+	uint32_t c;
+	while (nextCodepoint(text, len, encoding, &pos, &c)) {
+		if (c == 0) {
+			break;
+		}
+		if (c < HOST_FONT_NUM_GLYPHS) {
+			width += font->glyphs[c].advance;
+		}
+		count++;
+	}
+	if (count > 1) {
+		width += (count - 1) * (font->tracking + tracking);
+	}
+	return width;
+}
+
+static int gfxDrawText(const void* text, size_t len, PDStringEncoding encoding, int x, int y) {
+	LCDFont* font = ctx->font;
+	if (font == NULL) {
+		return 0;
+	}
+
+	int penX = x + ctx->offsetX;
+	int penY = y + ctx->offsetY;
+	int startX = penX;
+	size_t pos = 0;
+	uint32_t c;
+	while (nextCodepoint(text, len, encoding, &pos, &c)) {
+		if (c == 0) {
+			break;
+		}
+		if (c == '\n') {
+			penX = startX;
+			penY += font->cellHeight + ctx->leading;
+			continue;
+		}
+		if (c < HOST_FONT_NUM_GLYPHS) {
+			LCDFontGlyph* glyph = &font->glyphs[c];
+			drawBitmapRaw(glyph->bitmap, penX, penY, ctx->drawMode, kBitmapUnflipped);
+			penX += glyph->advance + font->tracking + ctx->tracking;
+		}
+	}
+	return penX - startX;
+}
+
+
+// - context & state
+
+static void resetContext(DrawContext* c, LCDBitmap* target) {
+	LCDFont* font = c->font;
+	int tracking = c->tracking;
+	memset(c, 0, sizeof(DrawContext));
+	c->target = target;
+	c->data = target != NULL ? target->data : frame;
+	c->rowbytes = target != NULL ? target->rowbytes : LCD_ROWSIZE;
+	c->width = target != NULL ? target->width : LCD_COLUMNS;
+	c->height = target != NULL ? target->height : LCD_ROWS;
+	c->clipRight = c->width;
+	c->clipBottom = c->height;
+	c->drawMode = kDrawModeCopy;
+	c->font = font;
+	c->tracking = tracking;
+}
+
+static void gfxPushContext(LCDBitmap* target) {
+	if (contextDepth + 1 >= HOST_CONTEXT_STACK_SIZE) {
+		hostGetApi()->system->error("%s:%i graphics context stack overflow", __FILE__, __LINE__);
+		return;
+	}
+	contextStack[contextDepth + 1] = *ctx;
+	contextDepth++;
+	ctx = &contextStack[contextDepth];
+	if (target != NULL) {
+		resetContext(ctx, target);
+	}
+}
+
+static void gfxPopContext(void) {
+	if (contextDepth == 0) {
+		return;
+	}
+	contextDepth--;
+	ctx = &contextStack[contextDepth];
+}
+
+static void gfxClear(LCDColor color) {
+	for (int y = 0; y < ctx->height; y++) {
+		if (color == kColorWhite || color == kColorBlack) {
+			memset(ctx->data + y * ctx->rowbytes, color == kColorWhite ? 0xff : 0x00, (size_t)ctx->rowbytes);
+		}
+		else {
+			for (int x = 0; x < ctx->width; x++) {
+				int c = colorAt(color, x, y);
+				if (c == 2) {
+					xorBit(ctx->data + y * ctx->rowbytes, x);
+				}
+				else if (c >= 0) {
+					setBit(ctx->data + y * ctx->rowbytes, x, c);
+				}
+			}
+		}
+	}
+	if (ctx->target != NULL && ctx->target->mask != NULL && color != kColorClear) {
+		memset(ctx->target->mask, 0xff, (size_t)ctx->rowbytes * (size_t)ctx->height);
+	}
+	markRows(0, ctx->height - 1);
+}
+
+static void gfxSetBackgroundColor(LCDSolidColor color) {
+	backgroundColor = color;
+}
+
+static void gfxSetStencil(LCDBitmap* stencil) {
+	(void)stencil;
+}
+
+static void gfxSetStencilImage(LCDBitmap* stencil, int tile) {
+	(void)stencil;
+	(void)tile;
+}
+
+static LCDBitmapDrawMode gfxSetDrawMode(LCDBitmapDrawMode mode) {
+	LCDBitmapDrawMode prev = ctx->drawMode;
+	ctx->drawMode = mode;
+	return prev;
+}
+
+static void gfxSetDrawOffset(int dx, int dy) {
+	ctx->offsetX = dx;
+	ctx->offsetY = dy;
+}
+
+static void setClipRaw(int x, int y, int width, int height) {
+	ctx->clipLeft = x > 0 ? x : 0;
+	ctx->clipTop = y > 0 ? y : 0;
+	ctx->clipRight = (x + width) < ctx->width ? (x + width) : ctx->width;
+	ctx->clipBottom = (y + height) < ctx->height ? (y + height) : ctx->height;
+}
+
+static void gfxSetClipRect(int x, int y, int width, int height) {
+	setClipRaw(x + ctx->offsetX, y + ctx->offsetY, width, height);
+}
+
+static void gfxSetScreenClipRect(int x, int y, int width, int height) {
+	setClipRaw(x, y, width, height);
+}
+
+static void gfxClearClipRect(void) {
+	setClipRaw(0, 0, ctx->width, ctx->height);
+}
+
+static void gfxSetLineCapStyle(LCDLineCapStyle endCapStyle) {
+	(void)endCapStyle;
+}
+
+static void gfxSetFont(LCDFont* font) {
+	ctx->font = font;
+}
+
+static void gfxSetTextTracking(int tracking) {
+	ctx->tracking = tracking;
+}
+
+static int gfxGetTextTracking(void) {
+	return ctx->tracking;
+}
+
+static void gfxSetTextLeading(int lineHeightAdustment) {
+	ctx->leading = lineHeightAdustment;
+}
+
+static void gfxSetColorToPattern(LCDColor* color, LCDBitmap* bitmap, int x, int y) {
+	uint8_t* pattern = colorPatterns[colorPatternNext];
+	colorPatternNext = (colorPatternNext + 1) % 4;
+	for (int row = 0; row < 8; row++) {
+		uint8_t bits = 0;
+		uint8_t mask = 0;
+		for (int col = 0; col < 8; col++) {
+			LCDSolidColor p = gfxGetBitmapPixel(bitmap, (x + col) % bitmap->width, (y + row) % bitmap->height);
+			bits = (uint8_t)((bits << 1) | (p == kColorWhite));
+			mask = (uint8_t)((mask << 1) | (p != kColorClear));
+		}
+		pattern[row] = bits;
+		pattern[8 + row] = mask;
+	}
+	*color = (LCDColor)pattern;
+}
+
+
+// - drawing
+
+static void gfxDrawBitmap(LCDBitmap* bitmap, int x, int y, LCDBitmapFlip flip) {
+	drawBitmapRaw(bitmap, x + ctx->offsetX, y + ctx->offsetY, ctx->drawMode, flip);
+}
+
+static void gfxTileBitmap(LCDBitmap* bitmap, int x, int y, int width, int height, LCDBitmapFlip flip) {
+	DrawContext saved = *ctx;
+	setClipRaw(x + ctx->offsetX, y + ctx->offsetY, width, height);
+	if (saved.clipLeft > ctx->clipLeft) ctx->clipLeft = saved.clipLeft;
+	if (saved.clipTop > ctx->clipTop) ctx->clipTop = saved.clipTop;
+	if (saved.clipRight < ctx->clipRight) ctx->clipRight = saved.clipRight;
+	if (saved.clipBottom < ctx->clipBottom) ctx->clipBottom = saved.clipBottom;
+	for (int ty = 0; ty < height; ty += bitmap->height) {
+		for (int tx = 0; tx < width; tx += bitmap->width) {
+			drawBitmapRaw(bitmap, x + tx + ctx->offsetX, y + ty + ctx->offsetY, ctx->drawMode, flip);
+		}
+	}
+	*ctx = saved;
+}
+
+static void gfxDrawScaledBitmap(LCDBitmap* bitmap, int x, int y, float xscale, float yscale) {
+	if (xscale == 0.0f || yscale == 0.0f) {
+		return;
+	}
+	int w = (int)(bitmap->width * fabsf(xscale));
+	int h = (int)(bitmap->height * fabsf(yscale));
+	x += ctx->offsetX;
+	y += ctx->offsetY;
+	for (int dy = 0; dy < h; dy++) {
+		int sy = (int)(dy / fabsf(yscale));
+		if (yscale < 0) {
+			sy = bitmap->height - 1 - sy;
+		}
+		for (int dx = 0; dx < w; dx++) {
+			int sx = (int)(dx / fabsf(xscale));
+			if (xscale < 0) {
+				sx = bitmap->width - 1 - sx;
+			}
+			LCDSolidColor p = gfxGetBitmapPixel(bitmap, sx, sy);
+			if (p != kColorClear) {
+				plotRaw(x + dx, y + dy, p);
+			}
+		}
+	}
+	markRows(y, y + h - 1);
+}
+
+static void gfxDrawRotatedBitmap(LCDBitmap* bitmap, int x, int y, float rotation, float centerx, float centery, float xscale, float yscale) {
+	LCDBitmap* rotated = gfxRotatedBitmap(bitmap, rotation, xscale, yscale, NULL);
+	if (rotated == NULL) {
+		return;
+	}
+	drawBitmapRaw(rotated, x + ctx->offsetX - (int)(rotated->width * centerx), y + ctx->offsetY - (int)(rotated->height * centery), ctx->drawMode, kBitmapUnflipped);
+	gfxFreeBitmap(rotated);
+}
+
+static void gfxFillRect(int x, int y, int width, int height, LCDColor color) {
+	x += ctx->offsetX;
+	y += ctx->offsetY;
+	if (width < 0) {
+		x += width;
+		width = -width;
+	}
+	if (height < 0) {
+		y += height;
+		height = -height;
+	}
+	for (int row = y; row < y + height; row++) {
+		fillSpan(x, x + width - 1, row, color);
+	}
+	markRows(y, y + height - 1);
+}
+
+static void gfxDrawRect(int x, int y, int width, int height, LCDColor color) {
+	gfxFillRect(x, y, width, 1, color);
+	gfxFillRect(x, y + height - 1, width, 1, color);
+	gfxFillRect(x, y + 1, 1, height - 2, color);
+	gfxFillRect(x + width - 1, y + 1, 1, height - 2, color);
+}
+
+static void gfxDrawLine(int x1, int y1, int x2, int y2, int width, LCDColor color) {
+	x1 += ctx->offsetX;
+	y1 += ctx->offsetY;
+	x2 += ctx->offsetX;
+	y2 += ctx->offsetY;
+
+	int dx = abs(x2 - x1);
+	int dy = -abs(y2 - y1);
+	int sx = x1 < x2 ? 1 : -1;
+	int sy = y1 < y2 ? 1 : -1;
+	int err = dx + dy;
+	int half = width > 1 ? width / 2 : 0;
+
+	for (;;) {
+		if (half == 0) {
+			plotRaw(x1, y1, color);
+		}
+		else {
+			for (int py = y1 - half; py < y1 - half + width; py++) {
+				fillSpan(x1 - half, x1 - half + width - 1, py, color);
+			}
+		}
+		if (x1 == x2 && y1 == y2) {
+			break;
+		}
+		int e2 = 2 * err;
+		if (e2 >= dy) {
+			err += dy;
+			x1 += sx;
+		}
+		if (e2 <= dx) {
+			err += dx;
+			y1 += sy;
+		}
+	}
+
+	int top = (y1 < y2 ? y1 : y2) - half;
+	int bottom = (y1 > y2 ? y1 : y2) + half;
+	markRows(top, bottom);
+}
+
+static void gfxFillTriangle(int x1, int y1, int x2, int y2, int x3, int y3, LCDColor color) {
+	int coords[6] = { x1, y1, x2, y2, x3, y3 };
+	hostGraphics.fillPolygon(3, coords, color, 0);
+}
+
+static void gfxFillPolygon(int nPoints, int* coords, LCDColor color, int fillrule) {
+	if (nPoints < 3) {
+		return;
+	}
+
+	int minY = coords[1];
+	int maxY = coords[1];
+	for (int i = 1; i < nPoints; i++) {
+		minY = coords[i * 2 + 1] < minY ? coords[i * 2 + 1] : minY;
+		maxY = coords[i * 2 + 1] > maxY ? coords[i * 2 + 1] : maxY;
+	}
+
+	float crossings[32];
+	int windings[32];
+	for (int y = minY; y <= maxY; y++) {
+		float cy = y + 0.5f;
+		int n = 0;
+		for (int i = 0; i < nPoints && n < 32; i++) {
+			int j = (i + 1) % nPoints;
+			float ax = (float)coords[i * 2], ay = (float)coords[i * 2 + 1];
+			float bx = (float)coords[j * 2], by = (float)coords[j * 2 + 1];
+			if ((ay <= cy && by > cy) || (by <= cy && ay > cy)) {
+				crossings[n] = ax + (cy - ay) * (bx - ax) / (by - ay);
+				windings[n] = by > ay ? 1 : -1;
+				n++;
+			}
+		}
+		// insertion sort; polygons here are tiny
+		for (int i = 1; i < n; i++) {
+			float cx = crossings[i];
+			int w = windings[i];
+			int j = i - 1;
+			while (j >= 0 && crossings[j] > cx) {
+				crossings[j + 1] = crossings[j];
+				windings[j + 1] = windings[j];
+				j--;
+			}
+			crossings[j + 1] = cx;
+			windings[j + 1] = w;
+		}
+
+		int winding = 0;
+		for (int i = 0; i + 1 < n; i++) {
+			winding += windings[i];
+			int inside = fillrule == 0 ? (winding != 0) : ((i & 1) == 0);
+			if (inside) {
+				int xa = (int)ceilf(crossings[i] - 0.5f);
+				int xb = (int)ceilf(crossings[i + 1] - 0.5f) - 1;
+				fillSpan(xa + ctx->offsetX, xb + ctx->offsetX, y + ctx->offsetY, color);
+			}
+		}
+		// vertices exactly on the scanline would otherwise leave apexes empty
+		if (n == 0) {
+			for (int i = 0; i < nPoints; i++) {
+				if (coords[i * 2 + 1] == y) {
+					plotRaw(coords[i * 2] + ctx->offsetX, y + ctx->offsetY, color);
+				}
+			}
+		}
+	}
+	markRows(minY + ctx->offsetY, maxY + ctx->offsetY);
+}
+
+static int angleInArc(float angle, float startAngle, float endAngle) {
+	if (startAngle == endAngle) {
+		return 1;
+	}
+	float start = fmodf(startAngle, 360.0f);
+	if (start < 0) {
+		start += 360.0f;
+	}
+	float end = fmodf(endAngle, 360.0f);
+	if (end < 0) {
+		end += 360.0f;
+	}
+	if (end <= start) {
+		end += 360.0f;
+	}
+	return (angle >= start && angle <= end) || (angle + 360.0f >= start && angle + 360.0f <= end);
+}
+
+/** Shared ellipse rasterizer; lineWidth <= 0 fills. Angles are in degrees, 0 = up, clockwise. */
+static void rasterEllipse(int x, int y, int width, int height, int lineWidth, float startAngle, float endAngle, LCDColor color) {
+	x += ctx->offsetX;
+	y += ctx->offsetY;
+	if (width <= 0 || height <= 0) {
+		return;
+	}
+
+	float rx = width / 2.0f;
+	float ry = height / 2.0f;
+	float cx = x + rx;
+	float cy = y + ry;
+	float irx = lineWidth > 0 ? rx - lineWidth : 0.0f;
+	float iry = lineWidth > 0 ? ry - lineWidth : 0.0f;
+	int fullCircle = (startAngle == endAngle);
+
+	for (int py = y; py < y + height; py++) {
+		float dy = py + 0.5f - cy;
+		float t = 1.0f - (dy * dy) / (ry * ry);
+		if (t < 0) {
+			continue;
+		}
+		float half = rx * sqrtf(t);
+		int xa = (int)ceilf(cx - half - 0.5f);
+		int xb = (int)floorf(cx + half - 0.5f);
+
+		float innerHalf = -1.0f;
+		if (irx > 0 && iry > 0) {
+			float it = 1.0f - (dy * dy) / (iry * iry);
+			if (it >= 0) {
+				innerHalf = irx * sqrtf(it);
+			}
+		}
+
+		if (fullCircle) {
+			if (innerHalf < 0) {
+				fillSpan(xa, xb, py, color);
+			}
+			else {
+				int ia = (int)ceilf(cx - innerHalf - 0.5f);
+				int ib = (int)floorf(cx + innerHalf - 0.5f);
+				fillSpan(xa, ia - 1, py, color);
+				fillSpan(ib + 1, xb, py, color);
+			}
+			continue;
+		}
+
+		for (int px = xa; px <= xb; px++) {
+			float dx = px + 0.5f - cx;
+			if (innerHalf >= 0 && fabsf(dx) < innerHalf) {
+				continue;
+			}
+			float angle = atan2f(dx, -dy) * 180.0f / (float)M_PI;
+			if (angle < 0) {
+				angle += 360.0f;
+			}
+			if (angleInArc(angle, startAngle, endAngle)) {
+				plotRaw(px, py, color);
+			}
+		}
+	}
+	markRows(y, y + height - 1);
+}
+
+static void gfxDrawEllipse(int x, int y, int width, int height, int lineWidth, float startAngle, float endAngle, LCDColor color) {
+	rasterEllipse(x, y, width, height, lineWidth > 0 ? lineWidth : 1, startAngle, endAngle, color);
+}
+
+static void gfxFillEllipse(int x, int y, int width, int height, float startAngle, float endAngle, LCDColor color) {
+	rasterEllipse(x, y, width, height, 0, startAngle, endAngle, color);
+}
+
+static void gfxSetPixel(int x, int y, LCDColor c) {
+	plotRaw(x + ctx->offsetX, y + ctx->offsetY, c);
+	markRows(y + ctx->offsetY, y + ctx->offsetY);
+}
+
+static int gfxCheckMaskCollision(LCDBitmap* bitmap1, int x1, int y1, LCDBitmapFlip flip1, LCDBitmap* bitmap2, int x2, int y2, LCDBitmapFlip flip2, LCDRect rect) {
+	(void)bitmap1; (void)x1; (void)y1; (void)flip1;
+	(void)bitmap2; (void)x2; (void)y2; (void)flip2;
+	(void)rect;
+	return 0;
+}
+
+
+// - frame buffer
+
+static uint8_t* gfxGetFrame(void) {
+	return frame;
+}
+
+static uint8_t* gfxGetDisplayFrame(void) {
+	return displayFrame;
+}
+
+static LCDBitmap* gfxGetDebugBitmap(void) {
+	return NULL;
+}
+
+static LCDBitmap* gfxCopyFrameBufferBitmap(void) {
+	return gfxCopyBitmap(&frameBitmap);
+}
+
+static LCDBitmap* gfxGetDisplayBufferBitmap(void) {
+	return &displayFrameBitmap;
+}
+
+static void gfxMarkUpdatedRows(int start, int end) {
+	DrawContext* saved = ctx;
+	ctx = &contextStack[0];
+	markRows(start, end);
+	ctx = saved;
+}
+
+static void gfxDisplay(void) {
+	hostGraphicsFlush();
+}
+
+const uint8_t* hostGetDisplayFrame(void) {
+	return displayFrame;
+}
+
+int hostGraphicsFlush(void) {
+	int flushed = 0;
+	for (int y = 0; y < LCD_ROWS; y++) {
+		if (rowsDirty[y]) {
+			memcpy(displayFrame + y * LCD_ROWSIZE, frame + y * LCD_ROWSIZE, LCD_ROWSIZE);
+			rowsDirty[y] = 0;
+			flushed++;
+		}
+	}
+	return flushed;
+}
+
+
+// - sprites
+
+static PDRect spriteBounds(LCDSprite* s) {
+	return PDRectMake(s->x - s->centerX * s->width, s->y - s->centerY * s->height, s->width, s->height);
+}
+
+static int dirtyRectsOverlap(const LCDRect* a, const LCDRect* b) {
+	return a->left < b->right && b->left < a->right && a->top < b->bottom && b->top < a->bottom;
+}
+
+static void mergeDirtyRect(LCDRect* into, const LCDRect* r) {
+	into->left = r->left < into->left ? r->left : into->left;
+	into->top = r->top < into->top ? r->top : into->top;
+	into->right = r->right > into->right ? r->right : into->right;
+	into->bottom = r->bottom > into->bottom ? r->bottom : into->bottom;
+}
+
+static void addDirtyRectRaw(int left, int top, int right, int bottom) {
+	left = left > 0 ? left : 0;
+	top = top > 0 ? top : 0;
+	right = right < LCD_COLUMNS ? right : LCD_COLUMNS;
+	bottom = bottom < LCD_ROWS ? bottom : LCD_ROWS;
+	if (right <= left || bottom <= top) {
+		return;
+	}
+
+	LCDRect r = { left, right, top, bottom };
+	for (int i = 0; i < spritesDirty; i++) {
+		if (dirtyRectsOverlap(&spritesDirtyRects[i], &r)) {
+			// merge (and the rects the merged one now overlaps, so the list stays disjoint)
+			mergeDirtyRect(&r, &spritesDirtyRects[i]);
+			spritesDirtyRects[i] = spritesDirtyRects[--spritesDirty];
+			i = -1;
+		}
+	}
+	if (spritesDirty == HOST_MAX_DIRTY_RECTS) {
+		mergeDirtyRect(&spritesDirtyRects[spritesDirty - 1], &r);
+		return;
+	}
+	spritesDirtyRects[spritesDirty++] = r;
+}
+
+static void markSpriteDirty(LCDSprite* s) {
+	if (!s->inDisplayList || !s->visible) {
+		return;
+	}
+	PDRect b = spriteBounds(s);
+	addDirtyRectRaw((int)floorf(b.x), (int)floorf(b.y), (int)ceilf(b.x + b.width), (int)ceilf(b.y + b.height));
+}
+
+static void spriteSetAlwaysRedraw(int flag) {
+	spritesAlwaysRedraw = flag;
+}
+
+static void spriteAddDirtyRect(LCDRect dirtyRect) {
+	addDirtyRectRaw(dirtyRect.left, dirtyRect.top, dirtyRect.right, dirtyRect.bottom);
+}
+
+static void spriteDrawSprites(void) {
+	if (spritesAlwaysRedraw) {
+		addDirtyRectRaw(0, 0, LCD_COLUMNS, LCD_ROWS);
+	}
+	if (!spritesDirty) {
+		return;
+	}
+
+	// sort display list by z-index (stable; display lists here are short)
+	for (int i = 1; i < displayListCount; i++) {
+		LCDSprite* s = displayList[i];
+		int j = i - 1;
+		while (j >= 0 && displayList[j]->zIndex > s->zIndex) {
+			displayList[j + 1] = displayList[j];
+			j--;
+		}
+		displayList[j + 1] = s;
+	}
+
+	DrawContext saved = *ctx;
+	for (int r = 0; r < spritesDirty; r++) {
+		LCDRect* dirty = &spritesDirtyRects[r];
+		setClipRaw(dirty->left, dirty->top, dirty->right - dirty->left, dirty->bottom - dirty->top);
+
+		if (backgroundColor != kColorClear) {
+			for (int y = ctx->clipTop; y < ctx->clipBottom; y++) {
+				fillSpan(ctx->clipLeft, ctx->clipRight - 1, y, backgroundColor);
+			}
+			markRows(ctx->clipTop, ctx->clipBottom - 1);
+		}
+
+		for (int i = 0; i < displayListCount; i++) {
+			LCDSprite* s = displayList[i];
+			if (!s->visible) {
+				continue;
+			}
+			PDRect b = spriteBounds(s);
+			if (b.x >= ctx->clipRight || b.y >= ctx->clipBottom || b.x + b.width <= ctx->clipLeft || b.y + b.height <= ctx->clipTop) {
+				continue;
+			}
+
+			int clipLeft = ctx->clipLeft, clipTop = ctx->clipTop, clipRight = ctx->clipRight, clipBottom = ctx->clipBottom;
+			if (s->hasClipRect) {
+				ctx->clipLeft = s->clipRect.left > clipLeft ? s->clipRect.left : clipLeft;
+				ctx->clipTop = s->clipRect.top > clipTop ? s->clipRect.top : clipTop;
+				ctx->clipRight = s->clipRect.right < clipRight ? s->clipRect.right : clipRight;
+				ctx->clipBottom = s->clipRect.bottom < clipBottom ? s->clipRect.bottom : clipBottom;
+			}
+
+			if (s->drawFunction != NULL) {
+				PDRect drawRect = PDRectMake((float)ctx->clipLeft, (float)ctx->clipTop, (float)(ctx->clipRight - ctx->clipLeft), (float)(ctx->clipBottom - ctx->clipTop));
+				s->drawFunction(s, b, drawRect);
+			}
+			else if (s->image != NULL) {
+				drawBitmapRaw(s->image, (int)floorf(b.x), (int)floorf(b.y), s->drawMode, s->flip);
+			}
+
+			ctx->clipLeft = clipLeft;
+			ctx->clipTop = clipTop;
+			ctx->clipRight = clipRight;
+			ctx->clipBottom = clipBottom;
+		}
+	}
+
+	*ctx = saved;
+	spritesDirty = 0;
+}
+
+static void spriteUpdateAndDrawSprites(void) {
+	for (int i = 0; i < displayListCount; i++) {
+		LCDSprite* s = displayList[i];
+		if (s->updatesEnabled && s->updateFunction != NULL) {
+			s->updateFunction(s);
+		}
+	}
+	spriteDrawSprites();
+}
+
+static LCDSprite* spriteNewSprite(void) {
+	LCDSprite* s = hostAlloc(sizeof(LCDSprite));
+	memset(s, 0, sizeof(LCDSprite));
+	s->centerX = 0.5f;
+	s->centerY = 0.5f;
+	s->visible = 1;
+	s->updatesEnabled = 1;
+	return s;
+}
+
+static void spriteRemoveSprite(LCDSprite* s) {
+	for (int i = 0; i < displayListCount; i++) {
+		if (displayList[i] == s) {
+			markSpriteDirty(s);
+			memmove(&displayList[i], &displayList[i + 1], (size_t)(displayListCount - i - 1) * sizeof(LCDSprite*));
+			displayListCount--;
+			s->inDisplayList = 0;
+			return;
+		}
+	}
+}
+
+static void spriteFreeSprite(LCDSprite* s) {
+	if (s == NULL) {
+		return;
+	}
+	spriteRemoveSprite(s);
+	hostFree(s);
+}
+
+static LCDSprite* spriteCopy(LCDSprite* s) {
+	LCDSprite* copy = spriteNewSprite();
+	*copy = *s;
+	copy->inDisplayList = 0;
+	return copy;
+}
+
+static void spriteAddSprite(LCDSprite* s) {
+	if (s->inDisplayList) {
+		return;
+	}
+	if (displayListCount == displayListCapacity) {
+		displayListCapacity = displayListCapacity > 0 ? displayListCapacity * 2 : 16;
+		displayList = hostRealloc(displayList, (size_t)displayListCapacity * sizeof(LCDSprite*));
+	}
+	displayList[displayListCount++] = s;
+	s->inDisplayList = 1;
+	markSpriteDirty(s);
+}
+
+static void spriteRemoveSprites(LCDSprite** sprites, int count) {
+	for (int i = 0; i < count; i++) {
+		spriteRemoveSprite(sprites[i]);
+	}
+}
+
+static void spriteRemoveAllSprites(void) {
+	while (displayListCount > 0) {
+		spriteRemoveSprite(displayList[0]);
+	}
+}
+
+static int spriteGetSpriteCount(void) {
+	return displayListCount;
+}
+
+static void spriteSetBounds(LCDSprite* s, PDRect bounds) {
+	markSpriteDirty(s);
+	s->width = bounds.width;
+	s->height = bounds.height;
+	s->x = bounds.x + s->centerX * bounds.width;
+	s->y = bounds.y + s->centerY * bounds.height;
+	markSpriteDirty(s);
+}
+
+static PDRect spriteGetBounds(LCDSprite* s) {
+	return spriteBounds(s);
+}
+
+static void spriteMoveTo(LCDSprite* s, float x, float y) {
+	markSpriteDirty(s);
+	s->x = x;
+	s->y = y;
+	markSpriteDirty(s);
+}
+
+static void spriteMoveBy(LCDSprite* s, float dx, float dy) {
+	spriteMoveTo(s, s->x + dx, s->y + dy);
+}
+
+static void spriteSetImage(LCDSprite* s, LCDBitmap* image, LCDBitmapFlip flip) {
+	markSpriteDirty(s);
+	s->image = image;
+	s->flip = flip;
+	if (image != NULL) {
+		s->width = (float)image->width;
+		s->height = (float)image->height;
+	}
+	markSpriteDirty(s);
+}
+
+static LCDBitmap* spriteGetImage(LCDSprite* s) {
+	return s->image;
+}
+
+static void spriteSetSize(LCDSprite* s, float width, float height) {
+	markSpriteDirty(s);
+	s->width = width;
+	s->height = height;
+	markSpriteDirty(s);
+}
+
+static void spriteSetZIndex(LCDSprite* s, int16_t zIndex) {
+	s->zIndex = zIndex;
+	markSpriteDirty(s);
+}
+
+static int16_t spriteGetZIndex(LCDSprite* s) {
+	return s->zIndex;
+}
+
+static void spriteSetDrawMode(LCDSprite* s, LCDBitmapDrawMode mode) {
+	s->drawMode = mode;
+	markSpriteDirty(s);
+}
+
+static void spriteSetImageFlip(LCDSprite* s, LCDBitmapFlip flip) {
+	s->flip = flip;
+	markSpriteDirty(s);
+}
+
+static LCDBitmapFlip spriteGetImageFlip(LCDSprite* s) {
+	return s->flip;
+}
+
+static void spriteSetStencil(LCDSprite* s, LCDBitmap* stencil) {
+	(void)s;
+	(void)stencil;
+}
+
+static void spriteSetClipRect(LCDSprite* s, LCDRect clipRect) {
+	s->hasClipRect = 1;
+	s->clipRect = clipRect;
+	markSpriteDirty(s);
+}
+
+static void spriteClearClipRect(LCDSprite* s) {
+	s->hasClipRect = 0;
+	markSpriteDirty(s);
+}
+
+static void spriteSetClipRectsInRange(LCDRect clipRect, int startZ, int endZ) {
+	for (int i = 0; i < displayListCount; i++) {
+		if (displayList[i]->zIndex >= startZ && displayList[i]->zIndex <= endZ) {
+			spriteSetClipRect(displayList[i], clipRect);
+		}
+	}
+}
+
+static void spriteClearClipRectsInRange(int startZ, int endZ) {
+	for (int i = 0; i < displayListCount; i++) {
+		if (displayList[i]->zIndex >= startZ && displayList[i]->zIndex <= endZ) {
+			spriteClearClipRect(displayList[i]);
+		}
+	}
+}
+
+static void spriteSetUpdatesEnabled(LCDSprite* s, int flag) {
+	s->updatesEnabled = flag;
+}
+
+static int spriteUpdatesEnabled(LCDSprite* s) {
+	return s->updatesEnabled;
+}
+
+static void spriteSetCollisionsEnabled(LCDSprite* s, int flag) {
+	(void)s;
+	(void)flag;
+}
+
+static int spriteCollisionsEnabled(LCDSprite* s) {
+	(void)s;
+	return 0;
+}
+
+static void spriteSetVisible(LCDSprite* s, int flag) {
+	if (s->visible != flag) {
+		if (s->visible) {
+			markSpriteDirty(s);
+		}
+		s->visible = flag;
+		markSpriteDirty(s);
+	}
+}
+
+static int spriteIsVisible(LCDSprite* s) {
+	return s->visible;
+}
+
+static void spriteSetOpaque(LCDSprite* s, int flag) {
+	s->opaque = flag;
+}
+
+static void spriteMarkDirty(LCDSprite* s) {
+	markSpriteDirty(s);
+}
+
+static void spriteSetTag(LCDSprite* s, uint8_t tag) {
+	s->tag = tag;
+}
+
+static uint8_t spriteGetTag(LCDSprite* s) {
+	return s->tag;
+}
+
+static void spriteSetIgnoresDrawOffset(LCDSprite* s, int flag) {
+	(void)s;
+	(void)flag;
+}
+
+static void spriteSetUpdateFunction(LCDSprite* s, LCDSpriteUpdateFunction* func) {
+	s->updateFunction = func;
+}
+
+static void spriteSetDrawFunction(LCDSprite* s, LCDSpriteDrawFunction* func) {
+	s->drawFunction = func;
+	markSpriteDirty(s);
+}
+
+static void spriteGetPosition(LCDSprite* s, float* x, float* y) {
+	if (x != NULL) {
+		*x = s->x;
+	}
+	if (y != NULL) {
+		*y = s->y;
+	}
+}
+
+static void spriteResetCollisionWorld(void) {
+}
+
+static void spriteSetCollideRect(LCDSprite* s, PDRect collideRect) {
+	s->collideRect = collideRect;
+}
+
+static PDRect spriteGetCollideRect(LCDSprite* s) {
+	return s->collideRect;
+}
+
+static void spriteClearCollideRect(LCDSprite* s) {
+	memset(&s->collideRect, 0, sizeof(PDRect));
+}
+
+static void spriteSetUserdata(LCDSprite* s, void* userdata) {
+	s->userdata = userdata;
+}
+
+static void* spriteGetUserdata(LCDSprite* s) {
+	return s->userdata;
+}
+
+static void spriteSetCenter(LCDSprite* s, float x, float y) {
+	markSpriteDirty(s);
+	s->centerX = x;
+	s->centerY = y;
+	markSpriteDirty(s);
+}
+
+static void spriteGetCenter(LCDSprite* s, float* x, float* y) {
+	if (x != NULL) {
+		*x = s->centerX;
+	}
+	if (y != NULL) {
+		*y = s->centerY;
+	}
+}
+
+
+// - tables
+
+const struct playdate_graphics hostGraphics = {
+	.clear = gfxClear,
+	.setBackgroundColor = gfxSetBackgroundColor,
+	.setStencil = gfxSetStencil,
+	.setDrawMode = gfxSetDrawMode,
+	.setDrawOffset = gfxSetDrawOffset,
+	.setClipRect = gfxSetClipRect,
+	.clearClipRect = gfxClearClipRect,
+	.setLineCapStyle = gfxSetLineCapStyle,
+	.setFont = gfxSetFont,
+	.setTextTracking = gfxSetTextTracking,
+	.pushContext = gfxPushContext,
+	.popContext = gfxPopContext,
+	.drawBitmap = gfxDrawBitmap,
+	.tileBitmap = gfxTileBitmap,
+	.drawLine = gfxDrawLine,
+	.fillTriangle = gfxFillTriangle,
+	.drawRect = gfxDrawRect,
+	.fillRect = gfxFillRect,
+	.drawEllipse = gfxDrawEllipse,
+	.fillEllipse = gfxFillEllipse,
+	.drawScaledBitmap = gfxDrawScaledBitmap,
+	.drawText = gfxDrawText,
+	.newBitmap = gfxNewBitmap,
+	.freeBitmap = gfxFreeBitmap,
+	.loadBitmap = gfxLoadBitmap,
+	.copyBitmap = gfxCopyBitmap,
+	.loadIntoBitmap = gfxLoadIntoBitmap,
+	.getBitmapData = gfxGetBitmapData,
+	.clearBitmap = gfxClearBitmap,
+	.rotatedBitmap = gfxRotatedBitmap,
+	.newBitmapTable = gfxNewBitmapTable,
+	.freeBitmapTable = gfxFreeBitmapTable,
+	.loadBitmapTable = gfxLoadBitmapTable,
+	.loadIntoBitmapTable = gfxLoadIntoBitmapTable,
+	.getTableBitmap = gfxGetTableBitmap,
+	.loadFont = gfxLoadFont,
+	.getFontPage = gfxGetFontPage,
+	.getPageGlyph = gfxGetPageGlyph,
+	.getGlyphKerning = gfxGetGlyphKerning,
+	.getTextWidth = gfxGetTextWidth,
+	.getFrame = gfxGetFrame,
+	.getDisplayFrame = gfxGetDisplayFrame,
+	.getDebugBitmap = gfxGetDebugBitmap,
+	.copyFrameBufferBitmap = gfxCopyFrameBufferBitmap,
+	.markUpdatedRows = gfxMarkUpdatedRows,
+	.display = gfxDisplay,
+	.setColorToPattern = gfxSetColorToPattern,
+	.checkMaskCollision = gfxCheckMaskCollision,
+	.setScreenClipRect = gfxSetScreenClipRect,
+	.fillPolygon = gfxFillPolygon,
+	.getFontHeight = gfxGetFontHeight,
+	.getDisplayBufferBitmap = gfxGetDisplayBufferBitmap,
+	.drawRotatedBitmap = gfxDrawRotatedBitmap,
+	.setTextLeading = gfxSetTextLeading,
+	.setBitmapMask = gfxSetBitmapMask,
+	.getBitmapMask = gfxGetBitmapMask,
+	.setStencilImage = gfxSetStencilImage,
+	.makeFontFromData = gfxMakeFontFromData,
+	.getTextTracking = gfxGetTextTracking,
+	.setPixel = gfxSetPixel,
+	.getBitmapPixel = gfxGetBitmapPixel,
+	.getBitmapTableInfo = gfxGetBitmapTableInfo,
+};
+
+const struct playdate_sprite hostSprite = {
+	.setAlwaysRedraw = spriteSetAlwaysRedraw,
+	.addDirtyRect = spriteAddDirtyRect,
+	.drawSprites = spriteDrawSprites,
+	.updateAndDrawSprites = spriteUpdateAndDrawSprites,
+	.newSprite = spriteNewSprite,
+	.freeSprite = spriteFreeSprite,
+	.copy = spriteCopy,
+	.addSprite = spriteAddSprite,
+	.removeSprite = spriteRemoveSprite,
+	.removeSprites = spriteRemoveSprites,
+	.removeAllSprites = spriteRemoveAllSprites,
+	.getSpriteCount = spriteGetSpriteCount,
+	.setBounds = spriteSetBounds,
+	.getBounds = spriteGetBounds,
+	.moveTo = spriteMoveTo,
+	.moveBy = spriteMoveBy,
+	.setImage = spriteSetImage,
+	.getImage = spriteGetImage,
+	.setSize = spriteSetSize,
+	.setZIndex = spriteSetZIndex,
+	.getZIndex = spriteGetZIndex,
+	.setDrawMode = spriteSetDrawMode,
+	.setImageFlip = spriteSetImageFlip,
+	.getImageFlip = spriteGetImageFlip,
+	.setStencil = spriteSetStencil,
+	.setClipRect = spriteSetClipRect,
+	.clearClipRect = spriteClearClipRect,
+	.setClipRectsInRange = spriteSetClipRectsInRange,
+	.clearClipRectsInRange = spriteClearClipRectsInRange,
+	.setUpdatesEnabled = spriteSetUpdatesEnabled,
+	.updatesEnabled = spriteUpdatesEnabled,
+	.setCollisionsEnabled = spriteSetCollisionsEnabled,
+	.collisionsEnabled = spriteCollisionsEnabled,
+	.setVisible = spriteSetVisible,
+	.isVisible = spriteIsVisible,
+	.setOpaque = spriteSetOpaque,
+	.markDirty = spriteMarkDirty,
+	.setTag = spriteSetTag,
+	.getTag = spriteGetTag,
+	.setIgnoresDrawOffset = spriteSetIgnoresDrawOffset,
+	.setUpdateFunction = spriteSetUpdateFunction,
+	.setDrawFunction = spriteSetDrawFunction,
+	.getPosition = spriteGetPosition,
+	.resetCollisionWorld = spriteResetCollisionWorld,
+	.setCollideRect = spriteSetCollideRect,
+	.getCollideRect = spriteGetCollideRect,
+	.clearCollideRect = spriteClearCollideRect,
+	.setUserdata = spriteSetUserdata,
+	.getUserdata = spriteGetUserdata,
+	.setCenter = spriteSetCenter,
+	.getCenter = spriteGetCenter,
+};
+
+
+// - lifecycle
+
+void hostGraphicsInit(void) {
+	memset(frame, 0xff, sizeof(frame));
+	memset(displayFrame, 0xff, sizeof(displayFrame));
+	memset(rowsDirty, 0, sizeof(rowsDirty));
+
+	frameBitmap = (LCDBitmap){ LCD_COLUMNS, LCD_ROWS, LCD_ROWSIZE, frame, NULL, 1 };
+	displayFrameBitmap = (LCDBitmap){ LCD_COLUMNS, LCD_ROWS, LCD_ROWSIZE, displayFrame, NULL, 1 };
+
+	contextDepth = 0;
+	ctx = &contextStack[0];
+	memset(ctx, 0, sizeof(DrawContext));
+	resetContext(ctx, NULL);
+
+	backgroundColor = kColorWhite;
+	spritesAlwaysRedraw = 0;
+	spritesDirty = 0;
+	displayListCount = 0;
+}
+
+void hostGraphicsShutdown(void) {
+	spriteRemoveAllSprites();
+	hostFree(displayList);
+	displayList = NULL;
+	displayListCapacity = 0;
+}
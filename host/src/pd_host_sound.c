@@ -0,0 +1,1020 @@
+//
+//  pd_host_sound.c
+//  playdate-hello-world-c-kickstarter
+//
+//  Host pd->sound: no audio is output, but samples are really loaded from WAV files and
+//  players/synths keep time against a virtual audio clock advanced once per frame, so
+//  isPlaying(), finish/loop callbacks and memory use behave like on device.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pd_host.h"
+
+
+#define HOST_MAX_SOUND_SOURCES 64
+#define HOST_MAX_CHANNEL_SOURCES 32
+#define HOST_SAMPLE_RATE 44100
+#define HOST_PATH_MAX 1024
+
+typedef enum {
+	kHostSourceFilePlayer,
+	kHostSourceSamplePlayer,
+	kHostSourceSynth,
+	kHostSourceCallback
+} HostSourceKind;
+
+struct SoundSource {
+	HostSourceKind kind;
+	float volumeLeft;
+	float volumeRight;
+	int playing;
+	sndCallbackProc* finishCallback;
+	void* finishUserdata;
+};
+
+struct FilePlayer {
+	struct SoundSource source;
+	int loaded;
+	float length;
+	float offset;
+	float rate;
+	float bufferLength;
+	/** plays remaining; 0 = loop indefinitely */
+	int repeat;
+	float loopStart;
+	float loopEnd;
+	sndCallbackProc* loopCallback;
+	void* loopUserdata;
+	int underrun;
+	int stopOnUnderrun;
+};
+
+struct AudioSample {
+	uint8_t* data;
+	SoundFormat format;
+	uint32_t sampleRate;
+	uint32_t byteLength;
+	int ownsData;
+};
+
+struct SamplePlayer {
+	struct SoundSource source;
+	AudioSample* sample;
+	float offset;
+	float rate;
+	/** plays remaining; 0 = loop indefinitely */
+	int repeat;
+	int paused;
+	sndCallbackProc* loopCallback;
+	void* loopUserdata;
+};
+
+struct PDSynth {
+	struct SoundSource source;
+	SoundWaveform waveform;
+	AudioSample* sample;
+	float attack;
+	float decay;
+	float sustain;
+	float release;
+	float transpose;
+	/** seconds left in the note incl. release; < 0 = held until noteOff */
+	float remaining;
+};
+
+struct SoundChannel {
+	SoundSource* sources[HOST_MAX_CHANNEL_SOURCES];
+	int count;
+	float volume;
+};
+
+static SoundSource* sources[HOST_MAX_SOUND_SOURCES];
+static int numSources = 0;
+static SoundChannel defaultChannel;
+static uint64_t audioClockSamples = 0;
+static uint64_t lastTickNanos = 0;
+
+
+static void registerSource(SoundSource* s, HostSourceKind kind) {
+	memset(s, 0, sizeof(SoundSource));
+	s->kind = kind;
+	s->volumeLeft = 1.0f;
+	s->volumeRight = 1.0f;
+	if (numSources < HOST_MAX_SOUND_SOURCES) {
+		sources[numSources++] = s;
+	}
+}
+
+static void unregisterSource(SoundSource* s) {
+	for (int i = 0; i < numSources; i++) {
+		if (sources[i] == s) {
+			sources[i] = sources[--numSources];
+			break;
+		}
+	}
+	for (int i = 0; i < defaultChannel.count; i++) {
+		if (defaultChannel.sources[i] == s) {
+			defaultChannel.sources[i] = defaultChannel.sources[--defaultChannel.count];
+			break;
+		}
+	}
+}
+
+static void finishSource(SoundSource* s) {
+	s->playing = 0;
+	if (s->finishCallback != NULL) {
+		s->finishCallback(s, s->finishUserdata);
+	}
+}
+
+
+// - WAV
+
+static uint32_t readLE32(const uint8_t* p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t readLE16(const uint8_t* p) {
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/** Loads a RIFF/WAVE file; PCM is converted to 16-bit (as pdc does), IMA ADPCM is kept as is. */
+static AudioSample* loadWav(const char* hostPath) {
+	FILE* fp = fopen(hostPath, "rb");
+	if (fp == NULL) {
+		return NULL;
+	}
+	hostCountFileOpen();
+
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	uint8_t* file = malloc((size_t)size);
+	if (file == NULL || fread(file, 1, (size_t)size, fp) != (size_t)size || size < 12 || memcmp(file, "RIFF", 4) != 0 || memcmp(file + 8, "WAVE", 4) != 0) {
+		free(file);
+		fclose(fp);
+		return NULL;
+	}
+	fclose(fp);
+
+	uint16_t formatTag = 0, channels = 0, bitsPerSample = 0;
+	uint32_t sampleRate = 0;
+	const uint8_t* data = NULL;
+	uint32_t dataSize = 0;
+
+	long pos = 12;
+	while (pos + 8 <= size) {
+		const uint8_t* chunk = file + pos;
+		uint32_t chunkSize = readLE32(chunk + 4);
+		if (memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16) {
+			formatTag = readLE16(chunk + 8);
+			channels = readLE16(chunk + 10);
+			sampleRate = readLE32(chunk + 12);
+			bitsPerSample = readLE16(chunk + 22);
+		}
+		else if (memcmp(chunk, "data", 4) == 0) {
+			data = chunk + 8;
+			dataSize = (uint32_t)(pos + 8 + chunkSize <= size ? chunkSize : size - pos - 8);
+		}
+		pos += 8 + chunkSize + (chunkSize & 1);
+	}
+
+	AudioSample* sample = NULL;
+	if (data != NULL && channels >= 1 && channels <= 2) {
+		if (formatTag == 1 && (bitsPerSample == 8 || bitsPerSample == 16 || bitsPerSample == 24 || bitsPerSample == 32)) {
+			uint32_t bytesPerSample = bitsPerSample / 8;
+			uint32_t count = dataSize / bytesPerSample;
+			int is8 = bitsPerSample == 8;
+			uint32_t outBytes = is8 ? count : count * 2;
+			sample = hostAlloc(sizeof(AudioSample) + outBytes);
+			sample->data = (uint8_t*)(sample + 1);
+			sample->format = is8 ? (channels == 2 ? kSound8bitStereo : kSound8bitMono) : (channels == 2 ? kSound16bitStereo : kSound16bitMono);
+			sample->sampleRate = sampleRate;
+			sample->byteLength = outBytes;
+			sample->ownsData = 0;
+			if (is8 || bitsPerSample == 16) {
+				memcpy(sample->data, data, outBytes);
+			}
+			else {
+				int16_t* out = (int16_t*)sample->data;
+				for (uint32_t i = 0; i < count; i++) {
+					// keep the top 16 bits of each little-endian sample
+					const uint8_t* in = data + i * bytesPerSample + (bytesPerSample - 2);
+					out[i] = (int16_t)readLE16(in);
+				}
+			}
+		}
+		else if (formatTag == 0x11) {
+			sample = hostAlloc(sizeof(AudioSample) + dataSize);
+			sample->data = (uint8_t*)(sample + 1);
+			sample->format = channels == 2 ? kSoundADPCMStereo : kSoundADPCMMono;
+			sample->sampleRate = sampleRate;
+			sample->byteLength = dataSize;
+			sample->ownsData = 0;
+			memcpy(sample->data, data, dataSize);
+		}
+	}
+
+	free(file);
+	return sample;
+}
+
+static float sampleLength(AudioSample* sample) {
+	if (sample == NULL || sample->sampleRate == 0) {
+		return 0.0f;
+	}
+	uint32_t frames;
+	switch (sample->format) {
+		case kSound8bitMono: frames = sample->byteLength; break;
+		case kSound8bitStereo: frames = sample->byteLength / 2; break;
+		case kSound16bitMono: frames = sample->byteLength / 2; break;
+		case kSound16bitStereo: frames = sample->byteLength / 4; break;
+		case kSoundADPCMMono: frames = sample->byteLength * 2; break;
+		case kSoundADPCMStereo: frames = sample->byteLength; break;
+		default: frames = 0; break;
+	}
+	return (float)frames / (float)sample->sampleRate;
+}
+
+
+// - pd->sound->sample
+
+static AudioSample* sampleNewSampleBuffer(int byteCount) {
+	AudioSample* sample = hostAlloc(sizeof(AudioSample) + (size_t)byteCount);
+	sample->data = (uint8_t*)(sample + 1);
+	sample->format = kSound16bitMono;
+	sample->sampleRate = HOST_SAMPLE_RATE;
+	sample->byteLength = (uint32_t)byteCount;
+	sample->ownsData = 0;
+	memset(sample->data, 0, (size_t)byteCount);
+	return sample;
+}
+
+static AudioSample* sampleLoad(const char* path) {
+	static const char* extensions[] = { ".wav", "" };
+	char hostPath[HOST_PATH_MAX];
+	if (!hostResolveAssetPath(path, extensions, 2, hostPath, sizeof(hostPath))) {
+		return NULL;
+	}
+	return loadWav(hostPath);
+}
+
+static int sampleLoadIntoSample(AudioSample* sample, const char* path) {
+	AudioSample* loaded = sampleLoad(path);
+	if (loaded == NULL) {
+		return 0;
+	}
+	uint32_t n = loaded->byteLength < sample->byteLength ? loaded->byteLength : sample->byteLength;
+	memcpy(sample->data, loaded->data, n);
+	sample->format = loaded->format;
+	sample->sampleRate = loaded->sampleRate;
+	sample->byteLength = n;
+	hostFree(loaded);
+	return 1;
+}
+
+static AudioSample* sampleNewSampleFromData(uint8_t* data, SoundFormat format, uint32_t sampleRate, int byteCount, int shouldFreeData) {
+	AudioSample* sample = hostAlloc(sizeof(AudioSample));
+	sample->data = data;
+	sample->format = format;
+	sample->sampleRate = sampleRate;
+	sample->byteLength = (uint32_t)byteCount;
+	sample->ownsData = shouldFreeData;
+	return sample;
+}
+
+static void sampleGetData(AudioSample* sample, uint8_t** data, SoundFormat* format, uint32_t* sampleRate, uint32_t* bytelength) {
+	if (data != NULL) {
+		*data = sample->data;
+	}
+	if (format != NULL) {
+		*format = sample->format;
+	}
+	if (sampleRate != NULL) {
+		*sampleRate = sample->sampleRate;
+	}
+	if (bytelength != NULL) {
+		*bytelength = sample->byteLength;
+	}
+}
+
+static void sampleFreeSample(AudioSample* sample) {
+	if (sample == NULL) {
+		return;
+	}
+	if (sample->ownsData) {
+		hostFree(sample->data);
+	}
+	hostFree(sample);
+}
+
+static float sampleGetLength(AudioSample* sample) {
+	return sampleLength(sample);
+}
+
+static int sampleDecompress(AudioSample* sample) {
+	(void)sample;
+	return 1;
+}
+
+static const struct playdate_sound_sample hostSample = {
+	.newSampleBuffer = sampleNewSampleBuffer,
+	.loadIntoSample = sampleLoadIntoSample,
+	.load = sampleLoad,
+	.newSampleFromData = sampleNewSampleFromData,
+	.getData = sampleGetData,
+	.freeSample = sampleFreeSample,
+	.getLength = sampleGetLength,
+	.decompress = sampleDecompress,
+};
+
+
+// - pd->sound->sampleplayer
+
+static SamplePlayer* samplePlayerNewPlayer(void) {
+	SamplePlayer* player = hostAlloc(sizeof(SamplePlayer));
+	memset(player, 0, sizeof(SamplePlayer));
+	registerSource(&player->source, kHostSourceSamplePlayer);
+	player->rate = 1.0f;
+	return player;
+}
+
+static void samplePlayerFreePlayer(SamplePlayer* player) {
+	if (player == NULL) {
+		return;
+	}
+	unregisterSource(&player->source);
+	hostFree(player);
+}
+
+static void samplePlayerSetSample(SamplePlayer* player, AudioSample* sample) {
+	player->sample = sample;
+	player->offset = 0.0f;
+}
+
+static int samplePlayerPlay(SamplePlayer* player, int repeat, float rate) {
+	if (player->sample == NULL) {
+		return 0;
+	}
+	player->repeat = repeat < 0 ? 0 : repeat;
+	player->rate = rate;
+	player->offset = 0.0f;
+	player->paused = 0;
+	player->source.playing = 1;
+	return 1;
+}
+
+static int samplePlayerIsPlaying(SamplePlayer* player) {
+	return player->source.playing;
+}
+
+static void samplePlayerStop(SamplePlayer* player) {
+	if (player->source.playing) {
+		finishSource(&player->source);
+	}
+	player->offset = 0.0f;
+}
+
+static void samplePlayerSetVolume(SamplePlayer* player, float left, float right) {
+	player->source.volumeLeft = left;
+	player->source.volumeRight = right;
+}
+
+static void samplePlayerGetVolume(SamplePlayer* player, float* left, float* right) {
+	*left = player->source.volumeLeft;
+	*right = player->source.volumeRight;
+}
+
+static float samplePlayerGetLength(SamplePlayer* player) {
+	return sampleLength(player->sample);
+}
+
+static void samplePlayerSetOffset(SamplePlayer* player, float offset) {
+	player->offset = offset;
+}
+
+static void samplePlayerSetRate(SamplePlayer* player, float rate) {
+	player->rate = rate;
+}
+
+static void samplePlayerSetPlayRange(SamplePlayer* player, int start, int end) {
+	(void)player;
+	(void)start;
+	(void)end;
+}
+
+static void samplePlayerSetFinishCallback(SamplePlayer* player, sndCallbackProc callback, void* userdata) {
+	player->source.finishCallback = callback;
+	player->source.finishUserdata = userdata;
+}
+
+static void samplePlayerSetLoopCallback(SamplePlayer* player, sndCallbackProc callback, void* userdata) {
+	player->loopCallback = callback;
+	player->loopUserdata = userdata;
+}
+
+static float samplePlayerGetOffset(SamplePlayer* player) {
+	return player->offset;
+}
+
+static float samplePlayerGetRate(SamplePlayer* player) {
+	return player->rate;
+}
+
+static void samplePlayerSetPaused(SamplePlayer* player, int flag) {
+	player->paused = flag;
+}
+
+static const struct playdate_sound_sampleplayer hostSamplePlayer = {
+	.newPlayer = samplePlayerNewPlayer,
+	.freePlayer = samplePlayerFreePlayer,
+	.setSample = samplePlayerSetSample,
+	.play = samplePlayerPlay,
+	.isPlaying = samplePlayerIsPlaying,
+	.stop = samplePlayerStop,
+	.setVolume = samplePlayerSetVolume,
+	.getVolume = samplePlayerGetVolume,
+	.getLength = samplePlayerGetLength,
+	.setOffset = samplePlayerSetOffset,
+	.setRate = samplePlayerSetRate,
+	.setPlayRange = samplePlayerSetPlayRange,
+	.setFinishCallback = samplePlayerSetFinishCallback,
+	.setLoopCallback = samplePlayerSetLoopCallback,
+	.getOffset = samplePlayerGetOffset,
+	.getRate = samplePlayerGetRate,
+	.setPaused = samplePlayerSetPaused,
+};
+
+
+// - pd->sound->fileplayer
+
+/** Estimates an MP3's duration from its first frame header's bitrate (CBR assumption). */
+static float estimateMp3Length(const char* hostPath) {
+	static const int bitratesV1L3[16] = { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 };
+
+	FILE* fp = fopen(hostPath, "rb");
+	if (fp == NULL) {
+		return 0.0f;
+	}
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	uint8_t header[10];
+	long start = 0;
+	if (fread(header, 1, 10, fp) == 10 && memcmp(header, "ID3", 3) == 0) {
+		start = 10 + ((header[6] & 0x7f) << 21 | (header[7] & 0x7f) << 14 | (header[8] & 0x7f) << 7 | (header[9] & 0x7f));
+	}
+
+	int kbps = 128;
+	uint8_t buf[4096];
+	fseek(fp, start, SEEK_SET);
+	size_t n = fread(buf, 1, sizeof(buf), fp);
+	for (size_t i = 0; i + 2 < n; i++) {
+		if (buf[i] == 0xff && (buf[i + 1] & 0xe0) == 0xe0) {
+			int b = bitratesV1L3[buf[i + 2] >> 4];
+			if (b > 0) {
+				kbps = b;
+				break;
+			}
+		}
+	}
+	fclose(fp);
+
+	return (float)(size - start) * 8.0f / (kbps * 1000.0f);
+}
+
+static FilePlayer* filePlayerNewPlayer(void) {
+	FilePlayer* player = hostAlloc(sizeof(FilePlayer));
+	memset(player, 0, sizeof(FilePlayer));
+	registerSource(&player->source, kHostSourceFilePlayer);
+	player->rate = 1.0f;
+	player->bufferLength = 1.0f;
+	return player;
+}
+
+static void filePlayerFreePlayer(FilePlayer* player) {
+	if (player == NULL) {
+		return;
+	}
+	unregisterSource(&player->source);
+	hostFree(player);
+}
+
+static int filePlayerLoadIntoPlayer(FilePlayer* player, const char* path) {
+	static const char* extensions[] = { "", ".mp3", ".wav" };
+	char hostPath[HOST_PATH_MAX];
+	if (!hostResolveAssetPath(path, extensions, 3, hostPath, sizeof(hostPath))) {
+		return 0;
+	}
+	hostCountFileOpen();
+
+	size_t len = strlen(hostPath);
+	if (len > 4 && strcmp(hostPath + len - 4, ".wav") == 0) {
+		AudioSample* sample = loadWav(hostPath);
+		player->length = sampleLength(sample);
+		sampleFreeSample(sample);
+	}
+	else {
+		player->length = estimateMp3Length(hostPath);
+	}
+	player->loaded = 1;
+	player->offset = 0.0f;
+	return 1;
+}
+
+static void filePlayerSetBufferLength(FilePlayer* player, float bufferLen) {
+	player->bufferLength = bufferLen;
+}
+
+static int filePlayerPlay(FilePlayer* player, int repeat) {
+	if (!player->loaded) {
+		return 0;
+	}
+	player->repeat = repeat < 0 ? 0 : repeat;
+	player->source.playing = 1;
+	return 1;
+}
+
+static int filePlayerIsPlaying(FilePlayer* player) {
+	return player->source.playing;
+}
+
+static void filePlayerPause(FilePlayer* player) {
+	player->source.playing = 0;
+}
+
+static void filePlayerStop(FilePlayer* player) {
+	if (player->source.playing) {
+		finishSource(&player->source);
+	}
+	player->offset = 0.0f;
+}
+
+static void filePlayerSetVolume(FilePlayer* player, float left, float right) {
+	player->source.volumeLeft = left;
+	player->source.volumeRight = right;
+}
+
+static void filePlayerGetVolume(FilePlayer* player, float* left, float* right) {
+	*left = player->source.volumeLeft;
+	*right = player->source.volumeRight;
+}
+
+static float filePlayerGetLength(FilePlayer* player) {
+	return player->length;
+}
+
+static void filePlayerSetOffset(FilePlayer* player, float offset) {
+	player->offset = offset;
+}
+
+static void filePlayerSetRate(FilePlayer* player, float rate) {
+	player->rate = rate;
+}
+
+static void filePlayerSetLoopRange(FilePlayer* player, float start, float end) {
+	player->loopStart = start;
+	player->loopEnd = end;
+}
+
+static int filePlayerDidUnderrun(FilePlayer* player) {
+	int underrun = player->underrun;
+	player->underrun = 0;
+	return underrun;
+}
+
+static void filePlayerSetFinishCallback(FilePlayer* player, sndCallbackProc callback, void* userdata) {
+	player->source.finishCallback = callback;
+	player->source.finishUserdata = userdata;
+}
+
+static void filePlayerSetLoopCallback(FilePlayer* player, sndCallbackProc callback, void* userdata) {
+	player->loopCallback = callback;
+	player->loopUserdata = userdata;
+}
+
+static float filePlayerGetOffset(FilePlayer* player) {
+	return player->offset;
+}
+
+static float filePlayerGetRate(FilePlayer* player) {
+	return player->rate;
+}
+
+static void filePlayerSetStopOnUnderrun(FilePlayer* player, int flag) {
+	player->stopOnUnderrun = flag;
+}
+
+static void filePlayerFadeVolume(FilePlayer* player, float left, float right, int32_t len, sndCallbackProc finishCallback, void* userdata) {
+	(void)len;
+	player->source.volumeLeft = left;
+	player->source.volumeRight = right;
+	if (finishCallback != NULL) {
+		finishCallback(&player->source, userdata);
+	}
+}
+
+static const struct playdate_sound_fileplayer hostFilePlayer = {
+	.newPlayer = filePlayerNewPlayer,
+	.freePlayer = filePlayerFreePlayer,
+	.loadIntoPlayer = filePlayerLoadIntoPlayer,
+	.setBufferLength = filePlayerSetBufferLength,
+	.play = filePlayerPlay,
+	.isPlaying = filePlayerIsPlaying,
+	.pause = filePlayerPause,
+	.stop = filePlayerStop,
+	.setVolume = filePlayerSetVolume,
+	.getVolume = filePlayerGetVolume,
+	.getLength = filePlayerGetLength,
+	.setOffset = filePlayerSetOffset,
+	.setRate = filePlayerSetRate,
+	.setLoopRange = filePlayerSetLoopRange,
+	.didUnderrun = filePlayerDidUnderrun,
+	.setFinishCallback = filePlayerSetFinishCallback,
+	.setLoopCallback = filePlayerSetLoopCallback,
+	.getOffset = filePlayerGetOffset,
+	.getRate = filePlayerGetRate,
+	.setStopOnUnderrun = filePlayerSetStopOnUnderrun,
+	.fadeVolume = filePlayerFadeVolume,
+};
+
+
+// - pd->sound->synth
+
+static PDSynth* synthNewSynth(void) {
+	PDSynth* synth = hostAlloc(sizeof(PDSynth));
+	memset(synth, 0, sizeof(PDSynth));
+	registerSource(&synth->source, kHostSourceSynth);
+	synth->sustain = 1.0f;
+	return synth;
+}
+
+static void synthFreeSynth(PDSynth* synth) {
+	if (synth == NULL) {
+		return;
+	}
+	unregisterSource(&synth->source);
+	hostFree(synth);
+}
+
+static void synthSetWaveform(PDSynth* synth, SoundWaveform wave) {
+	synth->waveform = wave;
+}
+
+static void synthSetSample(PDSynth* synth, AudioSample* sample, uint32_t sustainStart, uint32_t sustainEnd) {
+	(void)sustainStart;
+	(void)sustainEnd;
+	synth->sample = sample;
+}
+
+static void synthSetAttackTime(PDSynth* synth, float attack) {
+	synth->attack = attack;
+}
+
+static void synthSetDecayTime(PDSynth* synth, float decay) {
+	synth->decay = decay;
+}
+
+static void synthSetSustainLevel(PDSynth* synth, float sustain) {
+	synth->sustain = sustain;
+}
+
+static void synthSetReleaseTime(PDSynth* synth, float release) {
+	synth->release = release;
+}
+
+static void synthSetTranspose(PDSynth* synth, float halfSteps) {
+	synth->transpose = halfSteps;
+}
+
+static void synthPlayNote(PDSynth* synth, float freq, float vel, float len, uint32_t when) {
+	(void)freq;
+	(void)vel;
+	(void)when;
+	synth->remaining = len < 0.0f ? -1.0f : len + synth->release;
+	synth->source.playing = 1;
+}
+
+static void synthPlayMIDINote(PDSynth* synth, MIDINote note, float vel, float len, uint32_t when) {
+	synthPlayNote(synth, 440.0f * powf(2.0f, (note - 69.0f) / 12.0f), vel, len, when);
+}
+
+static void synthNoteOff(PDSynth* synth, uint32_t when) {
+	(void)when;
+	if (synth->source.playing) {
+		synth->remaining = synth->release;
+	}
+}
+
+static void synthStop(PDSynth* synth) {
+	if (synth->source.playing) {
+		finishSource(&synth->source);
+	}
+}
+
+static void synthSetVolume(PDSynth* synth, float left, float right) {
+	synth->source.volumeLeft = left;
+	synth->source.volumeRight = right;
+}
+
+static void synthGetVolume(PDSynth* synth, float* left, float* right) {
+	*left = synth->source.volumeLeft;
+	*right = synth->source.volumeRight;
+}
+
+static int synthIsPlaying(PDSynth* synth) {
+	return synth->source.playing;
+}
+
+static int synthGetParameterCount(PDSynth* synth) {
+	(void)synth;
+	return 0;
+}
+
+static int synthSetParameter(PDSynth* synth, int parameter, float value) {
+	(void)synth;
+	(void)parameter;
+	(void)value;
+	return 0;
+}
+
+static const struct playdate_sound_synth hostSynth = {
+	.newSynth = synthNewSynth,
+	.freeSynth = synthFreeSynth,
+	.setWaveform = synthSetWaveform,
+	.setSample = synthSetSample,
+	.setAttackTime = synthSetAttackTime,
+	.setDecayTime = synthSetDecayTime,
+	.setSustainLevel = synthSetSustainLevel,
+	.setReleaseTime = synthSetReleaseTime,
+	.setTranspose = synthSetTranspose,
+	.getParameterCount = synthGetParameterCount,
+	.setParameter = synthSetParameter,
+	.playNote = synthPlayNote,
+	.playMIDINote = synthPlayMIDINote,
+	.noteOff = synthNoteOff,
+	.stop = synthStop,
+	.setVolume = synthSetVolume,
+	.getVolume = synthGetVolume,
+	.isPlaying = synthIsPlaying,
+};
+
+
+// - pd->sound->channel, pd->sound->source, pd->sound
+
+static SoundChannel* channelNewChannel(void) {
+	SoundChannel* channel = hostAlloc(sizeof(SoundChannel));
+	memset(channel, 0, sizeof(SoundChannel));
+	channel->volume = 1.0f;
+	return channel;
+}
+
+static void channelFreeChannel(SoundChannel* channel) {
+	if (channel != &defaultChannel) {
+		hostFree(channel);
+	}
+}
+
+static int channelAddSource(SoundChannel* channel, SoundSource* source) {
+	for (int i = 0; i < channel->count; i++) {
+		if (channel->sources[i] == source) {
+			return 0;
+		}
+	}
+	if (channel->count >= HOST_MAX_CHANNEL_SOURCES) {
+		return 0;
+	}
+	channel->sources[channel->count++] = source;
+	return 1;
+}
+
+static int channelRemoveSource(SoundChannel* channel, SoundSource* source) {
+	for (int i = 0; i < channel->count; i++) {
+		if (channel->sources[i] == source) {
+			channel->sources[i] = channel->sources[--channel->count];
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static SoundSource* channelAddCallbackSource(SoundChannel* channel, AudioSourceFunction* callback, void* context, int stereo) {
+	(void)callback;
+	(void)context;
+	(void)stereo;
+	SoundSource* source = hostAlloc(sizeof(SoundSource));
+	registerSource(source, kHostSourceCallback);
+	source->playing = 1;
+	channelAddSource(channel, source);
+	return source;
+}
+
+static void channelSetVolume(SoundChannel* channel, float volume) {
+	channel->volume = volume;
+}
+
+static float channelGetVolume(SoundChannel* channel) {
+	return channel->volume;
+}
+
+static const struct playdate_sound_channel hostChannel = {
+	.newChannel = channelNewChannel,
+	.freeChannel = channelFreeChannel,
+	.addSource = channelAddSource,
+	.removeSource = channelRemoveSource,
+	.addCallbackSource = channelAddCallbackSource,
+	.setVolume = channelSetVolume,
+	.getVolume = channelGetVolume,
+};
+
+static void sourceSetVolume(SoundSource* c, float lvol, float rvol) {
+	c->volumeLeft = lvol;
+	c->volumeRight = rvol;
+}
+
+static void sourceGetVolume(SoundSource* c, float* outl, float* outr) {
+	*outl = c->volumeLeft;
+	*outr = c->volumeRight;
+}
+
+static int sourceIsPlaying(SoundSource* c) {
+	return c->playing;
+}
+
+static void sourceSetFinishCallback(SoundSource* c, sndCallbackProc callback, void* userdata) {
+	c->finishCallback = callback;
+	c->finishUserdata = userdata;
+}
+
+static const struct playdate_sound_source hostSource = {
+	.setVolume = sourceSetVolume,
+	.getVolume = sourceGetVolume,
+	.isPlaying = sourceIsPlaying,
+	.setFinishCallback = sourceSetFinishCallback,
+};
+
+static uint32_t soundGetCurrentTime(void) {
+	return (uint32_t)audioClockSamples;
+}
+
+static SoundSource* soundAddSource(AudioSourceFunction* callback, void* context, int stereo) {
+	return channelAddCallbackSource(&defaultChannel, callback, context, stereo);
+}
+
+static SoundChannel* soundGetDefaultChannel(void) {
+	return &defaultChannel;
+}
+
+static int soundAddChannel(SoundChannel* channel) {
+	(void)channel;
+	return 1;
+}
+
+static int soundRemoveChannel(SoundChannel* channel) {
+	(void)channel;
+	return 1;
+}
+
+static void soundSetOutputsActive(int headphone, int speaker) {
+	(void)headphone;
+	(void)speaker;
+}
+
+static int soundRemoveSource(SoundSource* source) {
+	int removed = channelRemoveSource(&defaultChannel, source);
+	if (source->kind == kHostSourceCallback) {
+		unregisterSource(source);
+		hostFree(source);
+	}
+	return removed;
+}
+
+static const char* soundGetError(void) {
+	return NULL;
+}
+
+const struct playdate_sound hostSound = {
+	.channel = &hostChannel,
+	.fileplayer = &hostFilePlayer,
+	.sample = &hostSample,
+	.sampleplayer = &hostSamplePlayer,
+	.synth = &hostSynth,
+	.source = &hostSource,
+	.getCurrentTime = soundGetCurrentTime,
+	.addSource = soundAddSource,
+	.getDefaultChannel = soundGetDefaultChannel,
+	.addChannel = soundAddChannel,
+	.removeChannel = soundRemoveChannel,
+	.setOutputsActive = soundSetOutputsActive,
+	.removeSource = soundRemoveSource,
+	.getError = soundGetError,
+};
+
+
+// - virtual audio clock
+
+static void tickFilePlayer(FilePlayer* player, float seconds, float wallSeconds) {
+	if (wallSeconds > player->bufferLength) {
+		// the frame took longer than the stream buffer holds; on device this is an audible dropout
+		player->underrun = 1;
+		if (player->stopOnUnderrun) {
+			finishSource(&player->source);
+			return;
+		}
+	}
+
+	player->offset += seconds * player->rate;
+	float end = player->loopEnd > 0.0f ? player->loopEnd : player->length;
+	while (player->source.playing && end > 0.0f && player->offset >= end) {
+		if (player->repeat == 1) {
+			player->offset = 0.0f;
+			finishSource(&player->source);
+			return;
+		}
+		if (player->repeat > 1) {
+			player->repeat--;
+		}
+		player->offset = player->loopStart + (player->offset - end);
+		if (player->loopCallback != NULL) {
+			player->loopCallback(&player->source, player->loopUserdata);
+		}
+	}
+}
+
+static void tickSamplePlayer(SamplePlayer* player, float seconds) {
+	if (player->paused) {
+		return;
+	}
+	float length = sampleLength(player->sample);
+	player->offset += seconds * (player->rate > 0.0f ? player->rate : -player->rate);
+	while (player->source.playing && length > 0.0f && player->offset >= length) {
+		if (player->repeat == 1) {
+			player->offset = 0.0f;
+			finishSource(&player->source);
+			return;
+		}
+		if (player->repeat > 1) {
+			player->repeat--;
+		}
+		player->offset -= length;
+		if (player->loopCallback != NULL) {
+			player->loopCallback(&player->source, player->loopUserdata);
+		}
+	}
+}
+
+static void tickSynth(PDSynth* synth, float seconds) {
+	if (synth->remaining < 0.0f) {
+		return;
+	}
+	synth->remaining -= seconds;
+	if (synth->remaining <= 0.0f) {
+		synth->remaining = 0.0f;
+		finishSource(&synth->source);
+	}
+}
+
+void hostSoundTick(float seconds) {
+	uint64_t now = hostNowNanos();
+	float wallSeconds = lastTickNanos != 0 ? (float)((now - lastTickNanos) / 1e9) : 0.0f;
+	lastTickNanos = now;
+
+	audioClockSamples += (uint64_t)(seconds * HOST_SAMPLE_RATE);
+
+	for (int i = 0; i < numSources; i++) {
+		SoundSource* s = sources[i];
+		if (!s->playing) {
+			continue;
+		}
+		switch (s->kind) {
+			case kHostSourceFilePlayer:
+				tickFilePlayer((FilePlayer*)s, seconds, wallSeconds);
+				break;
+			case kHostSourceSamplePlayer:
+				tickSamplePlayer((SamplePlayer*)s, seconds);
+				break;
+			case kHostSourceSynth:
+				tickSynth((PDSynth*)s, seconds);
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+void hostSoundInit(void) {
+	memset(&defaultChannel, 0, sizeof(defaultChannel));
+	defaultChannel.volume = 1.0f;
+	numSources = 0;
+	audioClockSamples = 0;
+	lastTickNanos = 0;
+}
+
+void hostSoundShutdown(void) {
+	numSources = 0;
+	defaultChannel.count = 0;
+}
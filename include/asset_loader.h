@@ -0,0 +1,78 @@
+#ifndef asset_loader_h
+#define asset_loader_h
+
+#include <stdint.h>
+
+#include "pd_api.h"
+
+/** The maximum number of jobs of an AssetLoader */
+#define ASSET_LOADER_MAX_JOBS 16
+
+/**
+ * Does (a step of) a job's loading.
+ *
+ * @return 1 once the job is done; 0 to be called again (e.g. for the next of several files)
+ */
+typedef int AssetLoaderStepFunction(PlaydateAPI* pd, void* userdata);
+
+typedef struct {
+	const char* name;
+	/** Jobs run in order of priority (lowest first), then in the order they were added */
+	int priority;
+	AssetLoaderStepFunction* step;
+	void* userdata;
+} AssetLoaderJob;
+
+typedef struct {
+	/** Step function calls, and assetLoaderUpdate() calls that ran any */
+	uint32_t steps;
+	uint32_t updates;
+	/** The time spent loading in total, and in the longest step (and its job), in seconds */
+	float totalTime;
+	float maxStepTime;
+	const char* maxStepJob;
+	/** The longest time an assetLoaderUpdate() call spent loading (its budget, plus the overrun of its last step), in seconds */
+	float maxUpdateTime;
+} AssetLoaderStats;
+
+/**
+ * A queue of loading jobs run a bit at a time from update(), within a time budget per frame, in priority order: e.g.
+ * what the first frame needs first, then the rest alongside interaction, so startup time doesn't grow with the assets
+ * loaded.
+ */
+typedef struct {
+	AssetLoaderJob jobs[ASSET_LOADER_MAX_JOBS];
+	int numJobs;
+	/** The index of the job running (the jobs before it are done) */
+	int current;
+	AssetLoaderStats stats;
+} AssetLoader;
+
+void assetLoaderInit(AssetLoader* loader);
+
+/**
+ * Queues a job, after the queued jobs of the same or lower priority.
+ *
+ * @return 1 on success; otherwise 0 (ASSET_LOADER_MAX_JOBS queued, or priority lower than that of the job running)
+ */
+int assetLoaderAdd(AssetLoader* loader, const char* name, int priority, AssetLoaderStepFunction* step, void* userdata);
+
+/**
+ * Runs job steps, in order, until budget seconds have passed (at least one step, if any jobs are left: a step can't be
+ * interrupted, so a step longer than the budget left overruns it).
+ *
+ * @return 1 if all jobs are done
+ */
+int assetLoaderUpdate(PlaydateAPI* pd, AssetLoader* loader, float budget);
+
+/**
+ * @return 1 if all jobs of priority up to priority (i.e. of the same or higher priority) are done
+ */
+int assetLoaderIsDone(const AssetLoader* loader, int priority);
+
+/**
+ * @return the fraction of the jobs of priority up to priority that are done, in [0, 1]
+ */
+float assetLoaderProgress(const AssetLoader* loader, int priority);
+
+#endif /* asset_loader_h */
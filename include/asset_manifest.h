@@ -0,0 +1,52 @@
+#ifndef asset_manifest_h
+#define asset_manifest_h
+
+#include <stdint.h>
+
+/*
+ * Asset manifest: every asset in src/assets by ID, with its kind, load path, dimensions and byte size, generated at build
+ * time by gen-asset-manifest.cmake (into asset_manifest_data.h in the build directory, see there for the ID names and
+ * the other constants generated). Code refers to assets by ID, so missing assets fail the build rather than the device.
+ */
+
+typedef enum {
+	/** A PNG image, compiled by pdc (loaded without extension) */
+	kAssetKindImage,
+	/**
+	 * A numbered sequence of same-sized frame images, packed into one frame pack at build time (path: the .framepack's,
+	 * see frame_pack.h; without Python, the frames are staged as the images that follow this entry instead)
+	 */
+	kAssetKindFrameSequence,
+	/**
+	 * An image larger than the screen, tiled into a tile set at build time (path: the .tileset's, see tile_set.h;
+	 * without Python, it isn't staged); follows the image's own entry
+	 */
+	kAssetKindTileSet,
+	kAssetKindFont,
+	/** Audio loaded as a sample (transcoded per src/audio_manifest.json) */
+	kAssetKindSound,
+	/** Audio streamed by a file player (from a music/ directory) */
+	kAssetKindMusic,
+	/** Any other file, copied as it is (path with extension) */
+	kAssetKindData
+} AssetKind;
+
+typedef struct {
+	AssetKind kind;
+	/** The path to load the asset by, as staged into the game's Source/ */
+	const char* path;
+	/** Images and tile sets: in pixels; frame sequences: per frame (0 otherwise) */
+	int width;
+	int height;
+	/** The source file's size in bytes (frame sequences: all frames'); staged files may differ (transcoded or packed) */
+	uint32_t size;
+	/** Frame sequences: the ID of the first frame (the others follow in order) and the number of frames (0 otherwise) */
+	int first;
+	int count;
+} AssetInfo;
+
+#include "asset_manifest_data.h"
+
+extern const AssetInfo assetManifest[kNumAssets];
+
+#endif /* asset_manifest_h */
@@ -0,0 +1,94 @@
+#ifndef bitmap_cache_h
+#define bitmap_cache_h
+
+#include <stdint.h>
+
+#include "pd_api.h"
+
+#include "memory_arena.h"
+
+/**
+ * Loads frame index, e.g. from a frame pack or an image file.
+ *
+ * @param reuse an evicted bitmap to load into (if possible), or NULL; if it isn't used, the function has to free it
+ * @return the loaded bitmap, or NULL on error
+ */
+typedef LCDBitmap* BitmapCacheLoadFunction(PlaydateAPI* pd, int index, LCDBitmap* reuse, void* userdata);
+
+typedef struct {
+	/** bitmapCacheSetWindow() requests whose frame was resident */
+	uint32_t hits;
+	/** bitmapCacheSetWindow() requests whose frame had to be loaded on the spot */
+	uint32_t misses;
+	/** Neighbour frames loaded ahead of being requested */
+	uint32_t prefetches;
+	uint32_t evictions;
+	uint32_t loadErrors;
+	int resident;
+	int peakResident;
+} BitmapCacheStats;
+
+/**
+ * A residency-bounded cache of a looping sequence of frames (e.g. rotation stills): the current frame plus radius
+ * neighbours in each direction are kept loaded; other frames stay resident while the budget allows and are evicted
+ * least recently used first.
+ */
+typedef struct {
+	int frameCount;
+	int radius;
+	/** Maximum number of resident frames; at least the window's 2 * radius + 1 */
+	int budget;
+	BitmapCacheLoadFunction* load;
+	void* userdata;
+	LCDBitmap** bitmaps;
+	/** Per-frame use stamps (from clock) for least-recently-used eviction */
+	uint32_t* lastUsed;
+	/** The arena bitmaps and lastUsed were allocated from (NULL: the heap) */
+	MemoryArena* arena;
+	uint32_t clock;
+	int center;
+	BitmapCacheStats stats;
+} BitmapCache;
+
+/**
+ * Allocates the cache's tables from arena (NULL: the heap).
+ *
+ * @return 1 on success; otherwise 0 (out of memory)
+ */
+int bitmapCacheInit(PlaydateAPI* pd, BitmapCache* cache, int frameCount, int radius, int budget, BitmapCacheLoadFunction* load, void* userdata, MemoryArena* arena);
+
+/**
+ * Frees all resident bitmaps and the cache's tables (unless allocated from an arena: those go with the arena).
+ */
+void bitmapCacheFree(PlaydateAPI* pd, BitmapCache* cache);
+
+/**
+ * Makes center the current frame: loads it if needed (counted as a hit or miss), then loads its missing neighbours,
+ * nearest first, evicting frames outside the window as the budget requires.
+ *
+ * @return center's bitmap, or NULL if it couldn't be loaded
+ */
+LCDBitmap* bitmapCacheSetWindow(PlaydateAPI* pd, BitmapCache* cache, int center);
+
+/**
+ * Makes center the current frame, loading only it if needed (counted as a hit or miss); its neighbours are left to
+ * bitmapCachePrefetch().
+ *
+ * @return center's bitmap, or NULL if it couldn't be loaded
+ */
+LCDBitmap* bitmapCacheSetCenter(PlaydateAPI* pd, BitmapCache* cache, int center);
+
+/**
+ * Loads up to maxLoads (all if negative) of the current frame's missing neighbours, nearest first, e.g. to spread
+ * loading the window over several frames.
+ *
+ * @return the number of neighbours still missing (frames that failed to load aren't counted)
+ */
+int bitmapCachePrefetch(PlaydateAPI* pd, BitmapCache* cache, int maxLoads);
+
+/**
+ * @return frame index's bitmap if resident, otherwise NULL (not counted, no loading)
+ */
+LCDBitmap* bitmapCachePeek(const BitmapCache* cache, int index);
+
+#endif /* bitmap_cache_h */
@@ -0,0 +1,44 @@
+#ifndef frame_blend_h
+#define frame_blend_h
+
+#include <stdint.h>
+
+#include "pd_api.h"
+
+/** The number of blend levels between two frames (the 4x4 Bayer matrix's thresholds): level 0 is all of the first frame */
+#define FRAME_BLEND_LEVELS 16
+/** The number of in-between frames kept by a FrameBlendRing */
+#define FRAME_BLEND_RING_SIZE 4
+
+/**
+ * Renders an in-between frame of two same-sized, opaque 1-bit bitmaps into out by ordered dithering: pixels whose
+ * Bayer threshold is below level are taken from b, the others from a.
+ *
+ * @return 1 on success; otherwise 0 (bitmaps of different sizes, or with masks)
+ */
+int frameBlend(PlaydateAPI* pd, LCDBitmap* a, LCDBitmap* b, int level, LCDBitmap* out);
+
+/**
+ * A small ring of the most recently rendered in-between frames, keyed by the first frame's index and the blend level
+ * (the second frame being implied, e.g. the first frame's successor). Slots are reused oldest first.
+ */
+typedef struct {
+	LCDBitmap* bitmaps[FRAME_BLEND_RING_SIZE];
+	int indices[FRAME_BLEND_RING_SIZE];
+	int levels[FRAME_BLEND_RING_SIZE];
+	int next;
+	uint32_t hits;
+	uint32_t misses;
+} FrameBlendRing;
+
+void frameBlendRingInit(FrameBlendRing* ring);
+
+/**
+ * @return the in-between frame of a (frame index) and b at level, from the ring or rendered into its oldest slot;
+ * NULL on error
+ */
+LCDBitmap* frameBlendRingGet(PlaydateAPI* pd, FrameBlendRing* ring, int index, int level, LCDBitmap* a, LCDBitmap* b);
+
+void frameBlendRingFree(PlaydateAPI* pd, FrameBlendRing* ring);
+
+#endif /* frame_blend_h */
@@ -0,0 +1,67 @@
+#ifndef frame_delta_h
+#define frame_delta_h
+
+#include <stdint.h>
+
+#include "pd_api.h"
+
+#include "memory_arena.h"
+
+/**
+ * A run of changed words within one row: delta words [wordIndex, wordIndex + numWords) apply to the row's words
+ * [firstWord, firstWord + numWords).
+ */
+typedef struct {
+	uint16_t row;
+	uint8_t firstWord;
+	uint8_t numWords;
+	uint32_t wordIndex;
+} FrameDeltaSpan;
+
+/**
+ * The XOR difference of two same-sized, opaque 1-bit bitmaps, as spans of changed 32-bit words per row: XOR'ing it onto
+ * one image (e.g. in the frame buffer) turns it into the other, either way round.
+ */
+typedef struct {
+	/** 1 once computed (successfully or not) */
+	int computed;
+	/** 1 if the delta exceeded the word limit it was computed with (or couldn't be computed): blit the frame instead */
+	int full;
+	int numSpans;
+	int numWords;
+	/** The topmost and bottommost changed rows (-1 if none) */
+	int top;
+	int bottom;
+	FrameDeltaSpan* spans;
+	uint32_t* words;
+	/** The arena spans and words were allocated from (NULL: the heap) */
+	MemoryArena* arena;
+} FrameDelta;
+
+/**
+ * Computes the delta between bitmaps a and b (same size, no mask, at most 255 words per row).
+ *
+ * @param maxWords the largest delta (in words) worth keeping; bigger deltas are only flagged as full
+ * @param arena the arena to allocate the delta from (NULL: the heap); if it overflows, the delta is flagged as full
+ */
+void frameDeltaCompute(PlaydateAPI* pd, FrameDelta* delta, LCDBitmap* a, LCDBitmap* b, int maxWords, MemoryArena* arena);
+
+/**
+ * XORs a (not full) delta onto frame (rows of rowbytes bytes, word-aligned; e.g. the display frame buffer),
+ * leaving out rows flagged in skipRows (if not NULL). Rows changed are flagged in rowsTouched.
+ */
+void frameDeltaApply(const FrameDelta* delta, uint8_t* frame, int rowbytes, const uint8_t* skipRows, uint8_t* rowsTouched);
+
+/**
+ * Copies the words a delta spans from src (rows of srcRowbytes bytes) into frame, leaving out rows flagged in skipRows
+ * (if not NULL). Rows changed are flagged in rowsTouched. This switches frame between any two images that only differ
+ * where the delta does, e.g. in-between frames of the delta's two frames.
+ */
+void frameDeltaCopy(const FrameDelta* delta, uint8_t* frame, int rowbytes, const uint8_t* src, int srcRowbytes, const uint8_t* skipRows, uint8_t* rowsTouched);
+
+/**
+ * Frees a delta's spans and words (unless allocated from an arena: those go with the arena).
+ */
+void frameDeltaFree(PlaydateAPI* pd, FrameDelta* delta);
+
+#endif /* frame_delta_h */
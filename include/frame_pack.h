@@ -0,0 +1,71 @@
+#ifndef frame_pack_h
+#define frame_pack_h
+
+#include <stdint.h>
+
+#include "pd_api.h"
+
+#include "memory_arena.h"
+
+/** Frame encodings in a frame pack's index (see scripts/pack_frames.py for the file format) */
+#define FRAME_PACK_ENCODING_KEY 0
+#define FRAME_PACK_ENCODING_DELTA 1
+
+/**
+ * A sequence of same-sized 1-bit frames (e.g. rotation stills) packed into one file at build time by
+ * scripts/pack_frames.py: rows of 32-bit words, run-length encoded, each frame either a key frame or the XOR delta
+ * to its previous frame.
+ *
+ * The whole file is read with one open and one read; the encoded frames stay resident in buffer, so frames can be
+ * decoded (again) later without file access.
+ */
+typedef struct {
+	int frameCount;
+	int width;
+	int height;
+	/** 32-bit words per packed row */
+	int rowWords;
+	/** Every keyInterval-th frame is a key frame, bounding the delta frames decoded for a single frame */
+	int keyInterval;
+	/** The pack file's contents */
+	uint8_t* buffer;
+	uint32_t bufferSize;
+	/** The arena buffer was allocated from (NULL: the heap) */
+	MemoryArena* arena;
+	const uint8_t* index;
+	const uint8_t* data;
+	uint32_t dataSize;
+} FramePack;
+
+/**
+ * Reads and validates a frame pack file, into a buffer allocated from arena (NULL: the heap).
+ *
+ * @return 1 on success; otherwise 0, with outErr (if not NULL) set to a static description, pack left empty and arena
+ * released back to where it was
+ */
+int framePackLoad(PlaydateAPI* pd, FramePack* pack, const char* path, MemoryArena* arena, const char** outErr);
+
+/**
+ * Frees a frame pack's buffer (unless allocated from an arena: it goes with the arena; bitmaps decoded from it are
+ * unaffected).
+ */
+void framePackFree(PlaydateAPI* pd, FramePack* pack);
+
+/**
+ * Decodes frame index into bitmap's data, starting from its nearest preceding key frame.
+ * bitmap has to be pack->width by pack->height and without mask (e.g. from newBitmap()).
+ *
+ * @return 1 on success; otherwise 0 (corrupt frame, or unsuitable bitmap)
+ */
+int framePackDecodeFrame(PlaydateAPI* pd, const FramePack* pack, int index, LCDBitmap* bitmap);
+
+/**
+ * Decodes frame index into bitmap's data from an adjacent frame (neighbourIndex being index - 1 or index + 1) already
+ * decoded into neighbour: the delta between them is applied to a copy of neighbour (XOR deltas work both ways),
+ * a key frame is decoded on its own. Cheaper than framePackDecodeFrame() when neighbours are at hand.
+ *
+ * @return 1 on success; otherwise 0 (also if the two frames aren't linked by a delta, e.g. neighbour is a key frame)
+ */
+int framePackDecodeFrameFrom(PlaydateAPI* pd, const FramePack* pack, int index, LCDBitmap* neighbour, int neighbourIndex, LCDBitmap* bitmap);
+
+#endif /* frame_pack_h */
@@ -0,0 +1,101 @@
+#ifndef frame_profiler_h
+#define frame_profiler_h
+
+/*
+ * Frame profiler: per-section timers within update(), kept per frame in a ring buffer, summarized as p50/p95/p99 per
+ * section and a frame time histogram, and optionally drawn as an overlay.
+ *
+ * Only compiled in if FRAME_PROFILER_ENABLED is defined to 1 (by CMake for all but Release builds); otherwise the
+ * PROFILE_BEGIN/PROFILE_END section macros expand to nothing, frame_profiler.c compiles to nothing, and any other use
+ * has to be within #if FRAME_PROFILER_ENABLED.
+ */
+
+#if FRAME_PROFILER_ENABLED
+
+#include <stdint.h>
+
+#include "pd_api.h"
+#include "font_blitter.h"
+#include "memory_arena.h"
+
+/** The maximum number of sections */
+#define FRAME_PROFILER_MAX_SECTIONS 8
+/** The number of frames kept (the window percentiles are taken over) */
+#define FRAME_PROFILER_RING_SIZE 128
+/** Frames between recomputing the summary */
+#define FRAME_PROFILER_STATS_INTERVAL 15
+/** Frame time histogram bins, of FRAME_PROFILER_HISTOGRAM_BIN_US each (the last one also counts all longer frames) */
+#define FRAME_PROFILER_HISTOGRAM_BINS 20
+#define FRAME_PROFILER_HISTOGRAM_BIN_US 2000
+
+typedef struct {
+	uint32_t p50;
+	uint32_t p95;
+	uint32_t p99;
+} FrameProfilerPercentiles;
+
+typedef struct {
+	const char* const* names;
+	int numSections;
+	/** getElapsedTime() when each section was last entered */
+	float sectionStart[FRAME_PROFILER_MAX_SECTIONS];
+	/** The current frame's time per section so far, in microseconds */
+	uint32_t current[FRAME_PROFILER_MAX_SECTIONS];
+	/** Per frame: the time of each section, and (at index numSections) of the whole frame, in microseconds */
+	uint32_t samples[FRAME_PROFILER_RING_SIZE][FRAME_PROFILER_MAX_SECTIONS + 1];
+	int next;
+	int count;
+	int framesUntilStats;
+	/** The summary of the frames in the ring, as of the last recompute (index numSections: whole frames) */
+	FrameProfilerPercentiles percentiles[FRAME_PROFILER_MAX_SECTIONS + 1];
+	uint16_t histogram[FRAME_PROFILER_HISTOGRAM_BINS];
+} FrameProfiler;
+
+/**
+ * Sets up a profiler for numSections (at most FRAME_PROFILER_MAX_SECTIONS) sections, named by names (not copied).
+ */
+void frameProfilerInit(FrameProfiler* profiler, const char* const* names, int numSections);
+
+/**
+ * Starts a frame: resets the elapsed time clock (so timings keep full float precision however long the game runs).
+ */
+void frameProfilerBeginFrame(PlaydateAPI* pd, FrameProfiler* profiler);
+
+void frameProfilerBeginSection(PlaydateAPI* pd, FrameProfiler* profiler, int section);
+
+/**
+ * Adds the time since frameProfilerBeginSection() to the section's time this frame (a section may be entered repeatedly).
+ */
+void frameProfilerEndSection(PlaydateAPI* pd, FrameProfiler* profiler, int section);
+
+/**
+ * Stores the frame's timings in the ring buffer, and every FRAME_PROFILER_STATS_INTERVAL frames recomputes the summary
+ * (sorting the samples in scratch, e.g. a per-frame arena).
+ *
+ * @return 1 if the summary was recomputed (i.e. an overlay is due for a redraw)
+ */
+int frameProfilerEndFrame(PlaydateAPI* pd, FrameProfiler* profiler, MemoryArena* scratch);
+
+/**
+ * The height of the overlay for a line height.
+ */
+int frameProfilerOverlayHeight(const FrameProfiler* profiler, int lineHeight);
+
+/**
+ * Draws the summary (one line of p50/p95/p99 per section and for the whole frame, in microseconds) and the frame time
+ * histogram, as wide as the screen and frameProfilerOverlayHeight() high from row y, in the font of text (NULL for no
+ * summary).
+ */
+void frameProfilerDrawOverlay(PlaydateAPI* pd, const FrameProfiler* profiler, FontBlitter* text, int y);
+
+#define PROFILE_BEGIN(pd, profiler, section) frameProfilerBeginSection(pd, profiler, section)
+#define PROFILE_END(pd, profiler, section) frameProfilerEndSection(pd, profiler, section)
+
+#else
+
+#define PROFILE_BEGIN(pd, profiler, section) ((void)0)
+#define PROFILE_END(pd, profiler, section) ((void)0)
+
+#endif /* FRAME_PROFILER_ENABLED */
+
+#endif /* frame_profiler_h */
@@ -0,0 +1,85 @@
+#ifndef globe_renderer_h
+#define globe_renderer_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pd_api.h"
+
+#include "memory_arena.h"
+
+/** The widest map a GlobeRenderer projects: its longitude offsets are bytes, of up to a quarter of the map's width (keep in sync with scripts/unwrap_globe.py) */
+#define GLOBE_RENDERER_MAX_MAP_WIDTH 1020
+/** The largest disc radius, in samples (radius / scale) */
+#define GLOBE_RENDERER_MAX_SAMPLE_RADIUS 0x7fff
+
+typedef struct {
+	/** Globes drawn, and the samples of the map taken for them (each drawn scale by scale pixels) */
+	uint32_t draws;
+	uint32_t samples;
+} GlobeRendererStats;
+
+/** A row of samples of the disc's lower half (its mirror above the equator shares its longitudes) */
+typedef struct {
+	/** The samples each side of the disc's center */
+	uint16_t halfWidth;
+	/** The map rows it samples: the row's own (south of the equator), and its mirror's (north) */
+	uint16_t south;
+	uint16_t north;
+} GlobeRendererRow;
+
+/**
+ * Renders a globe at any longitude from one 1-bit equirectangular map (see scripts/unwrap_globe.py), instead of a
+ * pre-rendered frame per step of rotation: an orthographic projection of the untilted sphere, through a table built
+ * once per disc size of each disc sample's map row and longitude offset from the disc's center. A sample's latitude
+ * only depends on its row, and its longitude offset doesn't depend on the longitude shown, so the table keeps one
+ * quarter of the disc (the others mirror it); drawing a row turns its offsets into map columns at the longitude shown,
+ * then gathers their map bits a frame buffer byte at a time.
+ *
+ * The disc is sampled at radius / scale samples, each drawn scale by scale pixels: a scale of 2 samples (and tabulates)
+ * a quarter as much, at half the resolution.
+ */
+typedef struct {
+	/** The map (not owned): its data, size and bytes per row */
+	LCDBitmap* map;
+	const uint8_t* mapData;
+	int mapWidth;
+	int mapHeight;
+	int mapRowbytes;
+	/** The disc's radius in pixels (a multiple of scale), and in samples */
+	int radius;
+	int scale;
+	int sampleRadius;
+	/** sampleRadius rows, from the equator down */
+	GlobeRendererRow* rows;
+	/** Per row, per sample right of the disc's center: its longitude offset, in map columns (rows packed one after the other) */
+	uint8_t* longitudes;
+	/** The map columns of the row being drawn (2 * sampleRadius at most) */
+	uint16_t* columns;
+	GlobeRendererStats stats;
+} GlobeRenderer;
+
+/**
+ * @return the arena room globeRendererInit() takes for the table of a disc of radius pixels at scale
+ */
+size_t globeRendererTableSize(int radius, int scale);
+
+/**
+ * Sets up rendering map (an equirectangular 1-bit image, longitude 0 at its left edge growing eastward, the north pole
+ * at its top; it must outlive the renderer) onto a disc of radius pixels (rounded down to a multiple of scale) at scale,
+ * building the table in arena (see globeRendererTableSize()).
+ *
+ * @return 1 on success; otherwise 0 (map too wide, radius or scale out of range, or the table doesn't fit in arena)
+ */
+int globeRendererInit(PlaydateAPI* pd, GlobeRenderer* globe, LCDBitmap* map, int radius, int scale, MemoryArena* arena);
+
+/**
+ * Draws the globe with longitude (in degrees) facing the viewer onto the disc centered at (centerX, centerY) of a 1-bit
+ * image (e.g. the frame buffer) of height rows of rowbytes bytes: the disc's pixels are overwritten, the pixels around
+ * it kept. Rows past the image's are clipped.
+ *
+ * @return 1 if drawn; 0 if the disc doesn't fit within the image's width (nothing is drawn)
+ */
+int globeRendererDraw(GlobeRenderer* globe, float longitude, uint8_t* image, int rowbytes, int height, int centerX, int centerY);
+
+#endif /* globe_renderer_h */
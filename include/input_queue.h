@@ -0,0 +1,125 @@
+#ifndef input_queue_h
+#define input_queue_h
+
+#include <stdint.h>
+
+#include "pd_api.h"
+#include "input_trace.h"
+
+/** The maximum number of events an InputQueue holds until consumed (more are dropped, and counted) */
+#define INPUT_QUEUE_SIZE 32
+/** The number of button events the system buffers per update cycle for the button callback (5 suffices at 30 fps) */
+#define INPUT_QUEUE_BUTTON_EVENTS 16
+/** The number of buttons (PDButtons bits) */
+#define INPUT_QUEUE_BUTTONS 6
+
+typedef enum {
+	/** A button went down (button: the one button; value: unused) */
+	kInputPress,
+	/** A button went up */
+	kInputRelease,
+	/** A button of the queue's repeat mask is still down, repeatDelay after its press and every repeatInterval after */
+	kInputRepeat,
+	/** The crank turned by value degrees since the last event (positive: forward) */
+	kInputCrank,
+	/** A menu item changed (button: unused; item: the caller's id; value: the item's value) */
+	kInputMenu
+} InputEventType;
+
+typedef struct {
+	InputEventType type;
+	PDButtons button;
+	int item;
+	float value;
+	/** When the event happened, by pd->system->getCurrentTimeMilliseconds() */
+	uint32_t time;
+} InputEvent;
+
+typedef struct {
+	uint32_t events;
+	/** Events that found the queue full */
+	uint32_t dropped;
+	/** Press and release of the same button within one update cycle (lost to polling current button state) */
+	uint32_t tapsInFrame;
+	/** The most events queued at once */
+	int maxDepth;
+	/** Events consumed, and the sum/maximum of their time from happening to being consumed, in milliseconds */
+	uint32_t latencyCount;
+	uint64_t latencyTotal;
+	uint32_t latencyMax;
+} InputQueueStats;
+
+/**
+ * Turns button, crank and menu input into a queue of timestamped events, consumed in the order they happened: e.g.
+ * a press and release within one frame, or several presses of a frame that took long, each come through as events
+ * rather than being lost between two polls of the buttons' current state.
+ *
+ * Button events come from the system's button callback (set up by inputQueueInit(), delivered before each update),
+ * or, where there is none, from the buttons' pushed/released state polled by inputQueuePoll().
+ *
+ * With an input trace (see inputQueueSetTrace()), each poll's input is recorded to it, or replayed from it in place of
+ * the system's (button callback and menu changes included) until its end; replayed events are timed on the trace's
+ * clock, so buttons repeat as they did when recorded (and their latency is not measured: it counts as 0).
+ */
+typedef struct {
+	InputEvent events[INPUT_QUEUE_SIZE];
+	/** The index of the oldest event, and the number queued */
+	int head;
+	int count;
+	/** The buttons down, as of the events queued so far */
+	PDButtons held;
+	/** The buttons pressed since the last inputQueuePoll() */
+	PDButtons pressedSincePoll;
+	/** 1 if button events come from the button callback; 0 if polled */
+	int buttonCallback;
+	/** The buttons that repeat while held, and the delay before the first repeat and between repeats, in milliseconds */
+	PDButtons repeatMask;
+	uint32_t repeatDelay;
+	uint32_t repeatInterval;
+	/** Per button (by bit index), when it next repeats */
+	uint32_t nextRepeat[INPUT_QUEUE_BUTTONS];
+	/** The crank's angle as of its last kInputCrank event (instead of pd->system->getCrankAngle(), for replays) */
+	float crankAngle;
+	/** The input trace recorded or replayed, or NULL; the time of the last poll, and the trace's clock when replaying */
+	InputTrace* trace;
+	uint32_t lastPoll;
+	uint32_t traceClock;
+	InputQueueStats stats;
+} InputQueue;
+
+/**
+ * Sets up an empty queue and registers it as the system's button callback (if the system has one).
+ */
+void inputQueueInit(PlaydateAPI* pd, InputQueue* queue, PDButtons repeatMask, uint32_t repeatDelay, uint32_t repeatInterval);
+
+/**
+ * Records the input of each poll to trace, or replays it from trace, as set up by inputTraceRecord() or
+ * inputTraceReplay() (NULL for neither).
+ */
+void inputQueueSetTrace(PlaydateAPI* pd, InputQueue* queue, InputTrace* trace);
+
+/**
+ * Queues the update cycle's input not delivered by callbacks: button presses and releases (if polled), repeats of held
+ * buttons and the crank's change (if undocked). Call once per update, before consuming the events.
+ */
+void inputQueuePoll(PlaydateAPI* pd, InputQueue* queue);
+
+/**
+ * Queues a menu item's change (e.g. from its callback), as item (0-255, to be recorded), with its value; ignored while
+ * replaying an input trace.
+ */
+void inputQueuePushMenu(PlaydateAPI* pd, InputQueue* queue, int item, int value);
+
+/**
+ * Takes the oldest event off the queue.
+ *
+ * @return 1 if there was one (copied to event); otherwise 0
+ */
+int inputQueuePop(PlaydateAPI* pd, InputQueue* queue, InputEvent* event);
+
+/**
+ * Unregisters the queue as the system's button callback.
+ */
+void inputQueueFree(PlaydateAPI* pd, InputQueue* queue);
+
+#endif /* input_queue_h */
@@ -0,0 +1,113 @@
+#ifndef input_trace_h
+#define input_trace_h
+
+#include <stdint.h>
+
+#include "pd_api.h"
+
+/*
+ * Input trace: a frame-by-frame record of the input read from pd->system (buttons, crank, accelerometer) and of menu
+ * changes, written to a file in the data directory, and replayed in place of the live input, so the same input
+ * pattern can be run again on the device, in the Simulator and in the host build and their frame times compared.
+ *
+ * File format (little-endian): an 8-byte header ("PDIT", version u16, frame record size u16), then one record per
+ * frame:
+ *
+ *   0  current buttons    u8        8  crank angle   u16 (1/128 degree)
+ *   1  pushed buttons     u8       10  crank change  i16 (1/64 degree)
+ *   2  released buttons   u8       12  accelerometer x, y, z  i16 each (1/4096 g)
+ *   3  flags              u8 (1: crank docked, 2: menu change)
+ *   4  menu item          u8
+ *   5  menu value         u8
+ *   6  time since the previous frame  u16 (ms)
+ */
+
+#define INPUT_TRACE_VERSION 1
+#define INPUT_TRACE_HEADER_SIZE 8
+#define INPUT_TRACE_FRAME_SIZE 18
+/** The number of frames buffered between file writes/reads */
+#define INPUT_TRACE_BUFFER_FRAMES 64
+
+typedef enum {
+	kInputTraceOff,
+	kInputTraceRecording,
+	kInputTraceReplaying
+} InputTraceMode;
+
+/** A frame's input */
+typedef struct {
+	PDButtons current;
+	PDButtons pushed;
+	PDButtons released;
+	int crankDocked;
+	float crankAngle;
+	float crankChange;
+	float accelerometer[3];
+	/** The menu item changed in the frame (the caller's id, 0-255), or -1 if none; and its value (0-255) */
+	int menuItem;
+	int menuValue;
+	/** The time since the previous frame, in milliseconds */
+	uint32_t elapsed;
+} InputTraceFrame;
+
+typedef struct {
+	uint32_t frames;
+	/** File writes (recording) or reads (replaying) */
+	uint32_t fileOps;
+	/** Menu changes lost to another in the same frame (recording) */
+	uint32_t menuChangesLost;
+	/** File errors (which end recording), and malformed traces */
+	uint32_t errors;
+} InputTraceStats;
+
+typedef struct {
+	InputTraceMode mode;
+	SDFile* file;
+	uint8_t buffer[INPUT_TRACE_BUFFER_FRAMES * INPUT_TRACE_FRAME_SIZE];
+	/** The frames in buffer: recorded and not written yet, or read and (up to next) replayed */
+	int buffered;
+	int next;
+	/** The menu change to record with the next frame (see InputTraceFrame.menuItem) */
+	int pendingMenuItem;
+	int pendingMenuValue;
+	InputTraceStats stats;
+} InputTrace;
+
+/**
+ * Starts recording to path (in the data directory, replaced if it exists).
+ *
+ * @return 1 on success; otherwise 0 (the trace is then off)
+ */
+int inputTraceRecord(PlaydateAPI* pd, InputTrace* trace, const char* path);
+
+/**
+ * Starts replaying the trace at path (in the data directory, or else the game's package).
+ *
+ * @return 1 on success; otherwise 0: no such file, or not a trace of this version (the trace is then off)
+ */
+int inputTraceReplay(PlaydateAPI* pd, InputTrace* trace, const char* path);
+
+/**
+ * Records a menu change with the next frame (if recording). Only one per frame is kept: the last.
+ */
+void inputTraceRecordMenu(InputTrace* trace, int item, int value);
+
+/**
+ * Records a frame's input (if recording), first rounding its crank and accelerometer values to their precision in the
+ * trace, so the recording run sees the same input as its replays.
+ */
+void inputTraceRecordFrame(PlaydateAPI* pd, InputTrace* trace, InputTraceFrame* frame);
+
+/**
+ * Replays the next frame (if replaying).
+ *
+ * @return 1 if there was one (copied to frame); otherwise 0 (at the end of the trace, which is then off)
+ */
+int inputTraceReplayFrame(PlaydateAPI* pd, InputTrace* trace, InputTraceFrame* frame);
+
+/**
+ * Ends recording (writing out the frames buffered) or replaying.
+ */
+void inputTraceClose(PlaydateAPI* pd, InputTrace* trace);
+
+#endif /* input_trace_h */
@@ -0,0 +1,104 @@
+#ifndef memory_arena_h
+#define memory_arena_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pd_api.h"
+
+/** The alignment of every arena allocation (and pool block) */
+#define MEMORY_ARENA_ALIGNMENT 8
+/** The room an allocation of size bytes takes up in an arena (to size arenas by) */
+#define MEMORY_ARENA_ROOM(size) (((size_t)(size) + MEMORY_ARENA_ALIGNMENT - 1) & ~(size_t)(MEMORY_ARENA_ALIGNMENT - 1))
+
+typedef struct {
+	/** The most bytes in use at once */
+	size_t peak;
+	/** Allocations refused for lack of space */
+	uint32_t overflows;
+	/** The size of the largest refused allocation */
+	size_t overflowMax;
+} MemoryArenaStats;
+
+/**
+ * A bump allocator over one block allocated up front: allocations are carved off its start in order and only ever
+ * released together, back to a mark (e.g. all of a scene's or a frame's data at once), so nothing in it fragments the
+ * heap however long the game runs. An allocation that doesn't fit is refused (NULL) and counted, never taken from the
+ * heap instead.
+ */
+typedef struct {
+	uint8_t* base;
+	size_t capacity;
+	/** Bytes in use: the offset of the next allocation */
+	size_t used;
+	MemoryArenaStats stats;
+} MemoryArena;
+
+/**
+ * A free list of fixed-size blocks carved from an arena, for small objects of one kind that come and go (blocks can be
+ * freed individually, unlike arena allocations). Like an arena, it refuses (and counts) allocations once empty.
+ */
+typedef struct {
+	uint8_t* blocks;
+	size_t blockSize;
+	int capacity;
+	/** The first free block; each free block starts with a pointer to the next */
+	void* freeList;
+	int live;
+	int peakLive;
+	uint32_t overflows;
+} MemoryPool;
+
+/**
+ * Allocates the arena's block of capacity bytes (the arena's only heap allocation).
+ *
+ * @return 1 on success; otherwise 0 (out of memory; the arena is then empty, refusing all allocations)
+ */
+int memoryArenaInit(PlaydateAPI* pd, MemoryArena* arena, size_t capacity);
+
+/**
+ * @return size bytes (aligned to MEMORY_ARENA_ALIGNMENT, not cleared), or NULL if they don't fit (counted in stats)
+ */
+void* memoryArenaAlloc(MemoryArena* arena, size_t size);
+
+/**
+ * @return a mark to release the arena back to with memoryArenaRelease(), freeing whatever was allocated after it
+ */
+size_t memoryArenaMark(const MemoryArena* arena);
+
+void memoryArenaRelease(MemoryArena* arena, size_t mark);
+
+/**
+ * Releases all of the arena's allocations at once (keeping its block).
+ */
+void memoryArenaReset(MemoryArena* arena);
+
+/**
+ * Frees the arena's block (and so everything allocated from it).
+ */
+void memoryArenaFree(PlaydateAPI* pd, MemoryArena* arena);
+
+/**
+ * Carves capacity blocks of blockSize bytes (rounded up to MEMORY_ARENA_ALIGNMENT, and to hold a pointer) from arena;
+ * they are released along with the arena.
+ *
+ * @return 1 on success; otherwise 0 (the arena overflowed; the pool is then empty, refusing all allocations)
+ */
+int memoryPoolInit(MemoryPool* pool, MemoryArena* arena, size_t blockSize, int capacity);
+
+/**
+ * @return a block (not cleared), or NULL if all are in use (counted in overflows)
+ */
+void* memoryPoolAlloc(MemoryPool* pool);
+
+/**
+ * Returns a block to the pool (NULL, and pointers that aren't the pool's blocks, are ignored).
+ */
+void memoryPoolFree(MemoryPool* pool, void* block);
+
+/**
+ * Returns all blocks to the pool at once.
+ */
+void memoryPoolReset(MemoryPool* pool);
+
+#endif /* memory_arena_h */
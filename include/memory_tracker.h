@@ -0,0 +1,76 @@
+#ifndef memory_tracker_h
+#define memory_tracker_h
+
+/*
+ * Memory tracker: a copy of the Playdate API whose allocating calls (system->realloc, and the bitmap, font, sample,
+ * player, synth and sprite constructors/destructors) are wrapped to account the memory each subsystem holds, by the tag
+ * current when it was allocated.
+ *
+ * Only compiled in if MEMORY_TRACKER_ENABLED is defined to 1 (by CMake for all but Release builds); otherwise
+ * MEMORY_TAG() expands to nothing, memory_tracker.c compiles to nothing, and any other use has to be within
+ * #if MEMORY_TRACKER_ENABLED.
+ */
+
+#if MEMORY_TRACKER_ENABLED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pd_api.h"
+
+/** The maximum number of live allocations/objects tracked individually; beyond that, allocations are only counted */
+#define MEMORY_TRACKER_MAX_OBJECTS 256
+
+typedef enum {
+	kMemoryTagOther,
+	kMemoryTagFont,
+	kMemoryTagTextures,
+	kMemoryTagSfx,
+	kMemoryTagMusic,
+	kMemoryTagSprites,
+	kNumMemoryTags
+} MemoryTag;
+
+typedef struct {
+	/** Bytes held now, and at most */
+	size_t current;
+	size_t peak;
+	/** Allocations/objects held now */
+	uint32_t live;
+	/** Allocations/objects made in total */
+	uint32_t allocs;
+} MemoryTagStats;
+
+/**
+ * Returns the tracking copy of pd (created on the first call, from pd); use it in place of pd from then on (and before
+ * allocating anything, so nothing allocated untracked gets freed tracked).
+ *
+ * Sizes are those of the data: exact for system->realloc(), bitmaps and samples; estimated for fonts (their file size)
+ * and file players (their stream buffer, as 16-bit stereo); 0 for sample players and sprites (only counted). The
+ * SDK's own bookkeeping per object isn't included.
+ */
+PlaydateAPI* memoryTrackerInstall(PlaydateAPI* pd);
+
+/**
+ * Sets the tag of what is allocated from now on (until set again).
+ *
+ * @return the previous tag
+ */
+MemoryTag memoryTrackerSetTag(MemoryTag tag);
+
+const MemoryTagStats* memoryTrackerGetStats(MemoryTag tag);
+
+/**
+ * Logs current/peak bytes and allocation counts per tag (and in total) to the console.
+ */
+void memoryTrackerLogReport(PlaydateAPI* pd);
+
+#define MEMORY_TAG(tag) memoryTrackerSetTag(tag)
+
+#else
+
+#define MEMORY_TAG(tag) ((void)0)
+
+#endif /* MEMORY_TRACKER_ENABLED */
+
+#endif /* memory_tracker_h */
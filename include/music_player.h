@@ -0,0 +1,64 @@
+#ifndef music_player_h
+#define music_player_h
+
+#include <stdint.h>
+
+#include "pd_api.h"
+
+/** Frames between polls of the fileplayer's underrun flag */
+#define MUSIC_PLAYER_UNDERRUN_POLL_FRAMES 8
+
+typedef struct {
+	/** Times the track looped (seamlessly, within the fileplayer) */
+	uint32_t loops;
+	/** Times playback stopped on its own (e.g. on an error) and was restarted */
+	uint32_t restarts;
+	/** Polls that found the stream had underrun (audible dropouts) since the previous poll */
+	uint32_t underruns;
+	/** Frames that took longer than the stream buffer holds (where underruns are to be expected) */
+	uint32_t slowFrames;
+	/** The longest time between two musicPlayerUpdate() calls, in seconds */
+	float maxFrameTime;
+	/** The time (re)starting playback took, i.e. opening the stream and decoding the buffer's initial fill, in seconds (last and longest) */
+	float startTime;
+	float maxStartTime;
+} MusicPlayerStats;
+
+/**
+ * A streamed music track looping seamlessly via the fileplayer's own looping (play() once with repeat 0), with
+ * finish-callback driven restarts instead of per-frame isPlaying() polling, and underrun/timing counters for tuning the
+ * stream buffer length.
+ */
+typedef struct {
+	FilePlayer* player;
+	/** The stream buffer length, in seconds */
+	float bufferLength;
+	/** Set by the finish callback once playback stopped */
+	volatile int stopped;
+	int framesUntilPoll;
+	/** getCurrentTimeMilliseconds() at the last musicPlayerUpdate() (0 before the first) */
+	unsigned int lastUpdateTime;
+	MusicPlayerStats stats;
+} MusicPlayer;
+
+/**
+ * Loads the track at path into a new fileplayer with a stream buffer of bufferLength seconds, added to channel.
+ *
+ * @return 1 on success; otherwise 0 (the player is still allocated, so musicPlayerFree() has to be called either way)
+ */
+int musicPlayerInit(PlaydateAPI* pd, MusicPlayer* music, const char* path, float bufferLength, SoundChannel* channel);
+
+/**
+ * Starts looping playback.
+ */
+void musicPlayerStart(PlaydateAPI* pd, MusicPlayer* music);
+
+/**
+ * Restarts playback if it stopped, polls for underruns every MUSIC_PLAYER_UNDERRUN_POLL_FRAMES frames and tracks frame
+ * times against the buffer length; call once per frame.
+ */
+void musicPlayerUpdate(PlaydateAPI* pd, MusicPlayer* music);
+
+void musicPlayerFree(PlaydateAPI* pd, MusicPlayer* music);
+
+#endif /* music_player_h */
@@ -0,0 +1,93 @@
+#ifndef scene_h
+#define scene_h
+
+#include <stdint.h>
+
+#include "pd_api.h"
+
+/** The maximum number of nodes of a Scene */
+#define SCENE_MAX_NODES 8
+
+/**
+ * A sprite of the scene, and the state last submitted to it (its image, or its draw function's size, position and
+ * visibility).
+ */
+typedef struct {
+	LCDSprite* sprite;
+	LCDBitmap* image;
+	float x;
+	float y;
+	float width;
+	float height;
+	int visible;
+	/** 1 if the sprite was marked dirty since the scene was last drawn */
+	int dirty;
+} SceneNode;
+
+typedef struct {
+	/** State changes submitted to the sprite system, and those skipped because the state was unchanged */
+	uint32_t submits;
+	uint32_t skips;
+	/** sceneDraw() calls that drew (i.e. something changed), and those that didn't */
+	uint32_t draws;
+	uint32_t idleDraws;
+} SceneStats;
+
+/**
+ * A retained layer over the sprite system: nodes keep the state last submitted to their sprite, and only pass on
+ * changes, so unchanged sprites aren't marked dirty; drawing then redraws just the dirty rects of what changed, over
+ * the previous frame, rather than clearing and redrawing the whole screen.
+ */
+typedef struct {
+	SceneNode nodes[SCENE_MAX_NODES];
+	int numNodes;
+	/** 1 if any node changed since the scene was last drawn */
+	int dirty;
+	SceneStats stats;
+} Scene;
+
+void sceneInit(Scene* scene);
+
+/**
+ * Adds a node: a new sprite (origin at its top-left, at zIndex) in the display list, showing nothing until given an
+ * image, or if draw is not NULL, drawn by draw once given a size.
+ *
+ * @return the node, or NULL on failure (SCENE_MAX_NODES reached, or allocation failure)
+ */
+SceneNode* sceneAddNode(PlaydateAPI* pd, Scene* scene, int16_t zIndex, LCDSpriteDrawFunction* draw);
+
+/**
+ * Sets the node's image (and size), if it is another bitmap than the node's.
+ */
+void sceneNodeSetImage(PlaydateAPI* pd, Scene* scene, SceneNode* node, LCDBitmap* image);
+
+/**
+ * Sets the size of a node drawn by a draw function, if changed.
+ */
+void sceneNodeSetSize(PlaydateAPI* pd, Scene* scene, SceneNode* node, float width, float height);
+
+/**
+ * Moves the node's top-left to x, y, if changed.
+ */
+void sceneNodeMoveTo(PlaydateAPI* pd, Scene* scene, SceneNode* node, float x, float y);
+
+void sceneNodeSetVisible(PlaydateAPI* pd, Scene* scene, SceneNode* node, int visible);
+
+/**
+ * Marks the node for redraw though its state is unchanged: its image's (or its draw function's) content changed.
+ */
+void sceneNodeInvalidate(PlaydateAPI* pd, Scene* scene, SceneNode* node);
+
+/**
+ * Redraws the dirty rects of the nodes changed since the last draw (over the frame buffer as left by it).
+ *
+ * @return 1 if anything was drawn; otherwise 0 (nothing changed)
+ */
+int sceneDraw(PlaydateAPI* pd, Scene* scene);
+
+/**
+ * Removes the nodes' sprites from the display list and frees them (not their images).
+ */
+void sceneFree(PlaydateAPI* pd, Scene* scene);
+
+#endif /* scene_h */
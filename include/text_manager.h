@@ -5,5 +5,11 @@
 
 char* getHelloText(void);
 char* getShowTextMenuItemLabel(void);
+#if FRAME_PROFILER_ENABLED
+char* getProfilerMenuItemLabel(void);
+#endif
+#if MEMORY_TRACKER_ENABLED
+char* getMemoryMenuItemLabel(void);
+#endif
 
 #endif /* text_manager_h */
@@ -0,0 +1,120 @@
+#ifndef tile_set_h
+#define tile_set_h
+
+#include <stdint.h>
+
+#include "pd_api.h"
+
+#include "memory_arena.h"
+
+/** The most levels a tile set has (keep in sync with scripts/tile_image.py) */
+#define TILE_SET_MAX_LEVELS 8
+
+typedef struct {
+	/** Views drawn, and those drawn with tiles still missing (deferred to a later frame by the load budget) */
+	uint32_t draws;
+	uint32_t incompleteDraws;
+	/** Tile lookups by tileSetDraw() that found the tile resident, and that had to load it */
+	uint32_t hits;
+	uint32_t misses;
+	/** Tiles loaded ahead of being drawn, by tileSetPrefetch() */
+	uint32_t prefetches;
+	uint32_t evictions;
+	/** Tile reads, and the seeks they took (reads of the tile following the last one read don't seek) */
+	uint32_t reads;
+	uint32_t seeks;
+	/** Tile loads refused for lack of a slot not in use by the frame (budget too small for the view) */
+	uint32_t overBudget;
+	uint32_t errors;
+	int peakResident;
+} TileSetStats;
+
+typedef struct {
+	int width;
+	int height;
+	/** In tiles */
+	int columns;
+	int rows;
+	/** The level's tile numbers, by row, then column */
+	uint16_t* tiles;
+} TileSetLevel;
+
+/**
+ * A large 1-bit image tiled at build time by scripts/tile_image.py (see there for the file format), with levels of half
+ * the resolution of the one before, streamed tile by tile: the file stays open, and only the tiles drawn (or
+ * prefetched around them) are read, into a cache of slots carved from an arena: a fixed RAM budget, however large the
+ * image. The least recently used tiles are evicted; tiles used in the current frame never are.
+ *
+ * Identical tiles (e.g. of solid color) are stored, read and cached once.
+ */
+typedef struct {
+	/** Level 0's size */
+	int width;
+	int height;
+	int levelCount;
+	TileSetLevel levels[TILE_SET_MAX_LEVELS];
+	/** Tile width and height in pixels (a multiple of 8), bytes per tile row, and bytes per tile */
+	int tileSize;
+	int tileRowBytes;
+	int tileBytes;
+	/** The color past the image's edges, as a byte of 8 pixels (0x00 black, 0xff white) */
+	uint8_t background;
+	/** The number of distinct tiles */
+	int tileCount;
+	SDFile* file;
+	uint32_t dataOffset;
+	/** The file position after the last tile read (-1: unknown) */
+	int filePosition;
+	/** Per tile number, its slot, or -1 if not resident */
+	int16_t* tileSlots;
+	/** Per slot: its tile's data, its tile number (-1: free), and the frame it was last used in */
+	uint8_t* slotData;
+	int32_t* slotTiles;
+	uint32_t* slotUsed;
+	int slotCount;
+	int resident;
+	/** The current frame (see tileSetBeginFrame()), and the tile loads left in its budget */
+	uint32_t frame;
+	int loadsLeft;
+	TileSetStats stats;
+} TileSet;
+
+/**
+ * Opens the tile set at path: reads and validates its header and index into arena, then carves as many cache slots as
+ * still fit from the arena's remaining room (so the arena's capacity is the tile set's whole RAM budget).
+ *
+ * @return 1 on success; otherwise 0, with outErr (if not NULL) set to a static description and the set left closed
+ */
+int tileSetOpen(PlaydateAPI* pd, TileSet* set, const char* path, MemoryArena* arena, const char** outErr);
+
+/**
+ * Closes the tile set's file (its index and cache go with their arena).
+ */
+void tileSetClose(PlaydateAPI* pd, TileSet* set);
+
+/**
+ * Starts a frame: tiles used from now on aren't evicted until the next, and at most maxLoads tiles are read in it
+ * (by tileSetDraw() and tileSetPrefetch() together), bounding the frame's file access.
+ */
+void tileSetBeginFrame(TileSet* set, int maxLoads);
+
+/**
+ * Draws the view of level whose top left corner is at (x, y) in the level's pixels (negative, or past the level's
+ * size, is off the image: drawn in the background color) into rows [top, top + height) of frame, width pixels (at most
+ * LCD_COLUMNS) from its left edge. Missing tiles are loaded within the frame's budget; the ones past it are drawn in the
+ * background color.
+ *
+ * @return 1 if the view is complete; 0 if tiles were left missing (draw again on a later frame)
+ */
+int tileSetDraw(PlaydateAPI* pd, TileSet* set, int level, int x, int y, int width, int height, uint8_t* frame, int rowbytes, int top);
+
+/**
+ * Loads the missing tiles of the view of level at (x, y), width by height pixels, grown by margin tiles on each side
+ * (e.g. the tiles panning reaches next), within what's left of the frame's budget. Its resident tiles are kept from
+ * eviction by later prefetches, so prefetching more than fits the cache leaves tiles missing rather than cycling them.
+ *
+ * @return the number of tiles still missing
+ */
+int tileSetPrefetch(PlaydateAPI* pd, TileSet* set, int level, int x, int y, int width, int height, int margin);
+
+#endif /* tile_set_h */
@@ -0,0 +1,61 @@
+#ifndef tone_player_h
+#define tone_player_h
+
+#include <stdint.h>
+
+#include "pd_api.h"
+
+/** The maximum number of voices of a TonePlayer */
+#define TONE_PLAYER_MAX_VOICES 16
+
+/**
+ * A tone, synthesized when played (no sample data): a note of a steady frequency, faded in and out by a linear envelope.
+ */
+typedef struct {
+	SoundWaveform waveform;
+	/** In Hz */
+	float frequency;
+	/** In seconds: the fade in from silence, the note's length (from its start, fade in included), and the fade out after it */
+	float attack;
+	float length;
+	float release;
+	/** The note's velocity (0 to 1) */
+	float volume;
+} TonePreset;
+
+typedef struct {
+	uint32_t triggers;
+	/** Triggers that found all voices playing and cut one off */
+	uint32_t steals;
+} TonePlayerStats;
+
+/**
+ * A fixed set of synths, any of which plays any tone, so overlapping tones don't cut each other off (until the voices
+ * run out).
+ */
+typedef struct {
+	PDSynth* voices[TONE_PLAYER_MAX_VOICES];
+	/** Per voice, the audio clock (pd->sound->getCurrentTime()) when last triggered */
+	uint32_t triggerTimes[TONE_PLAYER_MAX_VOICES];
+	int numVoices;
+	SoundChannel* channel;
+	TonePlayerStats stats;
+} TonePlayer;
+
+/**
+ * Allocates numVoices synths (at most TONE_PLAYER_MAX_VOICES) and adds them to channel.
+ *
+ * @return 1 on success; otherwise 0 (too many voices, or allocation failure)
+ */
+int tonePlayerInit(PlaydateAPI* pd, TonePlayer* player, int numVoices, SoundChannel* channel);
+
+/**
+ * Plays tone on an idle voice, or if there is none, takes over the voice that was triggered the longest ago.
+ *
+ * @return the voice's index, or -1 on error (no voices)
+ */
+int tonePlayerPlay(PlaydateAPI* pd, TonePlayer* player, const TonePreset* tone);
+
+void tonePlayerFree(PlaydateAPI* pd, TonePlayer* player);
+
+#endif /* tone_player_h */
@@ -0,0 +1,69 @@
+//
+//  accelerometer.h
+//  {}{{__KICKSTART_PLAYDATE_GAME_NAME__}}{}
+//
+//  {}{{__KICKSTART_AUTHOR__}}{}
+//
+
+#ifndef accelerometer_h
+#define accelerometer_h
+
+#include <stdint.h>
+
+#include "pd_api.h"
+
+/** 1 g in the accelerometer's fixed-point values (16.16) */
+#define ACCELEROMETER_ONE (1 << 16)
+
+typedef struct {
+	/** Sensor reads, and updates that skipped the read (before the next sample was due) */
+	uint32_t samples;
+	uint32_t decimated;
+	/** Samples that changed the output, and those that moved the filtered value only within the deadband */
+	uint32_t changes;
+	uint32_t deadbanded;
+} AccelerometerStats;
+
+/**
+ * The accelerometer, sampled at most every sampleInterval ms, low-pass filtered (an exponential moving average of
+ * weight 1 / 2^filterShift per sample) and calibrated (minus the offsets), all in 16.16 fixed point: its output
+ * (value) only follows the filtered reading once that moves more than deadband away, so sensor noise doesn't change it
+ * every frame.
+ */
+typedef struct {
+	uint32_t sampleInterval;
+	int filterShift;
+	int32_t deadband;
+	/** The time the next sample is due (ms) */
+	uint32_t nextSample;
+	/** 0 until the first sample (which the filter starts from) */
+	int sampled;
+	int32_t filtered[3];
+	/** The reading calibrated as level (see accelerometerCalibrate()) */
+	int32_t offset[3];
+	/** The output per axis (x, y, z): the calibrated filtered reading, as of the last change beyond the deadband */
+	int32_t value[3];
+	/** 1 if the output changed outside accelerometerUpdate() (by calibration) since it last returned */
+	int changed;
+	AccelerometerStats stats;
+} Accelerometer;
+
+/**
+ * Initializes the accelerometer's state (with no calibration offsets); the peripheral itself is enabled with
+ * setPeripheralsEnabled(kAccelerometer).
+ */
+void accelerometerInit(Accelerometer* accelerometer, uint32_t sampleInterval, int filterShift, int32_t deadband);
+
+/**
+ * Samples and filters the sensor, if a sample is due.
+ *
+ * @return 1 if the output (value) changed since the last call; otherwise 0
+ */
+int accelerometerUpdate(PlaydateAPI* pd, Accelerometer* accelerometer);
+
+/**
+ * Calibrates the current (filtered) reading as level: its output is zero from now on, and relative to it.
+ */
+void accelerometerCalibrate(Accelerometer* accelerometer);
+
+#endif /* accelerometer_h */
@@ -0,0 +1,118 @@
+//
+//  font_blitter.h
+//  {}{{__KICKSTART_PLAYDATE_GAME_NAME__}}{}
+//
+//  {}{{__KICKSTART_AUTHOR__}}{}
+//  
+
+#ifndef font_blitter_h
+#define font_blitter_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pd_api.h"
+
+/**
+ * If 1, a set-up FontBlitter blits glyphs into the frame buffer itself; if 0, it draws through drawText() (e.g. on a
+ * platform where that measures faster).
+ */
+#ifndef FONT_BLITTER_ENABLED
+#define FONT_BLITTER_ENABLED 1
+#endif
+
+/** The glyphs a FontBlitter blits: printable ASCII */
+#define FONT_BLITTER_FIRST_GLYPH 32
+#define FONT_BLITTER_NUM_GLYPHS 95
+/** The largest glyph a FontBlitter blits (a glyph row is one 32-bit word); fonts with larger glyphs are drawn with drawText() */
+#define FONT_BLITTER_MAX_GLYPH_WIDTH 32
+/** The number of labels (constant strings) whose width is cached */
+#define FONT_BLITTER_LABEL_CACHE_SIZE 16
+
+typedef struct {
+	const char* text;
+	size_t length;
+	int width;
+	/** 1 if any pair of the label's glyphs is kerned */
+	int kerned;
+} FontBlitterLabel;
+
+typedef struct {
+	/** Runs blitted, and (if not set up, or not FONT_BLITTER_ENABLED) drawn through drawText() */
+	uint32_t blits;
+	uint32_t fallbacks;
+	/** Label cache lookups that found the label, and those that measured it */
+	uint32_t labelHits;
+	uint32_t labelMisses;
+} FontBlitterStats;
+
+/**
+ * Draws ASCII text in a fixed bitmap font straight into the frame buffer: the font's glyphs are decoded once into
+ * per-glyph row masks (32-bit words, leftmost pixel in the top bit) of their black and white (opaque) pixels, then
+ * blitted row by row with a shift and a mask-and-set per frame buffer byte, instead of a drawText() call working
+ * through the font's glyph pages per character.
+ *
+ * Draws in any draw mode (as drawText() would in that mode), clipped to the screen (not to the graphics context's clip
+ * rect, nor offset by its draw offset).
+ */
+typedef struct {
+	LCDFont* font;
+	int height;
+	/** The space between glyphs: the font's tracking, plus the text tracking when set up */
+	int tracking;
+	LCDBitmapDrawMode drawMode;
+	/** The glyph rows: height words per glyph, of black pixels, then of white; NULL if not set up (drawn by drawText()) */
+	uint32_t* rows;
+	int8_t advance[FONT_BLITTER_NUM_GLYPHS];
+	/** Per glyph: its LCDFontGlyph (NULL if the font lacks it), and 1 if it is kerned with any following glyph */
+	LCDFontGlyph* glyphs[FONT_BLITTER_NUM_GLYPHS];
+	uint8_t kerns[FONT_BLITTER_NUM_GLYPHS];
+	FontBlitterLabel labels[FONT_BLITTER_LABEL_CACHE_SIZE];
+	int numLabels;
+	/** The label to replace next, once the cache is full */
+	int nextLabel;
+	FontBlitterStats stats;
+} FontBlitter;
+
+/**
+ * Decodes font's glyphs for blitting, with the graphics context's current text tracking.
+ *
+ * @return 1 on success; otherwise 0 (glyphs too large or of an unexpected format, or allocation failure): the blitter
+ * then draws through drawText()
+ */
+int fontBlitterInit(PlaydateAPI* pd, FontBlitter* blitter, LCDFont* font);
+
+/**
+ * Sets the draw mode of the blitter's text (kDrawModeCopy initially).
+ *
+ * @return the previous draw mode
+ */
+LCDBitmapDrawMode fontBlitterSetDrawMode(FontBlitter* blitter, LCDBitmapDrawMode mode);
+
+/**
+ * Draws length characters of text with its top-left at x, y ('\n' starts a new line; non-ASCII characters are skipped).
+ * Through drawText() (if not set up), this leaves the blitter's font set in the graphics context.
+ *
+ * @return the width drawn (of the last line)
+ */
+int fontBlitterDrawText(PlaydateAPI* pd, FontBlitter* blitter, const char* text, size_t length, int x, int y);
+
+/**
+ * Like fontBlitterDrawText(), for a label: text that never changes at its address (e.g. a string literal), so its
+ * width and kerning are looked up in a cache by address.
+ */
+int fontBlitterDrawLabel(PlaydateAPI* pd, FontBlitter* blitter, const char* text, size_t length, int x, int y);
+
+/**
+ * @return the width of length characters of text (a single line), as pd->graphics->getTextWidth() would measure it
+ */
+int fontBlitterTextWidth(PlaydateAPI* pd, FontBlitter* blitter, const char* text, size_t length);
+
+/**
+ * Like fontBlitterTextWidth(), for a label (see fontBlitterDrawLabel()).
+ */
+int fontBlitterLabelWidth(PlaydateAPI* pd, FontBlitter* blitter, const char* text, size_t length);
+
+void fontBlitterFree(PlaydateAPI* pd, FontBlitter* blitter);
+
+#endif /* font_blitter_h */
@@ -0,0 +1,71 @@
+//
+//  accelerometer.c
+//  {}{{__KICKSTART_PLAYDATE_GAME_NAME__}}{}
+//
+//  {}{{__KICKSTART_AUTHOR__}}{}
+//
+
+#include <string.h>
+
+#include "accelerometer.h"
+
+
+void accelerometerInit(Accelerometer* accelerometer, uint32_t sampleInterval, int filterShift, int32_t deadband) {
+	memset(accelerometer, 0, sizeof(*accelerometer));
+	accelerometer->sampleInterval = sampleInterval;
+	accelerometer->filterShift = filterShift;
+	accelerometer->deadband = deadband;
+}
+
+int accelerometerUpdate(PlaydateAPI* pd, Accelerometer* accelerometer) {
+	int changed = accelerometer->changed;
+	accelerometer->changed = 0;
+
+	uint32_t now = pd->system->getCurrentTimeMilliseconds();
+	if (accelerometer->sampled && (int32_t)(now - accelerometer->nextSample) < 0) {
+		accelerometer->stats.decimated++;
+		return changed;
+	}
+	accelerometer->nextSample = now + accelerometer->sampleInterval;
+	accelerometer->stats.samples++;
+
+	float reading[3];
+	pd->system->getAccelerometer(&reading[0], &reading[1], &reading[2]);
+	int moved = 0;
+	for (int i = 0; i < 3; i++) {
+		int32_t raw = (int32_t)(reading[i] * ACCELEROMETER_ONE);
+		if (accelerometer->sampled) {
+			accelerometer->filtered[i] += (raw - accelerometer->filtered[i]) >> accelerometer->filterShift;
+		}
+		else {
+			accelerometer->filtered[i] = raw;
+		}
+
+		int32_t value = accelerometer->filtered[i] - accelerometer->offset[i];
+		int32_t delta = value - accelerometer->value[i];
+		if (delta > accelerometer->deadband || delta < -accelerometer->deadband || accelerometer->sampled == 0) {
+			accelerometer->value[i] = value;
+			changed = 1;
+		}
+		else if (delta != 0) {
+			moved = 1;
+		}
+	}
+	accelerometer->sampled = 1;
+
+	if (changed) {
+		accelerometer->stats.changes++;
+	}
+	else if (moved) {
+		accelerometer->stats.deadbanded++;
+	}
+	return changed;
+}
+
+void accelerometerCalibrate(Accelerometer* accelerometer) {
+	for (int i = 0; i < 3; i++) {
+		accelerometer->offset[i] = accelerometer->filtered[i];
+		accelerometer->value[i] = 0;
+	}
+	accelerometer->changed = 1;
+}
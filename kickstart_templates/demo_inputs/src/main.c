@@ -8,16 +8,19 @@
 //  is meant to demonstrate:
 //
 //  - handling all inputs: D-pad, A / B buttons, Crank, Accelerometer, System menu
-//  - loading and using a custom font
+//  - loading and using a custom font (its labels blitted straight into the frame buffer)
 //  - including additional C source/header files
 //
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "pd_api.h"
 
 #include "text_manager.h"
+#include "font_blitter.h"
+#include "accelerometer.h"
 
 
 static int update(void* userdata);
@@ -30,6 +33,8 @@ LCDFont* font = NULL;
 int fontTracking = 0;
 int textHeight = 0;
 int textWidth = 0;
+/** Draws the labels in font */
+FontBlitter labelText;
 
 // The total number of divisions of an imaginary circle, one of which crank rotation will be mapped to as it is operated.
 #define NUM_CRANK_DIV 8
@@ -49,10 +54,18 @@ float crankRotationDivLowAngle = 0;
 /** The higher (i.e. closer to +inf) arc angle of the current crank rotation division, that together with the low angle forms the div's circular arc. */
 float crankRotationDivHighAngle = 0;
 
-/** The accelerometer's current x-axis value. */
-float acceleroX;
-float acceleroY;
-float acceleroZ;
+/** The accelerometer's sample interval (ms): the dots don't need a reading every frame (at 30 FPS, every other frame is sampled) */
+#define ACCELERO_SAMPLE_INTERVAL 50
+/** The accelerometer's low-pass filter: each sample weighs 1 / 2^ACCELERO_FILTER_SHIFT */
+#define ACCELERO_FILTER_SHIFT 2
+/** The change in a reading below which the dots don't move: about 2 pixels on their rails (1 g is LCD_COLUMNS / 2) */
+#define ACCELERO_DEADBAND (ACCELEROMETER_ONE / 100)
+
+Accelerometer accelero;
+/** The accelerometer's current x-axis dot position on its rail. */
+int acceleroX = LCD_COLUMNS / 2;
+int acceleroY = LCD_COLUMNS / 2;
+int acceleroZ = LCD_COLUMNS / 2;
 
 /** The previous frame's button input state */
 PDButtons btnsPrev;
@@ -69,7 +82,38 @@ int fgColor = -1;
 int bgColor = -1;
 
 LCDBitmapDrawMode textDrawMode = 0;
-LCDBitmapDrawMode tempDrawMode = 0;
+
+/** The elements of the controller map that change with input, drawn over its static background */
+enum {
+	kElementDpadLeft,
+	kElementDpadRight,
+	kElementDpadUp,
+	kElementDpadDown,
+	kElementButtonA,
+	kElementButtonB,
+	kElementCrank,
+	kElementAcceleroX,
+	kElementAcceleroY,
+	kElementAcceleroZ,
+	kNumElements
+};
+/** The frame buffer rows each element covers: top and bottom (inclusive) */
+const int elementRows[kNumElements][2] = {
+	{ 35, 55 }, { 35, 55 }, { 20, 30 }, { 60, 70 },
+	{ 30, 59 }, { 30, 59 }, { 25, 64 },
+	{ 180, 187 }, { 200, 207 }, { 220, 227 }
+};
+/** Each element's state as last drawn (see getElementState()) */
+int renderedElementStates[kNumElements];
+/**
+ * The static parts of the controller map (labels, crank outline, accelerometer rails), per dark mode setting: rendered
+ * once, then copied back over the rows of elements that changed, instead of clearing and redrawing the whole screen.
+ */
+LCDBitmap* backgrounds[2] = { NULL, NULL };
+/** The dark mode setting of the background in the frame buffer, or -1 if none yet */
+int renderedDarkMode = -1;
+/** 1 for each frame buffer row restored from the background this frame */
+uint8_t backgroundRowsRestored[LCD_ROWS];
 
 /**
  * Callback for Playdate API system menu user interaction, invoked by system menu user interaction.
@@ -79,7 +123,178 @@ static void systemMenuItemDarkModeCallback(void* userdata) {
 }
 
 static void systemMenuItemResetAcceleroCallback(void* userdata) {
-	// TODO: accelero handling+
+	accelerometerCalibrate(&accelero);
+}
+
+/**
+ * @return the x of an accelerometer dot on its rail for an axis' value: the rail's middle for 0, its ends for +/-1 g
+ */
+static int getAcceleroDotX(int32_t value) {
+	int x = LCD_COLUMNS / 2 + (int)(((int64_t)value * (LCD_COLUMNS / 2)) >> 16);
+	return x > 0 ? (x < LCD_COLUMNS - 8 ? x : LCD_COLUMNS - 8) : 0;
+}
+
+/**
+ * Renders the static parts of the controller map for the current dark mode setting into the frame buffer.
+ *
+ * @return a copy of it, or NULL on allocation failure
+ */
+static LCDBitmap* renderBackground(void) {
+	pd->graphics->clear(bgColor);
+	
+	// render labels (string literals: their widths are cached by the blitter)
+	fontBlitterSetDrawMode(&labelText, textDrawMode);
+	fontBlitterDrawLabel(pd, &labelText, getDpadLabelText(), strlen(getDpadLabelText()), 40, 5);
+	fontBlitterDrawLabel(pd, &labelText, getAButtonLabelText(), strlen(getAButtonLabelText()), 220, 5);
+	fontBlitterDrawLabel(pd, &labelText, getBButtonLabelText(), strlen(getBButtonLabelText()), 170, 5);
+	fontBlitterDrawLabel(pd, &labelText, getCrankLabelText(), strlen(getCrankLabelText()), 325, 5);
+	fontBlitterDrawLabel(pd, &labelText, getAcceleroLabelText(), strlen(getAcceleroLabelText()), 165, 150);
+	fontBlitterDrawLabel(pd, &labelText, getAcceleroXLabelText(), strlen(getAcceleroXLabelText()), 195, 170);
+	fontBlitterDrawLabel(pd, &labelText, getAcceleroYLabelText(), strlen(getAcceleroYLabelText()), 195, 190);
+	fontBlitterDrawLabel(pd, &labelText, getAcceleroZLabelText(), strlen(getAcceleroZLabelText()), 195, 210);
+	
+	// render crank outline and accelero rails
+	pd->graphics->drawEllipse(320, 25, 40, 40, 1, 0, 0, fgColor);
+	pd->graphics->drawLine(0, 184, LCD_COLUMNS, 184, 1, fgColor);
+	pd->graphics->drawLine(0, 204, LCD_COLUMNS, 204, 1, fgColor);
+	pd->graphics->drawLine(0, 224, LCD_COLUMNS, 224, 1, fgColor);
+	
+	LCDBitmap* background = pd->graphics->newBitmap(LCD_COLUMNS, LCD_ROWS, bgColor);
+	if (background == NULL) {
+		pd->system->error("%s:%i Error allocating background bitmap", __FILE__, __LINE__);
+		return NULL;
+	}
+	int width, height, rowbytes;
+	uint8_t* mask;
+	uint8_t* data;
+	pd->graphics->getBitmapData(background, &width, &height, &rowbytes, &mask, &data);
+	uint8_t* frame = pd->graphics->getFrame();
+	for (int y = 0; y < LCD_ROWS; y++) {
+		memcpy(data + y * rowbytes, frame + y * LCD_ROWSIZE, LCD_COLUMNS / 8);
+	}
+	pd->graphics->markUpdatedRows(0, LCD_ROWS - 1);
+	return background;
+}
+
+/**
+ * Copies rows [top, bottom] of the rendered dark mode's background into the frame buffer.
+ */
+static void restoreBackgroundRows(int top, int bottom) {
+	LCDBitmap* background = backgrounds[renderedDarkMode];
+	if (background == NULL) {
+		return;
+	}
+	int width, height, rowbytes;
+	uint8_t* mask;
+	uint8_t* data;
+	pd->graphics->getBitmapData(background, &width, &height, &rowbytes, &mask, &data);
+	uint8_t* frame = pd->graphics->getFrame();
+	for (int y = top; y <= bottom; y++) {
+		memcpy(frame + y * LCD_ROWSIZE, data + y * rowbytes, LCD_COLUMNS / 8);
+		backgroundRowsRestored[y] = 1;
+	}
+	pd->graphics->markUpdatedRows(top, bottom);
+}
+
+/**
+ * @return 1 if any of rows [top, bottom] were restored from the background this frame
+ */
+static int rowsRestored(int top, int bottom) {
+	for (int y = top; y <= bottom; y++) {
+		if (backgroundRowsRestored[y]) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @return the state an element is drawn in: 1 if its button is pressed (else 0), the crank division, or the
+ * accelerometer dot's x
+ */
+static int getElementState(int element) {
+	switch (element) {
+		case kElementDpadLeft: return (kButtonLeft & btnsCurr) != 0;
+		case kElementDpadRight: return (kButtonRight & btnsCurr) != 0;
+		case kElementDpadUp: return (kButtonUp & btnsCurr) != 0;
+		case kElementDpadDown: return (kButtonDown & btnsCurr) != 0;
+		case kElementButtonA: return (kButtonA & btnsCurr) != 0;
+		case kElementButtonB: return (kButtonB & btnsCurr) != 0;
+		case kElementCrank: return crankRotationDiv;
+		case kElementAcceleroX: return acceleroX;
+		case kElementAcceleroY: return acceleroY;
+		case kElementAcceleroZ: return acceleroZ;
+		default: return 0;
+	}
+}
+
+/**
+ * Draws a D-pad direction: filled if pressed, else outlined.
+ */
+static void drawDpadTriangle(int x1, int y1, int x2, int y2, int x3, int y3, int pressed) {
+	if (pressed) {
+		pd->graphics->fillTriangle(x1, y1, x2, y2, x3, y3, fgColor);
+	}
+	else {
+		pd->graphics->drawLine(x1, y1, x2, y2, 1, fgColor);
+		pd->graphics->drawLine(x2, y2, x3, y3, 1, fgColor);
+		pd->graphics->drawLine(x3, y3, x1, y1, 1, fgColor);
+	}
+}
+
+/**
+ * Draws an element in a state (see getElementState()) over the background.
+ */
+static void drawElement(int element, int state) {
+	switch (element) {
+		// render d-pad
+		case kElementDpadLeft:
+			drawDpadTriangle(30, 45, 40, 35, 40, 55, state);
+			break;
+		case kElementDpadRight:
+			drawDpadTriangle(80, 45, 70, 35, 70, 55, state);
+			break;
+		case kElementDpadUp:
+			drawDpadTriangle(55, 20, 45, 30, 65, 30, state);
+			break;
+		case kElementDpadDown:
+			drawDpadTriangle(55, 70, 45, 60, 65, 60, state);
+			break;
+		
+		// render a / b
+		case kElementButtonA:
+			if (state) {
+				pd->graphics->fillEllipse(210, 30, 30, 30, 0, 0, fgColor);
+			}
+			else {
+				pd->graphics->drawEllipse(210, 30, 30, 30, 1, 0, 0, fgColor);
+			}
+			break;
+		case kElementButtonB:
+			if (state) {
+				pd->graphics->fillEllipse(160, 30, 30, 30, 0, 0, fgColor);
+			}
+			else {
+				pd->graphics->drawEllipse(160, 30, 30, 30, 1, 0, 0, fgColor);
+			}
+			break;
+		
+		// render crank position
+		case kElementCrank:
+			pd->graphics->fillEllipse(320, 25, 40, 40, crankRotationDivLowAngle, crankRotationDivHighAngle, fgColor);
+			break;
+		
+		// render accelero values
+		case kElementAcceleroX:
+			pd->graphics->fillEllipse(state, 180, 8, 8, 0, 0, fgColor);
+			break;
+		case kElementAcceleroY:
+			pd->graphics->fillEllipse(state, 200, 8, 8, 0, 0, fgColor);
+			break;
+		case kElementAcceleroZ:
+			pd->graphics->fillEllipse(state, 220, 8, 8, 0, 0, fgColor);
+			break;
+	}
 }
 
 /**
@@ -106,12 +321,14 @@ int eventHandler(PlaydateAPI* pd, PDSystemEvent event, uint32_t arg) {
 		pd->graphics->setFont(font);
 		fontTracking = pd->graphics->getTextTracking();
 		textHeight = pd->graphics->getFontHeight(font);
+		fontBlitterInit(pd, &labelText, font);
 		
 		// init system menu
 		darkModeMenuItemCheckmark = pd->system->addCheckmarkMenuItem(getDarkModeMenuItemLabel(), darkMode, systemMenuItemDarkModeCallback, NULL);
-		// resetAcceleroMenuItemAction = pd->system->addMenuItem(getResetAcceleroMenuItemLabel(), systemMenuItemResetAcceleroCallback, NULL); // TODO: accelero handling+
+		resetAcceleroMenuItemAction = pd->system->addMenuItem(getResetAcceleroMenuItemLabel(), systemMenuItemResetAcceleroCallback, NULL);
 		
 		// init/enable accelerometer
+		accelerometerInit(&accelero, ACCELERO_SAMPLE_INTERVAL, ACCELERO_FILTER_SHIFT, ACCELERO_DEADBAND);
 		pd->system->setPeripheralsEnabled(kAccelerometer);
 
 		// use C-only Playdate API:
@@ -121,7 +338,18 @@ int eventHandler(PlaydateAPI* pd, PDSystemEvent event, uint32_t arg) {
 	else if (event == kEventTerminate) {
 		// game shutdown tasks:
 		
+		pd->system->logToConsole(
+			"accelerometer: %u samples, %u updates between samples, %u changes, %u samples within the deadband",
+			(unsigned int)accelero.stats.samples, (unsigned int)accelero.stats.decimated,
+			(unsigned int)accelero.stats.changes, (unsigned int)accelero.stats.deadbanded
+		);
 		pd->system->setPeripheralsEnabled(kNone);
+		fontBlitterFree(pd, &labelText);
+		for (int i = 0; i < 2; i++) {
+			if (backgrounds[i] != NULL) {
+				pd->graphics->freeBitmap(backgrounds[i]);
+			}
+		}
 	}
 	
 	return 0;
@@ -181,183 +409,54 @@ static int update(void* userdata) {
 	crankRotationDivHighAngle = crankRotationDiv * 45 + 22.5;
 	crankRotationDivLowAngle = crankRotationDiv * 45 - 22.5;
 	
-	// read accelerometer
-	pd->system->getAccelerometer(&acceleroX, &acceleroY, &acceleroZ);
-	acceleroX = acceleroX > 0 ?
-		(acceleroX * LCD_COLUMNS / 2 + LCD_COLUMNS / 2) :
-		(LCD_COLUMNS / 2 - fabs(acceleroX) * LCD_COLUMNS / 2);
-	acceleroY = acceleroY > 0 ?
-		(acceleroY * LCD_COLUMNS / 2 + LCD_COLUMNS / 2) :
-		(LCD_COLUMNS / 2 - fabs(acceleroY) * LCD_COLUMNS / 2);
-	acceleroZ = acceleroZ > 0 ?
-		(acceleroZ * LCD_COLUMNS / 2 + LCD_COLUMNS / 2) :
-		(LCD_COLUMNS / 2 - fabs(acceleroZ) * LCD_COLUMNS / 2);
-	
-	
-	// clear frame buffer before rendering anything this frame
-	pd->graphics->clear(bgColor);
-	
-	// render labels
-	tempDrawMode = pd->graphics->setDrawMode(textDrawMode);
-	pd->graphics->drawText(getDpadLabelText(), strlen(getDpadLabelText()), kASCIIEncoding, 40, 5);
-	pd->graphics->drawText(getAButtonLabelText(), strlen(getAButtonLabelText()), kASCIIEncoding, 220, 5);
-	pd->graphics->drawText(getBButtonLabelText(), strlen(getBButtonLabelText()), kASCIIEncoding, 170, 5);
-	pd->graphics->drawText(getCrankLabelText(), strlen(getCrankLabelText()), kASCIIEncoding, 325, 5);
-	pd->graphics->drawText(getAcceleroLabelText(), strlen(getAcceleroLabelText()), kASCIIEncoding, 165, 150);
-	pd->graphics->drawText(getAcceleroXLabelText(), strlen(getAcceleroXLabelText()), kASCIIEncoding, 195, 170);
-	pd->graphics->drawText(getAcceleroYLabelText(), strlen(getAcceleroYLabelText()), kASCIIEncoding, 195, 190);
-	pd->graphics->drawText(getAcceleroZLabelText(), strlen(getAcceleroZLabelText()), kASCIIEncoding, 195, 210);
-	pd->graphics->setDrawMode(tempDrawMode); // restore prior draw mode
-	
-	// render d-pad
-	if (kButtonLeft & btnsCurr) {
-		pd->graphics->fillTriangle(
-			30, 45,
-			40, 35,
-			40, 55,
-			fgColor
-		);
-	}
-	else {
-		pd->graphics->drawLine(
-			30, 45,
-			40, 35,
-			1,
-			fgColor
-		);
-		pd->graphics->drawLine(
-			40, 35,
-			40, 55,
-			1,
-			fgColor
-		);
-		pd->graphics->drawLine(
-			40, 55,
-			30, 45,
-			1,
-			fgColor
-		);
+	// read accelerometer (sampled, filtered and calibrated; the dots only move if its output changed)
+	if (accelerometerUpdate(pd, &accelero)) {
+		acceleroX = getAcceleroDotX(accelero.value[0]);
+		acceleroY = getAcceleroDotX(accelero.value[1]);
+		acceleroZ = getAcceleroDotX(accelero.value[2]);
 	}
 	
-	if (kButtonRight & btnsCurr) {
-		pd->graphics->fillTriangle(
-			80, 45,
-			70, 35,
-			70, 55,
-			fgColor
-		);
-	}
-	else {
-		pd->graphics->drawLine(
-			80, 45,
-			70, 35,
-			1,
-			fgColor
-		);
-		pd->graphics->drawLine(
-			70, 35,
-			70, 55,
-			1,
-			fgColor
-		);
-		pd->graphics->drawLine(
-			70, 55,
-			80, 45,
-			1,
-			fgColor
-		);
-	}
 	
-	if (kButtonUp & btnsCurr) {
-		pd->graphics->fillTriangle(
-			55, 20,
-			45, 30,
-			65, 30,
-			fgColor
-		);
-	}
-	else {
-		pd->graphics->drawLine(
-			55, 20,
-			45, 30,
-			1,
-			fgColor
-		);
-		pd->graphics->drawLine(
-			45, 30,
-			65, 30,
-			1,
-			fgColor
-		);
-		pd->graphics->drawLine(
-			65, 30,
-			55, 20,
-			1,
-			fgColor
-		);
+	// bring the frame buffer's background up to date with the dark mode (rendering it the first time), then redraw just
+	// the elements that changed, and any others in the rows restored for them
+	int redrawAll = darkMode != renderedDarkMode;
+	if (redrawAll) {
+		renderedDarkMode = darkMode;
+		if (backgrounds[darkMode] == NULL) {
+			backgrounds[darkMode] = renderBackground();
+		}
+		else {
+			restoreBackgroundRows(0, LCD_ROWS - 1);
+		}
 	}
 	
-	if (kButtonDown & btnsCurr) {
-		pd->graphics->fillTriangle(
-			55, 70,
-			45, 60,
-			65, 60,
-			fgColor
-		);
+	int elementStates[kNumElements];
+	for (int e = 0; e < kNumElements; e++) {
+		elementStates[e] = getElementState(e);
+		if (redrawAll == 0 && elementStates[e] != renderedElementStates[e]) {
+			restoreBackgroundRows(elementRows[e][0], elementRows[e][1]);
+		}
 	}
-	else {
-		pd->graphics->drawLine(
-			55, 70,
-			45, 60,
-			1,
-			fgColor
-		);
-		pd->graphics->drawLine(
-			45, 60,
-			65, 60,
-			1,
-			fgColor
-		);
-		pd->graphics->drawLine(
-			65, 60,
-			55, 70,
-			1,
-			fgColor
-		);
+	int drawn = redrawAll;
+	for (int e = 0; e < kNumElements; e++) {
+		if (redrawAll || rowsRestored(elementRows[e][0], elementRows[e][1])) {
+			drawElement(e, elementStates[e]);
+			renderedElementStates[e] = elementStates[e];
+			drawn = 1;
+		}
 	}
+	memset(backgroundRowsRestored, 0, sizeof(backgroundRowsRestored));
 	
-	// render a / b
-	if (kButtonA & btnsCurr) {
-		pd->graphics->fillEllipse(210, 30, 30, 30, 0, 0, fgColor);
-	}
-	else {
-		pd->graphics->drawEllipse(210, 30, 30, 30, 1, 0, 0, fgColor);
-	}
+	// store this frame's button state for next frame's reference (only at end of this frame)
+	btnsPrev = btnsCurr;
 	
-	if (kButtonB & btnsCurr) {
-		pd->graphics->fillEllipse(160, 30, 30, 30, 0, 0, fgColor);
+	// nothing changed: leave the display as is (idle)
+	if (drawn == 0) {
+		return 0;
 	}
-	else {
-		pd->graphics->drawEllipse(160, 30, 30, 30, 1, 0, 0, fgColor);
-	}
-	
-	// render crank
-	pd->graphics->drawEllipse(320, 25, 40, 40, 1, 0, 0, fgColor);
-	pd->graphics->fillEllipse(320, 25, 40, 40, crankRotationDivLowAngle, crankRotationDivHighAngle, fgColor);
 	
-	// render accelero values
-	pd->graphics->drawLine(0, 184, LCD_COLUMNS, 184, 1, fgColor);
-	pd->graphics->fillEllipse((acceleroX > 0 ? (acceleroX < LCD_COLUMNS - 8 ? acceleroX : LCD_COLUMNS - 8) : 0), 180, 8, 8, 0, 0, fgColor);
-	pd->graphics->drawLine(0, 204, LCD_COLUMNS, 204, 1, fgColor);
-	pd->graphics->fillEllipse((acceleroY > 0 ? (acceleroY < LCD_COLUMNS - 8 ? acceleroY : LCD_COLUMNS - 8) : 0), 200, 8, 8, 0, 0, fgColor);
-	pd->graphics->drawLine(0, 224, LCD_COLUMNS, 224, 1, fgColor);
-	pd->graphics->fillEllipse((acceleroZ > 0 ? (acceleroZ < LCD_COLUMNS - 8 ? acceleroZ : LCD_COLUMNS - 8) : 0), 220, 8, 8, 0, 0, fgColor);
-    
 	// render FPS text (debugging only)
 	pd->system->drawFPS(0,0);
 	
-	// store this frame's button state for next frame's reference (only at end of this frame)
-	btnsPrev = btnsCurr;
-
 	return 1;
 }
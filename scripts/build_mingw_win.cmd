@@ -17,6 +17,9 @@ REM     "~PROJECT_ROOT/<PLAYDATE_GAME_NAME>.pdx" directory, and create the
 REM     intermediary "~PROJECT_ROOT/Source" directory.
 REM   - A zip archive of the Playdate distributable directory is 
 REM     generated into "~PROJECT_ROOT/dist" (if command exists).
+REM   - Builds are incremental: "build", "Source" and "*.pdx" are kept, so
+REM     only changed sources and assets are rebuilt/restaged. Pass "clean"
+REM     as the second argument to delete them first (e.g. `build_mingw_win.cmd Release clean`).
 REM
 REM - Developed against Playdate SDK v2.5.0.
 
@@ -34,6 +37,9 @@ REM - argv[0] == Release || Debug
 set PD_BUILD_TYPE=%1
 if "%PD_BUILD_TYPE"=="" (set PD_BUILD_TYPE=Release)
 
+REM - argv[1] == clean || (none)
+set PD_CLEAN=%2
+
 where.exe /q tar && (set CREATE_ZIP=true) || (set CREATE_ZIP=false)
 
 if "%PD_MAKE_PATH%"=="" (echo -- PD_MAKE_PATH Path not found; set ENV value PD_MAKE_PATH to make.exe or edit script && exit /b 1)
@@ -41,13 +47,19 @@ if "%PD_CMAKE_C_COMPILER%"=="" (echo -- PD_CMAKE_C_COMPILER Path not found; set
 if "%PD_CMAKE_TOOLCHAIN_FILE%"=="" (echo -- PD_CMAKE_TOOLCHAIN_FILE Path not found; set ENV value PD_CMAKE_TOOLCHAIN_FILE to Playdate SDK's arm.cmake or edit script && exit /b 1)
 
 
-REM - clean any previous build artifacts to ensure build always has latest:
-for /d %%d in ("build" "Source" "*.pdx" "dist") do (
-  (rmdir /s /q "%%~d" && echo -- goodbye, "%%~d") || echo -- did not find to remove: "%%~d"
+REM - on request, clean any previous build artifacts (otherwise they're reused, and only what changed is rebuilt):
+if "%PD_CLEAN%"=="clean" (
+	for /d %%d in ("build" "Source" "*.pdx") do (
+	  (rmdir /s /q "%%~d" && echo -- goodbye, "%%~d") || echo -- did not find to remove: "%%~d"
+	)
 )
+REM - the distributable archive is always regenerated:
+if exist "dist" (rmdir /s /q "dist")
 
-REM - run cmake/make config and build, in ~PROJECT_ROOT/build dir (FIXME: have to run this set twice to ensure all needed Playdate files are generated):
-for /l %%i in (1, 1, 2) do (
+REM - run cmake/make config and build, in ~PROJECT_ROOT/build dir (FIXME: a fresh build dir needs this set run twice to ensure all needed Playdate files are generated; an existing one, once):
+set PD_BUILD_PASSES=1
+if not exist "build/CMakeCache.txt" (set PD_BUILD_PASSES=2)
+for /l %%i in (1, 1, %PD_BUILD_PASSES%) do (
 	(cmake -G "MinGW Makefiles" -DCMAKE_C_COMPILER="%PD_CMAKE_C_COMPILER%" -DCMAKE_TOOLCHAIN_FILE="%PD_CMAKE_TOOLCHAIN_FILE%" -DCMAKE_BUILD_TYPE=%PD_BUILD_TYPE% -B "./build" && echo -- CONFIG COMPLETED) && ^^
 	("%PD_MAKE_PATH%" -C "./build" && echo -- BUILD COMPLETED)
 )
@@ -0,0 +1,255 @@
+#!/usr/bin/env python3
+"""
+- Packs numbered 1-bit frame sequences (e.g. rotation stills) into single frame pack files,
+  loaded at runtime by src/frame_pack.c in one file open and one decode pass.
+
+- Frame images are found in --src-dir by the name pattern "<name>_frame-<NN><suffix>.png".
+  Each <name> group is written, ordered by <NN>, to "<out-dir>/<name>.framepack".
+
+- Pack format (all integers little-endian):
+  - header, 32 bytes:
+    - magic "PDFP", u16 version (1), u16 frame count, u16 width, u16 height,
+    - u16 words per row (32-bit words, rows padded with white), u16 key frame interval,
+    - u32 index offset, u32 data offset, u32 data size, 4 reserved bytes
+  - index, 12 bytes per frame: u32 offset (from data offset), u32 size, u8 encoding, 3 reserved bytes
+    - encoding 0: key frame, the frame's words run-length encoded
+    - encoding 1: delta frame, the XOR of the frame and the previous frame, run-length encoded
+  - data: the encoded frames
+  - run-length encoding: a stream of u16 tokens over the frame's rows of words;
+    bit 15 set: repeat the following word (bits 0-14) + 1 times,
+    bit 15 clear: copy the following (bits 0-14) + 1 words.
+    Words are 4 raw bytes of the 1-bit row (bit set = white, most significant bit first), so they are
+    never byte-swapped.
+
+- Standard library only; reads non-interlaced grayscale/palette PNGs (as produced for 1-bit art).
+
+- Usage: pack_frames.py --src-dir DIR --out-dir DIR [--key-interval N]
+  Prints the path of every frame image that was packed, one per line.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+PACK_MAGIC = b"PDFP"
+PACK_VERSION = 1
+HEADER_SIZE = 32
+INDEX_ENTRY_SIZE = 12
+ENCODING_KEY = 0
+ENCODING_DELTA = 1
+MAX_RUN = 0x8000
+
+FRAME_NAME_PATTERN = re.compile(r"^(?P<name>.+)_frame-(?P<number>\d+)(?P<suffix>[^/]*)\.png$")
+
+
+def read_png_1bit(path):
+    """Decodes a PNG into (width, height, rows), rows being lists of 0/1 (1 = white)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError("%s: not a PNG" % path)
+
+    pos = 8
+    idat = b""
+    palette = None
+    transparency = None
+    width = height = bit_depth = color_type = interlace = None
+    while pos < len(data):
+        length, kind = struct.unpack(">I4s", data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b"IHDR":
+            width, height, bit_depth, color_type, _, _, interlace = struct.unpack(">IIBBBBB", body)
+        elif kind == b"PLTE":
+            palette = [body[i:i + 3] for i in range(0, len(body), 3)]
+        elif kind == b"tRNS":
+            transparency = body
+        elif kind == b"IDAT":
+            idat += body
+        elif kind == b"IEND":
+            break
+
+    if interlace != 0:
+        raise ValueError("%s: interlaced PNGs are not supported" % path)
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[color_type]
+    bits_per_pixel = channels * bit_depth
+    stride = (width * bits_per_pixel + 7) // 8
+    bpp = max(1, bits_per_pixel // 8)
+    raw = zlib.decompress(idat)
+
+    rows = []
+    prev = bytearray(stride)
+    for y in range(height):
+        filter_type = raw[y * (stride + 1)]
+        line = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for i in range(stride):
+            a = line[i - bpp] if i >= bpp else 0
+            b = prev[i]
+            c = prev[i - bpp] if i >= bpp else 0
+            if filter_type == 1:
+                line[i] = (line[i] + a) & 0xFF
+            elif filter_type == 2:
+                line[i] = (line[i] + b) & 0xFF
+            elif filter_type == 3:
+                line[i] = (line[i] + ((a + b) >> 1)) & 0xFF
+            elif filter_type == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                line[i] = (line[i] + (a if pa <= pb and pa <= pc else (b if pb <= pc else c))) & 0xFF
+        prev = line
+
+        row = []
+        for x in range(width):
+            if bit_depth < 8:
+                sample = (line[(x * bits_per_pixel) // 8] >> (8 - bit_depth - (x * bits_per_pixel) % 8)) & ((1 << bit_depth) - 1)
+                samples = [sample]
+            else:
+                step = bit_depth // 8
+                base = x * channels * step
+                samples = [line[base + ch * step] for ch in range(channels)]
+
+            if color_type == 3:
+                rgb = palette[samples[0]]
+                opaque = transparency is None or samples[0] >= len(transparency) or transparency[samples[0]] >= 128
+                luma = (rgb[0] * 299 + rgb[1] * 587 + rgb[2] * 114) // 1000
+            elif color_type in (0, 4):
+                maxval = (1 << bit_depth) - 1
+                luma = samples[0] * 255 // maxval
+                opaque = color_type == 0 or samples[1] * 255 // maxval >= 128
+            else:
+                scale = 255 // ((1 << bit_depth) - 1) if bit_depth < 16 else 1
+                r, g, b = [s * scale if bit_depth < 16 else s for s in samples[:3]]
+                luma = (r * 299 + g * 587 + b * 114) // 1000
+                opaque = color_type == 2 or samples[3] * scale >= 128
+            # transparent pixels are packed as white; frame packs hold opaque images
+            row.append(1 if (luma >= 128 or not opaque) else 0)
+        rows.append(row)
+
+    return width, height, rows
+
+
+def frame_words(width, rows, words_per_row):
+    """Packs rows of 0/1 into a list of 4-byte words, padding each row with white bits."""
+    words = []
+    padded_bits = words_per_row * 32
+    for row in rows:
+        bits = row + [1] * (padded_bits - width)
+        row_bytes = bytearray()
+        for i in range(0, padded_bits, 8):
+            value = 0
+            for bit in bits[i:i + 8]:
+                value = (value << 1) | bit
+            row_bytes.append(value)
+        words.extend(bytes(row_bytes[i:i + 4]) for i in range(0, len(row_bytes), 4))
+    return words
+
+
+def rle_encode(words):
+    out = bytearray()
+    i = 0
+    n = len(words)
+    literal_start = None
+
+    def flush_literal(end):
+        nonlocal literal_start
+        start = literal_start
+        while start is not None and start < end:
+            count = min(end - start, MAX_RUN)
+            out.extend(struct.pack("<H", count - 1))
+            for word in words[start:start + count]:
+                out.extend(word)
+            start += count
+        literal_start = None
+
+    while i < n:
+        run = 1
+        while i + run < n and run < MAX_RUN and words[i + run] == words[i]:
+            run += 1
+        if run >= 3:
+            flush_literal(i)
+            out.extend(struct.pack("<H", 0x8000 | (run - 1)))
+            out.extend(words[i])
+            i += run
+        else:
+            if literal_start is None:
+                literal_start = i
+            i += run
+    flush_literal(n)
+    return bytes(out)
+
+
+def pack_frames(frame_paths, key_interval):
+    frames = [read_png_1bit(path) for path in frame_paths]
+    width, height = frames[0][0], frames[0][1]
+    for path, (w, h, _) in zip(frame_paths, frames):
+        if (w, h) != (width, height):
+            raise ValueError("%s: frame is %ix%i, expected %ix%i" % (path, w, h, width, height))
+    words_per_row = (width + 31) // 32
+
+    entries = []
+    data = bytearray()
+    prev_words = None
+    for index, (_, _, rows) in enumerate(frames):
+        words = frame_words(width, rows, words_per_row)
+        encoded = rle_encode(words)
+        encoding = ENCODING_KEY
+        if prev_words is not None and index % key_interval != 0:
+            delta = [bytes(a ^ b for a, b in zip(w, p)) for w, p in zip(words, prev_words)]
+            encoded_delta = rle_encode(delta)
+            if len(encoded_delta) < len(encoded):
+                encoded = encoded_delta
+                encoding = ENCODING_DELTA
+        entries.append((len(data), len(encoded), encoding))
+        data.extend(encoded)
+        while len(data) % 4 != 0:
+            data.append(0)
+        prev_words = words
+
+    index_offset = HEADER_SIZE
+    data_offset = index_offset + INDEX_ENTRY_SIZE * len(entries)
+    out = bytearray()
+    out.extend(PACK_MAGIC)
+    out.extend(struct.pack("<HHHHHHIII4x", PACK_VERSION, len(frames), width, height, words_per_row, key_interval, index_offset, data_offset, len(data)))
+    for offset, size, encoding in entries:
+        out.extend(struct.pack("<IIB3x", offset, size, encoding))
+    out.extend(data)
+    return bytes(out)
+
+
+def find_sequences(src_dir):
+    sequences = {}
+    for entry in sorted(os.listdir(src_dir)):
+        match = FRAME_NAME_PATTERN.match(entry)
+        if match:
+            sequences.setdefault(match.group("name"), []).append((int(match.group("number")), os.path.join(src_dir, entry)))
+    return {name: [path for _, path in sorted(frames)] for name, frames in sequences.items()}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pack numbered 1-bit frame images into frame pack files.")
+    parser.add_argument("--src-dir", required=True)
+    parser.add_argument("--out-dir", required=True)
+    parser.add_argument("--key-interval", type=int, default=8, help="every Nth frame is a key frame; bounds the delta chain decoded for random access")
+    args = parser.parse_args()
+
+    if args.key_interval < 1:
+        parser.error("--key-interval must be >= 1")
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    for name, paths in find_sequences(args.src_dir).items():
+        packed = pack_frames(paths, args.key_interval)
+        out_path = os.path.join(args.out_dir, name + ".framepack")
+        # only rewrite on change, so downstream steps (pdc) see an unchanged timestamp
+        if not os.path.exists(out_path) or open(out_path, "rb").read() != packed:
+            with open(out_path, "wb") as f:
+                f.write(packed)
+        for path in paths:
+            print(path)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
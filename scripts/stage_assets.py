@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+"""
+- Stages --src-dir (the project's assets) into --out-dir incrementally: only assets whose inputs
+  changed are copied or converted, conversions run in parallel, and staged files whose source was
+  removed are deleted.
+
+- Each staged file is produced by one step:
+  - frame pack: a numbered 1-bit frame sequence ("<name>_frame-<NN>*.png", see pack_frames.py),
+    packed into "<name>.framepack" beside it
+  - tile set: an image larger than the screen (see tile_image.py), tiled into "<name>.tileset" beside it
+    (the image itself is copied too)
+  - audio: a *.wav/*.mp3, transcoded per --audio-manifest (see transcode_audio.py)
+  - copy: any other file
+  A step's key is the SHA-256 of its kind, settings and inputs (relative paths and contents). The
+  keys of the last run are kept in the --manifest file (JSON, in the build tree); a step is skipped
+  if its key and its output are unchanged. Inputs are only re-hashed when their size or
+  modification time changed.
+
+- Files in --out-dir that no step produced are deleted (so nothing else may be staged there).
+
+- Usage: stage_assets.py --src-dir DIR --out-dir DIR --manifest FILE [--audio-manifest FILE]
+         [--key-interval N] [--tile-size N] [--jobs N]
+  Prints the path of every file written or deleted, one per line, then a summary.
+"""
+
+import argparse
+import concurrent.futures
+import hashlib
+import json
+import os
+import shutil
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import pack_frames  # noqa: E402
+import tile_image  # noqa: E402
+import transcode_audio  # noqa: E402
+
+# bump to re-stage everything after changing how steps are keyed or run
+STAGE_VERSION = 1
+
+
+def file_hash(path, stat, previous):
+    """Returns the input's content hash, reusing the last run's if size and modification time are unchanged."""
+    if previous and previous.get("size") == stat.st_size and previous.get("mtime") == stat.st_mtime_ns:
+        return previous["hash"]
+    digest = hashlib.sha256()
+    with open(path, "rb") as f:
+        for block in iter(lambda: f.read(1 << 16), b""):
+            digest.update(block)
+    return digest.hexdigest()
+
+
+def plan_steps(src_dir, audio_manifest):
+    """Returns {output relative path: (kind, setting, [input relative paths])}."""
+    steps = {}
+
+    def add(rel_out, step):
+        if rel_out in steps:
+            raise ValueError("%s and %s both stage to %s" % (steps[rel_out][2][0], step[2][0], rel_out))
+        steps[rel_out] = step
+
+    for root, _, files in os.walk(src_dir):
+        rel_dir = os.path.relpath(root, src_dir).replace(os.sep, "/")
+        rel_dir = "" if rel_dir == "." else rel_dir + "/"
+
+        sequences = pack_frames.find_sequences(root)
+        packed = set()
+        for name, paths in sequences.items():
+            inputs = [rel_dir + os.path.basename(path) for path in paths]
+            packed.update(inputs)
+            add(rel_dir + name + ".framepack", ("framepack", None, inputs))
+
+        for name in sorted(files):
+            rel_path = rel_dir + name
+            if rel_path in packed:
+                continue
+            stem, ext = os.path.splitext(rel_path)
+            if ext.lower() == ".png" and tile_image.is_tiled(os.path.join(root, name)):
+                add(stem + ".tileset", ("tileset", None, [rel_path]))
+            if audio_manifest is not None and ext.lower() in transcode_audio.AUDIO_EXTENSIONS:
+                audio_format = transcode_audio.format_for(rel_path, audio_manifest)
+                add(stem + transcode_audio.output_ext(ext.lower(), audio_format), ("audio", audio_format, [rel_path]))
+            else:
+                add(rel_path, ("copy", None, [rel_path]))
+    return steps
+
+
+def run_step(src_dir, out_path, kind, setting, inputs, key_interval, tile_size):
+    """Produces one staged file; returns False if it fell back to a plain copy (so isn't final)."""
+    os.makedirs(os.path.dirname(out_path), exist_ok=True)
+    src_paths = [os.path.join(src_dir, rel_path) for rel_path in inputs]
+    if kind == "framepack":
+        with open(out_path, "wb") as f:
+            f.write(pack_frames.pack_frames(src_paths, key_interval))
+        return True
+    if kind == "tileset":
+        with open(out_path, "wb") as f:
+            f.write(tile_image.tile_image(src_paths[0], tile_size))
+        return True
+    if kind == "audio":
+        with tempfile.TemporaryDirectory() as temp_dir:
+            return transcode_audio.transcode(src_paths[0], out_path, setting, temp_dir)
+    shutil.copy2(src_paths[0], out_path)
+    return True
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Stages assets incrementally")
+    parser.add_argument("--src-dir", required=True)
+    parser.add_argument("--out-dir", required=True)
+    parser.add_argument("--manifest", required=True, help="step keys and input hashes of the last run (JSON)")
+    parser.add_argument("--audio-manifest", help="audio formats (see transcode_audio.py); without it, audio is copied")
+    parser.add_argument("--key-interval", type=int, default=8, help="frame pack key frame interval (see pack_frames.py)")
+    parser.add_argument("--tile-size", type=int, default=32, help="tile set tile size (see tile_image.py)")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1, help="parallel conversions")
+    args = parser.parse_args()
+
+    audio_manifest = None
+    if args.audio_manifest:
+        with open(args.audio_manifest) as f:
+            audio_manifest = json.load(f)
+    try:
+        with open(args.manifest) as f:
+            previous = json.load(f)
+        if previous.get("version") != STAGE_VERSION:
+            previous = {}
+    except (OSError, ValueError):
+        previous = {}
+    previous_inputs = previous.get("inputs", {})
+    previous_steps = previous.get("steps", {})
+
+    steps = plan_steps(args.src_dir, audio_manifest)
+
+    # key every step by its settings and its inputs' content
+    inputs = {}
+    keys = {}
+    for rel_out, (kind, setting, step_inputs) in sorted(steps.items()):
+        digest = hashlib.sha256()
+        digest.update(json.dumps([STAGE_VERSION, kind, setting]).encode())
+        if kind == "framepack":
+            digest.update(str(args.key_interval).encode())
+        if kind == "tileset":
+            digest.update(str(args.tile_size).encode())
+        if kind == "audio":
+            digest.update(str(transcode_audio.TRANSCODER_VERSION).encode())
+        for rel_path in step_inputs:
+            path = os.path.join(args.src_dir, rel_path)
+            stat = os.stat(path)
+            content = file_hash(path, stat, previous_inputs.get(rel_path))
+            inputs[rel_path] = {"size": stat.st_size, "mtime": stat.st_mtime_ns, "hash": content}
+            digest.update(rel_path.encode() + b"\0" + content.encode())
+        keys[rel_out] = digest.hexdigest()
+
+    dirty = [
+        rel_out for rel_out in sorted(steps)
+        if previous_steps.get(rel_out) != keys[rel_out] or not os.path.exists(os.path.join(args.out_dir, rel_out))
+    ]
+
+    done = {rel_out: key for rel_out, key in keys.items() if rel_out not in dirty}
+    failed = None
+    with concurrent.futures.ProcessPoolExecutor(max_workers=max(1, min(args.jobs, len(dirty) or 1))) as pool:
+        futures = {
+            pool.submit(run_step, args.src_dir, os.path.join(args.out_dir, rel_out), *steps[rel_out], args.key_interval, args.tile_size): rel_out
+            for rel_out in dirty
+        }
+        for future in concurrent.futures.as_completed(futures):
+            rel_out = futures[future]
+            try:
+                final = future.result()
+            except Exception as e:
+                failed = failed or "%s: %s" % (rel_out, e)
+                continue
+            if final:
+                done[rel_out] = keys[rel_out]
+            else:
+                print("warning: ffmpeg not found; %s staged as it is" % rel_out, file=sys.stderr)
+            print(os.path.join(args.out_dir, rel_out))
+
+    # delete what no step produces (anymore), and directories left empty
+    removed = 0
+    for root, dirs, files in os.walk(args.out_dir, topdown=False):
+        for name in files:
+            path = os.path.join(root, name)
+            rel_out = os.path.relpath(path, args.out_dir).replace(os.sep, "/")
+            if rel_out not in steps:
+                os.remove(path)
+                removed += 1
+                print(path)
+        if root != args.out_dir and not os.listdir(root):
+            os.rmdir(root)
+
+    # record only finished steps, so failed or fallen back ones are retried next time
+    with open(args.manifest, "w") as f:
+        json.dump({"version": STAGE_VERSION, "inputs": inputs, "steps": done}, f, indent=1, sort_keys=True)
+
+    print("staged %d of %d assets (%d removed)" % (len(dirty), len(steps), removed))
+    if failed:
+        raise ValueError(failed)
+    return 0
+
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except (OSError, ValueError) as e:
+        print("stage_assets.py: %s" % e, file=sys.stderr)
+        sys.exit(1)
@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+"""
+- Tiles 1-bit images larger than the screen into tile sets, streamed tile by tile at runtime by src/tile_set.c
+  (so only the tiles in and around the view need to be in memory).
+
+- Every PNG in --src-dir wider than SCREEN_WIDTH or taller than SCREEN_HEIGHT is written to
+  "<out-dir>/<name>.tileset": the image (level 0) and half-resolution levels of it (each half the size of
+  the one before, re-dithered), down to the first one that fits on the screen.
+
+- Tile set format (all integers little-endian):
+  - header, 32 bytes:
+    - magic "PDTS", u16 version (1), u16 tile size (pixels, square, a multiple of 8), u16 level count,
+      u16 width, u16 height (level 0's), u8 background (0: black, 1: white; the color past the image's
+      edges, and of the edge tiles' padding), 1 reserved byte, u16 tile count, 2 reserved bytes,
+    - u32 index offset, u32 data offset, u32 data size
+  - levels, 8 bytes per level (from the header's end): u16 width, u16 height, u16 columns, u16 rows (in tiles)
+  - index: per level, per tile (by row, then column) a u16 tile number; tile number n's data is at the
+    data offset + n * the tile's byte size (tile size * tile size / 8)
+  - data: the distinct tiles (identical tiles, e.g. solid ones, are stored once), each tile size rows of
+    tile size / 8 bytes of 1-bit pixels (bit set = white, most significant bit first)
+
+- Standard library only (PNGs are read as for pack_frames.py).
+
+- Usage: tile_image.py --src-dir DIR --out-dir DIR [--tile-size N]
+  Prints the path of every image that was tiled, one per line.
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import pack_frames  # noqa: E402
+
+TILE_SET_MAGIC = b"PDTS"
+TILE_SET_VERSION = 1
+HEADER_SIZE = 32
+LEVEL_ENTRY_SIZE = 8
+MAX_TILES = 0x10000
+# keep in sync with TILE_SET_MAX_LEVELS (include/tile_set.h)
+MAX_LEVELS = 8
+
+SCREEN_WIDTH = 400
+SCREEN_HEIGHT = 240
+
+# 4x4 ordered dither thresholds, for re-dithering the half-resolution levels
+BAYER_4X4 = (
+    (0, 8, 2, 10),
+    (12, 4, 14, 6),
+    (3, 11, 1, 9),
+    (15, 7, 13, 5),
+)
+
+
+def png_size(path):
+    """Returns a PNG's (width, height) from its header, without decoding it."""
+    with open(path, "rb") as f:
+        header = f.read(24)
+    if header[:8] != b"\x89PNG\r\n\x1a\n" or header[12:16] != b"IHDR":
+        raise ValueError("%s: not a PNG" % path)
+    return struct.unpack(">II", header[16:24])
+
+
+def is_tiled(path):
+    """Returns True if the image at path is staged as a tile set (it's larger than the screen)."""
+    width, height = png_size(path)
+    return width > SCREEN_WIDTH or height > SCREEN_HEIGHT
+
+
+def background_of(width, height, rows):
+    """Returns the image's border color (the more common one along its edges): 0 black, 1 white."""
+    edge = [rows[0][x] + rows[height - 1][x] for x in range(width)] + [rows[y][0] + rows[y][width - 1] for y in range(height)]
+    return 1 if 2 * sum(edge) > len(edge) else 0
+
+
+def half_level(width, height, rows, background):
+    """Returns (width, height, rows) at half the resolution: 2x2 blocks averaged, then ordered-dithered back to 1 bit."""
+    half_width = (width + 1) // 2
+    half_height = (height + 1) // 2
+
+    def pixel(x, y):
+        return rows[y][x] if x < width and y < height else background
+
+    half_rows = []
+    for y in range(half_height):
+        row = []
+        for x in range(half_width):
+            # white if the block's coverage (in sixteenths) exceeds the threshold: 4 of 4 always, 0 never
+            level = (pixel(2 * x, 2 * y) + pixel(2 * x + 1, 2 * y) + pixel(2 * x, 2 * y + 1) + pixel(2 * x + 1, 2 * y + 1)) * 4
+            row.append(1 if level > BAYER_4X4[y % 4][x % 4] else 0)
+        half_rows.append(row)
+    return half_width, half_height, half_rows
+
+
+def tile_bytes(rows, width, height, tile_size, column, row, background):
+    """Packs one tile's pixels (padded with background past the image's edges) into bytes."""
+    out = bytearray()
+    for y in range(row * tile_size, (row + 1) * tile_size):
+        line = rows[y] if y < height else None
+        for x0 in range(column * tile_size, (column + 1) * tile_size, 8):
+            value = 0
+            for x in range(x0, x0 + 8):
+                bit = line[x] if line is not None and x < width else background
+                value = (value << 1) | bit
+            out.append(value)
+    return bytes(out)
+
+
+def tile_image(path, tile_size):
+    width, height, rows = pack_frames.read_png_1bit(path)
+    background = background_of(width, height, rows)
+
+    levels = [(width, height, rows)]
+    while (levels[-1][0] > SCREEN_WIDTH or levels[-1][1] > SCREEN_HEIGHT) and len(levels) < MAX_LEVELS:
+        levels.append(half_level(*levels[-1], background))
+
+    tiles = {}
+    data = bytearray()
+    level_entries = bytearray()
+    index = bytearray()
+    for level_width, level_height, level_rows in levels:
+        columns = (level_width + tile_size - 1) // tile_size
+        tile_rows = (level_height + tile_size - 1) // tile_size
+        level_entries.extend(struct.pack("<HHHH", level_width, level_height, columns, tile_rows))
+        for row in range(tile_rows):
+            for column in range(columns):
+                tile = tile_bytes(level_rows, level_width, level_height, tile_size, column, row, background)
+                number = tiles.get(tile)
+                if number is None:
+                    number = len(tiles)
+                    if number >= MAX_TILES:
+                        raise ValueError("%s: more than %i distinct tiles; use a larger --tile-size" % (path, MAX_TILES))
+                    tiles[tile] = number
+                    data.extend(tile)
+                index.extend(struct.pack("<H", number))
+
+    index_offset = HEADER_SIZE + len(level_entries)
+    data_offset = index_offset + len(index)
+    while data_offset % 4 != 0:
+        index.append(0)
+        data_offset += 1
+    out = bytearray()
+    out.extend(TILE_SET_MAGIC)
+    out.extend(struct.pack(
+        "<HHHHHBxH2xIII", TILE_SET_VERSION, tile_size, len(levels), width, height, background, len(tiles),
+        index_offset, data_offset, len(data)
+    ))
+    out.extend(level_entries)
+    out.extend(index)
+    out.extend(data)
+    return bytes(out)
+
+
+def find_images(src_dir):
+    """Returns the paths of the images in src_dir to tile (frame images aside: those are packed), in name order."""
+    return [
+        os.path.join(src_dir, entry) for entry in sorted(os.listdir(src_dir))
+        if entry.lower().endswith(".png") and not pack_frames.FRAME_NAME_PATTERN.match(entry) and is_tiled(os.path.join(src_dir, entry))
+    ]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Tile 1-bit images larger than the screen into tile sets.")
+    parser.add_argument("--src-dir", required=True)
+    parser.add_argument("--out-dir", required=True)
+    parser.add_argument("--tile-size", type=int, default=32, help="tile width and height in pixels (a multiple of 8)")
+    args = parser.parse_args()
+
+    if args.tile_size < 8 or args.tile_size > 256 or args.tile_size % 8 != 0:
+        parser.error("--tile-size must be a multiple of 8 in [8, 256]")
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    for path in find_images(args.src_dir):
+        tiled = tile_image(path, args.tile_size)
+        out_path = os.path.join(args.out_dir, os.path.splitext(os.path.basename(path))[0] + ".tileset")
+        # only rewrite on change, so downstream steps (pdc) see an unchanged timestamp
+        if not os.path.exists(out_path) or open(out_path, "rb").read() != tiled:
+            with open(out_path, "wb") as f:
+                f.write(tiled)
+        print(path)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,327 @@
+#!/usr/bin/env python3
+"""
+- Stages the audio assets (*.wav, *.mp3) of --src-dir into --out-dir, transcoding each to the format
+  its manifest entry asks for:
+  - "adpcm": IMA ADPCM WAV (4 bits per sample; decoded natively by the Playdate, so samples stay
+    compressed in memory, at about a quarter of 16-bit PCM)
+  - "pcm": 16-bit PCM WAV
+  - "mp3": MP3 (streamed by the fileplayer; for music)
+  - "copy": the file as it is
+  WAV sources are read with the standard library; decoding/encoding MP3 needs ffmpeg on the PATH.
+  If ffmpeg is needed but missing, the file is copied as it is (with a warning).
+
+- Manifest (JSON, --manifest): {"formats": {"<path>": "<format>", ...}, "default": "<format>"}
+  <path> is a file or directory relative to --src-dir (e.g. "music", "music/theme.mp3");
+  the longest matching path wins, files matching none get "default" (or "copy").
+
+- Outputs are named like their sources, with the extension of their format (".wav" or ".mp3").
+  Files whose content, format and this script's version are unchanged since the last run (per the
+  --cache file of content hashes) are skipped; outputs of sources that were removed, or whose
+  output name changed, are deleted.
+
+- Usage: transcode_audio.py --src-dir DIR --out-dir DIR --manifest FILE --cache FILE
+  Prints the path of every output written, one per line.
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+
+# bump to re-transcode everything after changing an encoder
+TRANSCODER_VERSION = 1
+
+AUDIO_EXTENSIONS = (".wav", ".mp3")
+FORMATS = ("adpcm", "pcm", "mp3", "copy")
+
+WAVE_FORMAT_PCM = 0x0001
+WAVE_FORMAT_IEEE_FLOAT = 0x0003
+WAVE_FORMAT_IMA_ADPCM = 0x0011
+WAVE_FORMAT_EXTENSIBLE = 0xFFFE
+
+# bytes per channel per ADPCM block (incl. its 4 byte header)
+ADPCM_CHANNEL_BLOCK_SIZE = 512
+
+IMA_INDEX_TABLE = (-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8)
+IMA_STEP_TABLE = (
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80,
+    88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544,
+    598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749,
+    3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635,
+    13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+)
+
+
+def read_wav(path):
+    """Decodes a PCM/float WAV into (sample rate, channels as lists of 16-bit ints)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"RIFF" or data[8:12] != b"WAVE":
+        raise ValueError("%s: not a WAV file" % path)
+
+    fmt = None
+    samples = None
+    pos = 12
+    while pos + 8 <= len(data):
+        chunk_id = data[pos:pos + 4]
+        chunk_size = struct.unpack_from("<I", data, pos + 4)[0]
+        body = data[pos + 8:pos + 8 + chunk_size] # (clamped for streamed WAVs, whose sizes are left unset)
+        if chunk_id == b"fmt ":
+            fmt = struct.unpack_from("<HHIIHH", body)
+            format_tag = fmt[0]
+            if format_tag == WAVE_FORMAT_EXTENSIBLE and len(body) >= 26:
+                format_tag = struct.unpack_from("<H", body, 24)[0]
+            fmt = (format_tag,) + fmt[1:]
+        elif chunk_id == b"data":
+            samples = body
+        pos += 8 + chunk_size + (chunk_size & 1)
+    if fmt is None or samples is None:
+        raise ValueError("%s: missing fmt or data chunk" % path)
+
+    format_tag, channels, rate, _, _, bits = fmt
+    width = bits // 8
+    if format_tag == WAVE_FORMAT_PCM and bits in (8, 16, 24, 32):
+        if bits == 8:
+            values = [(b - 128) << 8 for b in samples]
+        elif bits == 16:
+            count = len(samples) // 2
+            values = list(struct.unpack_from("<%dh" % count, samples))
+        else:
+            count = len(samples) // width
+            values = [
+                int.from_bytes(samples[i * width:(i + 1) * width], "little", signed=True) >> (bits - 16)
+                for i in range(count)
+            ]
+    elif format_tag == WAVE_FORMAT_IEEE_FLOAT and bits in (32, 64):
+        count = len(samples) // width
+        floats = struct.unpack_from("<%d%s" % (count, "f" if bits == 32 else "d"), samples)
+        values = [max(-32768, min(32767, int(round(v * 32767.0)))) for v in floats]
+    else:
+        raise ValueError("%s: unsupported WAV format (tag 0x%04x, %d bits)" % (path, format_tag, bits))
+
+    frames = len(values) // channels
+    return rate, [values[c:frames * channels:channels] for c in range(channels)]
+
+
+def wav_file(format_chunk, data, extra_chunks=b""):
+    body = b"WAVE" + b"fmt " + struct.pack("<I", len(format_chunk)) + format_chunk + extra_chunks
+    body += b"data" + struct.pack("<I", len(data)) + data + (b"\0" if len(data) & 1 else b"")
+    return b"RIFF" + struct.pack("<I", len(body)) + body
+
+
+def encode_pcm16(rate, channels):
+    count = len(channels)
+    frames = len(channels[0])
+    interleaved = [channels[c][i] for i in range(frames) for c in range(count)]
+    format_chunk = struct.pack("<HHIIHH", WAVE_FORMAT_PCM, count, rate, rate * count * 2, count * 2, 16)
+    return wav_file(format_chunk, struct.pack("<%dh" % len(interleaved), *interleaved))
+
+
+def encode_adpcm_nibbles(samples, predictor, index):
+    """IMA ADPCM-encodes samples following a block's header sample; returns (nibbles, predictor, step index)."""
+    nibbles = []
+    for sample in samples:
+        step = IMA_STEP_TABLE[index]
+        diff = sample - predictor
+        nibble = 0
+        if diff < 0:
+            nibble = 8
+            diff = -diff
+        # mirror the decoder's arithmetic, so the predictor doesn't drift from the decoded signal
+        delta = step >> 3
+        if diff >= step:
+            nibble |= 4
+            diff -= step
+            delta += step
+        step >>= 1
+        if diff >= step:
+            nibble |= 2
+            diff -= step
+            delta += step
+        step >>= 1
+        if diff >= step:
+            nibble |= 1
+            delta += step
+        predictor = predictor - delta if nibble & 8 else predictor + delta
+        predictor = max(-32768, min(32767, predictor))
+        index = max(0, min(88, index + IMA_INDEX_TABLE[nibble]))
+        nibbles.append(nibble)
+    return nibbles, predictor, index
+
+
+def encode_adpcm(rate, channels):
+    """Encodes to an IMA ADPCM WAV (Microsoft layout: per block, per-channel headers, then 8 samples per channel in turn)."""
+    count = len(channels)
+    frames = len(channels[0])
+    block_align = ADPCM_CHANNEL_BLOCK_SIZE * count
+    samples_per_block = (ADPCM_CHANNEL_BLOCK_SIZE - 4) * 2 + 1
+
+    blocks = []
+    indices = [0] * count
+    for start in range(0, frames, samples_per_block):
+        headers = b""
+        channel_nibbles = []
+        for c in range(count):
+            block = channels[c][start:start + samples_per_block]
+            block += [0] * (samples_per_block - len(block)) # (pad the last block with silence)
+            predictor = block[0]
+            headers += struct.pack("<hBB", predictor, indices[c], 0)
+            nibbles, _, indices[c] = encode_adpcm_nibbles(block[1:], predictor, indices[c])
+            channel_nibbles.append(nibbles)
+
+        body = bytearray(headers)
+        for group in range(0, samples_per_block - 1, 8):
+            for c in range(count):
+                n = channel_nibbles[c][group:group + 8]
+                body += bytes(n[i] | (n[i + 1] << 4) for i in range(0, 8, 2))
+        blocks.append(bytes(body))
+
+    format_chunk = struct.pack(
+        "<HHIIHHHH", WAVE_FORMAT_IMA_ADPCM, count, rate, rate * block_align // samples_per_block,
+        block_align, 4, 2, samples_per_block,
+    )
+    fact_chunk = b"fact" + struct.pack("<II", 4, frames)
+    return wav_file(format_chunk, b"".join(blocks), fact_chunk)
+
+
+def run_ffmpeg(args):
+    ffmpeg = shutil.which("ffmpeg")
+    if ffmpeg is None:
+        return False
+    subprocess.run([ffmpeg, "-v", "error", "-y"] + args, check=True, stdin=subprocess.DEVNULL)
+    return True
+
+
+def read_audio(path, temp_dir):
+    """Decodes a WAV or (with ffmpeg) MP3; returns (rate, channels), or None if ffmpeg is missing."""
+    if path.lower().endswith(".wav"):
+        return read_wav(path)
+    decoded = os.path.join(temp_dir, "decoded.wav")
+    if not run_ffmpeg(["-i", path, "-acodec", "pcm_s16le", "-f", "wav", decoded]):
+        return None
+    return read_wav(decoded)
+
+
+def transcode(src_path, out_path, audio_format, temp_dir):
+    """Writes src_path to out_path in audio_format; returns False if it had to be copied as it is instead."""
+    source_ext = os.path.splitext(src_path)[1].lower()
+    if audio_format == "copy" or (audio_format == "mp3" and source_ext == ".mp3"):
+        shutil.copyfile(src_path, out_path)
+        return True
+
+    if audio_format == "mp3":
+        if run_ffmpeg(["-i", src_path, "-codec:a", "libmp3lame", "-q:a", "4", out_path]):
+            return True
+    else:
+        decoded = read_audio(src_path, temp_dir)
+        if decoded is not None:
+            encoded = encode_adpcm(*decoded) if audio_format == "adpcm" else encode_pcm16(*decoded)
+            with open(out_path, "wb") as f:
+                f.write(encoded)
+            return True
+
+    shutil.copyfile(src_path, out_path)
+    return False
+
+
+def format_for(rel_path, manifest):
+    best, best_len = manifest.get("default", "copy"), -1
+    for path, audio_format in manifest.get("formats", {}).items():
+        path = path.strip("/")
+        if (rel_path == path or rel_path.startswith(path + "/")) and len(path) > best_len:
+            best, best_len = audio_format, len(path)
+    if best not in FORMATS:
+        raise ValueError("unknown audio format '%s' for %s (one of %s)" % (best, rel_path, ", ".join(FORMATS)))
+    return best
+
+
+def output_ext(src_ext, audio_format):
+    if audio_format in ("adpcm", "pcm"):
+        return ".wav"
+    if audio_format == "mp3":
+        return ".mp3"
+    return src_ext
+
+
+def content_hash(path, audio_format):
+    digest = hashlib.sha256()
+    digest.update(("%d:%s:" % (TRANSCODER_VERSION, audio_format)).encode())
+    with open(path, "rb") as f:
+        for block in iter(lambda: f.read(1 << 16), b""):
+            digest.update(block)
+    return digest.hexdigest()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Transcodes audio assets per a manifest")
+    parser.add_argument("--src-dir", required=True)
+    parser.add_argument("--out-dir", required=True)
+    parser.add_argument("--manifest", required=True)
+    parser.add_argument("--cache", required=True, help="content hashes of the last run (JSON)")
+    args = parser.parse_args()
+
+    with open(args.manifest) as f:
+        manifest = json.load(f)
+    try:
+        with open(args.cache) as f:
+            cache = json.load(f)
+    except (OSError, ValueError):
+        cache = {}
+
+    sources = []
+    for root, _, files in os.walk(args.src_dir):
+        for name in sorted(files):
+            if os.path.splitext(name)[1].lower() in AUDIO_EXTENSIONS:
+                rel_path = os.path.relpath(os.path.join(root, name), args.src_dir).replace(os.sep, "/")
+                sources.append(rel_path)
+
+    new_cache = {}
+    outputs = {}
+    with tempfile.TemporaryDirectory() as temp_dir:
+        for rel_path in sorted(sources):
+            audio_format = format_for(rel_path, manifest)
+            stem, ext = os.path.splitext(rel_path)
+            rel_out = stem + output_ext(ext.lower(), audio_format)
+            if rel_out in outputs:
+                raise ValueError("%s and %s both stage to %s" % (outputs[rel_out], rel_path, rel_out))
+            outputs[rel_out] = rel_path
+
+            src_path = os.path.join(args.src_dir, rel_path)
+            out_path = os.path.join(args.out_dir, rel_out)
+            digest = content_hash(src_path, audio_format)
+            entry = cache.get(rel_path)
+            if entry and entry.get("hash") == digest and entry.get("output") == rel_out and os.path.exists(out_path):
+                new_cache[rel_path] = entry
+                continue
+
+            os.makedirs(os.path.dirname(out_path), exist_ok=True)
+            if transcode(src_path, out_path, audio_format, temp_dir):
+                new_cache[rel_path] = {"hash": digest, "output": rel_out}
+            else:
+                print("warning: ffmpeg not found; %s copied as it is instead of as %s" % (rel_path, audio_format), file=sys.stderr)
+            print(out_path)
+
+    # delete outputs that are no longer produced (their source was removed, or staged under another name now)
+    for rel_path, entry in cache.items():
+        rel_out = entry.get("output")
+        if rel_out and rel_out not in outputs:
+            stale = os.path.join(args.out_dir, rel_out)
+            if os.path.exists(stale):
+                os.remove(stale)
+
+    with open(args.cache, "w") as f:
+        json.dump(new_cache, f, indent=1, sort_keys=True)
+    return 0
+
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except (OSError, ValueError, subprocess.CalledProcessError) as e:
+        print("transcode_audio.py: %s" % e, file=sys.stderr)
+        sys.exit(1)
@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+"""
+- Unwraps the globe rotation frames ("<name>_frame-NN<suffix>.png", as packed by pack_frames.py) into one
+  1-bit equirectangular map, for the procedural globe renderer (src/globe_renderer.c) to project back
+  onto the sphere at any longitude.
+
+- The frames are taken as orthographic views of an untilted globe, the same disc in every frame, turned
+  360 / frame count degrees from one frame to the next. The disc is fitted to the frames' lit pixels
+  (printed, for the renderer's disc settings), and the turn's direction is the one under which the frames
+  agree the most where they overlap.
+
+- Each map pixel blends the frames that see it, weighted towards the one facing it the most (so the limbs'
+  foreshortened pixels count for little), from the frames' pixels box-filtered to gray levels; the blend
+  is ordered-dithered back to 1 bit. Longitudes grow eastward (to the right on the disc) from map column 0,
+  the center of the first frame; frame n is centered at longitude direction * 360 * n / frame count (the
+  printed direction: -1 for the Earth's own turn, the view's longitude falling as it turns).
+
+- Standard library only (PNGs are read as for pack_frames.py, and written as 1-bit grayscale).
+
+- Usage: unwrap_globe.py --frames PNG... --out PNG [--width N]
+  The map is N by N / 2 pixels (N even). The default, 400, is the widest map that still fits the screen (so
+  it's staged as a plain image, not a tile set) and about matches the frames' resolution at the disc's center.
+"""
+
+import argparse
+import math
+import os
+import struct
+import sys
+import zlib
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import pack_frames  # noqa: E402
+
+# 4x4 ordered dither thresholds, as for tile_image.py's levels
+BAYER_4X4 = (
+    (0, 8, 2, 10),
+    (12, 4, 14, 6),
+    (3, 11, 1, 9),
+    (15, 7, 13, 5),
+)
+
+# frame pixels are averaged over a (2 * BOX_RADIUS + 1) square, to sample gray levels rather than dither
+BOX_RADIUS = 1
+# how sharply the blend favors the frame facing a point (the weight is the cosine of its angle from the view, to this power)
+FACING_POWER = 4
+# the least facing a frame's pixel needs to count towards the frames' agreement (the limbs, where the fit's error shows the most, don't)
+SCORE_MIN_FACING = 0.15
+
+
+def fit_disc(frames):
+    """Returns the (center x, center y, radius) of the disc enclosing the lit pixels of all frames."""
+    left = top = 1 << 30
+    right = bottom = -1
+    for width, height, rows in frames:
+        for y in range(height):
+            row = rows[y]
+            if 1 not in row:
+                continue
+            top = min(top, y)
+            bottom = max(bottom, y)
+            left = min(left, row.index(1))
+            right = max(right, width - 1 - row[::-1].index(1))
+    center_x = (left + right + 1) / 2.0
+    center_y = (top + bottom + 1) / 2.0
+    radius = max(right + 1 - left, bottom + 1 - top) / 2.0
+    return center_x, center_y, radius
+
+
+def box_filter(width, height, rows):
+    """Returns the frame as gray levels in [0, 1]: each pixel the mean of the box around it."""
+    integral = [[0] * (width + 1) for _ in range(height + 1)]
+    for y in range(height):
+        running = 0
+        row = rows[y]
+        above = integral[y]
+        line = integral[y + 1]
+        for x in range(width):
+            running += row[x]
+            line[x + 1] = above[x + 1] + running
+    gray = []
+    for y in range(height):
+        y0 = max(0, y - BOX_RADIUS)
+        y1 = min(height, y + BOX_RADIUS + 1)
+        line = []
+        for x in range(width):
+            x0 = max(0, x - BOX_RADIUS)
+            x1 = min(width, x + BOX_RADIUS + 1)
+            total = integral[y1][x1] - integral[y0][x1] - integral[y1][x0] + integral[y0][x0]
+            line.append(total / float((y1 - y0) * (x1 - x0)))
+        gray.append(line)
+    return gray
+
+
+def project(disc, latitude, longitude):
+    """Returns the frame pixel (x, y) showing (latitude, longitude offset from the view's center), or None past the limb."""
+    if abs(longitude) >= math.pi / 2:
+        return None
+    center_x, center_y, radius = disc
+    x = int(center_x + radius * math.cos(latitude) * math.sin(longitude))
+    y = int(center_y - radius * math.sin(latitude))
+    return x, y
+
+
+def wrap_angle(angle):
+    return (angle + math.pi) % (2 * math.pi) - math.pi
+
+
+def unwrap(grays, disc, map_width, direction):
+    """Returns the map's gray levels (rows of map_width / 2 floats), and the frames' disagreement where they overlap."""
+    map_height = map_width // 2
+    count = len(grays)
+    step = direction * 2 * math.pi / count
+    disagreement = 0.0
+    overlaps = 0
+    gray_rows = []
+    for row in range(map_height):
+        latitude = math.pi / 2 - (row + 0.5) * math.pi / map_height
+        line = []
+        for column in range(map_width):
+            longitude = (column + 0.5) * 2 * math.pi / map_width
+            total = weights = 0.0
+            seen = []
+            for n, gray in enumerate(grays):
+                offset = wrap_angle(longitude - n * step)
+                pixel = project(disc, latitude, offset)
+                if pixel is None:
+                    continue
+                facing = math.cos(latitude) * math.cos(offset)
+                weight = facing ** FACING_POWER
+                value = gray[pixel[1]][pixel[0]]
+                total += weight * value
+                weights += weight
+                if facing > SCORE_MIN_FACING:
+                    seen.append(value)
+            line.append(total / weights if weights > 0 else 0.0)
+            if len(seen) >= 2:
+                disagreement += max(seen) - min(seen)
+                overlaps += 1
+        gray_rows.append(line)
+    return gray_rows, disagreement / max(1, overlaps)
+
+
+def dither(gray_rows):
+    """Returns the gray levels ordered-dithered to 1-bit rows (1 white)."""
+    return [
+        [1 if level * 16 > BAYER_4X4[y % 4][x % 4] + 0.5 else 0 for x, level in enumerate(line)]
+        for y, line in enumerate(gray_rows)
+    ]
+
+
+def write_png_1bit(path, rows):
+    width = len(rows[0])
+    raw = bytearray()
+    for line in rows:
+        raw.append(0)
+        for x0 in range(0, width, 8):
+            value = 0
+            for x in range(x0, x0 + 8):
+                value = (value << 1) | (line[x] if x < width else 0)
+            raw.append(value)
+
+    def chunk(kind, data):
+        return struct.pack(">I", len(data)) + kind + data + struct.pack(">I", zlib.crc32(kind + data) & 0xffffffff)
+
+    png = b"\x89PNG\r\n\x1a\n" + chunk(b"IHDR", struct.pack(">IIBBBBB", width, len(rows), 1, 0, 0, 0, 0))
+    png += chunk(b"IDAT", zlib.compress(bytes(raw), 9)) + chunk(b"IEND", b"")
+    # only rewrite on change, as the staging scripts do
+    if not os.path.exists(path) or open(path, "rb").read() != png:
+        with open(path, "wb") as f:
+            f.write(png)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Unwrap globe rotation frames into an equirectangular map.")
+    parser.add_argument("--frames", nargs="+", required=True, help="the rotation's frames, in order")
+    parser.add_argument("--out", required=True)
+    parser.add_argument("--width", type=int, default=400, help="map width (even); the height is half")
+    args = parser.parse_args()
+
+    # keep in sync with GLOBE_RENDERER_MAX_MAP_WIDTH (include/globe_renderer.h)
+    if args.width < 16 or args.width > 1020 or args.width % 2 != 0:
+        parser.error("--width must be even, in [16, 1020]")
+    if len(args.frames) < 2:
+        parser.error("need at least 2 frames")
+
+    frames = [pack_frames.read_png_1bit(path) for path in args.frames]
+    disc = fit_disc(frames)
+    grays = [box_filter(*frame) for frame in frames]
+
+    best = None
+    for direction in (1, -1):
+        gray_rows, disagreement = unwrap(grays, disc, args.width, direction)
+        print("direction %+i: disagreement %.3f" % (direction, disagreement))
+        if best is None or disagreement < best[1]:
+            best = (gray_rows, disagreement, direction)
+
+    write_png_1bit(args.out, dither(best[0]))
+    print("disc center (%.1f, %.1f), radius %.1f; direction %+i; wrote %s (%ix%i)" % (
+        disc[0], disc[1], disc[2], best[2], args.out, args.width, args.width // 2
+    ))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
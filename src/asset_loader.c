@@ -0,0 +1,77 @@
+#include <string.h>
+
+#include "asset_loader.h"
+
+
+void assetLoaderInit(AssetLoader* loader) {
+	memset(loader, 0, sizeof(*loader));
+}
+
+int assetLoaderAdd(AssetLoader* loader, const char* name, int priority, AssetLoaderStepFunction* step, void* userdata) {
+	if (loader->numJobs == ASSET_LOADER_MAX_JOBS) {
+		return 0;
+	}
+	if (loader->current < loader->numJobs && priority < loader->jobs[loader->current].priority) {
+		return 0; // (would have to run before the job already running)
+	}
+
+	int index = loader->numJobs;
+	while (index > loader->current && loader->jobs[index - 1].priority > priority) {
+		loader->jobs[index] = loader->jobs[index - 1];
+		index--;
+	}
+	loader->jobs[index] = (AssetLoaderJob){ name, priority, step, userdata };
+	loader->numJobs++;
+	return 1;
+}
+
+int assetLoaderUpdate(PlaydateAPI* pd, AssetLoader* loader, float budget) {
+	if (loader->current == loader->numJobs) {
+		return 1;
+	}
+	loader->stats.updates++;
+
+	// (elapsed time deltas within the frame: the clock may be reset at frame start, e.g. by the frame profiler)
+	float start = pd->system->getElapsedTime();
+	float now = start;
+	while (loader->current < loader->numJobs) {
+		AssetLoaderJob* job = &loader->jobs[loader->current];
+		float stepStart = now;
+		int done = job->step(pd, job->userdata);
+		now = pd->system->getElapsedTime();
+
+		float stepTime = now - stepStart;
+		loader->stats.steps++;
+		if (stepTime > loader->stats.maxStepTime) {
+			loader->stats.maxStepTime = stepTime;
+			loader->stats.maxStepJob = job->name;
+		}
+		if (done) {
+			loader->current++;
+		}
+		if (now - start >= budget) {
+			break;
+		}
+	}
+	loader->stats.totalTime += now - start;
+	if (now - start > loader->stats.maxUpdateTime) {
+		loader->stats.maxUpdateTime = now - start;
+	}
+	return loader->current == loader->numJobs;
+}
+
+int assetLoaderIsDone(const AssetLoader* loader, int priority) {
+	return loader->current == loader->numJobs || loader->jobs[loader->current].priority > priority;
+}
+
+float assetLoaderProgress(const AssetLoader* loader, int priority) {
+	int total = 0;
+	int done = 0;
+	for (int i = 0; i < loader->numJobs; i++) {
+		if (loader->jobs[i].priority <= priority) {
+			total++;
+			done += i < loader->current;
+		}
+	}
+	return (total > 0) ? (float)done / total : 1.0f;
+}
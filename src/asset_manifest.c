@@ -0,0 +1,6 @@
+#include "asset_manifest.h"
+
+
+const AssetInfo assetManifest[kNumAssets] = {
+	ASSET_MANIFEST_ENTRIES
+};
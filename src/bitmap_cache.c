@@ -0,0 +1,170 @@
+#include <string.h>
+
+#include "bitmap_cache.h"
+
+
+/**
+ * @return the distance between frames a and b, going either way around the loop
+ */
+static int frameDistance(const BitmapCache* cache, int a, int b) {
+	int d = a > b ? a - b : b - a;
+	return d < cache->frameCount - d ? d : cache->frameCount - d;
+}
+
+static int wrapIndex(const BitmapCache* cache, int index) {
+	index %= cache->frameCount;
+	return index >= 0 ? index : index + cache->frameCount;
+}
+
+/**
+ * Evicts the least recently used resident frame outside the current window.
+ *
+ * @return the evicted bitmap (for reuse), or NULL if there was nothing to evict
+ */
+static LCDBitmap* evictOne(BitmapCache* cache) {
+	int victim = -1;
+	for (int i = 0; i < cache->frameCount; i++) {
+		if (
+			cache->bitmaps[i] != NULL && frameDistance(cache, i, cache->center) > cache->radius &&
+			(victim < 0 || cache->lastUsed[i] < cache->lastUsed[victim])
+		) {
+			victim = i;
+		}
+	}
+	if (victim < 0) {
+		return NULL;
+	}
+
+	LCDBitmap* bitmap = cache->bitmaps[victim];
+	cache->bitmaps[victim] = NULL;
+	cache->stats.resident--;
+	cache->stats.evictions++;
+	return bitmap;
+}
+
+static LCDBitmap* loadFrame(PlaydateAPI* pd, BitmapCache* cache, int index) {
+	LCDBitmap* reuse = (cache->stats.resident >= cache->budget) ? evictOne(cache) : NULL;
+
+	LCDBitmap* bitmap = cache->load(pd, index, reuse, cache->userdata);
+	if (bitmap == NULL) {
+		cache->stats.loadErrors++;
+		return NULL;
+	}
+
+	cache->bitmaps[index] = bitmap;
+	cache->stats.resident++;
+	if (cache->stats.resident > cache->stats.peakResident) {
+		cache->stats.peakResident = cache->stats.resident;
+	}
+	return bitmap;
+}
+
+int bitmapCacheInit(PlaydateAPI* pd, BitmapCache* cache, int frameCount, int radius, int budget, BitmapCacheLoadFunction* load, void* userdata, MemoryArena* arena) {
+	memset(cache, 0, sizeof(*cache));
+
+	if (radius > frameCount / 2) {
+		radius = frameCount / 2;
+	}
+	int windowFrames = (2 * radius + 1 < frameCount) ? 2 * radius + 1 : frameCount;
+
+	cache->frameCount = frameCount;
+	cache->radius = radius;
+	cache->budget = (budget > windowFrames) ? budget : windowFrames;
+	cache->load = load;
+	cache->userdata = userdata;
+	cache->center = -1;
+	cache->arena = arena;
+	if (arena != NULL) {
+		cache->bitmaps = memoryArenaAlloc(arena, frameCount * sizeof(LCDBitmap*));
+		cache->lastUsed = memoryArenaAlloc(arena, frameCount * sizeof(uint32_t));
+	}
+	else {
+		cache->bitmaps = pd->system->realloc(NULL, frameCount * sizeof(LCDBitmap*));
+		cache->lastUsed = pd->system->realloc(NULL, frameCount * sizeof(uint32_t));
+	}
+	if (cache->bitmaps == NULL || cache->lastUsed == NULL) {
+		bitmapCacheFree(pd, cache);
+		return 0;
+	}
+	memset(cache->bitmaps, 0, frameCount * sizeof(LCDBitmap*));
+	memset(cache->lastUsed, 0, frameCount * sizeof(uint32_t));
+	return 1;
+}
+
+void bitmapCacheFree(PlaydateAPI* pd, BitmapCache* cache) {
+	if (cache->bitmaps != NULL) {
+		for (int i = 0; i < cache->frameCount; i++) {
+			if (cache->bitmaps[i] != NULL) {
+				pd->graphics->freeBitmap(cache->bitmaps[i]);
+			}
+		}
+		if (cache->arena == NULL) {
+			pd->system->realloc(cache->bitmaps, 0);
+		}
+	}
+	if (cache->lastUsed != NULL && cache->arena == NULL) {
+		pd->system->realloc(cache->lastUsed, 0);
+	}
+	memset(cache, 0, sizeof(*cache));
+}
+
+LCDBitmap* bitmapCacheSetCenter(PlaydateAPI* pd, BitmapCache* cache, int center) {
+	if (cache->frameCount <= 0) {
+		return NULL;
+	}
+	center = wrapIndex(cache, center);
+	cache->center = center;
+	cache->clock++;
+
+	LCDBitmap* bitmap = cache->bitmaps[center];
+	if (bitmap != NULL) {
+		cache->stats.hits++;
+	}
+	else {
+		cache->stats.misses++;
+		bitmap = loadFrame(pd, cache, center);
+	}
+	cache->lastUsed[center] = cache->clock;
+	return bitmap;
+}
+
+int bitmapCachePrefetch(PlaydateAPI* pd, BitmapCache* cache, int maxLoads) {
+	if (cache->frameCount <= 0 || cache->center < 0) {
+		return 0;
+	}
+
+	// neighbours, nearest first (the frames the crank reaches next), alternating directions
+	int missing = 0;
+	for (int d = 1; d <= cache->radius; d++) {
+		for (int dir = 1; dir >= -1; dir -= 2) {
+			int index = wrapIndex(cache, cache->center + dir * d);
+			if (cache->bitmaps[index] == NULL) {
+				if (maxLoads == 0) {
+					missing++;
+					continue;
+				}
+				maxLoads--;
+				if (loadFrame(pd, cache, index) != NULL) {
+					cache->stats.prefetches++;
+				}
+			}
+			if (cache->bitmaps[index] != NULL && cache->lastUsed[index] < cache->clock - 1) {
+				cache->lastUsed[index] = cache->clock - 1;
+			}
+		}
+	}
+	return missing;
+}
+
+LCDBitmap* bitmapCacheSetWindow(PlaydateAPI* pd, BitmapCache* cache, int center) {
+	LCDBitmap* bitmap = bitmapCacheSetCenter(pd, cache, center);
+	bitmapCachePrefetch(pd, cache, -1);
+	return bitmap;
+}
+
+LCDBitmap* bitmapCachePeek(const BitmapCache* cache, int index) {
+	if (index < 0 || index >= cache->frameCount) {
+		return NULL;
+	}
+	return cache->bitmaps[index];
+}
@@ -0,0 +1,304 @@
+#include <string.h>
+
+#include "font_blitter.h"
+
+
+/** What a draw mode does to the frame buffer pixels under a glyph's black and white pixels (see blitGlyph()) */
+enum {
+	kClearBlack = 1 << 0,
+	kClearWhite = 1 << 1,
+	kSetBlack = 1 << 2,
+	kSetWhite = 1 << 3,
+	kFlipBlack = 1 << 4,
+	kFlipWhite = 1 << 5
+};
+static const uint8_t drawModeOps[] = {
+	[kDrawModeCopy] = kClearBlack | kSetWhite,
+	[kDrawModeWhiteTransparent] = kClearBlack,
+	[kDrawModeBlackTransparent] = kSetWhite,
+	[kDrawModeFillWhite] = kSetBlack | kSetWhite,
+	[kDrawModeFillBlack] = kClearBlack | kClearWhite,
+	[kDrawModeXOR] = kFlipWhite,
+	[kDrawModeNXOR] = kFlipBlack,
+	[kDrawModeInverted] = kClearWhite | kSetBlack
+};
+
+/**
+ * @return a word of its width leftmost bits set
+ */
+static uint32_t leftBits(int width) {
+	return (width >= 32) ? 0xffffffffu : ~(0xffffffffu >> width);
+}
+
+/**
+ * Reads bits [0, width) of a bitmap row into a word, leftmost pixel in the top bit.
+ */
+static uint32_t readRow(const uint8_t* row, int width) {
+	uint32_t word = 0;
+	for (int b = 0; b < (width + 7) / 8; b++) {
+		word |= (uint32_t)row[b] << (24 - 8 * b);
+	}
+	return word & leftBits(width);
+}
+
+/**
+ * Computes the kerning between glyph index g and the character after it.
+ */
+static int kerning(PlaydateAPI* pd, const FontBlitter* blitter, int g, uint8_t next) {
+	if (blitter->kerns[g] == 0) {
+		return 0;
+	}
+	return pd->graphics->getGlyphKerning(blitter->glyphs[g], g + FONT_BLITTER_FIRST_GLYPH, next);
+}
+
+/**
+ * @return the glyph index of c, or -1 if not a glyph of the blitter's font
+ */
+static int glyphIndex(const FontBlitter* blitter, uint8_t c) {
+	int g = c - FONT_BLITTER_FIRST_GLYPH;
+	return (g >= 0 && g < FONT_BLITTER_NUM_GLYPHS && blitter->glyphs[g] != NULL) ? g : -1;
+}
+
+int fontBlitterInit(PlaydateAPI* pd, FontBlitter* blitter, LCDFont* font) {
+	memset(blitter, 0, sizeof(*blitter));
+	blitter->font = font;
+	blitter->drawMode = kDrawModeCopy;
+	if (font == NULL) {
+		return 0;
+	}
+	blitter->height = pd->graphics->getFontHeight(font);
+
+	// the glyphs and their advances (and the first glyph, to measure the font's tracking by)
+	int first = -1;
+	for (int g = 0; g < FONT_BLITTER_NUM_GLYPHS; g++) {
+		uint32_t c = g + FONT_BLITTER_FIRST_GLYPH;
+		LCDFontPage* page = pd->graphics->getFontPage(font, c);
+		int advance = 0;
+		blitter->glyphs[g] = (page != NULL) ? pd->graphics->getPageGlyph(page, c, NULL, &advance) : NULL;
+		blitter->advance[g] = (int8_t)advance;
+		if (blitter->glyphs[g] != NULL && first < 0) {
+			first = g;
+		}
+	}
+	if (first < 0) {
+		return 0;
+	}
+
+	// which glyphs are kerned with any other (so only those look up kerning per pair)
+	for (int g = 0; g < FONT_BLITTER_NUM_GLYPHS; g++) {
+		for (int n = 0; n < FONT_BLITTER_NUM_GLYPHS && blitter->glyphs[g] != NULL && blitter->kerns[g] == 0; n++) {
+			if (blitter->glyphs[n] != NULL && pd->graphics->getGlyphKerning(blitter->glyphs[g], g + FONT_BLITTER_FIRST_GLYPH, n + FONT_BLITTER_FIRST_GLYPH) != 0) {
+				blitter->kerns[g] = 1;
+			}
+		}
+	}
+
+	// (the font's own tracking isn't exposed: measure it off two of a glyph, as getTextWidth() puts it between them)
+	char pair[2] = { (char)(first + FONT_BLITTER_FIRST_GLYPH), (char)(first + FONT_BLITTER_FIRST_GLYPH) };
+	int textTracking = pd->graphics->getTextTracking();
+	blitter->tracking =
+		pd->graphics->getTextWidth(font, pair, 2, kASCIIEncoding, 0) - 2 * blitter->advance[first] - kerning(pd, blitter, first, pair[1]) +
+		textTracking;
+
+	// decode the glyphs' rows
+	uint32_t* rows = pd->system->realloc(NULL, FONT_BLITTER_NUM_GLYPHS * 2 * blitter->height * sizeof(uint32_t));
+	if (rows == NULL) {
+		return 0;
+	}
+	memset(rows, 0, FONT_BLITTER_NUM_GLYPHS * 2 * blitter->height * sizeof(uint32_t));
+	for (int g = 0; g < FONT_BLITTER_NUM_GLYPHS; g++) {
+		LCDBitmap* bitmap = NULL;
+		if (blitter->glyphs[g] == NULL) {
+			continue;
+		}
+		pd->graphics->getPageGlyph(pd->graphics->getFontPage(font, g + FONT_BLITTER_FIRST_GLYPH), g + FONT_BLITTER_FIRST_GLYPH, &bitmap, NULL);
+		if (bitmap == NULL) {
+			continue; // (e.g. space)
+		}
+
+		int width = 0, height = 0, rowbytes = 0;
+		uint8_t* mask = NULL;
+		uint8_t* data = NULL;
+		pd->graphics->getBitmapData(bitmap, &width, &height, &rowbytes, &mask, &data);
+		if (width > FONT_BLITTER_MAX_GLYPH_WIDTH || height > blitter->height || data == NULL) {
+			pd->system->realloc(rows, 0);
+			return 0;
+		}
+		uint32_t* black = rows + g * 2 * blitter->height;
+		uint32_t* white = black + blitter->height;
+		for (int y = 0; y < height; y++) {
+			uint32_t opaque = (mask != NULL) ? readRow(mask + y * rowbytes, width) : leftBits(width);
+			uint32_t bits = readRow(data + y * rowbytes, width);
+			black[y] = opaque & ~bits;
+			white[y] = opaque & bits;
+		}
+	}
+	blitter->rows = rows;
+	return 1;
+}
+
+LCDBitmapDrawMode fontBlitterSetDrawMode(FontBlitter* blitter, LCDBitmapDrawMode mode) {
+	LCDBitmapDrawMode previous = blitter->drawMode;
+	blitter->drawMode = mode;
+	return previous;
+}
+
+/**
+ * The width of text (up to its first line break), and whether any of its glyph pairs are kerned.
+ */
+static int measure(PlaydateAPI* pd, const FontBlitter* blitter, const char* text, size_t length, int* kerned) {
+	int width = 0;
+	int count = 0;
+	*kerned = 0;
+	for (size_t i = 0; i < length && text[i] != '\n' && text[i] != '\0'; i++) {
+		int g = glyphIndex(blitter, (uint8_t)text[i]);
+		if (g < 0) {
+			continue;
+		}
+		int k = (i + 1 < length) ? kerning(pd, blitter, g, (uint8_t)text[i + 1]) : 0;
+		*kerned |= k != 0;
+		width += blitter->advance[g] + k;
+		count++;
+	}
+	return (count > 1) ? width + (count - 1) * blitter->tracking : width;
+}
+
+/**
+ * @return the cached label for text, measuring (and caching) it first if not cached yet
+ */
+static const FontBlitterLabel* lookupLabel(PlaydateAPI* pd, FontBlitter* blitter, const char* text, size_t length) {
+	for (int i = 0; i < blitter->numLabels; i++) {
+		if (blitter->labels[i].text == text && blitter->labels[i].length == length) {
+			blitter->stats.labelHits++;
+			return &blitter->labels[i];
+		}
+	}
+	blitter->stats.labelMisses++;
+
+	FontBlitterLabel* label;
+	if (blitter->numLabels < FONT_BLITTER_LABEL_CACHE_SIZE) {
+		label = &blitter->labels[blitter->numLabels++];
+	}
+	else {
+		label = &blitter->labels[blitter->nextLabel];
+		blitter->nextLabel = (blitter->nextLabel + 1) % FONT_BLITTER_LABEL_CACHE_SIZE;
+	}
+	label->text = text;
+	label->length = length;
+	label->width = measure(pd, blitter, text, length, &label->kerned);
+	return label;
+}
+
+/**
+ * Blits a glyph's rows into the frame buffer at x, y (clipped to the screen), combining them per byte as
+ * (frame & ~clear | set) ^ flip, with clear/set/flip picked from the glyph's black and white pixels by ops (the draw
+ * mode's drawModeOps).
+ */
+static void blitGlyph(uint8_t* frame, const FontBlitter* blitter, int g, int x, int y, uint8_t ops) {
+	const uint32_t* black = blitter->rows + g * 2 * blitter->height;
+	const uint32_t* white = black + blitter->height;
+	int byte = (x >= 0) ? x / 8 : -((7 - x) / 8);
+	int shift = x - byte * 8;
+	int top = (y < 0) ? -y : 0;
+	int bottom = (y + blitter->height > LCD_ROWS) ? LCD_ROWS - y : blitter->height;
+
+	for (int r = top; r < bottom; r++) {
+		if ((black[r] | white[r]) == 0) {
+			continue;
+		}
+		// (the row shifted into place over the 5 bytes it can span, the leftmost in the top byte)
+		uint64_t b = (uint64_t)black[r] << (32 - shift);
+		uint64_t w = (uint64_t)white[r] << (32 - shift);
+		uint64_t clear = ((ops & kClearBlack) ? b : 0) | ((ops & kClearWhite) ? w : 0);
+		uint64_t set = ((ops & kSetBlack) ? b : 0) | ((ops & kSetWhite) ? w : 0);
+		uint64_t flip = ((ops & kFlipBlack) ? b : 0) | ((ops & kFlipWhite) ? w : 0);
+
+		uint8_t* dst = frame + (y + r) * LCD_ROWSIZE;
+		for (int k = 0; k < 5; k++) {
+			int d = byte + k;
+			int s = 56 - 8 * k;
+			uint8_t c = (uint8_t)(clear >> s), t = (uint8_t)(set >> s), f = (uint8_t)(flip >> s);
+			if ((c | t | f) != 0 && d >= 0 && d < LCD_COLUMNS / 8) {
+				dst[d] = (uint8_t)(((dst[d] & ~c) | t) ^ f);
+			}
+		}
+	}
+}
+
+/**
+ * Draws text (see fontBlitterDrawText()); kerned is 0 if none of its glyph pairs are kerned (skipping the lookups).
+ */
+static int drawText(PlaydateAPI* pd, FontBlitter* blitter, const char* text, size_t length, int x, int y, int kerned) {
+	if (FONT_BLITTER_ENABLED == 0 || blitter->rows == NULL) {
+		blitter->stats.fallbacks++;
+		LCDBitmapDrawMode previous = pd->graphics->setDrawMode(blitter->drawMode);
+		pd->graphics->setFont(blitter->font);
+		int width = pd->graphics->drawText(text, length, kASCIIEncoding, x, y);
+		pd->graphics->setDrawMode(previous);
+		return width;
+	}
+	blitter->stats.blits++;
+
+	uint8_t* frame = pd->graphics->getFrame();
+	uint8_t ops = drawModeOps[((unsigned int)blitter->drawMode < sizeof(drawModeOps)) ? blitter->drawMode : kDrawModeCopy];
+	int penX = x;
+	int penY = y;
+	int lines = 1;
+	for (size_t i = 0; i < length && text[i] != '\0'; i++) {
+		if (text[i] == '\n') {
+			penX = x;
+			penY += blitter->height;
+			lines++;
+			continue;
+		}
+		int g = glyphIndex(blitter, (uint8_t)text[i]);
+		if (g < 0) {
+			continue;
+		}
+		if (penX < LCD_COLUMNS && penX + FONT_BLITTER_MAX_GLYPH_WIDTH > 0 && penY < LCD_ROWS && penY + blitter->height > 0) {
+			blitGlyph(frame, blitter, g, penX, penY, ops);
+		}
+		penX += blitter->advance[g] + blitter->tracking;
+		if (kerned && i + 1 < length) {
+			penX += kerning(pd, blitter, g, (uint8_t)text[i + 1]);
+		}
+	}
+
+	int top = (y > 0) ? y : 0;
+	int bottom = (y + lines * blitter->height < LCD_ROWS) ? y + lines * blitter->height - 1 : LCD_ROWS - 1;
+	if (top <= bottom) {
+		pd->graphics->markUpdatedRows(top, bottom);
+	}
+	return (penX > x) ? penX - x - blitter->tracking : 0;
+}
+
+int fontBlitterDrawText(PlaydateAPI* pd, FontBlitter* blitter, const char* text, size_t length, int x, int y) {
+	return drawText(pd, blitter, text, length, x, y, 1);
+}
+
+int fontBlitterDrawLabel(PlaydateAPI* pd, FontBlitter* blitter, const char* text, size_t length, int x, int y) {
+	int kerned = (blitter->rows != NULL) ? lookupLabel(pd, blitter, text, length)->kerned : 1;
+	return drawText(pd, blitter, text, length, x, y, kerned);
+}
+
+int fontBlitterTextWidth(PlaydateAPI* pd, FontBlitter* blitter, const char* text, size_t length) {
+	if (blitter->rows == NULL) {
+		return pd->graphics->getTextWidth(blitter->font, text, length, kASCIIEncoding, pd->graphics->getTextTracking());
+	}
+	int kerned;
+	return measure(pd, blitter, text, length, &kerned);
+}
+
+int fontBlitterLabelWidth(PlaydateAPI* pd, FontBlitter* blitter, const char* text, size_t length) {
+	if (blitter->rows == NULL) {
+		return fontBlitterTextWidth(pd, blitter, text, length);
+	}
+	return lookupLabel(pd, blitter, text, length)->width;
+}
+
+void fontBlitterFree(PlaydateAPI* pd, FontBlitter* blitter) {
+	if (blitter->rows != NULL) {
+		pd->system->realloc(blitter->rows, 0);
+	}
+	memset(blitter, 0, sizeof(*blitter));
+}
@@ -0,0 +1,116 @@
+#include <string.h>
+
+#include "frame_blend.h"
+
+
+/** The 4x4 Bayer matrix: thresholds [0, FRAME_BLEND_LEVELS) by row and column */
+static const uint8_t bayer4x4[4][4] = {
+	{  0,  8,  2, 10 },
+	{ 12,  4, 14,  6 },
+	{  3, 11,  1,  9 },
+	{ 15,  7, 13,  5 }
+};
+
+/**
+ * @return a 32-bit mask of the pixels of a row y (& 3) whose threshold is below level, as packed in 1-bit rows
+ */
+static uint32_t bayerRowMask(int y, int level) {
+	uint8_t byte = 0;
+	for (int x = 0; x < 8; x++) {
+		if (bayer4x4[y & 3][x & 3] < level) {
+			byte |= 0x80 >> x;
+		}
+	}
+	uint32_t mask;
+	memset(&mask, byte, sizeof(mask));
+	return mask;
+}
+
+/**
+ * The blend kernel: a plain loop over whole words (the compiler can unroll/vectorize), taking b's bits where mask is set.
+ */
+static void blendWords(uint32_t* restrict out, const uint32_t* restrict a, const uint32_t* restrict b, uint32_t mask, int count) {
+	for (int i = 0; i < count; i++) {
+		out[i] = a[i] ^ ((a[i] ^ b[i]) & mask);
+	}
+}
+
+int frameBlend(PlaydateAPI* pd, LCDBitmap* a, LCDBitmap* b, int level, LCDBitmap* out) {
+	int width, height, rowbytes;
+	int widthB, heightB, rowbytesB;
+	int widthOut, heightOut, rowbytesOut;
+	uint8_t* mask;
+	uint8_t* maskB;
+	uint8_t* maskOut;
+	uint8_t* dataA;
+	uint8_t* dataB;
+	uint8_t* dataOut;
+	pd->graphics->getBitmapData(a, &width, &height, &rowbytes, &mask, &dataA);
+	pd->graphics->getBitmapData(b, &widthB, &heightB, &rowbytesB, &maskB, &dataB);
+	pd->graphics->getBitmapData(out, &widthOut, &heightOut, &rowbytesOut, &maskOut, &dataOut);
+	if (
+		widthB != width || heightB != height || rowbytesB != rowbytes ||
+		widthOut != width || heightOut != height || rowbytesOut != rowbytes || rowbytes % 4 != 0 ||
+		mask != NULL || maskB != NULL || maskOut != NULL
+	) {
+		return 0;
+	}
+
+	uint32_t rowMasks[4];
+	for (int y = 0; y < 4; y++) {
+		rowMasks[y] = bayerRowMask(y, level);
+	}
+	for (int y = 0; y < height; y++) {
+		blendWords(
+			(uint32_t*)(dataOut + y * rowbytes), (const uint32_t*)(dataA + y * rowbytes), (const uint32_t*)(dataB + y * rowbytes),
+			rowMasks[y & 3], rowbytes / 4
+		);
+	}
+	return 1;
+}
+
+void frameBlendRingInit(FrameBlendRing* ring) {
+	memset(ring, 0, sizeof(*ring));
+	for (int i = 0; i < FRAME_BLEND_RING_SIZE; i++) {
+		ring->indices[i] = -1;
+	}
+}
+
+LCDBitmap* frameBlendRingGet(PlaydateAPI* pd, FrameBlendRing* ring, int index, int level, LCDBitmap* a, LCDBitmap* b) {
+	for (int i = 0; i < FRAME_BLEND_RING_SIZE; i++) {
+		if (ring->bitmaps[i] != NULL && ring->indices[i] == index && ring->levels[i] == level) {
+			ring->hits++;
+			return ring->bitmaps[i];
+		}
+	}
+	ring->misses++;
+
+	int slot = ring->next;
+	ring->next = (ring->next + 1) % FRAME_BLEND_RING_SIZE;
+	ring->indices[slot] = -1;
+	if (ring->bitmaps[slot] == NULL) {
+		int width, height, rowbytes;
+		uint8_t* mask;
+		uint8_t* data;
+		pd->graphics->getBitmapData(a, &width, &height, &rowbytes, &mask, &data);
+		ring->bitmaps[slot] = pd->graphics->newBitmap(width, height, kColorWhite);
+		if (ring->bitmaps[slot] == NULL) {
+			return NULL;
+		}
+	}
+	if (frameBlend(pd, a, b, level, ring->bitmaps[slot]) == 0) {
+		return NULL;
+	}
+	ring->indices[slot] = index;
+	ring->levels[slot] = level;
+	return ring->bitmaps[slot];
+}
+
+void frameBlendRingFree(PlaydateAPI* pd, FrameBlendRing* ring) {
+	for (int i = 0; i < FRAME_BLEND_RING_SIZE; i++) {
+		if (ring->bitmaps[i] != NULL) {
+			pd->graphics->freeBitmap(ring->bitmaps[i]);
+		}
+	}
+	frameBlendRingInit(ring);
+}
@@ -0,0 +1,146 @@
+#include <string.h>
+
+#include "frame_delta.h"
+
+
+static uint32_t loadWord(const uint8_t* p) {
+	uint32_t word;
+	memcpy(&word, p, sizeof(word));
+	return word;
+}
+
+/**
+ * The blit kernel: a plain, branch-free loop over whole words for the compiler to unroll/vectorize.
+ */
+static void xorWords(uint32_t* restrict dst, const uint32_t* restrict src, int count) {
+	for (int i = 0; i < count; i++) {
+		dst[i] ^= src[i];
+	}
+}
+
+/**
+ * Finds the first and last differing word of a row.
+ *
+ * @return the number of words from the first to the last differing word (0 if the row is unchanged)
+ */
+static int diffRow(const uint8_t* rowA, const uint8_t* rowB, int rowWords, int* first) {
+	int last = -1;
+	*first = -1;
+	for (int w = 0; w < rowWords; w++) {
+		if (loadWord(rowA + w * 4) != loadWord(rowB + w * 4)) {
+			if (*first < 0) {
+				*first = w;
+			}
+			last = w;
+		}
+	}
+	return (last >= 0) ? last - *first + 1 : 0;
+}
+
+void frameDeltaCompute(PlaydateAPI* pd, FrameDelta* delta, LCDBitmap* a, LCDBitmap* b, int maxWords, MemoryArena* arena) {
+	frameDeltaFree(pd, delta);
+	delta->computed = 1;
+	delta->full = 1;
+
+	int widthA, heightA, rowbytesA, widthB, heightB, rowbytesB;
+	uint8_t* maskA;
+	uint8_t* maskB;
+	uint8_t* dataA;
+	uint8_t* dataB;
+	pd->graphics->getBitmapData(a, &widthA, &heightA, &rowbytesA, &maskA, &dataA);
+	pd->graphics->getBitmapData(b, &widthB, &heightB, &rowbytesB, &maskB, &dataB);
+	int rowWords = rowbytesA / 4;
+	if (
+		widthA != widthB || heightA != heightB || rowbytesA != rowbytesB || rowbytesA % 4 != 0 || rowWords > 255 ||
+		maskA != NULL || maskB != NULL
+	) {
+		return;
+	}
+
+	// first pass: size the delta
+	int numSpans = 0;
+	int numWords = 0;
+	for (int row = 0; row < heightA; row++) {
+		int first;
+		int count = diffRow(dataA + row * rowbytesA, dataB + row * rowbytesB, rowWords, &first);
+		if (count > 0) {
+			numSpans++;
+			numWords += count;
+		}
+	}
+	if (numWords > maxWords) {
+		return;
+	}
+
+	// second pass: store spans and words in one allocation
+	size_t spansSize = numSpans * sizeof(FrameDeltaSpan);
+	size_t bufferSize = spansSize + numWords * sizeof(uint32_t);
+	uint8_t* buffer = NULL;
+	if (numSpans > 0) {
+		buffer = (arena != NULL) ? memoryArenaAlloc(arena, bufferSize) : pd->system->realloc(NULL, bufferSize);
+		if (buffer == NULL) {
+			return;
+		}
+	}
+	delta->arena = arena;
+	delta->spans = (FrameDeltaSpan*)buffer;
+	delta->words = (uint32_t*)(buffer + spansSize);
+	delta->top = -1;
+	delta->bottom = -1;
+
+	for (int row = 0; row < heightA; row++) {
+		const uint8_t* rowA = dataA + row * rowbytesA;
+		const uint8_t* rowB = dataB + row * rowbytesB;
+		int first;
+		int count = diffRow(rowA, rowB, rowWords, &first);
+		if (count == 0) {
+			continue;
+		}
+		FrameDeltaSpan* span = &delta->spans[delta->numSpans++];
+		span->row = row;
+		span->firstWord = first;
+		span->numWords = count;
+		span->wordIndex = delta->numWords;
+		for (int w = first; w < first + count; w++) {
+			delta->words[delta->numWords++] = loadWord(rowA + w * 4) ^ loadWord(rowB + w * 4);
+		}
+		if (delta->top < 0) {
+			delta->top = row;
+		}
+		delta->bottom = row;
+	}
+	delta->full = 0;
+}
+
+void frameDeltaApply(const FrameDelta* delta, uint8_t* frame, int rowbytes, const uint8_t* skipRows, uint8_t* rowsTouched) {
+	for (int i = 0; i < delta->numSpans; i++) {
+		const FrameDeltaSpan* span = &delta->spans[i];
+		if (skipRows != NULL && skipRows[span->row]) {
+			continue;
+		}
+		xorWords((uint32_t*)(frame + span->row * rowbytes) + span->firstWord, delta->words + span->wordIndex, span->numWords);
+		if (rowsTouched != NULL) {
+			rowsTouched[span->row] = 1;
+		}
+	}
+}
+
+void frameDeltaCopy(const FrameDelta* delta, uint8_t* frame, int rowbytes, const uint8_t* src, int srcRowbytes, const uint8_t* skipRows, uint8_t* rowsTouched) {
+	for (int i = 0; i < delta->numSpans; i++) {
+		const FrameDeltaSpan* span = &delta->spans[i];
+		if (skipRows != NULL && skipRows[span->row]) {
+			continue;
+		}
+		memcpy(frame + span->row * rowbytes + span->firstWord * 4, src + span->row * srcRowbytes + span->firstWord * 4, span->numWords * 4);
+		if (rowsTouched != NULL) {
+			rowsTouched[span->row] = 1;
+		}
+	}
+}
+
+void frameDeltaFree(PlaydateAPI* pd, FrameDelta* delta) {
+	if (delta->spans != NULL && delta->arena == NULL) {
+		pd->system->realloc(delta->spans, 0);
+	}
+	memset(delta, 0, sizeof(*delta));
+}
@@ -0,0 +1,259 @@
+#include <string.h>
+
+#include "frame_pack.h"
+
+
+#define FRAME_PACK_HEADER_SIZE 32
+#define FRAME_PACK_INDEX_ENTRY_SIZE 12
+#define FRAME_PACK_VERSION 1
+/** RLE token flag: repeat the following word, instead of copying the following words */
+#define FRAME_PACK_TOKEN_RUN 0x8000
+
+/**
+ * Write position of the next decoded word in a bitmap's data.
+ */
+typedef struct {
+	uint8_t* data;
+	int rowbytes;
+	int rowWords;
+	/** Bytes of a row's last word that fit into rowbytes (4, unless rowbytes isn't word-aligned) */
+	int lastWordBytes;
+	int row;
+	int col;
+	int wordsLeft;
+} FrameCursor;
+
+
+static uint16_t readU16(const uint8_t* p) {
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t readU32(const uint8_t* p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void framePackEntry(const FramePack* pack, int index, uint32_t* offset, uint32_t* size, int* encoding) {
+	const uint8_t* entry = pack->index + index * FRAME_PACK_INDEX_ENTRY_SIZE;
+	*offset = readU32(entry);
+	*size = readU32(entry + 4);
+	*encoding = entry[8];
+}
+
+static int initCursor(PlaydateAPI* pd, const FramePack* pack, LCDBitmap* bitmap, FrameCursor* cursor) {
+	int width, height;
+	uint8_t* mask;
+	pd->graphics->getBitmapData(bitmap, &width, &height, &cursor->rowbytes, &mask, &cursor->data);
+	if (width != pack->width || height != pack->height || mask != NULL || cursor->rowbytes < (width + 7) / 8) {
+		return 0;
+	}
+
+	cursor->rowWords = pack->rowWords;
+	cursor->lastWordBytes = cursor->rowbytes - (pack->rowWords - 1) * 4;
+	if (cursor->lastWordBytes > 4) {
+		cursor->lastWordBytes = 4;
+	}
+	cursor->row = 0;
+	cursor->col = 0;
+	cursor->wordsLeft = pack->rowWords * pack->height;
+	return 1;
+}
+
+/**
+ * Decodes one RLE-encoded frame through cursor: the words are written, or XOR'ed onto what's there for delta frames
+ * (whose runs of zero words are skipped, as they leave the destination unchanged).
+ */
+static int decodeRle(const uint8_t* src, uint32_t size, FrameCursor* cursor, int xor) {
+	const uint8_t* end = src + size;
+	while (cursor->wordsLeft > 0) {
+		if (end - src < 2) {
+			return 0;
+		}
+		uint16_t token = readU16(src);
+		src += 2;
+
+		int count = (token & ~FRAME_PACK_TOKEN_RUN) + 1;
+		int isRun = (token & FRAME_PACK_TOKEN_RUN) != 0;
+		if (count > cursor->wordsLeft || end - src < (isRun ? 4 : count * 4)) {
+			return 0;
+		}
+
+		if (isRun && xor && readU32(src) == 0) {
+			int word = cursor->row * cursor->rowWords + cursor->col + count;
+			cursor->row = word / cursor->rowWords;
+			cursor->col = word % cursor->rowWords;
+			cursor->wordsLeft -= count;
+			src += 4;
+			continue;
+		}
+
+		for (int i = 0; i < count; i++) {
+			const uint8_t* word = isRun ? src : src + i * 4;
+			uint8_t* dst = cursor->data + cursor->row * cursor->rowbytes + cursor->col * 4;
+			int n = (cursor->col == cursor->rowWords - 1) ? cursor->lastWordBytes : 4;
+			if (xor) {
+				for (int b = 0; b < n; b++) {
+					dst[b] ^= word[b];
+				}
+			}
+			else {
+				memcpy(dst, word, n);
+			}
+			if (++cursor->col == cursor->rowWords) {
+				cursor->col = 0;
+				cursor->row++;
+			}
+		}
+		cursor->wordsLeft -= count;
+		src += isRun ? 4 : count * 4;
+	}
+	return 1;
+}
+
+static int decodeEntry(const FramePack* pack, int index, FrameCursor* cursor) {
+	uint32_t offset, size;
+	int encoding;
+	framePackEntry(pack, index, &offset, &size, &encoding);
+	return decodeRle(pack->data + offset, size, cursor, encoding == FRAME_PACK_ENCODING_DELTA);
+}
+
+int framePackLoad(PlaydateAPI* pd, FramePack* pack, const char* path, MemoryArena* arena, const char** outErr) {
+	memset(pack, 0, sizeof(*pack));
+	const char* err = NULL;
+	size_t arenaMark = (arena != NULL) ? memoryArenaMark(arena) : 0;
+
+	FileStat stat;
+	SDFile* file = NULL;
+	if (pd->file->stat(path, &stat) != 0 || stat.size < FRAME_PACK_HEADER_SIZE) {
+		err = "file not found";
+	}
+	else if ((file = pd->file->open(path, kFileRead)) == NULL) {
+		err = "file could not be opened";
+	}
+	else if ((pack->buffer = (arena != NULL) ? memoryArenaAlloc(arena, stat.size) : pd->system->realloc(NULL, stat.size)) == NULL) {
+		err = "out of memory";
+	}
+	else if (pd->file->read(file, pack->buffer, stat.size) != (int)stat.size) {
+		err = "file could not be read";
+	}
+	if (file != NULL) {
+		pd->file->close(file);
+	}
+
+	if (err == NULL) {
+		const uint8_t* header = pack->buffer;
+		pack->bufferSize = stat.size;
+		pack->frameCount = readU16(header + 6);
+		pack->width = readU16(header + 8);
+		pack->height = readU16(header + 10);
+		pack->rowWords = readU16(header + 12);
+		pack->keyInterval = readU16(header + 14);
+		uint32_t indexOffset = readU32(header + 16);
+		uint32_t dataOffset = readU32(header + 20);
+		pack->dataSize = readU32(header + 24);
+
+		if (memcmp(header, "PDFP", 4) != 0 || readU16(header + 4) != FRAME_PACK_VERSION) {
+			err = "not a frame pack, or unsupported version";
+		}
+		else if (
+			pack->frameCount == 0 || pack->width == 0 || pack->height == 0 || pack->rowWords != (pack->width + 31) / 32 ||
+			indexOffset + (uint32_t)pack->frameCount * FRAME_PACK_INDEX_ENTRY_SIZE > dataOffset ||
+			dataOffset > pack->bufferSize || pack->dataSize > pack->bufferSize - dataOffset
+		) {
+			err = "corrupt header";
+		}
+		else {
+			pack->index = pack->buffer + indexOffset;
+			pack->data = pack->buffer + dataOffset;
+			for (int i = 0; i < pack->frameCount && err == NULL; i++) {
+				uint32_t offset, size;
+				int encoding;
+				framePackEntry(pack, i, &offset, &size, &encoding);
+				if (offset > pack->dataSize || size > pack->dataSize - offset || encoding > FRAME_PACK_ENCODING_DELTA || (i == 0 && encoding != FRAME_PACK_ENCODING_KEY)) {
+					err = "corrupt index";
+				}
+			}
+		}
+	}
+
+	pack->arena = arena;
+
+	if (err != NULL) {
+		framePackFree(pd, pack);
+		if (arena != NULL) {
+			memoryArenaRelease(arena, arenaMark);
+		}
+		if (outErr != NULL) {
+			*outErr = err;
+		}
+		return 0;
+	}
+	return 1;
+}
+
+void framePackFree(PlaydateAPI* pd, FramePack* pack) {
+	if (pack->buffer != NULL && pack->arena == NULL) {
+		pd->system->realloc(pack->buffer, 0);
+	}
+	memset(pack, 0, sizeof(*pack));
+}
+
+int framePackDecodeFrame(PlaydateAPI* pd, const FramePack* pack, int index, LCDBitmap* bitmap) {
+	if (index < 0 || index >= pack->frameCount) {
+		return 0;
+	}
+
+	int key = index;
+	uint32_t offset, size;
+	int encoding;
+	framePackEntry(pack, key, &offset, &size, &encoding);
+	while (encoding != FRAME_PACK_ENCODING_KEY) {
+		framePackEntry(pack, --key, &offset, &size, &encoding);
+	}
+
+	for (int i = key; i <= index; i++) {
+		FrameCursor cursor;
+		if (initCursor(pd, pack, bitmap, &cursor) == 0 || decodeEntry(pack, i, &cursor) == 0) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int framePackDecodeFrameFrom(PlaydateAPI* pd, const FramePack* pack, int index, LCDBitmap* neighbour, int neighbourIndex, LCDBitmap* bitmap) {
+	if (index < 0 || index >= pack->frameCount) {
+		return 0;
+	}
+
+	FrameCursor cursor;
+	if (initCursor(pd, pack, bitmap, &cursor) == 0) {
+		return 0;
+	}
+
+	uint32_t offset, size;
+	int encoding;
+	framePackEntry(pack, index, &offset, &size, &encoding);
+	if (encoding == FRAME_PACK_ENCODING_KEY) {
+		return decodeEntry(pack, index, &cursor);
+	}
+
+	// the delta linking the two frames is stored with the later one
+	int deltaIndex = (neighbourIndex == index - 1) ? index : neighbourIndex;
+	if (neighbourIndex != index - 1 && neighbourIndex != index + 1) {
+		return 0;
+	}
+	if (deltaIndex >= pack->frameCount) {
+		return 0;
+	}
+	framePackEntry(pack, deltaIndex, &offset, &size, &encoding);
+	FrameCursor neighbourCursor;
+	if (
+		encoding != FRAME_PACK_ENCODING_DELTA || neighbour == NULL || neighbour == bitmap ||
+		initCursor(pd, pack, neighbour, &neighbourCursor) == 0
+	) {
+		return 0;
+	}
+
+	// start from a copy of the neighbour frame, then apply the delta
+	memcpy(cursor.data, neighbourCursor.data, (size_t)cursor.rowbytes * pack->height);
+	return decodeEntry(pack, deltaIndex, &cursor);
+}
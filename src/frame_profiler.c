@@ -0,0 +1,124 @@
+#include "frame_profiler.h"
+
+#if FRAME_PROFILER_ENABLED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/** The height of the frame time histogram in the overlay */
+#define OVERLAY_HISTOGRAM_HEIGHT 24
+#define OVERLAY_MARGIN 2
+
+
+static uint32_t microseconds(float seconds) {
+	return seconds > 0.0f ? (uint32_t)(seconds * 1000000.0f) : 0;
+}
+
+static int compareU32(const void* a, const void* b) {
+	uint32_t x = *(const uint32_t*)a;
+	uint32_t y = *(const uint32_t*)b;
+	return (x > y) - (x < y);
+}
+
+void frameProfilerInit(FrameProfiler* profiler, const char* const* names, int numSections) {
+	memset(profiler, 0, sizeof(*profiler));
+	profiler->names = names;
+	profiler->numSections = numSections < FRAME_PROFILER_MAX_SECTIONS ? numSections : FRAME_PROFILER_MAX_SECTIONS;
+	profiler->framesUntilStats = FRAME_PROFILER_STATS_INTERVAL;
+}
+
+void frameProfilerBeginFrame(PlaydateAPI* pd, FrameProfiler* profiler) {
+	pd->system->resetElapsedTime();
+	memset(profiler->current, 0, sizeof(profiler->current));
+}
+
+void frameProfilerBeginSection(PlaydateAPI* pd, FrameProfiler* profiler, int section) {
+	profiler->sectionStart[section] = pd->system->getElapsedTime();
+}
+
+void frameProfilerEndSection(PlaydateAPI* pd, FrameProfiler* profiler, int section) {
+	profiler->current[section] += microseconds(pd->system->getElapsedTime() - profiler->sectionStart[section]);
+}
+
+static void updateStats(FrameProfiler* profiler, MemoryArena* scratch) {
+	// (without room for the sort, the percentiles keep their last values)
+	uint32_t* sorted = memoryArenaAlloc(scratch, profiler->count * sizeof(uint32_t));
+	for (int s = 0; s <= profiler->numSections && sorted != NULL; s++) {
+		for (int i = 0; i < profiler->count; i++) {
+			sorted[i] = profiler->samples[i][s];
+		}
+		qsort(sorted, profiler->count, sizeof(sorted[0]), compareU32);
+		FrameProfilerPercentiles* p = &profiler->percentiles[s];
+		p->p50 = sorted[(profiler->count - 1) * 50 / 100];
+		p->p95 = sorted[(profiler->count - 1) * 95 / 100];
+		p->p99 = sorted[(profiler->count - 1) * 99 / 100];
+	}
+
+	memset(profiler->histogram, 0, sizeof(profiler->histogram));
+	for (int i = 0; i < profiler->count; i++) {
+		uint32_t bin = profiler->samples[i][profiler->numSections] / FRAME_PROFILER_HISTOGRAM_BIN_US;
+		profiler->histogram[bin < FRAME_PROFILER_HISTOGRAM_BINS ? bin : FRAME_PROFILER_HISTOGRAM_BINS - 1]++;
+	}
+}
+
+int frameProfilerEndFrame(PlaydateAPI* pd, FrameProfiler* profiler, MemoryArena* scratch) {
+	uint32_t* sample = profiler->samples[profiler->next];
+	memcpy(sample, profiler->current, profiler->numSections * sizeof(uint32_t));
+	sample[profiler->numSections] = microseconds(pd->system->getElapsedTime());
+	profiler->next = (profiler->next + 1) % FRAME_PROFILER_RING_SIZE;
+	if (profiler->count < FRAME_PROFILER_RING_SIZE) {
+		profiler->count++;
+	}
+
+	if (--profiler->framesUntilStats > 0) {
+		return 0;
+	}
+	profiler->framesUntilStats = FRAME_PROFILER_STATS_INTERVAL;
+	updateStats(profiler, scratch);
+	return 1;
+}
+
+int frameProfilerOverlayHeight(const FrameProfiler* profiler, int lineHeight) {
+	return (profiler->numSections + 1) * lineHeight + OVERLAY_HISTOGRAM_HEIGHT + 3 * OVERLAY_MARGIN;
+}
+
+void frameProfilerDrawOverlay(PlaydateAPI* pd, const FrameProfiler* profiler, FontBlitter* text, int y) {
+	int lineHeight = text != NULL ? text->height : 0;
+	int height = frameProfilerOverlayHeight(profiler, lineHeight);
+	pd->graphics->fillRect(0, y, LCD_COLUMNS, height, kColorWhite);
+	pd->graphics->drawRect(0, y, LCD_COLUMNS, height, kColorBlack);
+
+	// p50/p95/p99 per section, then of whole frames (in microseconds)
+	if (text != NULL) {
+		char line[64];
+		for (int s = 0; s <= profiler->numSections; s++) {
+			const FrameProfilerPercentiles* p = &profiler->percentiles[s];
+			int length = snprintf(
+				line, sizeof(line), "%-8s %6u %6u %6u",
+				s < profiler->numSections ? profiler->names[s] : "frame",
+				(unsigned int)p->p50, (unsigned int)p->p95, (unsigned int)p->p99
+			);
+			fontBlitterDrawText(pd, text, line, length, OVERLAY_MARGIN, y + OVERLAY_MARGIN + s * lineHeight);
+		}
+	}
+
+	// frame time histogram: one bar per bin, scaled to the fullest bin
+	uint16_t fullest = 1;
+	for (int b = 0; b < FRAME_PROFILER_HISTOGRAM_BINS; b++) {
+		if (profiler->histogram[b] > fullest) {
+			fullest = profiler->histogram[b];
+		}
+	}
+	int barWidth = (LCD_COLUMNS - 2 * OVERLAY_MARGIN) / FRAME_PROFILER_HISTOGRAM_BINS;
+	int baseline = y + height - OVERLAY_MARGIN;
+	for (int b = 0; b < FRAME_PROFILER_HISTOGRAM_BINS; b++) {
+		int barHeight = profiler->histogram[b] * OVERLAY_HISTOGRAM_HEIGHT / fullest;
+		if (barHeight > 0) {
+			pd->graphics->fillRect(OVERLAY_MARGIN + b * barWidth, baseline - barHeight, barWidth - 1, barHeight, kColorBlack);
+		}
+	}
+}
+
+#endif /* FRAME_PROFILER_ENABLED */
@@ -0,0 +1,245 @@
+#include <math.h>
+#include <string.h>
+
+#include "globe_renderer.h"
+
+
+#define GLOBE_PI 3.14159265f
+
+/** Gathers pixels into bytes of a 1-bit image row, leftmost pixel in the top bit */
+typedef struct {
+	uint8_t* out;
+	unsigned int bits;
+	int count;
+} BitWriter;
+
+/**
+ * Starts writing pixels at x of line (the pixels left of x in its byte are kept).
+ */
+static inline void bitWriterBegin(BitWriter* writer, uint8_t* line, int x) {
+	writer->out = line + (x >> 3);
+	writer->count = x & 7;
+	writer->bits = (writer->count > 0) ? (unsigned int)(*writer->out >> (8 - writer->count)) : 0;
+}
+
+static inline void bitWriterPut(BitWriter* writer, unsigned int bit) {
+	writer->bits = (writer->bits << 1) | bit;
+	if (++writer->count == 8) {
+		*writer->out++ = (uint8_t)writer->bits;
+		writer->bits = 0;
+		writer->count = 0;
+	}
+}
+
+/**
+ * Writes the last, partial byte (the pixels right of the last one written in it are kept).
+ */
+static inline void bitWriterEnd(BitWriter* writer) {
+	if (writer->count > 0) {
+		int rest = 8 - writer->count;
+		*writer->out = (uint8_t)((writer->bits << rest) | (*writer->out & ((1u << rest) - 1)));
+	}
+}
+
+/**
+ * @return the samples each side of the center of the disc's row (counted from the equator) of a disc of sampleRadius
+ */
+static int halfWidthOf(int sampleRadius, int row) {
+	float y = (row + 0.5f) / sampleRadius;
+	int halfWidth = (int)(sampleRadius * sqrtf(1.0f - y * y) + 0.5f);
+	return (halfWidth < sampleRadius) ? halfWidth : sampleRadius;
+}
+
+/**
+ * @return the number of longitude offsets of a disc of sampleRadius (the samples right of the center of its lower half)
+ */
+static size_t longitudeCount(int sampleRadius) {
+	size_t count = 0;
+	for (int row = 0; row < sampleRadius; row++) {
+		count += halfWidthOf(sampleRadius, row);
+	}
+	return count;
+}
+
+/** Per 4 bits, the byte of each of them doubled (for drawing samples 2 pixels wide) */
+static const uint8_t doubledBits[16] = {
+	0x00, 0x03, 0x0c, 0x0f, 0x30, 0x33, 0x3c, 0x3f, 0xc0, 0xc3, 0xcc, 0xcf, 0xf0, 0xf3, 0xfc, 0xff
+};
+
+static inline unsigned int mapBit(const uint8_t* mapRow, int column) {
+	return (mapRow[column >> 3] >> (~column & 7)) & 1;
+}
+
+/**
+ * Draws count samples of map row at columns from x in line, each scale pixels wide: a pixel at a time up to a byte
+ * boundary, then (at scales 1 and 2) a byte at a time, its samples' map bits looked up independently of each other.
+ */
+static void drawRow(const uint8_t* mapRow, const uint16_t* columns, int count, int scale, uint8_t* line, int x) {
+	BitWriter writer;
+	bitWriterBegin(&writer, line, x);
+	int i = 0;
+	if (scale == 1) {
+		for (; i < count && writer.count != 0; i++) {
+			bitWriterPut(&writer, mapBit(mapRow, columns[i]));
+		}
+		for (; i + 8 <= count; i += 8) {
+			const uint16_t* c = columns + i;
+			*writer.out++ = (uint8_t)(
+				(mapBit(mapRow, c[0]) << 7) | (mapBit(mapRow, c[1]) << 6) | (mapBit(mapRow, c[2]) << 5) | (mapBit(mapRow, c[3]) << 4) |
+				(mapBit(mapRow, c[4]) << 3) | (mapBit(mapRow, c[5]) << 2) | (mapBit(mapRow, c[6]) << 1) | mapBit(mapRow, c[7])
+			);
+		}
+	}
+	else if (scale == 2) {
+		// (from an odd x, the byte boundary is never reached: all of it goes a pixel at a time)
+		for (; i < count && writer.count != 0; i++) {
+			unsigned int bit = mapBit(mapRow, columns[i]);
+			bitWriterPut(&writer, bit);
+			bitWriterPut(&writer, bit);
+		}
+		for (; i + 4 <= count; i += 4) {
+			const uint16_t* c = columns + i;
+			*writer.out++ = doubledBits[(mapBit(mapRow, c[0]) << 3) | (mapBit(mapRow, c[1]) << 2) | (mapBit(mapRow, c[2]) << 1) | mapBit(mapRow, c[3])];
+		}
+	}
+	for (; i < count; i++) {
+		unsigned int bit = mapBit(mapRow, columns[i]);
+		for (int s = 0; s < scale; s++) {
+			bitWriterPut(&writer, bit);
+		}
+	}
+	bitWriterEnd(&writer);
+}
+
+/**
+ * Copies pixels [x0, x1) of row src into row dst (the pixels around them in their bytes are kept).
+ */
+static void copyPixels(uint8_t* dst, const uint8_t* src, int x0, int x1) {
+	int first = x0 >> 3;
+	int last = (x1 - 1) >> 3;
+	uint8_t firstMask = (uint8_t)(0xff >> (x0 & 7));
+	uint8_t lastMask = (uint8_t)(0xff << (7 - ((x1 - 1) & 7)));
+	if (first == last) {
+		uint8_t mask = firstMask & lastMask;
+		dst[first] = (uint8_t)((dst[first] & ~mask) | (src[first] & mask));
+		return;
+	}
+	dst[first] = (uint8_t)((dst[first] & ~firstMask) | (src[first] & firstMask));
+	memcpy(dst + first + 1, src + first + 1, last - first - 1);
+	dst[last] = (uint8_t)((dst[last] & ~lastMask) | (src[last] & lastMask));
+}
+
+size_t globeRendererTableSize(int radius, int scale) {
+	int sampleRadius = (scale > 0) ? radius / scale : 0;
+	if (sampleRadius <= 0) {
+		return 0;
+	}
+	size_t rows = MEMORY_ARENA_ROOM(sampleRadius * sizeof(GlobeRendererRow));
+	size_t columns = MEMORY_ARENA_ROOM(2 * sampleRadius * sizeof(uint16_t));
+	return rows + MEMORY_ARENA_ROOM(longitudeCount(sampleRadius)) + columns;
+}
+
+int globeRendererInit(PlaydateAPI* pd, GlobeRenderer* globe, LCDBitmap* map, int radius, int scale, MemoryArena* arena) {
+	memset(globe, 0, sizeof(*globe));
+	if (map == NULL || scale <= 0 || radius / scale <= 0 || radius / scale > GLOBE_RENDERER_MAX_SAMPLE_RADIUS) {
+		return 0;
+	}
+	uint8_t* mask = NULL;
+	uint8_t* data = NULL;
+	pd->graphics->getBitmapData(map, &globe->mapWidth, &globe->mapHeight, &globe->mapRowbytes, &mask, &data);
+	if (data == NULL || globe->mapWidth < 4 || globe->mapWidth > GLOBE_RENDERER_MAX_MAP_WIDTH || globe->mapHeight <= 0) {
+		return 0;
+	}
+
+	int sampleRadius = radius / scale;
+	GlobeRendererRow* rows = memoryArenaAlloc(arena, sampleRadius * sizeof(GlobeRendererRow));
+	uint8_t* longitudes = memoryArenaAlloc(arena, longitudeCount(sampleRadius));
+	uint16_t* columns = memoryArenaAlloc(arena, 2 * sampleRadius * sizeof(uint16_t));
+	if (rows == NULL || longitudes == NULL || columns == NULL) {
+		return 0;
+	}
+
+	// per row: its latitude's map rows (y, the sine of the latitude, is a sample's distance below the equator); per
+	// sample: the longitude offset its distance from the center makes on the row's circle of latitude
+	int mapWidth = globe->mapWidth;
+	int mapHeight = globe->mapHeight;
+	uint8_t* longitude = longitudes;
+	for (int row = 0; row < sampleRadius; row++) {
+		float y = (row + 0.5f) / sampleRadius;
+		float latitude = asinf(y) / GLOBE_PI;
+		int south = (int)((0.5f + latitude) * mapHeight);
+		int north = (int)((0.5f - latitude) * mapHeight);
+		rows[row].south = (uint16_t)((south < mapHeight) ? south : mapHeight - 1);
+		rows[row].north = (uint16_t)((north > 0) ? north : 0);
+
+		int halfWidth = halfWidthOf(sampleRadius, row);
+		rows[row].halfWidth = (uint16_t)halfWidth;
+		float circle = sqrtf(1.0f - y * y);
+		for (int x = 0; x < halfWidth; x++) {
+			float u = (x + 0.5f) / sampleRadius / circle;
+			int offset = (int)(asinf(u < 1.0f ? u : 1.0f) / (2.0f * GLOBE_PI) * mapWidth + 0.5f);
+			*longitude++ = (uint8_t)((offset < mapWidth / 4) ? offset : mapWidth / 4);
+		}
+	}
+
+	globe->map = map;
+	globe->mapData = data;
+	globe->radius = sampleRadius * scale;
+	globe->scale = scale;
+	globe->sampleRadius = sampleRadius;
+	globe->rows = rows;
+	globe->longitudes = longitudes;
+	globe->columns = columns;
+	return 1;
+}
+
+int globeRendererDraw(GlobeRenderer* globe, float longitude, uint8_t* image, int rowbytes, int height, int centerX, int centerY) {
+	int radius = globe->radius;
+	if (globe->rows == NULL || centerX - radius < 0 || centerX + radius > rowbytes * 8) {
+		return 0;
+	}
+
+	int mapWidth = globe->mapWidth;
+	int column = (int)floorf(longitude * mapWidth / 360.0f) % mapWidth;
+	column += (column < 0) ? mapWidth : 0;
+	int scale = globe->scale;
+	const uint8_t* longitudes = globe->longitudes;
+	uint16_t* columns = globe->columns;
+	uint32_t samples = 0;
+	for (int r = 0; r < globe->sampleRadius; r++) {
+		const GlobeRendererRow* row = &globe->rows[r];
+		int halfWidth = row->halfWidth;
+		int x0 = centerX - halfWidth * scale;
+		int x1 = centerX + halfWidth * scale;
+
+		// the row's map columns at the longitude: its offsets west of the center (mirrored), then east, wrapped around
+		for (int i = 0; i < halfWidth; i++) {
+			int west = column - longitudes[i];
+			int east = column + longitudes[i];
+			columns[halfWidth - 1 - i] = (uint16_t)(west + ((west < 0) ? mapWidth : 0));
+			columns[halfWidth + i] = (uint16_t)(east - ((east >= mapWidth) ? mapWidth : 0));
+		}
+
+		// the row's mirror above the equator, then the row itself: drawn into its first line in the image, then copied
+		// to the others of its scale
+		for (int south = 0; south < 2; south++) {
+			int top = centerY + (south ? r : -(r + 1)) * scale;
+			int first = (top > 0) ? top : 0;
+			int end = (top + scale < height) ? top + scale : height;
+			if (first >= end || halfWidth == 0) {
+				continue;
+			}
+			const uint8_t* mapRow = globe->mapData + (south ? row->south : row->north) * globe->mapRowbytes;
+			uint8_t* line = image + first * rowbytes;
+			drawRow(mapRow, columns, 2 * halfWidth, scale, line, x0);
+			for (int y = first + 1; y < end; y++) {
+				copyPixels(image + y * rowbytes, line, x0, x1);
+			}
+			samples += 2 * halfWidth;
+		}
+		longitudes += halfWidth;
+	}
+	globe->stats.draws++;
+	globe->stats.samples += samples;
+	return 1;
+}
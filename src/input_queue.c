@@ -0,0 +1,220 @@
+#include <string.h>
+
+#include "input_queue.h"
+
+
+static void push(InputQueue* queue, InputEventType type, PDButtons button, int item, float value, uint32_t time) {
+	queue->stats.events++;
+	if (queue->count == INPUT_QUEUE_SIZE) {
+		queue->stats.dropped++;
+		return;
+	}
+	queue->events[(queue->head + queue->count) % INPUT_QUEUE_SIZE] = (InputEvent){ type, button, item, value, time };
+	queue->count++;
+	if (queue->count > queue->stats.maxDepth) {
+		queue->stats.maxDepth = queue->count;
+	}
+}
+
+static int buttonIndex(PDButtons button) {
+	int i = 0;
+	while (i < INPUT_QUEUE_BUTTONS - 1 && (button & (1 << i)) == 0) {
+		i++;
+	}
+	return i;
+}
+
+/**
+ * Queues a button's press or release (ignoring presses of buttons already down, and releases of buttons already up).
+ */
+static void pushButton(InputQueue* queue, PDButtons button, int down, uint32_t time) {
+	if (down) {
+		if (queue->held & button) {
+			return;
+		}
+		queue->held |= button;
+		queue->pressedSincePoll |= button;
+		queue->nextRepeat[buttonIndex(button)] = time + queue->repeatDelay;
+		push(queue, kInputPress, button, 0, 0.0f, time);
+	}
+	else {
+		if ((queue->held & button) == 0) {
+			return;
+		}
+		queue->held &= ~button;
+		if (queue->pressedSincePoll & button) {
+			queue->stats.tapsInFrame++;
+		}
+		push(queue, kInputRelease, button, 0, 0.0f, time);
+	}
+}
+
+/**
+ * PDButtonCallbackFunction: queues the system's button events, as they happened, ahead of the update.
+ */
+static int buttonCallback(PDButtons button, int down, uint32_t when, void* userdata) {
+	InputQueue* queue = userdata;
+	if (queue->trace != NULL && queue->trace->mode == kInputTraceReplaying) {
+		return 0;
+	}
+	for (int i = 0; i < INPUT_QUEUE_BUTTONS; i++) {
+		if (button & (1 << i)) {
+			pushButton(queue, (PDButtons)(1 << i), down, when);
+		}
+	}
+	return 0;
+}
+
+void inputQueueInit(PlaydateAPI* pd, InputQueue* queue, PDButtons repeatMask, uint32_t repeatDelay, uint32_t repeatInterval) {
+	memset(queue, 0, sizeof(*queue));
+	queue->repeatMask = repeatMask;
+	queue->repeatDelay = repeatDelay;
+	queue->repeatInterval = repeatInterval;
+	if (pd->system->setButtonCallback != NULL) {
+		pd->system->setButtonCallback(buttonCallback, queue, INPUT_QUEUE_BUTTON_EVENTS);
+		queue->buttonCallback = 1;
+	}
+}
+
+void inputQueueSetTrace(PlaydateAPI* pd, InputQueue* queue, InputTrace* trace) {
+	queue->trace = trace;
+	queue->lastPoll = pd->system->getCurrentTimeMilliseconds();
+	queue->traceClock = queue->lastPoll;
+}
+
+/**
+ * Reads the update cycle's input from the system: the buttons' polled state (if there's no button callback), and the
+ * crank's (if undocked); or all of it, if recording.
+ */
+static void readFrame(PlaydateAPI* pd, InputQueue* queue, InputTraceFrame* frame, uint32_t now) {
+	int recording = queue->trace != NULL && queue->trace->mode == kInputTraceRecording;
+	memset(frame, 0, sizeof(*frame));
+	frame->menuItem = -1;
+	frame->elapsed = now - queue->lastPoll;
+
+	if (queue->buttonCallback == 0 || recording) {
+		pd->system->getButtonState(&frame->current, &frame->pushed, &frame->released);
+	}
+	frame->crankDocked = pd->system->isCrankDocked();
+	if (frame->crankDocked == 0) {
+		frame->crankChange = pd->system->getCrankChange();
+	}
+	if (frame->crankChange != 0.0f || recording) {
+		frame->crankAngle = pd->system->getCrankAngle();
+	}
+	if (recording) {
+		pd->system->getAccelerometer(&frame->accelerometer[0], &frame->accelerometer[1], &frame->accelerometer[2]);
+	}
+}
+
+/**
+ * Queues the presses and releases of a polled button state.
+ */
+static void pushPolledButtons(InputQueue* queue, const InputTraceFrame* frame, uint32_t now) {
+	// (no order within the update cycle: a button both pushed and released was tapped if up now, else let go and re-pressed)
+	for (int i = 0; i < INPUT_QUEUE_BUTTONS; i++) {
+		PDButtons button = (PDButtons)(1 << i);
+		if ((frame->pushed & frame->released & button) && (frame->current & button)) {
+			pushButton(queue, button, 0, now);
+			pushButton(queue, button, 1, now);
+		}
+		else if (frame->pushed & frame->released & button) {
+			pushButton(queue, button, 1, now);
+			pushButton(queue, button, 0, now);
+		}
+		else if (frame->pushed & button) {
+			pushButton(queue, button, 1, now);
+		}
+		else if (frame->released & button) {
+			pushButton(queue, button, 0, now);
+		}
+	}
+}
+
+void inputQueuePoll(PlaydateAPI* pd, InputQueue* queue) {
+	uint32_t live = pd->system->getCurrentTimeMilliseconds();
+	uint32_t now = live;
+	InputTrace* trace = queue->trace;
+
+	InputTraceFrame frame;
+	int replaying = trace != NULL && trace->mode == kInputTraceReplaying;
+	int replayed = replaying && inputTraceReplayFrame(pd, trace, &frame);
+	if (replayed) {
+		queue->traceClock += frame.elapsed;
+		now = queue->traceClock;
+	}
+	else {
+		if (replaying) {
+			// (the end of the trace: let go of the buttons it left down, as live input takes over)
+			for (int i = 0; i < INPUT_QUEUE_BUTTONS; i++) {
+				pushButton(queue, (PDButtons)(1 << i), 0, now);
+			}
+		}
+		readFrame(pd, queue, &frame, now);
+		if (trace != NULL) {
+			inputTraceRecordFrame(pd, trace, &frame);
+		}
+	}
+	queue->lastPoll = live;
+
+	if (replayed || queue->buttonCallback == 0) {
+		pushPolledButtons(queue, &frame, now);
+	}
+	queue->pressedSincePoll = 0;
+
+	// repeats of held buttons (one per poll at most: a long frame doesn't release a burst of them)
+	for (int i = 0; i < INPUT_QUEUE_BUTTONS; i++) {
+		PDButtons button = (PDButtons)(1 << i);
+		if ((queue->held & queue->repeatMask & button) && (int32_t)(now - queue->nextRepeat[i]) >= 0) {
+			push(queue, kInputRepeat, button, 0, 0.0f, now);
+			queue->nextRepeat[i] += queue->repeatInterval;
+			if ((int32_t)(now - queue->nextRepeat[i]) >= 0) {
+				queue->nextRepeat[i] = now + queue->repeatInterval;
+			}
+		}
+	}
+
+	if (frame.crankDocked == 0 && frame.crankChange != 0.0f) {
+		queue->crankAngle = frame.crankAngle;
+		push(queue, kInputCrank, 0, 0, frame.crankChange, now);
+	}
+	if (replayed && frame.menuItem >= 0) {
+		push(queue, kInputMenu, 0, frame.menuItem, (float)frame.menuValue, now);
+	}
+}
+
+void inputQueuePushMenu(PlaydateAPI* pd, InputQueue* queue, int item, int value) {
+	if (queue->trace != NULL) {
+		if (queue->trace->mode == kInputTraceReplaying) {
+			return;
+		}
+		inputTraceRecordMenu(queue->trace, item, value);
+	}
+	push(queue, kInputMenu, 0, item, (float)value, pd->system->getCurrentTimeMilliseconds());
+}
+
+int inputQueuePop(PlaydateAPI* pd, InputQueue* queue, InputEvent* event) {
+	if (queue->count == 0) {
+		return 0;
+	}
+	*event = queue->events[queue->head];
+	queue->head = (queue->head + 1) % INPUT_QUEUE_SIZE;
+	queue->count--;
+
+	// (replayed events are timed on the trace's clock, which is only as far as the last poll)
+	int replaying = queue->trace != NULL && queue->trace->mode == kInputTraceReplaying;
+	uint32_t latency = (replaying ? queue->traceClock : pd->system->getCurrentTimeMilliseconds()) - event->time;
+	queue->stats.latencyCount++;
+	queue->stats.latencyTotal += latency;
+	if (latency > queue->stats.latencyMax) {
+		queue->stats.latencyMax = latency;
+	}
+	return 1;
+}
+
+void inputQueueFree(PlaydateAPI* pd, InputQueue* queue) {
+	if (queue->buttonCallback) {
+		pd->system->setButtonCallback(NULL, NULL, 0);
+	}
+	memset(queue, 0, sizeof(*queue));
+}
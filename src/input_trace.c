@@ -0,0 +1,189 @@
+#include <string.h>
+
+#include "input_trace.h"
+
+
+/** The fixed-point scales of the crank angle, crank change and accelerometer values in a frame record */
+#define CRANK_ANGLE_SCALE 128.0f
+#define CRANK_CHANGE_SCALE 64.0f
+#define ACCELEROMETER_SCALE 4096.0f
+
+#define FLAG_CRANK_DOCKED 1
+#define FLAG_MENU 2
+
+static void put16(uint8_t* p, uint16_t value) {
+	p[0] = (uint8_t)value;
+	p[1] = (uint8_t)(value >> 8);
+}
+
+static uint16_t get16(const uint8_t* p) {
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/**
+ * @return value in units of 1/scale, rounded to nearest and clamped to [min, max]
+ */
+static int32_t quantize(float value, float scale, int32_t min, int32_t max) {
+	float scaled = value * scale;
+	int32_t q = (int32_t)(scaled + (scaled >= 0.0f ? 0.5f : -0.5f));
+	return q < min ? min : (q > max ? max : q);
+}
+
+/**
+ * Writes out the frames buffered; on failure, stops recording.
+ */
+static void flush(PlaydateAPI* pd, InputTrace* trace) {
+	if (trace->buffered == 0) {
+		return;
+	}
+	int size = trace->buffered * INPUT_TRACE_FRAME_SIZE;
+	trace->stats.fileOps++;
+	if (pd->file->write(trace->file, trace->buffer, size) != size) {
+		trace->stats.errors++;
+		trace->buffered = 0;
+		inputTraceClose(pd, trace);
+		return;
+	}
+	trace->buffered = 0;
+}
+
+int inputTraceRecord(PlaydateAPI* pd, InputTrace* trace, const char* path) {
+	memset(trace, 0, sizeof(*trace));
+	trace->pendingMenuItem = -1;
+
+	trace->file = pd->file->open(path, kFileWrite);
+	if (trace->file == NULL) {
+		trace->stats.errors++;
+		return 0;
+	}
+	uint8_t header[INPUT_TRACE_HEADER_SIZE] = { 'P', 'D', 'I', 'T' };
+	put16(header + 4, INPUT_TRACE_VERSION);
+	put16(header + 6, INPUT_TRACE_FRAME_SIZE);
+	if (pd->file->write(trace->file, header, sizeof(header)) != (int)sizeof(header)) {
+		trace->stats.errors++;
+		pd->file->close(trace->file);
+		trace->file = NULL;
+		return 0;
+	}
+	trace->mode = kInputTraceRecording;
+	return 1;
+}
+
+int inputTraceReplay(PlaydateAPI* pd, InputTrace* trace, const char* path) {
+	memset(trace, 0, sizeof(*trace));
+	trace->pendingMenuItem = -1;
+
+	trace->file = pd->file->open(path, kFileReadData | kFileRead);
+	if (trace->file == NULL) {
+		return 0;
+	}
+	uint8_t header[INPUT_TRACE_HEADER_SIZE];
+	if (pd->file->read(trace->file, header, sizeof(header)) != (int)sizeof(header) || memcmp(header, "PDIT", 4) != 0 ||
+		get16(header + 4) != INPUT_TRACE_VERSION || get16(header + 6) != INPUT_TRACE_FRAME_SIZE) {
+		trace->stats.errors++;
+		pd->file->close(trace->file);
+		trace->file = NULL;
+		return 0;
+	}
+	trace->mode = kInputTraceReplaying;
+	return 1;
+}
+
+void inputTraceRecordMenu(InputTrace* trace, int item, int value) {
+	if (trace->mode != kInputTraceRecording) {
+		return;
+	}
+	if (trace->pendingMenuItem >= 0) {
+		trace->stats.menuChangesLost++;
+	}
+	trace->pendingMenuItem = item;
+	trace->pendingMenuValue = value;
+}
+
+void inputTraceRecordFrame(PlaydateAPI* pd, InputTrace* trace, InputTraceFrame* frame) {
+	if (trace->mode != kInputTraceRecording) {
+		return;
+	}
+	frame->menuItem = trace->pendingMenuItem;
+	frame->menuValue = trace->pendingMenuValue;
+	trace->pendingMenuItem = -1;
+
+	uint8_t* p = trace->buffer + trace->buffered * INPUT_TRACE_FRAME_SIZE;
+	p[0] = (uint8_t)frame->current;
+	p[1] = (uint8_t)frame->pushed;
+	p[2] = (uint8_t)frame->released;
+	p[3] = (uint8_t)((frame->crankDocked ? FLAG_CRANK_DOCKED : 0) | (frame->menuItem >= 0 ? FLAG_MENU : 0));
+	p[4] = (uint8_t)(frame->menuItem >= 0 ? frame->menuItem : 0);
+	p[5] = (uint8_t)frame->menuValue;
+	put16(p + 6, (uint16_t)(frame->elapsed < 0xffff ? frame->elapsed : 0xffff));
+
+	int32_t angle = quantize(frame->crankAngle, CRANK_ANGLE_SCALE, 0, (int32_t)(360.0f * CRANK_ANGLE_SCALE) - 1);
+	int32_t change = quantize(frame->crankChange, CRANK_CHANGE_SCALE, INT16_MIN, INT16_MAX);
+	put16(p + 8, (uint16_t)angle);
+	put16(p + 10, (uint16_t)change);
+	frame->crankAngle = angle / CRANK_ANGLE_SCALE;
+	frame->crankChange = change / CRANK_CHANGE_SCALE;
+	for (int i = 0; i < 3; i++) {
+		int32_t a = quantize(frame->accelerometer[i], ACCELEROMETER_SCALE, INT16_MIN, INT16_MAX);
+		put16(p + 12 + 2 * i, (uint16_t)a);
+		frame->accelerometer[i] = a / ACCELEROMETER_SCALE;
+	}
+
+	trace->stats.frames++;
+	if (++trace->buffered == INPUT_TRACE_BUFFER_FRAMES) {
+		flush(pd, trace);
+	}
+}
+
+int inputTraceReplayFrame(PlaydateAPI* pd, InputTrace* trace, InputTraceFrame* frame) {
+	if (trace->mode != kInputTraceReplaying) {
+		return 0;
+	}
+	if (trace->next == trace->buffered) {
+		trace->stats.fileOps++;
+		int size = pd->file->read(trace->file, trace->buffer, sizeof(trace->buffer));
+		trace->buffered = size > 0 ? size / INPUT_TRACE_FRAME_SIZE : 0;
+		trace->next = 0;
+		if (size > 0 && size % INPUT_TRACE_FRAME_SIZE != 0) {
+			trace->stats.errors++; // (a truncated last frame: the frames before it are replayed)
+		}
+		if (trace->buffered == 0) {
+			inputTraceClose(pd, trace);
+			return 0;
+		}
+	}
+
+	const uint8_t* p = trace->buffer + trace->next++ * INPUT_TRACE_FRAME_SIZE;
+	frame->current = (PDButtons)p[0];
+	frame->pushed = (PDButtons)p[1];
+	frame->released = (PDButtons)p[2];
+	frame->crankDocked = (p[3] & FLAG_CRANK_DOCKED) != 0;
+	frame->menuItem = (p[3] & FLAG_MENU) ? p[4] : -1;
+	frame->menuValue = p[5];
+	frame->elapsed = get16(p + 6);
+	frame->crankAngle = get16(p + 8) / CRANK_ANGLE_SCALE;
+	frame->crankChange = (int16_t)get16(p + 10) / CRANK_CHANGE_SCALE;
+	for (int i = 0; i < 3; i++) {
+		frame->accelerometer[i] = (int16_t)get16(p + 12 + 2 * i) / ACCELEROMETER_SCALE;
+	}
+	trace->stats.frames++;
+	return 1;
+}
+
+void inputTraceClose(PlaydateAPI* pd, InputTrace* trace) {
+	if (trace->mode == kInputTraceRecording) {
+		int size = trace->buffered * INPUT_TRACE_FRAME_SIZE;
+		if (size > 0) {
+			trace->stats.fileOps++;
+			if (pd->file->write(trace->file, trace->buffer, size) != size) {
+				trace->stats.errors++;
+			}
+		}
+		trace->buffered = 0;
+	}
+	if (trace->file != NULL) {
+		pd->file->close(trace->file);
+		trace->file = NULL;
+	}
+	trace->mode = kInputTraceOff;
+}
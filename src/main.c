@@ -14,7 +14,7 @@
 //  - handling inputs: D-pad, A / B buttons, Crank, System menu
 //  - loading and using a custom font
 //  - loading and rendering images
-//  - loading and playing music/sound
+//  - loading and playing music, and synthesizing sound
 //  - including additional C source/header files
 //
 //  This project renders stills of our Blue Planet that revolves based on input while 
@@ -27,14 +27,64 @@
 #include "pd_api.h"
 
 #include "text_manager.h"
+#include "memory_arena.h"
+#include "asset_manifest.h"
+#include "asset_loader.h"
+#include "input_queue.h"
+#include "input_trace.h"
+#include "scene.h"
+#include "font_blitter.h"
+#include "frame_pack.h"
+#include "bitmap_cache.h"
+#include "frame_delta.h"
+#include "frame_blend.h"
+#include "tile_set.h"
+#include "globe_renderer.h"
+#include "tone_player.h"
+#include "music_player.h"
+#include "frame_profiler.h"
+#include "memory_tracker.h"
 
 
 static int update(void* userdata);
+static int updateFrame(void);
 
 /** Playdate API runtime */
 PlaydateAPI* pd = NULL;
 
-const char* fontPath = "assets/fonts/hello-world-c_2024a";
+/**
+ * The session's load-time data (the frame pack, spriteBitmapCache's tables and spriteDeltas) in one block, sized at init
+ * and released at once at exit, instead of individual heap allocations
+ */
+MemoryArena assetArena;
+/** Scratch memory for the work of a frame: reset at the top of every update(), so frames don't allocate from the heap */
+MemoryArena frameArena;
+#define FRAME_ARENA_SIZE (8 * 1024)
+
+/**
+ * Loads the assets a bit per update() instead of all at init, so startup doesn't take longer the more there are: first
+ * what the first frame needs (shown with a progress bar until then), then the rest alongside interaction.
+ */
+AssetLoader assetLoader;
+/** assetLoader's job priorities */
+enum {
+	/** Needed for the first frame (and interaction to start): loaded within ASSET_LOAD_BUDGET_STARTUP per frame */
+	kLoadPriorityFirstFrame,
+	/** Then, within ASSET_LOAD_BUDGET per frame: what input reaches first */
+	kLoadPriorityInteraction,
+	kLoadPriorityBackground
+};
+/** The time per update() spent loading, in seconds: until the first frame is ready (there's nothing else to do), and after */
+#define ASSET_LOAD_BUDGET_STARTUP 0.025f
+#define ASSET_LOAD_BUDGET 0.004f
+/** The size of the progress bar shown until the first frame is ready (centered on screen) */
+#define LOAD_PROGRESS_WIDTH 200
+#define LOAD_PROGRESS_HEIGHT 10
+/** The progress bar's fill last drawn, in pixels (-1 if not drawn yet) */
+int renderedLoadProgress = -1;
+
+/** (assets are referred to by their ID in the generated asset manifest, see asset_manifest.h) */
+const AssetInfo* fontAsset = &assetManifest[kAssetFontsHelloWorldC2024a];
 LCDFont* font = NULL;
 int fontTracking = 0;
 int textHeight = 0;
@@ -42,60 +92,112 @@ int textWidth = 0;
 /** in so many words: "Hello World!" */
 char* helloText = NULL;
 
-const char* musicFilePath = "assets/music/arp+surf=earth.mp3";
-FilePlayer* filePlayer = NULL;
+/** (staged as MP3 or ADPCM, per src/audio_manifest.json) */
+const AssetInfo* musicAsset = &assetManifest[kAssetMusicArpSurfEarth];
+/** The music's stream buffer length, in seconds: longer tolerates longer frames (see the underrun counters logged at exit), shorter takes less memory and starts faster */
+#define MUSIC_BUFFER_LENGTH 0.5f
+MusicPlayer music;
 
-#define NUM_SOUND_PATHS 3
-const char* soundPaths[NUM_SOUND_PATHS] = {
-	"assets/sfx/nasa_apollo-11-moonwalk-restored_YT-S9HdPi9Ikhk_beep-1",
-	"assets/sfx/nasa_apollo-11-moonwalk-restored_YT-S9HdPi9Ikhk_beep-2",
-	"assets/sfx/nasa_apollo-11-moonwalk-restored_YT-S9HdPi9Ikhk_beep-3"
-};
-typedef struct {
-	int id;
-	AudioSample* sample;
-} SoundInfo;
-SoundInfo soundInfos[NUM_SOUND_PATHS] = {
-	{ 1, NULL },
-	{ 2, NULL },
-	{ 3, NULL }
+/**
+ * The sounds: the Apollo beeps, synthesized as they play (see tonePlayerPlay()) rather than loaded as samples; measured
+ * from the restored moonwalk recording's beeps (its tones, without its hiss, or beep-2's lead-in of silence)
+ */
+const TonePreset soundTones[] = {
+	// beep-1
+	{ kWaveformSine, 2482.0f, 0.005f, 0.25f, 0.01f, 0.036f },
+	// beep-2: fainter, with a slower fade in
+	{ kWaveformSine, 2486.0f, 0.025f, 0.24f, 0.01f, 0.021f },
+	// beep-3: beep-1's tone again (the recording only differs in its longer tail of hiss)
+	{ kWaveformSine, 2482.0f, 0.005f, 0.25f, 0.01f, 0.036f },
 };
-SamplePlayer* samplePlayer = NULL;
+#define NUM_SOUND_TONES (int)(sizeof(soundTones) / sizeof(soundTones[0]))
+/** The number of overlapping tones before the oldest one is cut off */
+#define SOUND_VOICES 6
+/** The synths playing soundTones */
+TonePlayer soundTonePlayer;
 
-/** The current index into soundInfos. Valid range of [0, NUM_SOUND_PATHS) */
+/** The current index into soundTones. Valid range of [0, NUM_SOUND_TONES) */
 int soundRoundRobinIndex = 0;
 
-#define NUM_BITMAP_PATHS 8
-const char* bitmapPaths[NUM_BITMAP_PATHS] = {
-	"assets/textures/nasa_the-blue-marble_ls-oc-sic_20020208_frame-01_1-bit",
-	"assets/textures/nasa_the-blue-marble_ls-oc-sic_20020208_frame-02_1-bit",
-	"assets/textures/nasa_the-blue-marble_ls-oc-sic_20020208_frame-03_1-bit",
-	"assets/textures/nasa_the-blue-marble_ls-oc-sic_20020208_frame-04_1-bit",
-	"assets/textures/nasa_the-blue-marble_ls-oc-sic_20020208_frame-05_1-bit",
-	"assets/textures/nasa_the-blue-marble_ls-oc-sic_20020208_frame-06_1-bit",
-	"assets/textures/nasa_the-blue-marble_ls-oc-sic_20020208_frame-07_1-bit",
-	"assets/textures/nasa_the-blue-marble_ls-oc-sic_20020208_frame-08_1-bit"
-};
+/**
+ * The sprite's frames: a frame sequence, staged as one frame pack (see scripts/pack_frames.py) if Python was available
+ * at build time, loaded from in favor of the frames' own images if present
+ */
+const AssetInfo* spriteFramesAsset = &assetManifest[kAssetTexturesNasaTheBlueMarbleLsOcSic20020208];
+#define NUM_BITMAP_PATHS kAssetTexturesNasaTheBlueMarbleLsOcSic20020208Count
+_Static_assert(
+	kAssetTexturesNasaTheBlueMarbleLsOcSic20020208Width == LCD_COLUMNS && kAssetTexturesNasaTheBlueMarbleLsOcSic20020208Height == LCD_ROWS,
+	"the sprite's frames have to be screen-sized"
+);
+/** The frame pack's encoded frames (kept resident to decode frames from on demand), if there is one */
+FramePack framePack;
+/** Frames of spriteInfos kept loaded in each direction of the current one */
+#define SPRITE_CACHE_RADIUS 2
+/** Maximum number of frames of spriteInfos loaded at once (at least 2 * SPRITE_CACHE_RADIUS + 1) */
+#define SPRITE_CACHE_BUDGET 6
+/** The loaded frames (bitmaps) of spriteInfos, indexed like spriteInfos */
+BitmapCache spriteBitmapCache;
 typedef struct {
 	int id;
 	PDRect rect;
-	LCDBitmap* bitmap;
 } SpriteInfo;
-SpriteInfo spriteInfos[NUM_BITMAP_PATHS] = {
-	{ 1, { 0.0f, 0.0f, 400.0f, 240.0f }, NULL },
-	{ 2, { 0.0f, 0.0f, 400.0f, 240.0f }, NULL },
-	{ 3, { 0.0f, 0.0f, 400.0f, 240.0f }, NULL },
-	{ 4, { 0.0f, 0.0f, 400.0f, 240.0f }, NULL },
-	{ 5, { 0.0f, 0.0f, 400.0f, 240.0f }, NULL },
-	{ 6, { 0.0f, 0.0f, 400.0f, 240.0f }, NULL },
-	{ 7, { 0.0f, 0.0f, 400.0f, 240.0f }, NULL },
-	{ 8, { 0.0f, 0.0f, 400.0f, 240.0f }, NULL }
-};
+/** (filled in from spriteFramesAsset's frames at init: id is the frame's asset ID, rect its size at the origin) */
+SpriteInfo spriteInfos[NUM_BITMAP_PATHS];
 SpriteInfo* spriteInfoCurr;
 SpriteInfo* spriteInfoPrev;
 SpriteInfo* spriteInfoTemp;
-/** The rendered sprite */
-LCDSprite* sprite = NULL;
+/** The steps prefetchSpriteFrames() took so far */
+int spritePrefetchSteps = 0;
+/** spriteInfoCurr's bitmap (owned by spriteBitmapCache) */
+LCDBitmap* spriteBitmapCurr = NULL;
+/**
+ * If 1, crank rotation in between two frames of spriteInfos is shown as dithered in-between frames of the two
+ * (see frame_blend.h), instead of snapping from frame to frame.
+ */
+int interpolateFrames = 1;
+/** How far spriteImageCurr is in between spriteInfoCurr's frame and the next, in [0, FRAME_BLEND_LEVELS); 0 is spriteInfoCurr's frame itself */
+int spriteBlendLevel = 0;
+/** The recently shown in-between frames */
+FrameBlendRing spriteBlendRing;
+/** The image shown for the sprite: spriteBitmapCurr, or an in-between frame from spriteBlendRing (or globeBitmap) */
+LCDBitmap* spriteImageCurr = NULL;
+
+/**
+ * If 1, the sprite is a globe rendered from one map (see globe_renderer.h) at whatever angle the crank turns it to (a
+ * degree of rotation per degree cranked), instead of spriteInfos' frames, which aren't loaded then: one map and a table
+ * in place of a bitmap per frame.
+ */
+int proceduralGlobe = 0;
+/** The globe's equirectangular map (made from spriteFramesAsset's frames by scripts/unwrap_globe.py) */
+const AssetInfo* globeMapAsset = &assetManifest[kAssetTexturesNasaTheBlueMarbleLsOcSic20020208Map1Bit];
+/** The globe's disc on screen: where the frames show it (as fitted by scripts/unwrap_globe.py) */
+#define GLOBE_CENTER_X 198
+#define GLOBE_CENTER_Y 120
+#define GLOBE_RADIUS 106
+/** The size of the globe's pixels: 1 samples the map per screen pixel; 2 per 2x2 pixels, at a quarter of the cost */
+#define GLOBE_SCALE 1
+/** The map's longitude per degree of imageRotation: -1 as the frames turn (the Earth's own way, see scripts/unwrap_globe.py) */
+#define GLOBE_TURN -1
+LCDBitmap* globeMap = NULL;
+GlobeRenderer globe;
+/** The screen-sized image the globe is rendered into (black around the disc), shown as spriteImageCurr */
+LCDBitmap* globeBitmap = NULL;
+/** The crank rotation not yet turned into whole degrees of imageRotation */
+float globeCrank = 0.0f;
+/** The rotation (within [0, 360)) rendered into globeBitmap (-1: none yet) */
+int globeRotation = -1;
+/**
+ * The scene drawn through the sprite system (if redrawOnChangeOnly is 0): the sprite, the text box over it, and
+ * overlays over both, each only updated (and redrawn) when changed.
+ */
+Scene scene;
+SceneNode* spriteNode = NULL;
+SceneNode* textBoxNode = NULL;
+enum {
+	kSceneLayerSprite,
+	kSceneLayerTextBox,
+	kSceneLayerOverlay
+};
 
 /**
  * The screen position of helloText's origin.
@@ -112,6 +214,59 @@ int textPosition = 2;
 int textX = 0;
 /** helloText's origin's y coordinate on screen */
 int textY = 0;
+/** The number of textPosition values */
+#define NUM_TEXT_POSITIONS 4
+/** The width of the text box's frame (black border plus white padding) around helloText */
+#define TEXT_BOX_MARGIN 6
+/** helloText's origin on screen ({ x, y }) per textPosition; computed along with textBoxBitmap */
+int textOrigins[NUM_TEXT_POSITIONS][2];
+/** helloText in its frame, pre-rendered once (and re-rendered only if the font, string or tracking changes) */
+LCDBitmap* textBoxBitmap = NULL;
+/** The font textBoxBitmap was rendered with */
+LCDFont* textBoxFont = NULL;
+/** The string textBoxBitmap was rendered with */
+const char* textBoxText = NULL;
+/** The tracking textBoxBitmap was rendered with */
+int textBoxTracking = 0;
+
+/**
+ * The map viewer, toggled by pressing A and B together: the largest Blue Marble image, streamed from its tile set (see
+ * tile_set.h) into a tile cache of a fixed RAM budget, panned with the D-pad and zoomed through its levels (full and
+ * half resolution) with the crank. The tile set is opened on first use and kept open until exit.
+ */
+const AssetInfo* mapAsset = &assetManifest[kAssetTexturesTheBlueMarble19721bit600x360Tiles];
+/** The map viewer's RAM budget: mapArena's size, holding the tile set's index and as many cached tiles as fit */
+#define MAP_MEMORY_BUDGET (24 * 1024)
+/** The most tiles read per frame; tiles past it are drawn in the background color until read on the following frames */
+#define MAP_TILE_LOADS_PER_FRAME 24
+/** The tiles loaded ahead around the view, per side (where panning reaches next) */
+#define MAP_PREFETCH_MARGIN 1
+/** The pixels (of the level shown) panned per frame while the D-pad is held */
+#define MAP_PAN_SPEED 6
+/** The crank rotation per zoom step, in degrees */
+#define MAP_ZOOM_CRANK 45.0f
+MemoryArena mapArena;
+TileSet mapTiles;
+/** 1 once mapTiles was opened */
+int mapOpened = 0;
+/** If 1, the map viewer is shown instead of the sprite and the text box */
+int mapShows = 0;
+/** The level shown: 0 is full resolution, each one after half the one before */
+int mapLevel = 0;
+/** The view's center, in level 0's pixels */
+int mapCenterX = 0;
+int mapCenterY = 0;
+/** The crank rotation toward the next zoom step */
+float mapZoomCrank = 0.0f;
+/** The level and view (its top left corner in the level's pixels) last drawn, and 1 if all its tiles were drawn */
+int renderedMapLevel = -1;
+int renderedMapX = 0;
+int renderedMapY = 0;
+int renderedMapComplete = 0;
+/** The mapShows state last drawn to the frame buffer */
+int renderedMapShows = 0;
+/** The buttons down, as of the input events handled so far (for telling A and B pressed together) */
+PDButtons buttonsDown = 0;
 
 float prevCrankAngle = 0.0f;
 float crankAngle = 0.0f;
@@ -124,26 +279,810 @@ int imageRotation = 0;
 /** The current index into spriteInfos, mapped from imageRotation to a sprite. Valid range of [0, NUM_BITMAP_PATHS) */
 int spriteIndexImageRotation = 0;
 
-/** The previous frame's button input state */
-PDButtons btnsPrev;
-/** The current frame's button input state */
-PDButtons btnsCurr;
-PDButtons btnsUpdateDown;
-PDButtons btnsUpdateUp;
+/** The input (buttons, crank, menu items) since the last frame, as events in the order they happened (see handleInputEvent()) */
+InputQueue inputQueue;
+/** The D-pad repeats while held: after INPUT_REPEAT_DELAY, then every INPUT_REPEAT_INTERVAL (in milliseconds) */
+#define INPUT_REPEAT_BUTTONS (kButtonLeft | kButtonRight | kButtonUp | kButtonDown)
+#define INPUT_REPEAT_DELAY 300
+#define INPUT_REPEAT_INTERVAL 100
+/**
+ * inputQueue's input trace: replayed in place of the live input from inputTraceReplayPath if there's such a file (in
+ * the data directory, or the game's package); otherwise, if built with INPUT_TRACE_RECORD, recorded to
+ * inputTraceRecordPath in the data directory
+ */
+InputTrace inputTrace;
+const char* inputTraceReplayPath = "input_replay.pdtrace";
+const char* inputTraceRecordPath = "input_record.pdtrace";
+/** The menu items whose changes come through inputQueue (as an InputEvent's item) */
+enum {
+	kMenuItemShowText,
+	kMenuItemProfiler
+};
 
 /** If 1, helloText will be rendered; otherwise, if 0 then will not be. */
 int textShows = 1;
 PDMenuItem* showTextMenuItemCheckmark;
 char* showTextMenuItemLabel = NULL;
 
+/**
+ * If 1, update() only redraws when something visible changed: it returns 0 (no display update) on unchanged frames,
+ * and otherwise redraws just the affected frame buffer rows, written through getFrame()/markUpdatedRows().
+ * If 0, the scene is drawn through the sprite system, which redraws the dirty rects of what changed (the host bench's
+ * --sprite-path, which checks both draw the same frames).
+ */
+int redrawOnChangeOnly = 1;
+/** The display refresh rate while there is input */
+#define REFRESH_RATE_ACTIVE 30.0f
+/** The display refresh rate once idle, i.e. no input for IDLE_FRAMES_BEFORE_THROTTLE frames; low enough to let the CPU sleep, high enough to pick up input promptly */
+#define REFRESH_RATE_IDLE 10.0f
+#define IDLE_FRAMES_BEFORE_THROTTLE 30
+/** The number of consecutive frames without any input */
+int idleFrames = 0;
+float refreshRate = REFRESH_RATE_ACTIVE;
+
+/** The sprite last drawn to the frame buffer (NULL if nothing was drawn yet) */
+SpriteInfo* renderedSpriteInfo = NULL;
+/** The spriteBlendLevel last drawn to the frame buffer */
+int renderedBlendLevel = 0;
+/** The globeRotation last drawn to the frame buffer */
+int renderedGlobeRotation = -1;
+/** The textPosition last drawn to the frame buffer */
+int renderedTextPosition = -1;
+/** The textShows state last drawn to the frame buffer */
+int renderedTextShows = -1;
+/** Per-row flags of frame buffer rows that need redrawing this frame */
+uint8_t rowsDirty[LCD_ROWS];
+/** Per-row flags of frame buffer rows patched with a sprite delta this frame */
+uint8_t rowsPatched[LCD_ROWS];
+/** The frame buffer rows at the top covered by drawFPS(0,0); redrawn rather than patched */
+#define FPS_ROWS 12
+/** The largest delta between two frames of spriteInfos, in percent of a frame's words, that is applied instead of redrawing the frame */
+#define SPRITE_DELTA_MAX_PERCENT 60
+/** The deltas between neighbouring frames of spriteInfos (spriteDeltas[i]: frames i and i + 1, wrapping around); computed on first use */
+FrameDelta spriteDeltas[NUM_BITMAP_PATHS];
+/** assetArena's room for spriteDeltas: enough for all of them at SPRITE_DELTA_MAX_PERCENT (deltas that don't fit would be redrawn instead) */
+#define SPRITE_DELTA_ARENA_SIZE \
+	(NUM_BITMAP_PATHS * MEMORY_ARENA_ROOM(LCD_ROWS * sizeof(FrameDeltaSpan) + SPRITE_DELTA_MAX_PERCENT * LCD_ROWSIZE * LCD_ROWS / 100))
+
+#if FRAME_PROFILER_ENABLED
+/** The sections of update() timed by frameProfiler */
+enum {
+	kProfileInput,
+	kProfileSprite,
+	kProfileDraw,
+	kProfileText,
+	kProfileAudio,
+	kProfileLoad,
+	kNumProfileSections
+};
+const char* const profileSectionNames[kNumProfileSections] = { "input", "sprite", "draw", "text", "audio", "load" };
+FrameProfiler frameProfiler;
+const char* profilerFontPath = "/System/Fonts/Roobert-10-Bold.pft";
+/** The overlay's font (the game's font if the system font couldn't be loaded) */
+LCDFont* profilerFont = NULL;
+/** Draws the overlay's text in profilerFont */
+FontBlitter profilerText;
+/** If 1, the frame profiler's summary is shown at the bottom of the screen (toggled from the system menu) */
+int profilerOverlayShows = 0;
+PDMenuItem* profilerMenuItemCheckmark;
+/** The topmost frame buffer row of the overlay */
+int profilerOverlayTop = LCD_ROWS;
+/** 1 if the summary changed since the overlay was last drawn */
+int profilerOverlayDue = 0;
+/** The overlay's node of scene */
+SceneNode* profilerOverlayNode = NULL;
+/** The profilerOverlayShows state last drawn to the frame buffer */
+int renderedProfilerOverlayShows = 0;
+#endif
+
+#if MEMORY_TRACKER_ENABLED
+PDMenuItem* memoryMenuItem;
+#endif
+
 
 /**
  * Callback for Playdate API system menu user interaction, invoked by system menu user interaction.
  */
 static void systemMenuItemCallback(void* userdata) {
-	textShows = pd->system->getMenuItemValue(showTextMenuItemCheckmark);
+	inputQueuePushMenu(pd, &inputQueue, kMenuItemShowText, pd->system->getMenuItemValue(showTextMenuItemCheckmark));
+}
+
+#if MEMORY_TRACKER_ENABLED
+static void memoryMenuItemCallback(void* userdata) {
+	memoryTrackerLogReport(pd);
+}
+#endif
+
+#if FRAME_PROFILER_ENABLED
+static void profilerMenuItemCallback(void* userdata) {
+	inputQueuePushMenu(pd, &inputQueue, kMenuItemProfiler, pd->system->getMenuItemValue(profilerMenuItemCheckmark));
+}
+
+/**
+ * Flags the frame buffer rows of the profiler overlay as needing redraw.
+ */
+static void markProfilerOverlayRowsDirty(void) {
+	memset(rowsDirty + profilerOverlayTop, 1, LCD_ROWS - profilerOverlayTop);
+}
+
+/**
+ * Draws the profiler overlay over the bottom of the screen.
+ */
+static void drawProfilerOverlay(void) {
+	frameProfilerDrawOverlay(pd, &frameProfiler, (profilerFont != NULL) ? &profilerText : NULL, profilerOverlayTop);
+	profilerOverlayDue = 0;
+}
+
+/**
+ * LCDSpriteDrawFunction for profilerOverlayNode.
+ */
+static void drawProfilerOverlaySprite(LCDSprite* sprite, PDRect bounds, PDRect drawrect) {
+	drawProfilerOverlay();
+}
+#endif
+
+/**
+ * Computes helloText's origin on screen for a textPosition (see textPosition for values).
+ */
+static void computeTextOrigin(int position, int* x, int* y) {
+	if (position == 0) {
+		*x = LCD_COLUMNS / 2 - textWidth / 2;
+		*y = 10;
+	}
+	else if (position == 1) {
+		*x = LCD_COLUMNS - textWidth - 10;
+		*y = LCD_ROWS / 2 - textHeight / 2;
+	}
+	else if (position == 2) {
+		*x = LCD_COLUMNS / 2 - textWidth / 2;
+		*y = LCD_ROWS - textHeight - 10;
+	}
+	else {
+		*x = 10;
+		*y = LCD_ROWS / 2 - textHeight / 2;
+	}
+}
+
+/**
+ * Looks up helloText's origin on screen for a textPosition in textOrigins.
+ */
+static void getTextOrigin(int position, int* x, int* y) {
+	*x = textOrigins[position][0];
+	*y = textOrigins[position][1];
+}
+
+/**
+ * (Re-)renders helloText and its frame into textBoxBitmap, and recomputes textOrigins, if the font, string or tracking
+ * changed since it was last rendered.
+ *
+ * @return 1 if re-rendered; otherwise 0
+ */
+static int updateTextBox(void) {
+	if (textBoxBitmap != NULL && textBoxFont == font && textBoxText == helloText && textBoxTracking == fontTracking) {
+		return 0;
+	}
+	textBoxFont = font;
+	textBoxText = helloText;
+	textBoxTracking = fontTracking;
+	
+	int textLength = strlen(helloText);
+	textHeight = pd->graphics->getFontHeight(font);
+	textWidth = pd->graphics->getTextWidth(font, helloText, textLength, kASCIIEncoding, fontTracking);
+	for (int position = 0; position < NUM_TEXT_POSITIONS; position++) {
+		computeTextOrigin(position, &textOrigins[position][0], &textOrigins[position][1]);
+	}
+	
+	if (textBoxBitmap != NULL) {
+		pd->graphics->freeBitmap(textBoxBitmap);
+	}
+	textBoxBitmap = pd->graphics->newBitmap(textWidth + 2 * TEXT_BOX_MARGIN, textHeight + 2 * TEXT_BOX_MARGIN, kColorBlack);
+	if (textBoxBitmap == NULL) {
+		pd->system->error("%s:%i Error allocating text box bitmap", __FILE__, __LINE__);
+		return 1;
+	}
+	pd->graphics->pushContext(textBoxBitmap);
+	pd->graphics->setFont(font);
+	pd->graphics->setTextTracking(fontTracking);
+	pd->graphics->fillRect(2, 2, textWidth + 8, textHeight + 8, kColorWhite);
+	pd->graphics->drawText(helloText, textLength, kASCIIEncoding, TEXT_BOX_MARGIN, TEXT_BOX_MARGIN);
+	pd->graphics->popContext();
+	return 1;
 }
 
+/**
+ * Renders helloText and its frame at textPosition (blits textBoxBitmap).
+ */
+static void drawTextBox(void) {
+	getTextOrigin(textPosition, &textX, &textY);
+	if (textBoxBitmap != NULL) {
+		pd->graphics->drawBitmap(textBoxBitmap, textX - TEXT_BOX_MARGIN, textY - TEXT_BOX_MARGIN, kBitmapUnflipped);
+	}
+}
+
+/**
+ * Flags the frame buffer rows covered by the text box (incl. its frame) at a textPosition as needing redraw.
+ */
+static void markTextBoxRowsDirty(int position) {
+	int x, y;
+	getTextOrigin(position, &x, &y);
+	for (int row = y - TEXT_BOX_MARGIN; row < y + textHeight + TEXT_BOX_MARGIN; row++) {
+		if (row >= 0 && row < LCD_ROWS) {
+			rowsDirty[row] = 1;
+		}
+	}
+}
+
+/**
+ * Redraws frame buffer rows [top, bottom]: the current sprite's rows are copied straight into the frame buffer
+ * and flushed with markUpdatedRows(), then the text box is drawn over them (clipped to the rows).
+ */
+static void redrawRows(int top, int bottom) {
+	int width = 0, height = 0, rowbytes = 0;
+	uint8_t* mask = NULL;
+	uint8_t* data = NULL;
+	if (spriteImageCurr != NULL) { // (NULL if the frame failed to load)
+		pd->graphics->getBitmapData(spriteImageCurr, &width, &height, &rowbytes, &mask, &data);
+	}
+	
+	int spriteX = (int)spriteInfoCurr->rect.x;
+	int spriteY = (int)spriteInfoCurr->rect.y;
+	
+	pd->graphics->setClipRect(0, top, LCD_COLUMNS, bottom - top + 1);
+	
+	if (mask == NULL && spriteX == 0 && width == LCD_COLUMNS) {
+		// fast path: a screen-wide, opaque image's rows map 1:1 onto frame buffer rows
+		uint8_t* frame = pd->graphics->getFrame();
+		for (int row = top; row <= bottom; row++) {
+			if (row >= spriteY && row < spriteY + height) {
+				memcpy(frame + row * LCD_ROWSIZE, data + (row - spriteY) * rowbytes, LCD_COLUMNS / 8);
+			}
+			else {
+				memset(frame + row * LCD_ROWSIZE, 0xff, LCD_COLUMNS / 8);
+			}
+		}
+		pd->graphics->markUpdatedRows(top, bottom);
+	}
+	else {
+		pd->graphics->fillRect(0, top, LCD_COLUMNS, bottom - top + 1, kColorWhite);
+		if (spriteImageCurr != NULL) {
+			pd->graphics->drawBitmap(spriteImageCurr, spriteX, spriteY, kBitmapUnflipped);
+		}
+	}
+	
+	if (textShows) {
+		drawTextBox();
+	}
+	
+	pd->graphics->clearClipRect();
+}
+
+/**
+ * @return 1 if the image of frame index at blend level is frame pair's (pair and pair + 1) frame, or in between them
+ */
+static int isInFramePair(int index, int level, int pair) {
+	return index == pair || (level == 0 && index == (pair + 1) % NUM_BITMAP_PATHS);
+}
+
+/**
+ * Switches the frame buffer from the rendered sprite image to spriteImageCurr, if both are of (or in between) the same
+ * two neighbouring frames: they then only differ where these two frames do, so just the words of the delta between
+ * them are XOR'ed in (both neighbouring frames) or copied in (otherwise), and their rows flushed with
+ * markUpdatedRows(). Rows under the text box (before and after), the FPS counter and the profiler overlay are flagged in
+ * rowsDirty to be redrawn instead.
+ *
+ * @return 1 if patched; 0 if the frame has to be redrawn instead (images not of neighbouring frames or not loaded,
+ * delta too large, or frames that aren't screen-wide, opaque images at the origin)
+ */
+static int patchSpriteRows(void) {
+	if (renderedSpriteInfo == NULL || spriteImageCurr == NULL) {
+		return 0;
+	}
+	
+	int rendered = renderedSpriteInfo - spriteInfos;
+	int curr = spriteInfoCurr - spriteInfos;
+	int deltaIndex;
+	if (isInFramePair(curr, spriteBlendLevel, rendered)) {
+		deltaIndex = rendered;
+	}
+	else if (renderedBlendLevel == 0 && isInFramePair(curr, spriteBlendLevel, (rendered + NUM_BITMAP_PATHS - 1) % NUM_BITMAP_PATHS)) {
+		deltaIndex = (rendered + NUM_BITMAP_PATHS - 1) % NUM_BITMAP_PATHS;
+	}
+	else {
+		return 0;
+	}
+	if (
+		renderedSpriteInfo->rect.x != 0.0f || renderedSpriteInfo->rect.y != 0.0f ||
+		spriteInfoCurr->rect.x != 0.0f || spriteInfoCurr->rect.y != 0.0f
+	) {
+		return 0;
+	}
+	
+	FrameDelta* delta = &spriteDeltas[deltaIndex];
+	if (delta->computed == 0) {
+		LCDBitmap* a = bitmapCachePeek(&spriteBitmapCache, deltaIndex);
+		LCDBitmap* b = bitmapCachePeek(&spriteBitmapCache, (deltaIndex + 1) % NUM_BITMAP_PATHS);
+		if (a == NULL || b == NULL) {
+			return 0; // (try again once both are loaded)
+		}
+		
+		int width, height, rowbytes;
+		uint8_t* mask;
+		uint8_t* data;
+		pd->graphics->getBitmapData(a, &width, &height, &rowbytes, &mask, &data);
+		if (width != LCD_COLUMNS || height > LCD_ROWS || rowbytes > LCD_ROWSIZE) {
+			delta->computed = 1;
+			delta->full = 1;
+		}
+		else {
+			frameDeltaCompute(pd, delta, a, b, SPRITE_DELTA_MAX_PERCENT * (rowbytes / 4) * height / 100, &assetArena);
+		}
+	}
+	if (delta->full) {
+		return 0;
+	}
+	
+	memset(rowsDirty, 1, FPS_ROWS);
+#if FRAME_PROFILER_ENABLED
+	if (profilerOverlayShows || renderedProfilerOverlayShows) {
+		markProfilerOverlayRowsDirty();
+	}
+#endif
+	if (renderedTextShows == 1) {
+		markTextBoxRowsDirty(renderedTextPosition);
+	}
+	if (textShows) {
+		markTextBoxRowsDirty(textPosition);
+	}
+	
+	memset(rowsPatched, 0, sizeof(rowsPatched));
+	if (renderedBlendLevel == 0 && spriteBlendLevel == 0) {
+		frameDeltaApply(delta, pd->graphics->getFrame(), LCD_ROWSIZE, rowsDirty, rowsPatched);
+	}
+	else {
+		int width, height, rowbytes;
+		uint8_t* mask;
+		uint8_t* data;
+		pd->graphics->getBitmapData(spriteImageCurr, &width, &height, &rowbytes, &mask, &data);
+		frameDeltaCopy(delta, pd->graphics->getFrame(), LCD_ROWSIZE, data, rowbytes, rowsDirty, rowsPatched);
+	}
+	for (int row = 0; row < LCD_ROWS; row++) {
+		if (rowsPatched[row]) {
+			int top = row;
+			while (row + 1 < LCD_ROWS && rowsPatched[row + 1]) {
+				row++;
+			}
+			pd->graphics->markUpdatedRows(top, row);
+		}
+	}
+	return 1;
+}
+
+/**
+ * Flags the frame buffer rows of the globe's disc as needing redraw.
+ */
+static void markGlobeRowsDirty(void) {
+	int top = GLOBE_CENTER_Y - globe.radius;
+	int bottom = GLOBE_CENTER_Y + globe.radius;
+	top = (top > 0) ? top : 0;
+	bottom = (bottom < LCD_ROWS) ? bottom : LCD_ROWS;
+	if (top < bottom) {
+		memset(rowsDirty + top, 1, bottom - top);
+	}
+}
+
+/**
+ * Tracks input activity and drops the display refresh rate while idle, restoring it as soon as there is input.
+ */
+static void updateRefreshRate(int inputActive) {
+	idleFrames = inputActive ? 0 : idleFrames + 1;
+	
+	float rate = (idleFrames >= IDLE_FRAMES_BEFORE_THROTTLE) ? REFRESH_RATE_IDLE : REFRESH_RATE_ACTIVE;
+	if (rate != refreshRate) {
+		refreshRate = rate;
+		pd->display->setRefreshRate(refreshRate);
+	}
+}
+
+/**
+ * Opens the map's tile set into mapArena (the map viewer's whole RAM budget), showing the whole image: the view
+ * centered, at the first level that fits on the screen (or the last).
+ *
+ * @return 1 on success; otherwise 0 (the viewer is then not shown)
+ */
+static int openMap(void) {
+	MEMORY_TAG(kMemoryTagTextures);
+	const char* outErr = NULL;
+	int opened =
+		memoryArenaInit(pd, &mapArena, MAP_MEMORY_BUDGET) &&
+		tileSetOpen(pd, &mapTiles, mapAsset->path, &mapArena, &outErr);
+	MEMORY_TAG(kMemoryTagOther);
+	if (opened == 0) {
+		pd->system->error("%s:%i Error opening tile set, path=%s, error=%s", __FILE__, __LINE__, mapAsset->path, outErr != NULL ? outErr : "out of memory");
+		memoryArenaFree(pd, &mapArena);
+		return 0;
+	}
+	
+	// (the budget should hold at least the tiles of a view that isn't aligned to tiles)
+	int viewTiles = (LCD_COLUMNS / mapTiles.tileSize + 2) * (LCD_ROWS / mapTiles.tileSize + 2);
+	if (mapTiles.slotCount < viewTiles) {
+		pd->system->logToConsole("map: %i tiles fit in MAP_MEMORY_BUDGET, a view takes up to %i", mapTiles.slotCount, viewTiles);
+	}
+	
+	mapOpened = 1;
+	mapCenterX = mapTiles.width / 2;
+	mapCenterY = mapTiles.height / 2;
+	mapLevel = mapTiles.levelCount - 1;
+	while (mapLevel > 0 && mapTiles.levels[mapLevel - 1].width <= LCD_COLUMNS && mapTiles.levels[mapLevel - 1].height <= LCD_ROWS) {
+		mapLevel--;
+	}
+	return 1;
+}
+
+/**
+ * Computes the view of the map at a level around mapCenterX/Y (its top left corner, in the level's pixels): kept within
+ * the level where the level is larger than the screen, and centered where it is smaller.
+ */
+static void getMapView(int levelIndex, int* x, int* y) {
+	const TileSetLevel* level = &mapTiles.levels[levelIndex];
+	*x = (mapCenterX >> levelIndex) - LCD_COLUMNS / 2;
+	*y = (mapCenterY >> levelIndex) - LCD_ROWS / 2;
+	if (level->width <= LCD_COLUMNS) {
+		*x = (level->width - LCD_COLUMNS) / 2;
+	}
+	else if (*x < 0 || *x > level->width - LCD_COLUMNS) {
+		*x = (*x < 0) ? 0 : level->width - LCD_COLUMNS;
+	}
+	if (level->height <= LCD_ROWS) {
+		*y = (level->height - LCD_ROWS) / 2;
+	}
+	else if (*y < 0 || *y > level->height - LCD_ROWS) {
+		*y = (*y < 0) ? 0 : level->height - LCD_ROWS;
+	}
+}
+
+/**
+ * Pans the map by MAP_PAN_SPEED pixels of the level shown in the directions of the D-pad buttons held, up to the
+ * image's edges (so panning past an edge doesn't build up).
+ */
+static void panMap(PDButtons held) {
+	int step = MAP_PAN_SPEED << mapLevel;
+	mapCenterX += ((held & kButtonRight) ? step : 0) - ((held & kButtonLeft) ? step : 0);
+	mapCenterY += ((held & kButtonDown) ? step : 0) - ((held & kButtonUp) ? step : 0);
+	mapCenterX = (mapCenterX < 0) ? 0 : (mapCenterX > mapTiles.width ? mapTiles.width : mapCenterX);
+	mapCenterY = (mapCenterY < 0) ? 0 : (mapCenterY > mapTiles.height ? mapTiles.height : mapCenterY);
+	
+	int x, y;
+	getMapView(mapLevel, &x, &y);
+	if (mapTiles.levels[mapLevel].width > LCD_COLUMNS) {
+		mapCenterX = (x + LCD_COLUMNS / 2) << mapLevel;
+	}
+	if (mapTiles.levels[mapLevel].height > LCD_ROWS) {
+		mapCenterY = (y + LCD_ROWS / 2) << mapLevel;
+	}
+}
+
+/**
+ * Draws the map viewer straight into the frame buffer (with the profiler overlay over it, if shown): all of the view if
+ * it moved, changed level or had tiles missing, otherwise only the overlay's rows if it is due. Then prefetches the
+ * tiles around the view, and the neighbouring levels' views, with what's left of the frame's tile loads.
+ *
+ * @return 1 if anything was drawn (the display needs an update); otherwise 0
+ */
+static int drawMap(void) {
+	tileSetBeginFrame(&mapTiles, MAP_TILE_LOADS_PER_FRAME);
+	int x, y;
+	getMapView(mapLevel, &x, &y);
+	
+	int top = LCD_ROWS;
+	if (renderedMapShows == 0 || mapLevel != renderedMapLevel || x != renderedMapX || y != renderedMapY || renderedMapComplete == 0) {
+		top = 0;
+	}
+#if FRAME_PROFILER_ENABLED
+	if ((profilerOverlayShows != renderedProfilerOverlayShows || (profilerOverlayShows && profilerOverlayDue)) && profilerOverlayTop < top) {
+		top = profilerOverlayTop;
+	}
+#endif
+	
+	if (top < LCD_ROWS) {
+		int complete = tileSetDraw(pd, &mapTiles, mapLevel, x, y + top, LCD_COLUMNS, LCD_ROWS - top, pd->graphics->getFrame(), LCD_ROWSIZE, top);
+		renderedMapComplete = (top == 0) ? complete : (renderedMapComplete && complete);
+		pd->graphics->markUpdatedRows(top, LCD_ROWS - 1);
+#if FRAME_PROFILER_ENABLED
+		if (profilerOverlayShows) {
+			drawProfilerOverlay();
+		}
+#endif
+		renderedMapLevel = mapLevel;
+		renderedMapX = x;
+		renderedMapY = y;
+	}
+#if FRAME_PROFILER_ENABLED
+	renderedProfilerOverlayShows = profilerOverlayShows;
+#endif
+	renderedMapShows = 1;
+	
+	tileSetPrefetch(pd, &mapTiles, mapLevel, x, y, LCD_COLUMNS, LCD_ROWS, MAP_PREFETCH_MARGIN);
+	for (int level = mapLevel - 1; level <= mapLevel + 1; level += 2) {
+		if (level >= 0 && level < mapTiles.levelCount) {
+			getMapView(level, &x, &y);
+			tileSetPrefetch(pd, &mapTiles, level, x, y, LCD_COLUMNS, LCD_ROWS, 0);
+		}
+	}
+	return top < LCD_ROWS;
+}
+
+/**
+ * BitmapCacheLoadFunction for spriteBitmapCache: decodes a frame from framePack (from an adjacent frame if one is
+ * loaded, otherwise from its key frame), or without a frame pack, loads it from its own image.
+ */
+static LCDBitmap* loadSpriteBitmap(PlaydateAPI* pd, int index, LCDBitmap* reuse, void* userdata) {
+	(void)userdata;
+	
+	if (framePack.buffer == NULL) {
+		const char* path = assetManifest[spriteInfos[index].id].path;
+		const char* outErr = NULL;
+		if (reuse != NULL) {
+			pd->graphics->loadIntoBitmap(path, reuse, &outErr);
+		}
+		LCDBitmap* bitmap = (reuse != NULL && outErr == NULL) ? reuse : pd->graphics->loadBitmap(path, &outErr);
+		if (bitmap == NULL) {
+			pd->system->error("%s:%i Error loading bitmap[%i], path=%s, error=%s", __FILE__, __LINE__, index, path, outErr);
+		}
+		if (reuse != NULL && bitmap != reuse) {
+			pd->graphics->freeBitmap(reuse);
+		}
+		return bitmap;
+	}
+	
+	LCDBitmap* bitmap = (reuse != NULL) ? reuse : pd->graphics->newBitmap(framePack.width, framePack.height, kColorWhite);
+	if (bitmap == NULL) {
+		return NULL;
+	}
+	LCDBitmap* prev = bitmapCachePeek(&spriteBitmapCache, index - 1);
+	LCDBitmap* next = bitmapCachePeek(&spriteBitmapCache, index + 1);
+	int decoded =
+		(prev != NULL && framePackDecodeFrameFrom(pd, &framePack, index, prev, index - 1, bitmap)) ||
+		(next != NULL && framePackDecodeFrameFrom(pd, &framePack, index, next, index + 1, bitmap)) ||
+		framePackDecodeFrame(pd, &framePack, index, bitmap);
+	if (decoded == 0) {
+		pd->system->error("%s:%i Error decoding frame pack frame[%i], path=%s", __FILE__, __LINE__, index, spriteFramesAsset->path);
+		pd->graphics->freeBitmap(bitmap);
+		return NULL;
+	}
+	return bitmap;
+}
+
+
+/**
+ * AssetLoaderStepFunction: loads the font (text is measured and rendered in updateTextBox(), on the first update).
+ */
+static int loadFont(PlaydateAPI* pd, void* userdata) {
+	(void)userdata;
+	
+	MEMORY_TAG(kMemoryTagFont);
+	const char* err;
+	font = pd->graphics->loadFont(fontAsset->path, &err);
+	if ( font == NULL ) {
+		pd->system->error("%s:%i Error loading font, path=%s: %s", __FILE__, __LINE__, fontAsset->path, err);
+	}
+	pd->graphics->setFont(font);
+	fontTracking = pd->graphics->getTextTracking();
+	MEMORY_TAG(kMemoryTagOther);
+	return 1;
+}
+
+/**
+ * AssetLoaderStepFunction: sets up the sprite's frames: loaded on demand into spriteBitmapCache, decoded from the frame
+ * pack (read into assetArena, sized for it) if there is one, otherwise from one image file per frame.
+ */
+static int loadSpriteFrames(PlaydateAPI* pd, void* userdata) {
+	(void)userdata;
+	
+	MEMORY_TAG(kMemoryTagTextures);
+	for (int i = 0; i < NUM_BITMAP_PATHS; i++) {
+		spriteInfos[i].id = spriteFramesAsset->first + i;
+		spriteInfos[i].rect = PDRectMake(0.0f, 0.0f, spriteFramesAsset->width, spriteFramesAsset->height);
+	}
+	FileStat framePackStat;
+	int framePackFound = pd->file->stat(spriteFramesAsset->path, &framePackStat) == 0;
+	size_t assetArenaSize =
+		(framePackFound ? MEMORY_ARENA_ROOM(framePackStat.size) : 0) +
+		MEMORY_ARENA_ROOM(NUM_BITMAP_PATHS * sizeof(LCDBitmap*)) + MEMORY_ARENA_ROOM(NUM_BITMAP_PATHS * sizeof(uint32_t)) +
+		SPRITE_DELTA_ARENA_SIZE;
+	if (memoryArenaInit(pd, &assetArena, assetArenaSize) == 0) {
+		pd->system->error("%s:%i Error allocating asset arena, size=%u", __FILE__, __LINE__, (unsigned int)assetArenaSize);
+	}
+	if (framePackFound) {
+		const char* outErr;
+		size_t arenaMark = memoryArenaMark(&assetArena);
+		if (framePackLoad(pd, &framePack, spriteFramesAsset->path, &assetArena, &outErr) == 0) {
+			pd->system->error("%s:%i Error loading frame pack, path=%s, error=%s", __FILE__, __LINE__, spriteFramesAsset->path, outErr);
+		}
+		else if (framePack.frameCount != NUM_BITMAP_PATHS || framePack.width != spriteFramesAsset->width || framePack.height != spriteFramesAsset->height) {
+			pd->system->error(
+				"%s:%i Error loading frame pack, path=%s, error=%i frames of %ix%i, expected %i of %ix%i (stale build?)", __FILE__, __LINE__, spriteFramesAsset->path,
+				framePack.frameCount, framePack.width, framePack.height, NUM_BITMAP_PATHS, spriteFramesAsset->width, spriteFramesAsset->height
+			);
+			framePackFree(pd, &framePack);
+			memoryArenaRelease(&assetArena, arenaMark);
+		}
+	}
+	if (bitmapCacheInit(pd, &spriteBitmapCache, NUM_BITMAP_PATHS, SPRITE_CACHE_RADIUS, SPRITE_CACHE_BUDGET, loadSpriteBitmap, NULL, &assetArena) == 0) {
+		pd->system->error("%s:%i Error allocating sprite bitmap cache", __FILE__, __LINE__);
+	}
+	MEMORY_TAG(kMemoryTagOther);
+	return 1;
+}
+
+/**
+ * Creates the scene's nodes of the sprite and the text box (only drawn through the sprite system, so not if
+ * redrawOnChangeOnly).
+ */
+static void addSpriteNodes(void) {
+	if (redrawOnChangeOnly) {
+		return;
+	}
+	
+	MEMORY_TAG(kMemoryTagSprites);
+	spriteNode = sceneAddNode(pd, &scene, kSceneLayerSprite, NULL);
+	textBoxNode = sceneAddNode(pd, &scene, kSceneLayerTextBox, NULL);
+	if (spriteNode == NULL || textBoxNode == NULL) {
+		pd->system->error("%s:%i Error allocating sprites", __FILE__, __LINE__);
+	}
+}
+
+/**
+ * AssetLoaderStepFunction: loads the sprite's first frame (only; its neighbours are left to prefetchSpriteFrames()) and
+ * creates the sprite showing it.
+ */
+static int loadFirstSpriteFrame(PlaydateAPI* pd, void* userdata) {
+	(void)userdata;
+	
+	MEMORY_TAG(kMemoryTagTextures);
+	spriteInfoCurr = &spriteInfos[0];
+	spriteBitmapCurr = bitmapCacheSetCenter(pd, &spriteBitmapCache, 0);
+	spriteImageCurr = spriteBitmapCurr;
+	frameBlendRingInit(&spriteBlendRing);
+	
+	addSpriteNodes();
+	MEMORY_TAG(kMemoryTagOther);
+	return 1;
+}
+
+/**
+ * AssetLoaderStepFunction: sets up the procedural globe in place of the sprite's frames: loads its map, builds its
+ * renderer's table into assetArena (sized for it), and creates the sprite showing globeBitmap (rendered on the first
+ * update).
+ */
+static int loadGlobe(PlaydateAPI* pd, void* userdata) {
+	(void)userdata;
+	
+	MEMORY_TAG(kMemoryTagTextures);
+	spriteInfos[0].id = (int)(globeMapAsset - assetManifest);
+	spriteInfos[0].rect = PDRectMake(0.0f, 0.0f, LCD_COLUMNS, LCD_ROWS);
+	spriteInfoCurr = &spriteInfos[0];
+	
+	size_t assetArenaSize = globeRendererTableSize(GLOBE_RADIUS, GLOBE_SCALE);
+	if (memoryArenaInit(pd, &assetArena, assetArenaSize) == 0) {
+		pd->system->error("%s:%i Error allocating asset arena, size=%u", __FILE__, __LINE__, (unsigned int)assetArenaSize);
+	}
+	const char* outErr = NULL;
+	globeMap = pd->graphics->loadBitmap(globeMapAsset->path, &outErr);
+	if (globeMap == NULL) {
+		pd->system->error("%s:%i Error loading bitmap, path=%s, error=%s", __FILE__, __LINE__, globeMapAsset->path, outErr);
+	}
+	else if (globeRendererInit(pd, &globe, globeMap, GLOBE_RADIUS, GLOBE_SCALE, &assetArena) == 0) {
+		pd->system->error("%s:%i Error setting up globe renderer, path=%s, radius=%i, scale=%i", __FILE__, __LINE__, globeMapAsset->path, GLOBE_RADIUS, GLOBE_SCALE);
+	}
+	globeBitmap = pd->graphics->newBitmap(LCD_COLUMNS, LCD_ROWS, kColorBlack);
+	if (globeBitmap == NULL) {
+		pd->system->error("%s:%i Error allocating globe bitmap", __FILE__, __LINE__);
+	}
+	spriteImageCurr = globeBitmap;
+	
+	addSpriteNodes();
+	MEMORY_TAG(kMemoryTagOther);
+	return 1;
+}
+
+/**
+ * AssetLoaderStepFunction: loads the first frame's neighbours in spriteBitmapCache's window, one per step (unless the
+ * crank got there first: update() loads the window of the current frame right away).
+ */
+static int prefetchSpriteFrames(PlaydateAPI* pd, void* userdata) {
+	(void)userdata;
+	
+	MEMORY_TAG(kMemoryTagTextures);
+	int missing = bitmapCachePrefetch(pd, &spriteBitmapCache, 1);
+	MEMORY_TAG(kMemoryTagOther);
+	// (at most one try per neighbour, so frames that fail to load don't keep the loader busy)
+	return missing == 0 || ++spritePrefetchSteps >= 2 * SPRITE_CACHE_RADIUS;
+}
+
+/**
+ * AssetLoaderStepFunction: sets up the voices playing the sounds.
+ */
+static int loadSounds(PlaydateAPI* pd, void* userdata) {
+	(void)userdata;
+	
+	MEMORY_TAG(kMemoryTagSfx);
+	if (tonePlayerInit(pd, &soundTonePlayer, SOUND_VOICES, pd->sound->getDefaultChannel()) == 0) {
+		pd->system->error("%s:%i Error allocating sound voices", __FILE__, __LINE__);
+	}
+	MEMORY_TAG(kMemoryTagOther);
+	return 1;
+}
+
+/**
+ * AssetLoaderStepFunction: loads the music and starts it.
+ */
+static int loadMusic(PlaydateAPI* pd, void* userdata) {
+	(void)userdata;
+	
+	MEMORY_TAG(kMemoryTagMusic);
+	int musicFound = musicPlayerInit(pd, &music, musicAsset->path, MUSIC_BUFFER_LENGTH, pd->sound->getDefaultChannel());
+	if (musicFound == 0) {
+		pd->system->error("%s:%i Error loading music, path=%s", __FILE__, __LINE__, musicAsset->path);
+	}
+	musicPlayerStart(pd, &music); // (loops by itself from here on)
+	MEMORY_TAG(kMemoryTagOther);
+	return 1;
+}
+
+#if FRAME_PROFILER_ENABLED
+/**
+ * AssetLoaderStepFunction: loads the profiler overlay's font (falling back to the game's font) and fits the overlay to it.
+ */
+static int loadProfilerFont(PlaydateAPI* pd, void* userdata) {
+	(void)userdata;
+	
+	MEMORY_TAG(kMemoryTagFont);
+	profilerFont = pd->graphics->loadFont(profilerFontPath, NULL);
+	MEMORY_TAG(kMemoryTagOther);
+	if (profilerFont == NULL) {
+		profilerFont = font;
+	}
+	if (profilerFont != NULL) {
+		fontBlitterInit(pd, &profilerText, profilerFont);
+		profilerOverlayTop = LCD_ROWS - frameProfilerOverlayHeight(&frameProfiler, pd->graphics->getFontHeight(profilerFont));
+	}
+	
+	if (redrawOnChangeOnly == 0) {
+		MEMORY_TAG(kMemoryTagSprites);
+		profilerOverlayNode = sceneAddNode(pd, &scene, kSceneLayerOverlay, drawProfilerOverlaySprite);
+		if (profilerOverlayNode == NULL) {
+			pd->system->error("%s:%i Error allocating sprites", __FILE__, __LINE__);
+		}
+		sceneNodeMoveTo(pd, &scene, profilerOverlayNode, 0.0f, (float)profilerOverlayTop);
+		sceneNodeSetSize(pd, &scene, profilerOverlayNode, (float)LCD_COLUMNS, (float)(LCD_ROWS - profilerOverlayTop));
+		sceneNodeSetVisible(pd, &scene, profilerOverlayNode, profilerOverlayShows);
+		MEMORY_TAG(kMemoryTagOther);
+	}
+	return 1;
+}
+#endif
+
+/**
+ * Draws the progress bar of loading the first frame's assets (over a blank screen), if it advanced.
+ *
+ * @return 1 if drawn (the display needs an update); otherwise 0
+ */
+static int drawLoadProgress(void) {
+	int progress = (int)(assetLoaderProgress(&assetLoader, kLoadPriorityFirstFrame) * (LOAD_PROGRESS_WIDTH - 4));
+	if (progress == renderedLoadProgress) {
+		return 0;
+	}
+	
+	int x = (LCD_COLUMNS - LOAD_PROGRESS_WIDTH) / 2;
+	int y = (LCD_ROWS - LOAD_PROGRESS_HEIGHT) / 2;
+	if (renderedLoadProgress < 0) {
+		pd->graphics->clear(kColorWhite);
+		pd->graphics->drawRect(x, y, LOAD_PROGRESS_WIDTH, LOAD_PROGRESS_HEIGHT, kColorBlack);
+	}
+	pd->graphics->fillRect(x + 2, y + 2, progress, LOAD_PROGRESS_HEIGHT - 4, kColorBlack);
+	renderedLoadProgress = progress;
+	return 1;
+}
 
 /**
  * Playdate API callback for handling PDSystemEvent events, invoking by Playdate on an event.
@@ -155,6 +1094,11 @@ __declspec(dllexport)
 #endif
 int eventHandler(PlaydateAPI* pd, PDSystemEvent event, uint32_t arg) {
 	(void)arg; // arg is currently only used for event = kEventKeyPressed
+	
+#if MEMORY_TRACKER_ENABLED
+	// account all allocations per subsystem (see memory_tracker.h; allocations are tagged with MEMORY_TAG())
+	pd = memoryTrackerInstall(pd);
+#endif
 
 	if (event == kEventInit) {
 		// game bootup tasks:
@@ -163,64 +1107,53 @@ int eventHandler(PlaydateAPI* pd, PDSystemEvent event, uint32_t arg) {
 		helloText = getHelloText();
 		showTextMenuItemLabel = getShowTextMenuItemLabel();
 		
-		const char* err;
-		
-		// load and init fonts
-		font = pd->graphics->loadFont(fontPath, &err);
-		if ( font == NULL ) {
-			pd->system->error("%s:%i Error loading font, path=%s: %s", __FILE__, __LINE__, fontPath, err);
-		}
-		pd->graphics->setFont(font);
-		fontTracking = pd->graphics->getTextTracking();
-		textHeight = pd->graphics->getFontHeight(font);
-		textWidth = pd->graphics->getTextWidth(font, helloText, strlen(helloText), kASCIIEncoding, fontTracking);
-		
-		// load and init music
-		filePlayer = pd->sound->fileplayer->newPlayer();
-		int musicFound = pd->sound->fileplayer->loadIntoPlayer(filePlayer, musicFilePath);
-		if (musicFound == 0) {
-			pd->system->error("%s:%i Error loading music, path=%s", __FILE__, __LINE__, musicFilePath);
+		// queue the assets' loading, done a bit per update() (see assetLoader), in the order they are needed
+		assetLoaderInit(&assetLoader);
+		sceneInit(&scene);
+		assetLoaderAdd(&assetLoader, "font", kLoadPriorityFirstFrame, loadFont, NULL);
+		if (proceduralGlobe) {
+			assetLoaderAdd(&assetLoader, "globe", kLoadPriorityFirstFrame, loadGlobe, NULL);
 		}
-		pd->sound->fileplayer->setBufferLength(filePlayer, 0.5f);
-		
-		pd->sound->channel->addSource(
-			pd->sound->getDefaultChannel(),
-			(SoundSource*)filePlayer
-		);
-		
-		// load and init sounds
-		samplePlayer = pd->sound->sampleplayer->newPlayer();
-		for (int i = 0; i < NUM_SOUND_PATHS; i++) {
-			soundInfos[i].sample = pd->sound->sample->load(soundPaths[i]);
-			if (soundInfos[i].sample == NULL) {
-				pd->system->error("%s:%i Error loading sample[%i], path=%s", __FILE__, __LINE__, i, soundPaths[i]);
-			}
+		else {
+			assetLoaderAdd(&assetLoader, "sprite frames", kLoadPriorityFirstFrame, loadSpriteFrames, NULL);
+			assetLoaderAdd(&assetLoader, "first sprite frame", kLoadPriorityFirstFrame, loadFirstSpriteFrame, NULL);
 		}
+#if FRAME_PROFILER_ENABLED
+		assetLoaderAdd(&assetLoader, "profiler font", kLoadPriorityFirstFrame, loadProfilerFont, NULL);
+#endif
+		assetLoaderAdd(&assetLoader, "sounds", kLoadPriorityInteraction, loadSounds, NULL);
+		if (proceduralGlobe == 0) {
+			assetLoaderAdd(&assetLoader, "sprite frame neighbours", kLoadPriorityInteraction, prefetchSpriteFrames, NULL);
+		}
+		assetLoaderAdd(&assetLoader, "music", kLoadPriorityBackground, loadMusic, NULL);
 		
-		pd->sound->channel->addSource(
-			pd->sound->getDefaultChannel(),
-			(SoundSource*)samplePlayer
-		);
-		
-		// load and init sprites (and textures)
-		for (int i = 0; i < NUM_BITMAP_PATHS; i++) {
-			const char* outErr;
-			spriteInfos[i].bitmap = pd->graphics->loadBitmap(bitmapPaths[i], &outErr);
-			if (spriteInfos[i].bitmap == NULL) {
-				pd->system->error("%s:%i Error loading bitmap[%i], path=%s, error=%s", __FILE__, __LINE__, i, bitmapPaths[i], outErr);
-			}
+		pd->display->setRefreshRate(refreshRate);
+		inputQueueInit(pd, &inputQueue, INPUT_REPEAT_BUTTONS, INPUT_REPEAT_DELAY, INPUT_REPEAT_INTERVAL);
+		if (inputTraceReplay(pd, &inputTrace, inputTraceReplayPath)) {
+			pd->system->logToConsole("input: replaying %s", inputTraceReplayPath);
 		}
-		spriteInfoCurr = &spriteInfos[0];
+#if INPUT_TRACE_RECORD
+		else if (inputTraceRecord(pd, &inputTrace, inputTraceRecordPath) == 0) {
+			pd->system->error("%s:%i Error opening input trace, path=%s: %s", __FILE__, __LINE__, inputTraceRecordPath, pd->file->geterr());
+		}
+#endif
+		inputQueueSetTrace(pd, &inputQueue, &inputTrace);
 		
-		sprite = pd->sprite->newSprite();
-		pd->sprite->setCenter(sprite, 0.0f, 0.0f); // just as a preference, we'll use top-left as sprite origin (instead of playdate-default of center)
-		pd->sprite->setSize(sprite, spriteInfoCurr->rect.width, spriteInfoCurr->rect.height);
-		pd->sprite->moveTo(sprite, spriteInfoCurr->rect.x, spriteInfoCurr->rect.y);
-		pd->sprite->setImage(sprite, spriteInfoCurr->bitmap, kBitmapUnflipped);
-		pd->sprite->addSprite(sprite); // simply add to display list to simplify rendering
+		if (memoryArenaInit(pd, &frameArena, FRAME_ARENA_SIZE) == 0) {
+			pd->system->error("%s:%i Error allocating frame arena, size=%u", __FILE__, __LINE__, (unsigned int)FRAME_ARENA_SIZE);
+		}
 		
 		// init system menu
 		showTextMenuItemCheckmark = pd->system->addCheckmarkMenuItem(showTextMenuItemLabel, textShows, systemMenuItemCallback, NULL);
+		
+#if FRAME_PROFILER_ENABLED
+		// init frame profiler (and its overlay, off until enabled from the system menu; its font is loaded with the first frame's assets)
+		frameProfilerInit(&frameProfiler, profileSectionNames, kNumProfileSections);
+		profilerMenuItemCheckmark = pd->system->addCheckmarkMenuItem(getProfilerMenuItemLabel(), profilerOverlayShows, profilerMenuItemCallback, NULL);
+#endif
+#if MEMORY_TRACKER_ENABLED
+		memoryMenuItem = pd->system->addMenuItem(getMemoryMenuItemLabel(), memoryMenuItemCallback, NULL);
+#endif
 
 		// use C-only Playdate API:
 		// Note: If you set an update callback in the kEventInit handler, the system assumes the game is pure C and doesn't run any Lua code in the game
@@ -229,27 +1162,118 @@ int eventHandler(PlaydateAPI* pd, PDSystemEvent event, uint32_t arg) {
 	else if (event == kEventTerminate) {
 		// game shutdown tasks:
 		
+#if MEMORY_TRACKER_ENABLED
+		memoryTrackerLogReport(pd);
+#endif
+		
 		// clean up any allocated resources
-		if (filePlayer != NULL) {
-			pd->sound->fileplayer->stop(filePlayer);
-			pd->sound->fileplayer->freePlayer(filePlayer);
+		MusicPlayerStats* musicStats = &music.stats;
+		pd->system->logToConsole(
+			"music: %u loops, %u restarts, %u underruns, %u frames longer than the %.2f s buffer (longest %.1f ms), start %.1f ms (max %.1f ms)",
+			(unsigned int)musicStats->loops, (unsigned int)musicStats->restarts, (unsigned int)musicStats->underruns,
+			(unsigned int)musicStats->slowFrames, (double)music.bufferLength, (double)musicStats->maxFrameTime * 1000.0,
+			(double)musicStats->startTime * 1000.0, (double)musicStats->maxStartTime * 1000.0
+		);
+		musicPlayerFree(pd, &music);
+		
+		pd->system->logToConsole(
+			"sound voices: %u triggers, %u steals",
+			(unsigned int)soundTonePlayer.stats.triggers, (unsigned int)soundTonePlayer.stats.steals
+		);
+		tonePlayerFree(pd, &soundTonePlayer);
+		
+		BitmapCacheStats* cacheStats = &spriteBitmapCache.stats;
+		pd->system->logToConsole(
+			"sprite bitmap cache: %u hits, %u misses, %u prefetches, %u evictions, %u load errors, %i peak resident",
+			(unsigned int)cacheStats->hits, (unsigned int)cacheStats->misses, (unsigned int)cacheStats->prefetches,
+			(unsigned int)cacheStats->evictions, (unsigned int)cacheStats->loadErrors, cacheStats->peakResident
+		);
+		bitmapCacheFree(pd, &spriteBitmapCache);
+		frameBlendRingFree(pd, &spriteBlendRing);
+		
+		if (proceduralGlobe) {
+			GlobeRendererStats* globeStats = &globe.stats;
+			pd->system->logToConsole(
+				"globe: %u draws of a %i px radius disc at scale %i, %.0f samples/draw, %u bytes of table",
+				(unsigned int)globeStats->draws, globe.radius, globe.scale,
+				globeStats->draws > 0 ? (double)globeStats->samples / globeStats->draws : 0.0,
+				(unsigned int)globeRendererTableSize(GLOBE_RADIUS, GLOBE_SCALE)
+			);
+		}
+		if (globeBitmap != NULL) {
+			pd->graphics->freeBitmap(globeBitmap);
 		}
+		if (globeMap != NULL) {
+			pd->graphics->freeBitmap(globeMap); // (the renderer's table goes with assetArena)
+		}
+		
+		SceneStats* sceneStats = &scene.stats;
+		pd->system->logToConsole(
+			"scene: %u state changes submitted, %u unchanged skipped, %u draws, %u frames without changes",
+			(unsigned int)sceneStats->submits, (unsigned int)sceneStats->skips, (unsigned int)sceneStats->draws, (unsigned int)sceneStats->idleDraws
+		);
+		sceneFree(pd, &scene);
 		
-		if (samplePlayer != NULL) {
-			pd->sound->sampleplayer->stop(samplePlayer);
-			pd->sound->sampleplayer->freePlayer(samplePlayer);
+		if (textBoxBitmap != NULL) {
+			pd->graphics->freeBitmap(textBoxBitmap);
 		}
-		for (int i = 0; i < NUM_SOUND_PATHS; i++) {
-			if (soundInfos[i].sample != NULL) {
-				pd->sound->sample->freeSample(soundInfos[i].sample);
-			}
+		
+		if (mapOpened) {
+			TileSetStats* mapStats = &mapTiles.stats;
+			pd->system->logToConsole(
+				"map tiles: %u draws (%u incomplete), %u hits, %u misses, %u prefetches, %u evictions, %u reads (%u seeks), %u over budget, %u errors, %i of %i slots peak resident",
+				(unsigned int)mapStats->draws, (unsigned int)mapStats->incompleteDraws, (unsigned int)mapStats->hits, (unsigned int)mapStats->misses,
+				(unsigned int)mapStats->prefetches, (unsigned int)mapStats->evictions, (unsigned int)mapStats->reads, (unsigned int)mapStats->seeks,
+				(unsigned int)mapStats->overBudget, (unsigned int)mapStats->errors, mapStats->peakResident, mapTiles.slotCount
+			);
+			tileSetClose(pd, &mapTiles);
+			memoryArenaFree(pd, &mapArena); // (the tile set's index and cache)
 		}
 		
-		for (int i = 0; i < NUM_BITMAP_PATHS; i++) {
-			if (spriteInfos[i].bitmap != NULL) {
-				pd->graphics->freeBitmap(spriteInfos[i].bitmap);
-			}
+#if FRAME_PROFILER_ENABLED
+		FontBlitterStats* textStats = &profilerText.stats;
+		pd->system->logToConsole(
+			"profiler text: %u runs blitted, %u drawn through drawText()",
+			(unsigned int)textStats->blits, (unsigned int)textStats->fallbacks
+		);
+		fontBlitterFree(pd, &profilerText);
+#endif
+		
+		InputQueueStats* inputStats = &inputQueue.stats;
+		pd->system->logToConsole(
+			"input: %u events (%u dropped, %u taps within a frame), %i max queued, event-to-handled latency %.1f ms mean, %u ms max",
+			(unsigned int)inputStats->events, (unsigned int)inputStats->dropped, (unsigned int)inputStats->tapsInFrame, inputStats->maxDepth,
+			inputStats->latencyCount > 0 ? (double)inputStats->latencyTotal / inputStats->latencyCount : 0.0, (unsigned int)inputStats->latencyMax
+		);
+		inputQueueFree(pd, &inputQueue);
+		
+		InputTraceStats* traceStats = &inputTrace.stats;
+		if (traceStats->frames > 0 || traceStats->errors > 0) {
+			pd->system->logToConsole(
+				"input trace: %u frames %s, %u file operations, %u menu changes lost, %u errors",
+				(unsigned int)traceStats->frames, inputTrace.mode == kInputTraceRecording ? "recorded" : "replayed",
+				(unsigned int)traceStats->fileOps, (unsigned int)traceStats->menuChangesLost, (unsigned int)traceStats->errors
+			);
 		}
+		inputTraceClose(pd, &inputTrace);
+		
+		AssetLoaderStats* loaderStats = &assetLoader.stats;
+		pd->system->logToConsole(
+			"asset loader: %i of %i jobs done in %u steps over %u updates, %.1f ms total, longest step %.1f ms (%s), longest update %.1f ms",
+			assetLoader.current, assetLoader.numJobs, (unsigned int)loaderStats->steps, (unsigned int)loaderStats->updates,
+			(double)loaderStats->totalTime * 1000.0, (double)loaderStats->maxStepTime * 1000.0,
+			loaderStats->maxStepJob != NULL ? loaderStats->maxStepJob : "-", (double)loaderStats->maxUpdateTime * 1000.0
+		);
+		
+		// the frame pack, the cache's tables and the deltas go with their arena
+		pd->system->logToConsole(
+			"arenas: assets %u of %u bytes used (%u overflows, largest %u bytes), frame %u of %u bytes peak (%u overflows, largest %u bytes)",
+			(unsigned int)assetArena.stats.peak, (unsigned int)assetArena.capacity, (unsigned int)assetArena.stats.overflows,
+			(unsigned int)assetArena.stats.overflowMax, (unsigned int)frameArena.stats.peak, (unsigned int)frameArena.capacity,
+			(unsigned int)frameArena.stats.overflows, (unsigned int)frameArena.stats.overflowMax
+		);
+		memoryArenaFree(pd, &assetArena);
+		memoryArenaFree(pd, &frameArena);
 	}
 	
 	return 0;
@@ -263,132 +1287,366 @@ int eventHandler(PlaydateAPI* pd, PDSystemEvent event, uint32_t arg) {
  */
 static int update(void* userdata) {
 	pd = userdata;
+	memoryArenaReset(&frameArena); // (the previous frame's scratch memory)
 	
-	
-	// read button input, if any
-	pd->system->getButtonState(&btnsCurr, &btnsUpdateDown, &btnsUpdateUp);
-	
-	// play one of the sounds if A or B button pressed (only if button newly pressed/down, to avoid constant playing...)
-	if (
-		((kButtonA & btnsCurr) && !(kButtonA & btnsPrev)) || 
-		((kButtonB & btnsCurr) && !(kButtonB & btnsPrev))
-	) {
-		pd->sound->sampleplayer->setSample(samplePlayer, soundInfos[soundRoundRobinIndex].sample);
-		soundRoundRobinIndex = soundRoundRobinIndex < (NUM_SOUND_PATHS-1) ? soundRoundRobinIndex + 1 : 0;
-		pd->sound->sampleplayer->play(samplePlayer, 1, 1.0f);
+	// until the first frame's assets are loaded, keep loading them (with all of the frame's time), showing progress
+	if (assetLoaderIsDone(&assetLoader, kLoadPriorityFirstFrame) == 0) {
+		assetLoaderUpdate(pd, &assetLoader, ASSET_LOAD_BUDGET_STARTUP);
+		if (assetLoaderIsDone(&assetLoader, kLoadPriorityFirstFrame) == 0) {
+			return drawLoadProgress();
+		}
 	}
 	
-	// update text position based on D-pad (if needed)
-	if (
-		((kButtonLeft & btnsCurr))
-	) {
-		textPosition = 3;
+#if FRAME_PROFILER_ENABLED
+	frameProfilerBeginFrame(pd, &frameProfiler);
+	int result = updateFrame();
+	if (frameProfilerEndFrame(pd, &frameProfiler, &frameArena)) {
+		profilerOverlayDue = 1;
 	}
-	else if (
-		((kButtonRight & btnsCurr))
-	) {
-		textPosition = 1;
+	return result;
+#else
+	return updateFrame();
+#endif
+}
+
+/**
+ * Handles an input event: A / B presses play a sound, D-pad presses (and repeats) move the text, the crank rotates the
+ * image (in steps of 15 degrees, or by the degree for the procedural globe), and menu items toggle what they show. A and B pressed together toggle the map viewer, in which the crank
+ * zooms the map instead (and the D-pad pans it, see updateFrame()).
+ */
+static void handleInputEvent(const InputEvent* event) {
+	switch (event->type) {
+		case kInputPress:
+		case kInputRepeat:
+			// play one of the sounds per A or B press (not while held, to avoid constant playing...)
+			if ((event->button & (kButtonA | kButtonB)) && event->type == kInputPress) {
+				tonePlayerPlay(pd, &soundTonePlayer, &soundTones[soundRoundRobinIndex]);
+				soundRoundRobinIndex = soundRoundRobinIndex < (NUM_SOUND_TONES-1) ? soundRoundRobinIndex + 1 : 0;
+			}
+			
+			if (event->type == kInputPress) {
+				buttonsDown |= event->button;
+				if ((event->button & (kButtonA | kButtonB)) && (buttonsDown & (kButtonA | kButtonB)) == (kButtonA | kButtonB)) {
+					mapShows = mapShows ? 0 : (mapOpened || openMap());
+					mapZoomCrank = 0.0f;
+				}
+			}
+			if (mapShows) {
+				break;
+			}
+			
+			// update text position based on D-pad
+			if (event->button == kButtonLeft) {
+				textPosition = 3;
+			}
+			else if (event->button == kButtonRight) {
+				textPosition = 1;
+			}
+			else if (event->button == kButtonUp) {
+				textPosition = 0;
+			}
+			else if (event->button == kButtonDown) {
+				textPosition = 2;
+			}
+			break;
+		
+		case kInputRelease:
+			buttonsDown &= ~event->button;
+			break;
+		
+		case kInputCrank:
+			if (mapShows) {
+				// forward zooms in (toward level 0), backward out, a level per MAP_ZOOM_CRANK degrees
+				mapZoomCrank += event->value;
+				if (mapZoomCrank >= MAP_ZOOM_CRANK || mapZoomCrank <= -MAP_ZOOM_CRANK) {
+					int level = mapLevel + (mapZoomCrank > 0.0f ? -1 : 1);
+					if (level >= 0 && level < mapTiles.levelCount) {
+						mapLevel = level;
+					}
+					mapZoomCrank = 0.0f;
+				}
+				break;
+			}
+			prevCrankAngle = crankAngle;
+			crankAngle = inputQueue.crankAngle;
+			crankChange = event->value;
+			
+			if (proceduralGlobe) {
+				globeCrank += crankChange;
+				imageRotation += (int)globeCrank;
+				globeCrank -= (int)globeCrank;
+				break;
+			}
+			if (crankChange > 0) {
+				// positive (forward/toward-screen) crank change!
+				crankAmount += crankChange;
+				
+				if (crankAmount > crankThreshold) {
+					crankAmount = 0;
+					imageRotation += 15;
+				}
+			}
+			else if (crankChange < 0) {
+				// negative (backward/behind-screen) crank change!
+				crankAmount += fabs(crankChange);
+				
+				if (fabs(crankAmount) > crankThreshold) {
+					crankAmount = 0;
+					imageRotation -= 15;
+				}
+			}
+			break;
+		
+		case kInputMenu:
+			if (event->item == kMenuItemShowText) {
+				textShows = (int)event->value;
+			}
+#if FRAME_PROFILER_ENABLED
+			else if (event->item == kMenuItemProfiler) {
+				profilerOverlayShows = (int)event->value;
+			}
+#endif
+			break;
 	}
+}
+
+/**
+ * The work of a frame of update() (see there).
+ */
+static int updateFrame(void) {
+	// load what's left of the assets, within this frame's budget
+	PROFILE_BEGIN(pd, &frameProfiler, kProfileLoad);
+	assetLoaderUpdate(pd, &assetLoader, ASSET_LOAD_BUDGET);
+	PROFILE_END(pd, &frameProfiler, kProfileLoad);
 	
-	if (
-		((kButtonUp & btnsCurr))
-	) {
-		textPosition = 0;
+	PROFILE_BEGIN(pd, &frameProfiler, kProfileInput);
+	
+	// handle the input since the last frame, event by event in the order it happened
+	inputQueuePoll(pd, &inputQueue);
+	int inputActive = inputQueue.held != 0;
+	InputEvent event;
+	while (inputQueuePop(pd, &inputQueue, &event)) {
+		handleInputEvent(&event);
+		inputActive = 1;
 	}
-	else if (
-		((kButtonDown & btnsCurr))
-	) {
-		textPosition = 2;
+	if (mapShows && (inputQueue.held & INPUT_REPEAT_BUTTONS)) {
+		panMap(inputQueue.held);
 	}
 	
-	// read any Crank input (if in use)
-	if (pd->system->isCrankDocked() == 0) {
-		prevCrankAngle = crankAngle;
-		crankAngle = pd->system->getCrankAngle();
-		crankChange = pd->system->getCrankChange();
-		
-		if (crankChange > 0) {
-			// positive (forward/toward-screen) crank change!
-			crankAmount += crankChange;
+	PROFILE_END(pd, &frameProfiler, kProfileInput);
+	PROFILE_BEGIN(pd, &frameProfiler, kProfileSprite);
+	MEMORY_TAG(kMemoryTagTextures);
+	
+	// update sprite based on updated rotation (if needed)
+	if (proceduralGlobe) {
+		// render the globe at the rotation, if it changed (any degree of it: there are no frames to snap to)
+		int rotation = ((imageRotation % 360) + 360) % 360;
+		if (rotation != globeRotation && globeBitmap != NULL) {
+			int width, height, rowbytes;
+			uint8_t* mask;
+			uint8_t* data;
+			pd->graphics->getBitmapData(globeBitmap, &width, &height, &rowbytes, &mask, &data);
+			globeRendererDraw(&globe, (float)(GLOBE_TURN * rotation), data, rowbytes, height, GLOBE_CENTER_X, GLOBE_CENTER_Y);
+			globeRotation = rotation;
+		}
+	}
+	else {
+		int blendLevel = 0;
+		if (interpolateFrames) {
+			// the frame at or before the rotation (within [0, 360)), and how far the rotation is toward the next frame
+			int degreesPerFrame = 360 / NUM_BITMAP_PATHS;
+			int rotation = ((imageRotation % 360) + 360) % 360;
+			spriteIndexImageRotation = rotation / degreesPerFrame;
+			blendLevel = (rotation % degreesPerFrame) * FRAME_BLEND_LEVELS / degreesPerFrame;
+		}
+		else {
+			spriteIndexImageRotation = (imageRotation % 360) / (360 / NUM_BITMAP_PATHS); // simplify rotation range down to 0 to 360, then map to the index range of [0, plus-minus NUM_BITMAP_PATHS)
+			spriteIndexImageRotation = (spriteIndexImageRotation >= 0) ? spriteIndexImageRotation : (NUM_BITMAP_PATHS + spriteIndexImageRotation); // ensure/map within range of [0, NUM_BITMAP_PATHS)
+		}
+		spriteInfoTemp = &spriteInfos[spriteIndexImageRotation];
+		if (spriteInfoTemp != spriteInfoCurr || blendLevel != spriteBlendLevel) {
+			if (spriteInfoTemp != spriteInfoCurr) {
+				spriteInfoPrev = spriteInfoCurr;
+				spriteInfoCurr = spriteInfoTemp;
+				// load the frame, if not already, and its upcoming neighbours
+				spriteBitmapCurr = bitmapCacheSetWindow(pd, &spriteBitmapCache, spriteIndexImageRotation);
+			}
 			
-			if (crankAmount > crankThreshold) {
-				crankAmount = 0;
-				imageRotation += 15;
+			// in between frames: dither the frame and the next one together (or reuse the recently dithered)
+			spriteBlendLevel = blendLevel;
+			spriteImageCurr = spriteBitmapCurr;
+			if (spriteBlendLevel > 0) {
+				LCDBitmap* next = bitmapCachePeek(&spriteBitmapCache, (spriteIndexImageRotation + 1) % NUM_BITMAP_PATHS);
+				LCDBitmap* blended = (spriteBitmapCurr != NULL && next != NULL) ?
+					frameBlendRingGet(pd, &spriteBlendRing, spriteIndexImageRotation, spriteBlendLevel, spriteBitmapCurr, next) :
+					NULL;
+				if (blended != NULL) {
+					spriteImageCurr = blended;
+				}
+				else {
+					spriteBlendLevel = 0; // (show the frame itself)
+				}
 			}
 		}
-		else if (crankChange < 0) {
-			// negative (backward/behind-screen) crank change!
-			crankAmount += fabs(crankChange);
-			
-			if (fabs(crankAmount) > crankThreshold) {
-				crankAmount = 0;
-				imageRotation -= 15;
+	}
+	
+	PROFILE_END(pd, &frameProfiler, kProfileSprite);
+	PROFILE_BEGIN(pd, &frameProfiler, kProfileAudio);
+	
+	// keep the music going (it loops by itself; this only restarts it should it have stopped, and counts underruns)
+	musicPlayerUpdate(pd, &music);
+	
+	PROFILE_END(pd, &frameProfiler, kProfileAudio);
+	
+	// (re-)render the text box if its font, string or tracking changed
+	PROFILE_BEGIN(pd, &frameProfiler, kProfileText);
+	MEMORY_TAG(kMemoryTagFont);
+	int textBoxChanged = updateTextBox();
+	MEMORY_TAG(kMemoryTagTextures); // (anything allocated while drawing)
+	PROFILE_END(pd, &frameProfiler, kProfileText);
+	
+	PROFILE_BEGIN(pd, &frameProfiler, kProfileDraw);
+	updateRefreshRate(inputActive);
+	if (mapShows) {
+		int drawn = drawMap();
+		PROFILE_END(pd, &frameProfiler, kProfileDraw);
+		if (drawn == 0) {
+			return 0; // nothing changed; let the system skip the display update
+		}
+		pd->system->drawFPS(0,0);
+		return 1;
+	}
+	if (renderedMapShows) {
+		// back from the map viewer: redraw everything over it
+		renderedMapShows = 0;
+		renderedSpriteInfo = NULL;
+		if (redrawOnChangeOnly == 0) {
+			sceneNodeInvalidate(pd, &scene, spriteNode);
+			sceneNodeInvalidate(pd, &scene, textBoxNode);
+#if FRAME_PROFILER_ENABLED
+			sceneNodeInvalidate(pd, &scene, profilerOverlayNode);
+#endif
+		}
+	}
+	if (redrawOnChangeOnly) {
+		// find which rows changed since the last rendered frame (if any), patching in a neighbouring frame's changes right away
+		memset(rowsDirty, 0, sizeof(rowsDirty));
+		int patched = 0;
+#if FRAME_PROFILER_ENABLED
+		if (profilerOverlayShows != renderedProfilerOverlayShows || (profilerOverlayShows && profilerOverlayDue)) {
+			markProfilerOverlayRowsDirty();
+		}
+#endif
+		if (textBoxChanged) {
+			memset(rowsDirty, 1, sizeof(rowsDirty));
+		}
+		else if (spriteInfoCurr != renderedSpriteInfo || spriteBlendLevel != renderedBlendLevel) {
+			patched = patchSpriteRows();
+			if (patched == 0) {
+				memset(rowsDirty, 1, sizeof(rowsDirty));
+			}
+		}
+		else {
+			if (globeRotation != renderedGlobeRotation) {
+				// the globe turned: only its disc's rows changed (redrawn with the text box over them)
+				markGlobeRowsDirty();
 			}
+			if (textShows != renderedTextShows || (textShows && textPosition != renderedTextPosition)) {
+				if (renderedTextShows == 1) {
+					markTextBoxRowsDirty(renderedTextPosition);
+				}
+				if (textShows) {
+					markTextBoxRowsDirty(textPosition);
+				}
+			}
+		}
+		
+#if FRAME_PROFILER_ENABLED
+		// the overlay is redrawn as a whole (over freshly redrawn rows)
+		if (profilerOverlayShows && memchr(rowsDirty + profilerOverlayTop, 1, LCD_ROWS - profilerOverlayTop) != NULL) {
+			markProfilerOverlayRowsDirty();
+		}
+#endif
+		
+		// redraw each run of dirty rows
+		int anyDirty = 0;
+		for (int row = 0; row < LCD_ROWS; row++) {
+			if (rowsDirty[row]) {
+				int top = row;
+				while (row + 1 < LCD_ROWS && rowsDirty[row + 1]) {
+					row++;
+				}
+				redrawRows(top, row);
+				anyDirty = 1;
+			}
+		}
+		
+#if FRAME_PROFILER_ENABLED
+		if (profilerOverlayShows && rowsDirty[profilerOverlayTop]) {
+			drawProfilerOverlay();
 		}
+		renderedProfilerOverlayShows = profilerOverlayShows;
+#endif
+		PROFILE_END(pd, &frameProfiler, kProfileDraw);
+		
+		if (anyDirty == 0 && patched == 0) {
+			return 0; // nothing changed; let the system skip the display update
+		}
+		
+		renderedSpriteInfo = spriteInfoCurr;
+		renderedBlendLevel = spriteBlendLevel;
+		renderedGlobeRotation = globeRotation;
+		renderedTextPosition = textPosition;
+		renderedTextShows = textShows;
+		
+		// render FPS text (debugging only; only refreshed on frames that redraw)
+		pd->system->drawFPS(0,0);
+		
+		return 1;
 	}
 	
-	// update sprite based on updated rotation (if needed)
-	spriteIndexImageRotation = (imageRotation % 360) / (360 / NUM_BITMAP_PATHS); // simplify rotation range down to 0 to 360, then map to the index range of [0, plus-minus NUM_BITMAP_PATHS)
-	spriteIndexImageRotation = (spriteIndexImageRotation >= 0) ? spriteIndexImageRotation : (NUM_BITMAP_PATHS + spriteIndexImageRotation); // ensure/map within range of [0, NUM_BITMAP_PATHS)
-	spriteInfoTemp = &spriteInfos[spriteIndexImageRotation];
-	if (spriteInfoTemp != spriteInfoCurr) {
-		spriteInfoPrev = spriteInfoCurr;
-		spriteInfoCurr = spriteInfoTemp;
+	// pass on what changed to the scene's nodes, to redraw only that
+	if (spriteInfoCurr != renderedSpriteInfo || spriteBlendLevel != renderedBlendLevel || globeRotation != renderedGlobeRotation) {
+		sceneNodeSetImage(pd, &scene, spriteNode, spriteImageCurr);
+		sceneNodeMoveTo(pd, &scene, spriteNode, spriteInfoCurr->rect.x, spriteInfoCurr->rect.y);
+		sceneNodeInvalidate(pd, &scene, spriteNode); // evicted and in-between frame bitmaps (and globeBitmap) are reused for other images, so the image pointer may be unchanged
 	}
 	
-	pd->sprite->setSize(sprite, spriteInfoCurr->rect.width, spriteInfoCurr->rect.height);
-	pd->sprite->moveTo(sprite, spriteInfoCurr->rect.x, spriteInfoCurr->rect.y);
-	pd->sprite->setImage(sprite, spriteInfoCurr->bitmap, kBitmapUnflipped);
+	PROFILE_END(pd, &frameProfiler, kProfileDraw);
+	PROFILE_BEGIN(pd, &frameProfiler, kProfileText);
+	int x, y;
+	getTextOrigin(textPosition, &x, &y);
+	sceneNodeSetImage(pd, &scene, textBoxNode, textBoxBitmap);
+	sceneNodeMoveTo(pd, &scene, textBoxNode, x - TEXT_BOX_MARGIN, y - TEXT_BOX_MARGIN);
+	sceneNodeSetVisible(pd, &scene, textBoxNode, textShows);
+	if (textBoxChanged) {
+		sceneNodeInvalidate(pd, &scene, textBoxNode);
+	}
+	PROFILE_END(pd, &frameProfiler, kProfileText);
+	PROFILE_BEGIN(pd, &frameProfiler, kProfileDraw);
 	
-	// loop music
-	if (pd->sound->fileplayer->isPlaying(filePlayer) == 0) {
-		pd->sound->fileplayer->play(filePlayer, 1);
+#if FRAME_PROFILER_ENABLED
+	sceneNodeSetVisible(pd, &scene, profilerOverlayNode, profilerOverlayShows);
+	if (profilerOverlayShows && profilerOverlayDue) {
+		sceneNodeInvalidate(pd, &scene, profilerOverlayNode);
 	}
+#endif
+	
+	// render the scene's dirty rects (over the last frame)
+	int drawn = sceneDraw(pd, &scene);
 	
+	PROFILE_END(pd, &frameProfiler, kProfileDraw);
 	
-	// clear frame buffer before rendering anything this frame
-	pd->graphics->clear(kColorWhite);
+	if (drawn == 0) {
+		return 0; // nothing changed; let the system skip the display update
+	}
 	
-	// render sprite (simply all in display list)
-	pd->sprite->drawSprites();
+	renderedSpriteInfo = spriteInfoCurr;
+	renderedBlendLevel = spriteBlendLevel;
+	renderedGlobeRotation = globeRotation;
 	
-	// update text position (if needed)
-	if (textShows) {
-		if (textPosition == 0) {
-			textX = LCD_COLUMNS / 2 - textWidth / 2;
-			textY = 10;
-			pd->graphics->fillRect(textX - 6, textY - 6, textWidth + 12, textHeight + 12, kColorBlack);
-			pd->graphics->fillRect(textX - 4, textY - 4, textWidth + 8, textHeight + 8, kColorWhite);
-			pd->graphics->drawText(helloText, strlen(helloText), kASCIIEncoding, textX, textY);
-		}
-		else if (textPosition == 1) {
-			textX = LCD_COLUMNS - textWidth - 10;
-			textY = LCD_ROWS / 2 - textHeight / 2;
-			pd->graphics->fillRect(textX - 6, textY - 6, textWidth + 12, textHeight + 12, kColorBlack);
-			pd->graphics->fillRect(textX - 4, textY - 4, textWidth + 8, textHeight + 8, kColorWhite);
-			pd->graphics->drawText(helloText, strlen(helloText), kASCIIEncoding, textX, textY);
-		}
-		else if (textPosition == 2) {
-			textX = LCD_COLUMNS / 2 - textWidth / 2;
-			textY = LCD_ROWS - textHeight - 10;
-			pd->graphics->fillRect(textX - 6, textY - 6, textWidth + 12, textHeight + 12, kColorBlack);
-			pd->graphics->fillRect(textX - 4, textY - 4, textWidth + 8, textHeight + 8, kColorWhite);
-			pd->graphics->drawText(helloText, strlen(helloText), kASCIIEncoding, textX, textY);
-		}
-		else if (textPosition == 3) {
-			textX = 10;
-			textY = LCD_ROWS / 2 - textHeight / 2;
-			pd->graphics->fillRect(textX - 6, textY - 6, textWidth + 12, textHeight + 12, kColorBlack);
-			pd->graphics->fillRect(textX - 4, textY - 4, textWidth + 8, textHeight + 8, kColorWhite);
-			pd->graphics->drawText(helloText, strlen(helloText), kASCIIEncoding, textX, textY);
-		}
-	}
-    
-	// render FPS text (debugging only)
+	// render FPS text (debugging only; only refreshed on frames that redraw)
 	pd->system->drawFPS(0,0);
-	
-	// store this frame's button state for next frame's reference (only at end of this frame)
-	btnsPrev = btnsCurr;
 
 	return 1;
 }
@@ -0,0 +1,103 @@
+#include <string.h>
+
+#include "memory_arena.h"
+
+
+int memoryArenaInit(PlaydateAPI* pd, MemoryArena* arena, size_t capacity) {
+	memset(arena, 0, sizeof(*arena));
+	if (capacity == 0) {
+		return 1;
+	}
+	arena->base = pd->system->realloc(NULL, capacity);
+	if (arena->base == NULL) {
+		return 0;
+	}
+	arena->capacity = capacity;
+	return 1;
+}
+
+void* memoryArenaAlloc(MemoryArena* arena, size_t size) {
+	// (the block from realloc() is at least as aligned as MEMORY_ARENA_ALIGNMENT, so aligned offsets are aligned addresses)
+	size_t offset = MEMORY_ARENA_ROOM(arena->used);
+	if (size > arena->capacity || offset > arena->capacity - size) {
+		arena->stats.overflows++;
+		if (size > arena->stats.overflowMax) {
+			arena->stats.overflowMax = size;
+		}
+		return NULL;
+	}
+	arena->used = offset + size;
+	if (arena->used > arena->stats.peak) {
+		arena->stats.peak = arena->used;
+	}
+	return arena->base + offset;
+}
+
+size_t memoryArenaMark(const MemoryArena* arena) {
+	return arena->used;
+}
+
+void memoryArenaRelease(MemoryArena* arena, size_t mark) {
+	if (mark < arena->used) {
+		arena->used = mark;
+	}
+}
+
+void memoryArenaReset(MemoryArena* arena) {
+	arena->used = 0;
+}
+
+void memoryArenaFree(PlaydateAPI* pd, MemoryArena* arena) {
+	if (arena->base != NULL) {
+		pd->system->realloc(arena->base, 0);
+	}
+	memset(arena, 0, sizeof(*arena));
+}
+
+int memoryPoolInit(MemoryPool* pool, MemoryArena* arena, size_t blockSize, int capacity) {
+	memset(pool, 0, sizeof(*pool));
+	pool->blockSize = MEMORY_ARENA_ROOM(blockSize > sizeof(void*) ? blockSize : sizeof(void*));
+	pool->blocks = (capacity > 0) ? memoryArenaAlloc(arena, pool->blockSize * capacity) : NULL;
+	if (pool->blocks == NULL) {
+		return capacity <= 0;
+	}
+	pool->capacity = capacity;
+	memoryPoolReset(pool);
+	return 1;
+}
+
+void* memoryPoolAlloc(MemoryPool* pool) {
+	void* block = pool->freeList;
+	if (block == NULL) {
+		pool->overflows++;
+		return NULL;
+	}
+	memcpy(&pool->freeList, block, sizeof(void*));
+	if (++pool->live > pool->peakLive) {
+		pool->peakLive = pool->live;
+	}
+	return block;
+}
+
+void memoryPoolFree(MemoryPool* pool, void* block) {
+	uint8_t* p = block;
+	if (
+		p == NULL || pool->blocks == NULL || p < pool->blocks || p >= pool->blocks + pool->blockSize * pool->capacity ||
+		(size_t)(p - pool->blocks) % pool->blockSize != 0
+	) {
+		return;
+	}
+	memcpy(block, &pool->freeList, sizeof(void*));
+	pool->freeList = block;
+	pool->live--;
+}
+
+void memoryPoolReset(MemoryPool* pool) {
+	pool->freeList = NULL;
+	for (int i = pool->capacity - 1; i >= 0; i--) {
+		void* block = pool->blocks + pool->blockSize * i;
+		memcpy(block, &pool->freeList, sizeof(void*));
+		pool->freeList = block;
+	}
+	pool->live = 0;
+}
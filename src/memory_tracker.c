@@ -0,0 +1,359 @@
+#include "memory_tracker.h"
+
+#if MEMORY_TRACKER_ENABLED
+
+#include <string.h>
+
+
+/** The audio rate and frame size file player stream buffers are estimated with */
+#define MUSIC_ESTIMATE_SAMPLE_RATE 44100
+#define MUSIC_ESTIMATE_FRAME_BYTES 4
+/** The size a synth (its oscillator and envelope state) is estimated at: there's no API for it */
+#define SYNTH_ESTIMATE_BYTES 256
+
+typedef struct {
+	const void* pointer;
+	size_t size;
+	MemoryTag tag;
+} TrackedObject;
+
+static const char* tagNames[kNumMemoryTags] = { "other", "font", "textures", "sfx", "music", "sprites" };
+
+/** The untracked API, and the tracking copies of it and of its wrapped sub-APIs */
+static PlaydateAPI* real = NULL;
+static PlaydateAPI tracked;
+static struct playdate_sys trackedSystem;
+static struct playdate_graphics trackedGraphics;
+static struct playdate_sprite trackedSprite;
+static struct playdate_sound trackedSound;
+static struct playdate_sound_sample trackedSample;
+static struct playdate_sound_fileplayer trackedFilePlayer;
+static struct playdate_sound_sampleplayer trackedSamplePlayer;
+static struct playdate_sound_synth trackedSynth;
+
+static MemoryTag currentTag = kMemoryTagOther;
+static MemoryTagStats stats[kNumMemoryTags];
+static MemoryTagStats totalStats;
+/** Allocations made while objects was full (held, but not accounted) */
+static uint32_t untrackedAllocs = 0;
+static TrackedObject objects[MEMORY_TRACKER_MAX_OBJECTS];
+static int numObjects = 0;
+
+
+static void account(MemoryTagStats* s, size_t size, int added) {
+	if (added) {
+		s->current += size;
+		s->live++;
+		s->allocs++;
+		if (s->current > s->peak) {
+			s->peak = s->current;
+		}
+	}
+	else {
+		s->current -= size;
+		s->live--;
+	}
+}
+
+static void track(const void* pointer, size_t size) {
+	if (pointer == NULL) {
+		return;
+	}
+	if (numObjects == MEMORY_TRACKER_MAX_OBJECTS) {
+		untrackedAllocs++;
+		return;
+	}
+	objects[numObjects++] = (TrackedObject){ pointer, size, currentTag };
+	account(&stats[currentTag], size, 1);
+	account(&totalStats, size, 1);
+}
+
+static TrackedObject* find(const void* pointer) {
+	for (int i = 0; i < numObjects; i++) {
+		if (objects[i].pointer == pointer) {
+			return &objects[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Stops tracking pointer (if tracked); returns its tag (or the current tag if not tracked).
+ */
+static MemoryTag untrack(const void* pointer) {
+	TrackedObject* object = (pointer != NULL) ? find(pointer) : NULL;
+	if (object == NULL) {
+		return currentTag;
+	}
+	MemoryTag tag = object->tag;
+	account(&stats[tag], object->size, 0);
+	account(&totalStats, object->size, 0);
+	*object = objects[--numObjects];
+	return tag;
+}
+
+/**
+ * Changes a tracked object's size (e.g. after reloading it).
+ */
+static void resize(const void* pointer, size_t size) {
+	TrackedObject* object = find(pointer);
+	if (object == NULL) {
+		return;
+	}
+	stats[object->tag].current += size - object->size;
+	totalStats.current += size - object->size;
+	object->size = size;
+	if (stats[object->tag].current > stats[object->tag].peak) {
+		stats[object->tag].peak = stats[object->tag].current;
+	}
+	if (totalStats.current > totalStats.peak) {
+		totalStats.peak = totalStats.current;
+	}
+}
+
+
+// - system
+
+static void* trackedRealloc(void* ptr, size_t size) {
+	void* moved = real->system->realloc(ptr, size);
+	if (size > 0 && moved == NULL) {
+		return NULL; // (ptr is left as it was)
+	}
+	MemoryTag tag = currentTag;
+	if (ptr != NULL) {
+		currentTag = untrack(ptr); // (resized allocations keep their tag)
+	}
+	track(moved, size);
+	currentTag = tag;
+	return moved;
+}
+
+
+// - graphics
+
+static size_t bitmapSize(LCDBitmap* bitmap) {
+	int width = 0, height = 0, rowbytes = 0;
+	uint8_t* mask = NULL;
+	uint8_t* data = NULL;
+	real->graphics->getBitmapData(bitmap, &width, &height, &rowbytes, &mask, &data);
+	return (size_t)rowbytes * height * (mask != NULL ? 2 : 1);
+}
+
+static LCDBitmap* trackedNewBitmap(int width, int height, LCDColor bgcolor) {
+	LCDBitmap* bitmap = real->graphics->newBitmap(width, height, bgcolor);
+	if (bitmap != NULL) {
+		track(bitmap, bitmapSize(bitmap));
+	}
+	return bitmap;
+}
+
+static LCDBitmap* trackedLoadBitmap(const char* path, const char** outerr) {
+	LCDBitmap* bitmap = real->graphics->loadBitmap(path, outerr);
+	if (bitmap != NULL) {
+		track(bitmap, bitmapSize(bitmap));
+	}
+	return bitmap;
+}
+
+static LCDBitmap* trackedCopyBitmap(LCDBitmap* bitmap) {
+	LCDBitmap* copy = real->graphics->copyBitmap(bitmap);
+	if (copy != NULL) {
+		track(copy, bitmapSize(copy));
+	}
+	return copy;
+}
+
+static void trackedLoadIntoBitmap(const char* path, LCDBitmap* bitmap, const char** outerr) {
+	real->graphics->loadIntoBitmap(path, bitmap, outerr);
+	resize(bitmap, bitmapSize(bitmap));
+}
+
+static void trackedFreeBitmap(LCDBitmap* bitmap) {
+	untrack(bitmap);
+	real->graphics->freeBitmap(bitmap);
+}
+
+static LCDFont* trackedLoadFont(const char* path, const char** outErr) {
+	LCDFont* font = real->graphics->loadFont(path, outErr);
+	if (font != NULL) {
+		// (no API for a font's size: estimated by its compiled file's)
+		char compiledPath[256];
+		FileStat stat;
+		stat.size = 0;
+		size_t length = strlen(path);
+		if (length + 5 <= sizeof(compiledPath)) {
+			memcpy(compiledPath, path, length);
+			memcpy(compiledPath + length, ".pft", 5);
+			if (real->file->stat(compiledPath, &stat) != 0 && real->file->stat(path, &stat) != 0) {
+				stat.size = 0;
+			}
+		}
+		track(font, stat.size);
+	}
+	return font;
+}
+
+
+// - sprite
+
+static LCDSprite* trackedNewSprite(void) {
+	LCDSprite* sprite = real->sprite->newSprite();
+	track(sprite, 0);
+	return sprite;
+}
+
+static void trackedFreeSprite(LCDSprite* sprite) {
+	untrack(sprite);
+	real->sprite->freeSprite(sprite);
+}
+
+
+// - sound
+
+static size_t sampleSize(AudioSample* sample) {
+	uint8_t* data = NULL;
+	SoundFormat format;
+	uint32_t sampleRate = 0;
+	uint32_t bytelength = 0;
+	real->sound->sample->getData(sample, &data, &format, &sampleRate, &bytelength);
+	return bytelength;
+}
+
+static AudioSample* trackedNewSampleBuffer(int byteCount) {
+	AudioSample* sample = real->sound->sample->newSampleBuffer(byteCount);
+	track(sample, byteCount > 0 ? (size_t)byteCount : 0);
+	return sample;
+}
+
+static AudioSample* trackedLoadSample(const char* path) {
+	AudioSample* sample = real->sound->sample->load(path);
+	if (sample != NULL) {
+		track(sample, sampleSize(sample));
+	}
+	return sample;
+}
+
+static void trackedFreeSample(AudioSample* sample) {
+	untrack(sample);
+	real->sound->sample->freeSample(sample);
+}
+
+static FilePlayer* trackedNewFilePlayer(void) {
+	FilePlayer* player = real->sound->fileplayer->newPlayer();
+	track(player, 0); // (sized by its buffer, once set)
+	return player;
+}
+
+static void trackedSetBufferLength(FilePlayer* player, float bufferLen) {
+	real->sound->fileplayer->setBufferLength(player, bufferLen);
+	resize(player, (size_t)(bufferLen * MUSIC_ESTIMATE_SAMPLE_RATE) * MUSIC_ESTIMATE_FRAME_BYTES);
+}
+
+static void trackedFreeFilePlayer(FilePlayer* player) {
+	untrack(player);
+	real->sound->fileplayer->freePlayer(player);
+}
+
+static SamplePlayer* trackedNewSamplePlayer(void) {
+	SamplePlayer* player = real->sound->sampleplayer->newPlayer();
+	track(player, 0);
+	return player;
+}
+
+static void trackedFreeSamplePlayer(SamplePlayer* player) {
+	untrack(player);
+	real->sound->sampleplayer->freePlayer(player);
+}
+
+static PDSynth* trackedNewSynth(void) {
+	PDSynth* synth = real->sound->synth->newSynth();
+	track(synth, SYNTH_ESTIMATE_BYTES);
+	return synth;
+}
+
+static void trackedFreeSynth(PDSynth* synth) {
+	untrack(synth);
+	real->sound->synth->freeSynth(synth);
+}
+
+
+PlaydateAPI* memoryTrackerInstall(PlaydateAPI* pd) {
+	if (real != NULL) {
+		return &tracked;
+	}
+	real = pd;
+
+	trackedSystem = *pd->system;
+	trackedSystem.realloc = trackedRealloc;
+
+	trackedGraphics = *pd->graphics;
+	trackedGraphics.newBitmap = trackedNewBitmap;
+	trackedGraphics.loadBitmap = trackedLoadBitmap;
+	trackedGraphics.copyBitmap = trackedCopyBitmap;
+	trackedGraphics.loadIntoBitmap = trackedLoadIntoBitmap;
+	trackedGraphics.freeBitmap = trackedFreeBitmap;
+	trackedGraphics.loadFont = trackedLoadFont;
+
+	trackedSprite = *pd->sprite;
+	trackedSprite.newSprite = trackedNewSprite;
+	trackedSprite.freeSprite = trackedFreeSprite;
+
+	trackedSample = *pd->sound->sample;
+	trackedSample.newSampleBuffer = trackedNewSampleBuffer;
+	trackedSample.load = trackedLoadSample;
+	trackedSample.freeSample = trackedFreeSample;
+
+	trackedFilePlayer = *pd->sound->fileplayer;
+	trackedFilePlayer.newPlayer = trackedNewFilePlayer;
+	trackedFilePlayer.setBufferLength = trackedSetBufferLength;
+	trackedFilePlayer.freePlayer = trackedFreeFilePlayer;
+
+	trackedSamplePlayer = *pd->sound->sampleplayer;
+	trackedSamplePlayer.newPlayer = trackedNewSamplePlayer;
+	trackedSamplePlayer.freePlayer = trackedFreeSamplePlayer;
+
+	trackedSynth = *pd->sound->synth;
+	trackedSynth.newSynth = trackedNewSynth;
+	trackedSynth.freeSynth = trackedFreeSynth;
+
+	trackedSound = *pd->sound;
+	trackedSound.sample = &trackedSample;
+	trackedSound.fileplayer = &trackedFilePlayer;
+	trackedSound.sampleplayer = &trackedSamplePlayer;
+	trackedSound.synth = &trackedSynth;
+
+	tracked = *pd;
+	tracked.system = &trackedSystem;
+	tracked.graphics = &trackedGraphics;
+	tracked.sprite = &trackedSprite;
+	tracked.sound = &trackedSound;
+	return &tracked;
+}
+
+MemoryTag memoryTrackerSetTag(MemoryTag tag) {
+	MemoryTag previous = currentTag;
+	currentTag = tag;
+	return previous;
+}
+
+const MemoryTagStats* memoryTrackerGetStats(MemoryTag tag) {
+	return &stats[tag];
+}
+
+void memoryTrackerLogReport(PlaydateAPI* pd) {
+	pd->system->logToConsole("memory (bytes of data; fonts, synths and music estimated):");
+	for (int tag = 0; tag < kNumMemoryTags; tag++) {
+		const MemoryTagStats* s = &stats[tag];
+		pd->system->logToConsole(
+			"  %-8s %8u current, %8u peak, %4u live, %5u allocated",
+			tagNames[tag], (unsigned int)s->current, (unsigned int)s->peak, (unsigned int)s->live, (unsigned int)s->allocs
+		);
+	}
+	pd->system->logToConsole(
+		"  %-8s %8u current, %8u peak, %4u live, %5u allocated (%u untracked)",
+		"total", (unsigned int)totalStats.current, (unsigned int)totalStats.peak, (unsigned int)totalStats.live,
+		(unsigned int)totalStats.allocs, (unsigned int)untrackedAllocs
+	);
+}
+
+#endif /* MEMORY_TRACKER_ENABLED */
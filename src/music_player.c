@@ -0,0 +1,87 @@
+#include <string.h>
+
+#include "music_player.h"
+
+
+static void musicLoopCallback(SoundSource* source, void* userdata) {
+	(void)source;
+	MusicPlayer* music = userdata;
+	music->stats.loops++;
+}
+
+static void musicFinishCallback(SoundSource* source, void* userdata) {
+	(void)source;
+	MusicPlayer* music = userdata;
+	music->stopped = 1;
+}
+
+int musicPlayerInit(PlaydateAPI* pd, MusicPlayer* music, const char* path, float bufferLength, SoundChannel* channel) {
+	memset(music, 0, sizeof(*music));
+	music->bufferLength = bufferLength;
+
+	music->player = pd->sound->fileplayer->newPlayer();
+	if (music->player == NULL) {
+		return 0;
+	}
+	pd->sound->fileplayer->setBufferLength(music->player, bufferLength);
+	pd->sound->fileplayer->setLoopCallback(music->player, musicLoopCallback, music);
+	pd->sound->fileplayer->setFinishCallback(music->player, musicFinishCallback, music);
+	pd->sound->channel->addSource(channel, (SoundSource*)music->player);
+	return pd->sound->fileplayer->loadIntoPlayer(music->player, path);
+}
+
+void musicPlayerStart(PlaydateAPI* pd, MusicPlayer* music) {
+	if (music->player == NULL) {
+		return;
+	}
+	music->stopped = 0;
+
+	float start = pd->system->getElapsedTime();
+	if (pd->sound->fileplayer->play(music->player, 0) == 0) { // (repeat 0: loop until stopped)
+		music->stopped = 1;
+	}
+	music->stats.startTime = pd->system->getElapsedTime() - start;
+	if (music->stats.startTime > music->stats.maxStartTime) {
+		music->stats.maxStartTime = music->stats.startTime;
+	}
+}
+
+void musicPlayerUpdate(PlaydateAPI* pd, MusicPlayer* music) {
+	if (music->player == NULL) {
+		return;
+	}
+
+	// (frame times by the millisecond clock: the elapsed time clock may be reset every frame, e.g. by the frame profiler)
+	unsigned int now = pd->system->getCurrentTimeMilliseconds();
+	if (music->lastUpdateTime != 0) {
+		float frameTime = (now - music->lastUpdateTime) / 1000.0f;
+		if (frameTime > music->stats.maxFrameTime) {
+			music->stats.maxFrameTime = frameTime;
+		}
+		if (frameTime > music->bufferLength) {
+			music->stats.slowFrames++;
+		}
+	}
+	music->lastUpdateTime = now;
+
+	if (--music->framesUntilPoll <= 0) {
+		music->framesUntilPoll = MUSIC_PLAYER_UNDERRUN_POLL_FRAMES;
+		if (pd->sound->fileplayer->didUnderrun(music->player)) {
+			music->stats.underruns++;
+		}
+	}
+
+	if (music->stopped) {
+		music->stats.restarts++;
+		musicPlayerStart(pd, music);
+	}
+}
+
+void musicPlayerFree(PlaydateAPI* pd, MusicPlayer* music) {
+	if (music->player != NULL) {
+		pd->sound->fileplayer->setFinishCallback(music->player, NULL, NULL);
+		pd->sound->fileplayer->stop(music->player);
+		pd->sound->fileplayer->freePlayer(music->player);
+	}
+	memset(music, 0, sizeof(*music));
+}
@@ -0,0 +1,105 @@
+#include <string.h>
+
+#include "scene.h"
+
+
+/**
+ * Counts a state change as submitted (or skipped, if unchanged); flags the node and scene for drawing if submitted.
+ *
+ * @return changed
+ */
+static int submit(Scene* scene, SceneNode* node, int changed) {
+	if (changed == 0) {
+		scene->stats.skips++;
+		return 0;
+	}
+	scene->stats.submits++;
+	node->dirty = 1;
+	scene->dirty = 1;
+	return 1;
+}
+
+void sceneInit(Scene* scene) {
+	memset(scene, 0, sizeof(*scene));
+}
+
+SceneNode* sceneAddNode(PlaydateAPI* pd, Scene* scene, int16_t zIndex, LCDSpriteDrawFunction* draw) {
+	if (scene->numNodes == SCENE_MAX_NODES) {
+		return NULL;
+	}
+	LCDSprite* sprite = pd->sprite->newSprite();
+	if (sprite == NULL) {
+		return NULL;
+	}
+
+	SceneNode* node = &scene->nodes[scene->numNodes++];
+	memset(node, 0, sizeof(*node));
+	node->sprite = sprite;
+	node->visible = 1;
+	pd->sprite->setCenter(sprite, 0.0f, 0.0f);
+	pd->sprite->setZIndex(sprite, zIndex);
+	if (draw != NULL) {
+		pd->sprite->setDrawFunction(sprite, draw);
+	}
+	pd->sprite->addSprite(sprite);
+	return node;
+}
+
+void sceneNodeSetImage(PlaydateAPI* pd, Scene* scene, SceneNode* node, LCDBitmap* image) {
+	if (submit(scene, node, image != node->image)) {
+		pd->sprite->setImage(node->sprite, image, kBitmapUnflipped);
+		node->image = image;
+	}
+}
+
+void sceneNodeSetSize(PlaydateAPI* pd, Scene* scene, SceneNode* node, float width, float height) {
+	if (submit(scene, node, width != node->width || height != node->height)) {
+		pd->sprite->setSize(node->sprite, width, height);
+		node->width = width;
+		node->height = height;
+	}
+}
+
+void sceneNodeMoveTo(PlaydateAPI* pd, Scene* scene, SceneNode* node, float x, float y) {
+	if (submit(scene, node, x != node->x || y != node->y)) {
+		pd->sprite->moveTo(node->sprite, x, y);
+		node->x = x;
+		node->y = y;
+	}
+}
+
+void sceneNodeSetVisible(PlaydateAPI* pd, Scene* scene, SceneNode* node, int visible) {
+	if (submit(scene, node, visible != node->visible)) {
+		pd->sprite->setVisible(node->sprite, visible);
+		node->visible = visible;
+	}
+}
+
+void sceneNodeInvalidate(PlaydateAPI* pd, Scene* scene, SceneNode* node) {
+	// (a node changed since the last draw is marked dirty already, over its old and new bounds)
+	if (submit(scene, node, node->dirty == 0)) {
+		pd->sprite->markDirty(node->sprite);
+	}
+}
+
+int sceneDraw(PlaydateAPI* pd, Scene* scene) {
+	if (scene->dirty == 0) {
+		scene->stats.idleDraws++;
+		return 0;
+	}
+	pd->sprite->drawSprites();
+	for (int i = 0; i < scene->numNodes; i++) {
+		scene->nodes[i].dirty = 0;
+	}
+	scene->dirty = 0;
+	scene->stats.draws++;
+	return 1;
+}
+
+void sceneFree(PlaydateAPI* pd, Scene* scene) {
+	for (int i = 0; i < scene->numNodes; i++) {
+		pd->sprite->removeSprite(scene->nodes[i].sprite);
+		pd->sprite->freeSprite(scene->nodes[i].sprite);
+	}
+	memset(scene, 0, sizeof(*scene));
+}
@@ -7,3 +7,15 @@ char* getHelloText(void) {
 char* getShowTextMenuItemLabel(void) {
 	return "say hello!";
 }
+
+#if FRAME_PROFILER_ENABLED
+char* getProfilerMenuItemLabel(void) {
+	return "profiler";
+}
+#endif
+
+#if MEMORY_TRACKER_ENABLED
+char* getMemoryMenuItemLabel(void) {
+	return "memory";
+}
+#endif
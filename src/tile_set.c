@@ -0,0 +1,345 @@
+#include <string.h>
+
+#include "tile_set.h"
+
+
+#define TILE_SET_HEADER_SIZE 32
+#define TILE_SET_LEVEL_ENTRY_SIZE 8
+#define TILE_SET_VERSION 1
+/** The room in bytes per cache slot besides its tile's data (slotTiles, slotUsed) */
+#define TILE_SET_SLOT_OVERHEAD (sizeof(int32_t) + sizeof(uint32_t))
+/** The most cache slots (tileSlots holds slot indices as int16_t) */
+#define TILE_SET_MAX_SLOTS 0x7fff
+
+
+static uint16_t readU16(const uint8_t* p) {
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t readU32(const uint8_t* p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @return a / b rounded toward negative infinity (b > 0), for view coordinates left of or above the image
+ */
+static int floorDiv(int a, int b) {
+	return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+/**
+ * Reads tile into a slot: a free one, or else the least recently used one not used in this frame (if prefetching: nor
+ * in the last frame, so prefetches don't evict each other or what was just drawn).
+ *
+ * @return the tile's data, or NULL if there was no slot for it or it couldn't be read
+ */
+static const uint8_t* loadTile(PlaydateAPI* pd, TileSet* set, int tile, int prefetch) {
+	int slot = -1;
+	for (int i = 0; i < set->slotCount; i++) {
+		if (set->slotTiles[i] < 0) {
+			slot = i;
+			break;
+		}
+		uint32_t age = set->frame - set->slotUsed[i];
+		if (age > (prefetch ? 1u : 0u) && (slot < 0 || age > set->frame - set->slotUsed[slot])) {
+			slot = i;
+		}
+	}
+	if (slot < 0) {
+		if (prefetch == 0) {
+			set->stats.overBudget++;
+		}
+		return NULL;
+	}
+
+	if (set->slotTiles[slot] >= 0) {
+		set->tileSlots[set->slotTiles[slot]] = -1;
+		set->slotTiles[slot] = -1;
+		set->resident--;
+		set->stats.evictions++;
+	}
+
+	set->loadsLeft--;
+	uint8_t* data = set->slotData + slot * set->tileBytes;
+	int position = (int)(set->dataOffset + (uint32_t)tile * set->tileBytes);
+	set->stats.reads++;
+	if (position != set->filePosition) {
+		set->stats.seeks++;
+		if (pd->file->seek(set->file, position, SEEK_SET) != 0) {
+			set->stats.errors++;
+			set->filePosition = -1;
+			return NULL;
+		}
+	}
+	if (pd->file->read(set->file, data, set->tileBytes) != set->tileBytes) {
+		set->stats.errors++;
+		set->filePosition = -1;
+		return NULL;
+	}
+	set->filePosition = position + set->tileBytes;
+
+	set->slotTiles[slot] = tile;
+	set->slotUsed[slot] = prefetch ? set->frame - 1 : set->frame;
+	set->tileSlots[tile] = (int16_t)slot;
+	if (++set->resident > set->stats.peakResident) {
+		set->stats.peakResident = set->resident;
+	}
+	return data;
+}
+
+/**
+ * @return the data of level's tile at (column, row), loaded if needed and the frame's budget allows; NULL if it is off
+ * the level (*missing unchanged) or couldn't be loaded (*missing set to 1)
+ */
+static const uint8_t* getTile(PlaydateAPI* pd, TileSet* set, const TileSetLevel* level, int column, int row, int* missing) {
+	if (column < 0 || column >= level->columns || row < 0 || row >= level->rows) {
+		return NULL;
+	}
+	int tile = level->tiles[row * level->columns + column];
+	int slot = set->tileSlots[tile];
+	if (slot >= 0) {
+		set->stats.hits++;
+		set->slotUsed[slot] = set->frame;
+		return set->slotData + slot * set->tileBytes;
+	}
+
+	const uint8_t* data = NULL;
+	if (set->loadsLeft > 0) {
+		set->stats.misses++;
+		data = loadTile(pd, set, tile, 0);
+	}
+	if (data == NULL) {
+		*missing = 1;
+	}
+	return data;
+}
+
+int tileSetOpen(PlaydateAPI* pd, TileSet* set, const char* path, MemoryArena* arena, const char** outErr) {
+	memset(set, 0, sizeof(*set));
+	const char* err = NULL;
+	size_t arenaMark = memoryArenaMark(arena);
+
+	uint8_t header[TILE_SET_HEADER_SIZE + TILE_SET_MAX_LEVELS * TILE_SET_LEVEL_ENTRY_SIZE];
+	uint32_t indexOffset = 0;
+	FileStat stat;
+	if (pd->file->stat(path, &stat) != 0 || stat.size < TILE_SET_HEADER_SIZE) {
+		err = "file not found";
+	}
+	else if ((set->file = pd->file->open(path, kFileRead)) == NULL) {
+		err = "file could not be opened";
+	}
+	else if (pd->file->read(set->file, header, TILE_SET_HEADER_SIZE) != TILE_SET_HEADER_SIZE) {
+		err = "file could not be read";
+	}
+	else if (memcmp(header, "PDTS", 4) != 0 || readU16(header + 4) != TILE_SET_VERSION) {
+		err = "not a tile set, or unsupported version";
+	}
+	else {
+		set->tileSize = readU16(header + 6);
+		set->levelCount = readU16(header + 8);
+		set->width = readU16(header + 10);
+		set->height = readU16(header + 12);
+		set->background = header[14] ? 0xff : 0x00;
+		set->tileCount = readU16(header + 16);
+		indexOffset = readU32(header + 20);
+		set->dataOffset = readU32(header + 24);
+		uint32_t dataSize = readU32(header + 28);
+		set->tileRowBytes = set->tileSize / 8;
+		set->tileBytes = set->tileRowBytes * set->tileSize;
+
+		if (
+			set->tileSize < 8 || set->tileSize % 8 != 0 || set->levelCount < 1 || set->levelCount > TILE_SET_MAX_LEVELS ||
+			set->tileCount < 1 || dataSize != (uint32_t)set->tileCount * set->tileBytes ||
+			indexOffset != TILE_SET_HEADER_SIZE + (uint32_t)set->levelCount * TILE_SET_LEVEL_ENTRY_SIZE ||
+			set->dataOffset < indexOffset || set->dataOffset > stat.size || dataSize > stat.size - set->dataOffset
+		) {
+			err = "corrupt header";
+		}
+		else if (pd->file->read(set->file, header + TILE_SET_HEADER_SIZE, indexOffset - TILE_SET_HEADER_SIZE) != (int)(indexOffset - TILE_SET_HEADER_SIZE)) {
+			err = "file could not be read";
+		}
+	}
+
+	// the levels, and their tile numbers in one block, read and then converted in place
+	uint32_t indexEntries = 0;
+	for (int i = 0; i < set->levelCount && err == NULL; i++) {
+		const uint8_t* entry = header + TILE_SET_HEADER_SIZE + i * TILE_SET_LEVEL_ENTRY_SIZE;
+		TileSetLevel* level = &set->levels[i];
+		level->width = readU16(entry);
+		level->height = readU16(entry + 2);
+		level->columns = readU16(entry + 4);
+		level->rows = readU16(entry + 6);
+		if (
+			level->width == 0 || level->height == 0 || (i == 0 && (level->width != set->width || level->height != set->height)) ||
+			level->columns != (level->width + set->tileSize - 1) / set->tileSize || level->rows != (level->height + set->tileSize - 1) / set->tileSize
+		) {
+			err = "corrupt level";
+		}
+		indexEntries += (uint32_t)level->columns * level->rows;
+	}
+	uint16_t* index = NULL;
+	if (err == NULL) {
+		if (indexOffset + indexEntries * 2 > set->dataOffset) {
+			err = "corrupt index";
+		}
+		else if ((index = memoryArenaAlloc(arena, indexEntries * 2)) == NULL) {
+			err = "out of memory";
+		}
+		else if (pd->file->read(set->file, index, indexEntries * 2) != (int)(indexEntries * 2)) {
+			err = "file could not be read";
+		}
+	}
+	for (uint32_t i = 0; i < indexEntries && err == NULL; i++) {
+		index[i] = readU16((const uint8_t*)&index[i]);
+		if (index[i] >= set->tileCount) {
+			err = "corrupt index";
+		}
+	}
+	for (int i = 0, first = 0; i < set->levelCount && err == NULL; i++) {
+		set->levels[i].tiles = index + first;
+		first += set->levels[i].columns * set->levels[i].rows;
+	}
+
+	// the cache: as many slots as fit in what's left of the arena
+	if (err == NULL) {
+		set->tileSlots = memoryArenaAlloc(arena, set->tileCount * sizeof(int16_t));
+		size_t room = arena->capacity - arena->used;
+		size_t slotCount = (room > 3 * MEMORY_ARENA_ALIGNMENT) ? (room - 3 * MEMORY_ARENA_ALIGNMENT) / (set->tileBytes + TILE_SET_SLOT_OVERHEAD) : 0;
+		set->slotCount = (slotCount < TILE_SET_MAX_SLOTS) ? (int)slotCount : TILE_SET_MAX_SLOTS;
+		set->slotData = memoryArenaAlloc(arena, set->slotCount * set->tileBytes);
+		set->slotTiles = memoryArenaAlloc(arena, set->slotCount * sizeof(int32_t));
+		set->slotUsed = memoryArenaAlloc(arena, set->slotCount * sizeof(uint32_t));
+		if (set->tileSlots == NULL || set->slotCount == 0 || set->slotData == NULL || set->slotTiles == NULL || set->slotUsed == NULL) {
+			err = "out of memory";
+		}
+	}
+
+	if (err != NULL) {
+		tileSetClose(pd, set);
+		memoryArenaRelease(arena, arenaMark);
+		if (outErr != NULL) {
+			*outErr = err;
+		}
+		return 0;
+	}
+
+	memset(set->tileSlots, 0xff, set->tileCount * sizeof(int16_t));
+	memset(set->slotTiles, 0xff, set->slotCount * sizeof(int32_t));
+	memset(set->slotUsed, 0, set->slotCount * sizeof(uint32_t));
+	set->filePosition = -1;
+	set->frame = 2; // (so prefetched tiles, stamped a frame back, are never stamped as far back as free slots)
+	return 1;
+}
+
+void tileSetClose(PlaydateAPI* pd, TileSet* set) {
+	if (set->file != NULL) {
+		pd->file->close(set->file);
+		set->file = NULL;
+	}
+	set->slotCount = 0;
+	set->resident = 0;
+}
+
+void tileSetBeginFrame(TileSet* set, int maxLoads) {
+	set->frame++;
+	set->loadsLeft = maxLoads;
+}
+
+int tileSetDraw(PlaydateAPI* pd, TileSet* set, int level, int x, int y, int width, int height, uint8_t* frame, int rowbytes, int top) {
+	const TileSetLevel* l = &set->levels[level];
+	int bytes = (width + 7) / 8;
+	// the view's bytes, from the level's byte column at or left of x, shifted left into place if x isn't byte-aligned
+	int byteX = floorDiv(x, 8);
+	int shift = x - byteX * 8;
+	int spanBytes = bytes + (shift != 0 ? 1 : 0);
+	int firstColumn = floorDiv(byteX, set->tileRowBytes);
+	int columnCount = floorDiv(byteX + spanBytes - 1, set->tileRowBytes) - firstColumn + 1;
+	uint8_t line[LCD_COLUMNS / 8 + 1];
+	const uint8_t* tiles[LCD_COLUMNS / 8 + 2];
+	int missing = 0;
+
+	for (int row = 0; row < height; ) {
+		// a band of rows in one row of tiles
+		int tileRow = floorDiv(y + row, set->tileSize);
+		int bandEnd = (tileRow + 1) * set->tileSize - y;
+		if (bandEnd > height) {
+			bandEnd = height;
+		}
+		if (tileRow < 0 || tileRow >= l->rows) {
+			for (; row < bandEnd; row++) {
+				memset(frame + (top + row) * rowbytes, set->background, bytes);
+			}
+			continue;
+		}
+		for (int i = 0; i < columnCount; i++) {
+			tiles[i] = getTile(pd, set, l, firstColumn + i, tileRow, &missing);
+		}
+
+		for (; row < bandEnd; row++) {
+			int tileY = y + row - tileRow * set->tileSize;
+			uint8_t* dst = frame + (top + row) * rowbytes;
+			uint8_t* out = (shift != 0) ? line : dst;
+			for (int b = 0; b < spanBytes; ) {
+				int column = floorDiv(byteX + b, set->tileRowBytes);
+				int offset = byteX + b - column * set->tileRowBytes;
+				int count = set->tileRowBytes - offset;
+				if (count > spanBytes - b) {
+					count = spanBytes - b;
+				}
+				const uint8_t* tile = tiles[column - firstColumn];
+				if (tile != NULL) {
+					memcpy(out + b, tile + tileY * set->tileRowBytes + offset, count);
+				}
+				else {
+					memset(out + b, set->background, count);
+				}
+				b += count;
+			}
+			if (shift != 0) {
+				for (int i = 0; i < bytes; i++) {
+					dst[i] = (uint8_t)((line[i] << shift) | (line[i + 1] >> (8 - shift)));
+				}
+			}
+		}
+	}
+
+	set->stats.draws++;
+	if (missing) {
+		set->stats.incompleteDraws++;
+	}
+	return missing == 0;
+}
+
+int tileSetPrefetch(PlaydateAPI* pd, TileSet* set, int level, int x, int y, int width, int height, int margin) {
+	const TileSetLevel* l = &set->levels[level];
+	int left = floorDiv(x, set->tileSize) - margin;
+	int right = floorDiv(x + width - 1, set->tileSize) + margin;
+	int topRow = floorDiv(y, set->tileSize) - margin;
+	int bottomRow = floorDiv(y + height - 1, set->tileSize) + margin;
+	left = (left < 0) ? 0 : left;
+	topRow = (topRow < 0) ? 0 : topRow;
+	right = (right >= l->columns) ? l->columns - 1 : right;
+	bottomRow = (bottomRow >= l->rows) ? l->rows - 1 : bottomRow;
+
+	int missing = 0;
+	for (int row = topRow; row <= bottomRow; row++) {
+		for (int column = left; column <= right; column++) {
+			int tile = l->tiles[row * l->columns + column];
+			int slot = set->tileSlots[tile];
+			if (slot >= 0) {
+				// (kept from eviction by other prefetches, like tiles just loaded, so the prefetched set settles)
+				if (set->slotUsed[slot] != set->frame) {
+					set->slotUsed[slot] = set->frame - 1;
+				}
+				continue;
+			}
+			if (set->loadsLeft > 0 && loadTile(pd, set, tile, 1) != NULL) {
+				set->stats.prefetches++;
+			}
+			else {
+				missing++;
+			}
+		}
+	}
+	return missing;
+}
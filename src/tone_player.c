@@ -0,0 +1,72 @@
+#include <string.h>
+
+#include "tone_player.h"
+
+
+int tonePlayerInit(PlaydateAPI* pd, TonePlayer* player, int numVoices, SoundChannel* channel) {
+	memset(player, 0, sizeof(*player));
+	if (numVoices < 1 || numVoices > TONE_PLAYER_MAX_VOICES) {
+		return 0;
+	}
+	player->channel = channel;
+
+	for (int v = 0; v < numVoices; v++) {
+		PDSynth* synth = pd->sound->synth->newSynth();
+		if (synth == NULL) {
+			tonePlayerFree(pd, player);
+			return 0;
+		}
+		player->voices[player->numVoices++] = synth;
+		pd->sound->synth->setDecayTime(synth, 0.0f);
+		pd->sound->synth->setSustainLevel(synth, 1.0f);
+		pd->sound->channel->addSource(channel, (SoundSource*)synth);
+	}
+	return 1;
+}
+
+int tonePlayerPlay(PlaydateAPI* pd, TonePlayer* player, const TonePreset* tone) {
+	if (player->numVoices == 0) {
+		return -1;
+	}
+
+	// an idle voice, if any
+	int chosen = -1;
+	for (int v = 0; v < player->numVoices; v++) {
+		if (pd->sound->synth->isPlaying(player->voices[v]) == 0) {
+			chosen = v;
+			break;
+		}
+	}
+
+	// otherwise, steal the oldest
+	if (chosen < 0) {
+		chosen = 0;
+		for (int v = 1; v < player->numVoices; v++) {
+			if ((int32_t)(player->triggerTimes[v] - player->triggerTimes[chosen]) < 0) {
+				chosen = v;
+			}
+		}
+		pd->sound->synth->stop(player->voices[chosen]);
+		player->stats.steals++;
+	}
+
+	// (the envelope is set per tone, as any voice plays any tone)
+	PDSynth* synth = player->voices[chosen];
+	pd->sound->synth->setWaveform(synth, tone->waveform);
+	pd->sound->synth->setAttackTime(synth, tone->attack);
+	pd->sound->synth->setReleaseTime(synth, tone->release);
+	pd->sound->synth->playNote(synth, tone->frequency, tone->volume, tone->length, 0);
+	player->triggerTimes[chosen] = pd->sound->getCurrentTime();
+	player->stats.triggers++;
+	return chosen;
+}
+
+void tonePlayerFree(PlaydateAPI* pd, TonePlayer* player) {
+	for (int v = 0; v < player->numVoices; v++) {
+		PDSynth* synth = player->voices[v];
+		pd->sound->synth->stop(synth);
+		pd->sound->channel->removeSource(player->channel, (SoundSource*)synth);
+		pd->sound->synth->freeSynth(synth);
+	}
+	memset(player, 0, sizeof(*player));
+}